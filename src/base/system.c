@@ -69,6 +69,108 @@ static NETSTATS network_stats = {0};
 
 static NETSOCKET invalid_socket = {NETTYPE_INVALID, -1, -1};
 
+/* atomics shared by the logger and the memory statistics. compswap
+   returns the value before the eventual swap, add the value after it */
+static unsigned atomic_compswap32(volatile unsigned *value, unsigned comperand, unsigned exchange)
+{
+#if defined(_MSC_VER)
+	return _InterlockedCompareExchange((volatile long *)value, (long)exchange, (long)comperand);
+#else
+	return __sync_val_compare_and_swap(value, comperand, exchange);
+#endif
+}
+
+static unsigned atomic_add32(volatile unsigned *value, unsigned amount)
+{
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((volatile long *)value, (long)amount) + amount;
+#else
+	return __sync_add_and_fetch(value, amount);
+#endif
+}
+
+static int64 atomic_compswap64(volatile int64 *value, int64 comperand, int64 exchange)
+{
+#if defined(_MSC_VER)
+	return InterlockedCompareExchange64(value, exchange, comperand);
+#else
+	return __sync_val_compare_and_swap(value, comperand, exchange);
+#endif
+}
+
+static int64 atomic_add64(volatile int64 *value, int64 amount)
+{
+#if defined(_MSC_VER)
+	return InterlockedExchangeAdd64(value, amount) + amount;
+#else
+	return __sync_add_and_fetch(value, amount);
+#endif
+}
+
+static void atomic_barrier()
+{
+#if defined(_MSC_VER)
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+/* async logging: dbg_msg formats the line straight into a slot of a
+   bounded multi producer ring, the logger thread hands the lines to the
+   loggers and flushes them in batches */
+enum
+{
+	LOG_RING_SIZE = 1024,
+	LOG_LINE_SIZE = 1024,
+	LOG_POLL_TIME = 5
+};
+
+typedef struct
+{
+	volatile unsigned sequence;
+	char line[LOG_LINE_SIZE];
+} LOG_SLOT;
+
+static LOG_SLOT *log_ring = 0;
+static volatile unsigned log_write_pos = 0;
+static unsigned log_read_pos = 0;
+static volatile unsigned log_dropped = 0;
+static volatile unsigned log_flush_requests = 0;
+static volatile unsigned log_flush_done = 0;
+static volatile int log_async = 0;
+static int log_flush_interval = 0;
+static void *log_thread = 0;
+
+/* the timestamp only changes once per second, the last one is shared */
+static volatile unsigned log_timestamp_version = 0;
+static volatile time_t log_timestamp_second = 0;
+static char log_timestamp_str[80];
+
+static void log_timestamp(char *buffer, int buffer_size)
+{
+	time_t now = time(0);
+	unsigned version = log_timestamp_version;
+	if(!(version&1) && log_timestamp_second == now)
+	{
+		str_copy(buffer, log_timestamp_str, buffer_size);
+		atomic_barrier();
+		if(log_timestamp_version == version)
+			return;
+	}
+
+	str_timestamp_ex(now, buffer, buffer_size, FORMAT_SPACE);
+
+	/* publish it, unless another thread is already at it */
+	if(!(version&1) && atomic_compswap32(&log_timestamp_version, version, version+1) == version)
+	{
+		str_copy(log_timestamp_str, buffer, sizeof(log_timestamp_str));
+		log_timestamp_second = now;
+		atomic_barrier();
+		log_timestamp_version = version+2;
+	}
+}
+
 void dbg_logger(DBG_LOGGER logger)
 {
 	loggers[num_loggers++] = logger;
@@ -79,6 +181,7 @@ void dbg_assert_imp(const char *filename, int line, int test, const char *msg)
 	if(!test)
 	{
 		dbg_msg("assert", "%s(%d): %s", filename, line, msg);
+		dbg_logger_flush();
 		dbg_break();
 	}
 }
@@ -88,29 +191,79 @@ void dbg_break()
 	*((volatile unsigned*)0) = 0x0;
 }
 
+static LOG_SLOT *log_reserve(unsigned *pos_out)
+{
+	unsigned pos = log_write_pos;
+	while(1)
+	{
+		LOG_SLOT *slot = &log_ring[pos&(LOG_RING_SIZE-1)];
+		int diff = (int)(slot->sequence - pos);
+		if(diff == 0)
+		{
+			unsigned prev = atomic_compswap32(&log_write_pos, pos, pos+1);
+			if(prev == pos)
+			{
+				*pos_out = pos;
+				return slot;
+			}
+			pos = prev;
+		}
+		else if(diff < 0)
+			return 0; /* the logger thread is behind, drop the line */
+		else
+			pos = log_write_pos;
+	}
+}
+
 void dbg_msg(const char *sys, const char *fmt, ...)
 {
 	va_list args;
 	char str[1024*4];
 	char *msg;
-	int i, len;
+	int i, len, size;
+	LOG_SLOT *slot = 0;
+	unsigned pos = 0;
 
 	char timestr[80];
-	str_timestamp_format(timestr, sizeof(timestr), FORMAT_SPACE);
+	log_timestamp(timestr, sizeof(timestr));
+
+	if(log_async)
+	{
+		slot = log_reserve(&pos);
+		if(!slot)
+		{
+			atomic_add32(&log_dropped, 1);
+			return;
+		}
+		msg = slot->line;
+		size = sizeof(slot->line);
+	}
+	else
+	{
+		msg = str;
+		size = sizeof(str);
+	}
 
-	str_format(str, sizeof(str), "[%s][%s]: ", timestr, sys);
+	str_format(msg, size, "[%s][%s]: ", timestr, sys);
 
-	len = str_length(str);
-	msg = (char *)str + len;
+	len = str_length(msg);
 
 	va_start(args, fmt);
 #if defined(CONF_FAMILY_WINDOWS) && !defined(__GNUC__)
-	_vsprintf_p(msg, sizeof(str)-len, fmt, args);
+	_vsprintf_p(msg+len, size-len, fmt, args);
 #else
-	vsnprintf(msg, sizeof(str)-len, fmt, args);
+	vsnprintf(msg+len, size-len, fmt, args);
 #endif
 	va_end(args);
 
+	if(slot)
+	{
+		/* publish the line */
+		atomic_barrier();
+		slot->sequence = pos+1;
+		return;
+	}
+
 	for(i = 0; i < num_loggers; i++)
 		loggers[i](str);
 }
@@ -206,7 +359,8 @@ static void logger_win_console(const char *line)
 static void logger_stdout(const char *line)
 {
 	printf("%s\n", line);
-	fflush(stdout);
+	if(!log_async)
+		fflush(stdout);
 }
 
 static void logger_debugger(const char *line)
@@ -223,7 +377,8 @@ static void logger_file(const char *line)
 {
 	io_write(logfile, line, str_length(line));
 	io_write_newline(logfile);
-	io_flush(logfile);
+	if(!log_async)
+		io_flush(logfile);
 }
 
 void dbg_logger_stdout()
@@ -255,6 +410,154 @@ void dbg_logger_filehandle(IOHANDLE handle)
 		dbg_logger(logger_file);
 }
 
+/* hands all published lines to the loggers, returns how many there were */
+static int log_drain()
+{
+	int num = 0;
+	int i;
+	while(1)
+	{
+		LOG_SLOT *slot = &log_ring[log_read_pos&(LOG_RING_SIZE-1)];
+		if(slot->sequence != log_read_pos+1)
+			break;
+		atomic_barrier();
+		for(i = 0; i < num_loggers; i++)
+			loggers[i](slot->line);
+		atomic_barrier();
+		slot->sequence = log_read_pos+LOG_RING_SIZE;
+		log_read_pos++;
+		num++;
+	}
+	return num;
+}
+
+static void log_flush_loggers()
+{
+	fflush(stdout);
+	if(logfile)
+		io_flush(logfile);
+}
+
+static void log_thread_func(void *user)
+{
+	unsigned reported_dropped = log_dropped;
+	int pending = 0;
+	int64 last_flush = time_get();
+	int i;
+
+	while(1)
+	{
+		int running = log_async;
+		unsigned requests = log_flush_requests;
+		unsigned dropped = log_dropped;
+		int64 now;
+
+		pending += log_drain();
+
+		if(dropped != reported_dropped)
+		{
+			char timestr[80];
+			char line[256];
+			log_timestamp(timestr, sizeof(timestr));
+			str_format(line, sizeof(line), "[%s][dbg/logger]: log is overloaded, dropped %u lines", timestr, dropped-reported_dropped);
+			for(i = 0; i < num_loggers; i++)
+				loggers[i](line);
+			reported_dropped = dropped;
+			pending++;
+		}
+
+		now = time_get();
+		if(pending && (requests != log_flush_done || !running || now-last_flush >= time_freq()*log_flush_interval/1000))
+		{
+			log_flush_loggers();
+			pending = 0;
+			last_flush = now;
+		}
+		log_flush_done = requests;
+
+		if(!running)
+			break;
+		thread_sleep(LOG_POLL_TIME);
+	}
+}
+
+void dbg_logger_async(int flush_interval)
+{
+	static int registered_exit = 0;
+	int i;
+
+	if(log_async)
+		return;
+
+	if(!log_ring)
+	{
+		log_ring = (LOG_SLOT *)mem_alloc(sizeof(LOG_SLOT)*LOG_RING_SIZE, 1);
+		for(i = 0; i < LOG_RING_SIZE; i++)
+			log_ring[i].sequence = i;
+		log_write_pos = 0;
+		log_read_pos = 0;
+	}
+
+	log_flush_interval = flush_interval;
+	log_async = 1;
+	atomic_barrier();
+	log_thread = thread_init(log_thread_func, 0);
+	if(!log_thread)
+	{
+		log_async = 0;
+		return;
+	}
+
+	if(!registered_exit)
+	{
+		atexit(dbg_logger_sync);
+		registered_exit = 1;
+	}
+}
+
+void dbg_logger_sync()
+{
+	int i;
+
+	if(!log_async)
+		return;
+
+	log_async = 0;
+	atomic_barrier();
+	thread_wait(log_thread);
+	thread_destroy(log_thread);
+	log_thread = 0;
+
+	/* lines that were reserved while the thread stopped, wait for the
+	   writers that are still formatting theirs to publish them */
+	for(i = 0; i < 1000; i++)
+	{
+		log_drain();
+		if(log_read_pos == log_write_pos)
+			break;
+		thread_sleep(1);
+	}
+	log_flush_loggers();
+}
+
+void dbg_logger_flush()
+{
+	unsigned request;
+	int i;
+
+	if(!log_async)
+		return;
+
+	request = atomic_add32(&log_flush_requests, 1);
+	for(i = 0; i < 1000 && log_async && (int)(log_flush_done-request) < 0; i++)
+		thread_sleep(1);
+}
+
+unsigned dbg_logger_dropped()
+{
+	return log_dropped;
+}
+
 #if defined(CONF_FAMILY_WINDOWS)
 static DWORD old_console_mode;
 
@@ -275,63 +578,294 @@ void dbg_console_cleanup()
 #endif
 /* */
 
+/* every block starts with a header right before the pointer handed out */
 typedef struct MEMHEADER
+{
+	unsigned size;
+	unsigned offset; /* from the start of the malloc'ed memory */
+	unsigned short tag;
+	unsigned short flags;
+	unsigned pad;
+} MEMHEADER;
+
+/* guarded blocks also remember where they come from, for the leak check */
+typedef struct MEMDEBUGINFO
 {
 	const char *filename;
 	int line;
-	int size;
-	struct MEMHEADER *prev;
-	struct MEMHEADER *next;
-} MEMHEADER;
+	struct MEMDEBUGINFO *prev;
+	struct MEMDEBUGINFO *next;
+} MEMDEBUGINFO;
 
 typedef struct MEMTAIL
 {
 	int guard;
 } MEMTAIL;
 
-static struct MEMHEADER *first = 0;
+typedef struct MEMCOUNTERS
+{
+	volatile int64 live_bytes;
+	volatile int64 peak_bytes;
+	volatile int64 live_blocks;
+	volatile int64 num_allocs;
+} MEMCOUNTERS;
+
+enum
+{
+	MEM_MIN_ALIGN = 16,
+	MEM_MALLOC_ALIGN = sizeof(void *)*2,
+	MEM_DEBUG_SIZE = (sizeof(MEMDEBUGINFO)+MEM_MIN_ALIGN-1)&~(MEM_MIN_ALIGN-1),
+
+	MEMFLAG_COUNTED = 1,
+	MEMFLAG_GUARDED = 2,
+};
+
 static const int MEM_GUARD_VAL = 0xbaadc0de;
+static const char *mem_tag_names[NUM_MEMTAGS] = {"general", "heap", "snapshot", "datafile", "map"};
+
+static volatile int mem_level = MEMDEBUG_OFF;
+static MEMCOUNTERS mem_counters[NUM_MEMTAGS];
+static MEMDEBUGINFO *mem_first = 0;
+static volatile int64 mem_list_lock = 0;
+
+static void mem_account(int tag, int64 size)
+{
+	MEMCOUNTERS *counters = &mem_counters[tag];
+	if(size > 0)
+	{
+		int64 live = atomic_add64(&counters->live_bytes, size);
+		int64 peak = counters->peak_bytes;
+		while(live > peak)
+		{
+			int64 prev = atomic_compswap64(&counters->peak_bytes, peak, live);
+			if(prev == peak)
+				break;
+			peak = prev;
+		}
+		atomic_add64(&counters->live_blocks, 1);
+		atomic_add64(&counters->num_allocs, 1);
+	}
+	else
+	{
+		atomic_add64(&counters->live_bytes, size);
+		atomic_add64(&counters->live_blocks, -1);
+	}
+}
+
+static void mem_list_acquire()
+{
+	while(atomic_compswap64(&mem_list_lock, 0, 1) != 0)
+	{
+	#if defined(CONF_ARCH_IA32) || defined(CONF_ARCH_AMD64)
+		_mm_pause();
+	#endif
+	}
+}
 
-void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment)
+static void mem_list_release()
 {
-	return malloc(size);
+	atomic_compswap64(&mem_list_lock, 1, 0);
+}
+
+static int mem_guard_intact(const MEMDEBUGINFO *info)
+{
+	const MEMHEADER *header = (const MEMHEADER *)((const char *)info + MEM_DEBUG_SIZE);
+	MEMTAIL tail;
+	mem_copy(&tail, (const char *)(header+1) + header->size, sizeof(tail));
+	return tail.guard == MEM_GUARD_VAL;
+}
+
+void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment, int tag)
+{
+	int level = mem_level;
+	unsigned align = MEM_MIN_ALIGN;
+	unsigned prefix = sizeof(MEMHEADER);
+	unsigned extra = 0;
+	unsigned tail = 0;
+	char *raw;
+	char *block;
+	MEMHEADER *header;
+
+	if(level == MEMDEBUG_OFF && alignment <= MEM_MALLOC_ALIGN)
+	{
+		/* the common case, just the header in front */
+		header = (MEMHEADER *)malloc(sizeof(MEMHEADER) + size);
+		if(!header)
+			return 0;
+		header->size = size;
+		header->offset = sizeof(MEMHEADER);
+		header->tag = (unsigned short)tag;
+		header->flags = 0;
+		return header+1;
+	}
+
+	while(align < alignment)
+		align <<= 1;
+	if(align > MEM_MALLOC_ALIGN)
+		extra = align - MEM_MALLOC_ALIGN;
+	if(level >= MEMDEBUG_GUARD)
+	{
+		prefix += MEM_DEBUG_SIZE;
+		tail = sizeof(MEMTAIL);
+	}
+
+	raw = (char *)malloc(prefix + extra + size + tail);
+	if(!raw)
+		return 0;
+	block = (char *)(((size_t)raw + prefix + align-1) & ~(size_t)(align-1));
+
+	header = (MEMHEADER *)block - 1;
+	header->size = size;
+	header->offset = (unsigned)(block - raw);
+	header->tag = (unsigned short)tag;
+	header->flags = 0;
+
+	if(level >= MEMDEBUG_STATS)
+	{
+		header->flags |= MEMFLAG_COUNTED;
+		mem_account(tag, size);
+	}
+
+	if(level >= MEMDEBUG_GUARD)
+	{
+		MEMDEBUGINFO *info = (MEMDEBUGINFO *)((char *)header - MEM_DEBUG_SIZE);
+		MEMTAIL guard;
+		guard.guard = MEM_GUARD_VAL;
+		mem_copy(block + size, &guard, sizeof(guard));
+
+		header->flags |= MEMFLAG_GUARDED;
+		info->filename = filename;
+		info->line = line;
+		info->prev = 0;
+		mem_list_acquire();
+		info->next = mem_first;
+		if(mem_first)
+			mem_first->prev = info;
+		mem_first = info;
+		mem_list_release();
+	}
+
+	return block;
 }
 
 void mem_free(void *p)
 {
-	free(p);
+	MEMHEADER *header;
+	if(!p)
+		return;
+
+	header = (MEMHEADER *)p - 1;
+	if(header->flags&MEMFLAG_COUNTED)
+		mem_account(header->tag, -(int64)header->size);
+	if(header->flags&MEMFLAG_GUARDED)
+	{
+		MEMDEBUGINFO *info = (MEMDEBUGINFO *)((char *)header - MEM_DEBUG_SIZE);
+		if(!mem_guard_intact(info))
+		{
+			dbg_msg("mem", "memory overrun of the block from %s(%d): %u bytes", info->filename, info->line, header->size);
+			dbg_assert(0, "memory guard overwritten");
+		}
+
+		mem_list_acquire();
+		if(info->prev)
+			info->prev->next = info->next;
+		else
+			mem_first = info->next;
+		if(info->next)
+			info->next->prev = info->prev;
+		mem_list_release();
+	}
+
+	free((char *)p - header->offset);
 }
 
-void mem_copy(void *dest, const void *source, unsigned size)
+static void mem_report_leaks()
 {
-	memcpy(dest, source, size);
+	int num = mem_print_blocks(16);
+	if(num)
+		dbg_msg("mem", "%d guarded blocks were still allocated at exit", num);
 }
 
-void mem_move(void *dest, const void *source, unsigned size)
+void mem_debug(int level)
 {
-	memmove(dest, source, size);
+	static int leak_check_registered = 0;
+	if(level >= MEMDEBUG_GUARD && !leak_check_registered)
+	{
+		atexit(mem_report_leaks);
+		leak_check_registered = 1;
+	}
+	mem_level = level;
 }
 
-void mem_zero(void *block,unsigned size)
+int mem_debug_level()
 {
-	memset(block, 0, size);
+	return mem_level;
+}
+
+const char *mem_tag_name(int tag)
+{
+	if(tag < 0 || tag >= NUM_MEMTAGS)
+		return "unknown";
+	return mem_tag_names[tag];
+}
+
+void mem_stats(int tag, MEMSTATS *stats)
+{
+	const MEMCOUNTERS *counters = &mem_counters[tag];
+	stats->live_bytes = counters->live_bytes;
+	stats->peak_bytes = counters->peak_bytes;
+	stats->live_blocks = counters->live_blocks;
+	stats->num_allocs = counters->num_allocs;
 }
 
-int mem_check_imp()
+int mem_check()
 {
-	MEMHEADER *header = first;
-	while(header)
+	int intact = 1;
+	MEMDEBUGINFO *info;
+	mem_list_acquire();
+	for(info = mem_first; info; info = info->next)
 	{
-		MEMTAIL *tail = (MEMTAIL *)(((char*)(header+1))+header->size);
-		if(tail->guard != MEM_GUARD_VAL)
+		if(!mem_guard_intact(info))
 		{
-			dbg_msg("mem", "Memory check failed at %s(%d): %d", header->filename, header->line, header->size);
-			return 0;
+			const MEMHEADER *header = (const MEMHEADER *)((const char *)info + MEM_DEBUG_SIZE);
+			dbg_msg("mem", "memory check failed at %s(%d): %u bytes", info->filename, info->line, header->size);
+			intact = 0;
 		}
-		header = header->next;
 	}
+	mem_list_release();
+	return intact;
+}
 
-	return 1;
+int mem_print_blocks(int max_blocks)
+{
+	int num = 0;
+	MEMDEBUGINFO *info;
+	mem_list_acquire();
+	for(info = mem_first; info; info = info->next, num++)
+	{
+		if(num < max_blocks)
+		{
+			const MEMHEADER *header = (const MEMHEADER *)((const char *)info + MEM_DEBUG_SIZE);
+			dbg_msg("mem", "%s(%d): %u bytes [%s]", info->filename, info->line, header->size, mem_tag_name(header->tag));
+		}
+	}
+	mem_list_release();
+	return num;
+}
+
+void mem_copy(void *dest, const void *source, unsigned size)
+{
+	memcpy(dest, source, size);
+}
+
+void mem_move(void *dest, const void *source, unsigned size)
+{
+	memmove(dest, source, size);
+}
+
+void mem_zero(void *block,unsigned size)
+{
+	memset(block, 0, size);
 }
 
 IOHANDLE io_open(const char *filename, int flags)
@@ -371,7 +905,7 @@ unsigned io_read(IOHANDLE io, void *buffer, unsigned size)
 
 void io_read_all(IOHANDLE io, void **result, unsigned *result_len)
 {
-	unsigned char *buffer = malloc(1024);
+	unsigned char *buffer = mem_alloc(1024, 1);
 	unsigned len = 0;
 	unsigned cap = 1024;
 	unsigned read;
@@ -384,15 +918,14 @@ void io_read_all(IOHANDLE io, void **result, unsigned *result_len)
 		len += read;
 		if(len == cap)
 		{
+			unsigned char *grown = mem_alloc(cap*2, 1);
+			mem_copy(grown, buffer, len);
+			mem_free(buffer);
+			buffer = grown;
 			cap *= 2;
-			buffer = realloc(buffer, cap);
 		}
 	}
-	if(len == cap)
-	{
-		buffer = realloc(buffer, cap + 1);
-	}
-	// ensure null termination
+	// there is always room for the null termination, the buffer grows when it is full
 	buffer[len] = 0;
 	*result = buffer;
 	*result_len = len;
@@ -406,7 +939,7 @@ char *io_read_all_str(IOHANDLE io)
 	io_read_all(io, &buffer, &len);
 	if(mem_has_null(buffer, len))
 	{
-		free(buffer);
+		mem_free(buffer);
 		return 0;
 	}
 	return buffer;
@@ -80,13 +80,32 @@ GNUC_ATTRIBUTE((format(printf, 2, 3)));
 
 /* Group: Memory */
 
+/*
+	Constants: Memory tags
+		MEMTAG_GENERAL - Everything that isn't tagged otherwise.
+		MEMTAG_HEAP - Chunks of <CHeap>.
+		MEMTAG_SNAPSHOT - Snapshots kept in the snapshot storage.
+		MEMTAG_DATAFILE - Datafile buffers.
+		MEMTAG_MAP - Expanded map tile data.
+*/
+enum
+{
+	MEMTAG_GENERAL=0,
+	MEMTAG_HEAP,
+	MEMTAG_SNAPSHOT,
+	MEMTAG_DATAFILE,
+	MEMTAG_MAP,
+	NUM_MEMTAGS
+};
+
 /*
 	Function: mem_alloc
 		Allocates memory.
 
 	Parameters:
 		size - Size of the needed block.
-		alignment - Alignment for the block.
+		alignment - Alignment for the block, a power of two. Blocks
+		are at least aligned like malloc aligns them.
 
 	Returns:
 		Returns a pointer to the newly allocated block. Returns a
@@ -95,21 +114,29 @@ GNUC_ATTRIBUTE((format(printf, 2, 3)));
 	Remarks:
 		- Passing 0 to size will allocated the smallest amount possible
 		and return a unique pointer.
+		- Use <mem_alloc_tagged> to account the block to a subsystem.
 
 	See Also:
-		<mem_free>
+		<mem_free>, <mem_debug>
+*/
+void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment, int tag);
+#define mem_alloc(s,a) mem_alloc_debug(__FILE__, __LINE__, (s), (a), MEMTAG_GENERAL)
+
+/*
+	Function: mem_alloc_tagged
+		Allocates memory like <mem_alloc> and accounts it to one of the
+		<Memory tags> in the statistics.
 */
-void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment);
-#define mem_alloc(s,a) mem_alloc_debug(__FILE__, __LINE__, (s), (a))
+#define mem_alloc_tagged(s,a,t) mem_alloc_debug(__FILE__, __LINE__, (s), (a), (t))
 
 /*
 	Function: mem_free
 		Frees a block allocated through <mem_alloc>.
 
 	Remarks:
-		- In the debug version of the library the function will assert if
-		a non-valid block is passed, like a null pointer or a block that
-		isn't allocated.
+		- Passing a null pointer does nothing.
+		- Blocks allocated while guards are on assert when they were
+		written past their end.
 
 	See Also:
 		<mem_alloc>
@@ -1603,6 +1630,106 @@ void dbg_logger_debugger();
 void dbg_logger_file(const char *filename);
 void dbg_logger_filehandle(IOHANDLE handle);
 
+/*
+	Function: dbg_logger_async
+		Moves the loggers to a background thread. <dbg_msg> then only
+		formats the line into a lock-free ring and the thread writes the
+		lines in batches.
+
+	Parameters:
+		flush_interval - Time in milliseconds after which written lines
+			are flushed at the latest.
+
+	Remarks:
+		Lines are cut at 1024 characters. When the ring is full, lines
+		are dropped and counted, see <dbg_logger_dropped>. Failed
+		assertions flush the log before they break.
+*/
+void dbg_logger_async(int flush_interval);
+
+/*
+	Function: dbg_logger_sync
+		Writes the pending lines and stops the background thread of
+		<dbg_logger_async>. Also runs at exit.
+*/
+void dbg_logger_sync();
+
+/*
+	Function: dbg_logger_flush
+		Waits until the lines logged so far are written and flushed.
+*/
+void dbg_logger_flush();
+
+/*
+	Function: dbg_logger_dropped
+		Returns the number of lines the async logger had to drop.
+*/
+unsigned dbg_logger_dropped();
+
+/* Group: Memory statistics */
+/*
+	Constants: Memory debug levels
+		MEMDEBUG_OFF - Nothing is tracked, the allocator is a thin layer over malloc.
+		MEMDEBUG_STATS - Live and peak bytes are counted per memory tag.
+		MEMDEBUG_GUARD - Blocks additionally get a guard after their end and
+		are listed, so overruns and leaks can be found.
+*/
+enum
+{
+	MEMDEBUG_OFF=0,
+	MEMDEBUG_STATS,
+	MEMDEBUG_GUARD
+};
+
+typedef struct
+{
+	int64 live_bytes;
+	int64 peak_bytes;
+	int64 live_blocks;
+	int64 num_allocs;
+} MEMSTATS;
+
+/*
+	Function: mem_debug
+		Sets what the allocator keeps track of, see <Memory debug levels>.
+
+	Remarks:
+		- Only blocks allocated while a level is on are covered by it,
+		so set it as early as possible.
+		- With guards on, the blocks that are still allocated at exit
+		are printed.
+*/
+void mem_debug(int level);
+int mem_debug_level();
+
+/*
+	Function: mem_stats
+		Fetches the statistics of a memory tag.
+*/
+void mem_stats(int tag, MEMSTATS *stats);
+const char *mem_tag_name(int tag);
+
+/*
+	Function: mem_check
+		Checks the guards of all guarded blocks.
+
+	Returns:
+		0 if a block was written past its end, 1 otherwise.
+*/
+int mem_check();
+
+/*
+	Function: mem_print_blocks
+		Prints the guarded blocks that are still allocated.
+
+	Parameters:
+		max_blocks - Number of blocks to print at most.
+
+	Returns:
+		The number of guarded blocks that are allocated.
+*/
+int mem_print_blocks(int max_blocks);
+
 #if defined(CONF_FAMILY_WINDOWS)
 void dbg_console_init();
 void dbg_console_cleanup();
@@ -0,0 +1,96 @@
+#include "map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+
+class CCollisionFixture : public benchmark::Fixture
+{
+public:
+	CBenchmarkMap *m_pMap;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	void SetUp(const benchmark::State &State)
+	{
+		m_pMap = new CBenchmarkMap;
+		m_Layers.Init(0, m_pMap);
+		m_Collision.Init(&m_Layers);
+	}
+
+	void TearDown(const benchmark::State &State)
+	{
+		delete m_pMap;
+	}
+};
+
+BENCHMARK_F(CCollisionFixture, IntersectLine)(benchmark::State &State)
+{
+	const float Width = CBenchmarkMap::WIDTH*32.0f;
+	const float Height = CBenchmarkMap::HEIGHT*32.0f;
+	int i = 0;
+	for(auto _ : State)
+	{
+		// lines of laser length in all directions across the map
+		vec2 From((i*97)%(int)Width, (i*61)%(int)Height);
+		vec2 To = From+direction(i*0.1f)*800.0f;
+		vec2 Col, BeforeCol;
+		benchmark::DoNotOptimize(m_Collision.IntersectLine(From, To, &Col, &BeforeCol));
+		i++;
+	}
+}
+
+BENCHMARK_F(CCollisionFixture, MoveBox)(benchmark::State &State)
+{
+	int i = 0;
+	for(auto _ : State)
+	{
+		vec2 Pos(64.0f+(i*37)%7000, 64.0f+(i*23)%3000);
+		vec2 Vel = direction(i*0.3f)*(5.0f+(i%20));
+		m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), 0.0f);
+		benchmark::DoNotOptimize(Pos);
+		i++;
+	}
+}
+
+// a full world of 64 characters running, jumping and hooking, ticked like CGameWorld does
+BENCHMARK_F(CCollisionFixture, CharacterCoreTick64)(benchmark::State &State)
+{
+	CWorldCore World;
+	CCharacterCore aCores[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		aCores[i].Init(&World, &m_Collision);
+		aCores[i].Reset();
+		aCores[i].m_Pos = vec2(64.0f+(i%32)*220.0f, 200.0f+(i/32)*1500.0f);
+		World.m_apCharacters[i] = &aCores[i];
+	}
+
+	int Tick = 0;
+	for(auto _ : State)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			CNetObj_PlayerInput *pInput = &aCores[i].m_Input;
+			pInput->m_Direction = ((Tick+i*7)/50)%3-1;
+			pInput->m_Jump = ((Tick+i)%40) < 2;
+			pInput->m_Hook = ((Tick+i*3)%100) < 60;
+			pInput->m_TargetX = (int)(cosf(Tick*0.02f+i)*200.0f);
+			pInput->m_TargetY = (int)(sinf(Tick*0.02f+i)*200.0f);
+		}
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			aCores[i].Tick(true);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			aCores[i].AddDragVelocity();
+			aCores[i].ResetDragVelocity();
+			aCores[i].Move();
+			aCores[i].Quantize();
+		}
+		Tick++;
+	}
+	State.SetItemsProcessed(State.iterations()*MAX_CLIENTS);
+}
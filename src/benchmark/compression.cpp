@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/huffman.h>
+
+// ints shaped like a snapshot delta: mostly small values, some large ones
+static void FillDeltaInts(int *pData, int Num)
+{
+	unsigned Seed = 1234;
+	for(int i = 0; i < Num; i++)
+	{
+		Seed = Seed*1103515245+12345;
+		int Value = (Seed>>16)&0xff;
+		pData[i] = (i%7) == 0 ? (int)(Seed>>8) : Value-128;
+	}
+}
+
+static void BM_VariableIntCompress(benchmark::State &State)
+{
+	int Num = State.range(0);
+	int *pData = new int[Num];
+	unsigned char *pCompressed = new unsigned char[Num*5];
+	FillDeltaInts(pData, Num);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(CVariableInt::Compress(pData, Num*sizeof(int), pCompressed, Num*5));
+	State.SetBytesProcessed(State.iterations()*Num*sizeof(int));
+	delete[] pCompressed;
+	delete[] pData;
+}
+BENCHMARK(BM_VariableIntCompress)->Arg(64)->Arg(1024)->Arg(16*1024);
+
+static void BM_VariableIntDecompress(benchmark::State &State)
+{
+	int Num = State.range(0);
+	int *pData = new int[Num];
+	unsigned char *pCompressed = new unsigned char[Num*5];
+	FillDeltaInts(pData, Num);
+	int Size = CVariableInt::Compress(pData, Num*sizeof(int), pCompressed, Num*5);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(CVariableInt::Decompress(pCompressed, Size, pData, Num*sizeof(int)));
+	State.SetBytesProcessed(State.iterations()*Num*sizeof(int));
+	delete[] pCompressed;
+	delete[] pData;
+}
+BENCHMARK(BM_VariableIntDecompress)->Arg(64)->Arg(1024)->Arg(16*1024);
+
+static void BM_HuffmanCompress(benchmark::State &State)
+{
+	static CHuffman s_Huffman;
+	s_Huffman.Init();
+	int Num = State.range(0);
+	int *pData = new int[Num/4];
+	unsigned char *pPacked = new unsigned char[Num];
+	unsigned char *pCompressed = new unsigned char[Num*2];
+	FillDeltaInts(pData, Num/4);
+	int Size = CVariableInt::Compress(pData, Num/4*sizeof(int), pPacked, Num);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(s_Huffman.Compress(pPacked, Size, pCompressed, Num*2));
+	State.SetBytesProcessed(State.iterations()*Size);
+	delete[] pCompressed;
+	delete[] pPacked;
+	delete[] pData;
+}
+BENCHMARK(BM_HuffmanCompress)->Arg(256)->Arg(1400);
+
+static void BM_HuffmanDecompress(benchmark::State &State)
+{
+	static CHuffman s_Huffman;
+	s_Huffman.Init();
+	int Num = State.range(0);
+	int *pData = new int[Num/4];
+	unsigned char *pPacked = new unsigned char[Num];
+	unsigned char *pCompressed = new unsigned char[Num*2];
+	FillDeltaInts(pData, Num/4);
+	int Size = CVariableInt::Compress(pData, Num/4*sizeof(int), pPacked, Num);
+	int CompressedSize = s_Huffman.Compress(pPacked, Size, pCompressed, Num*2);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(s_Huffman.Decompress(pCompressed, CompressedSize, pPacked, Num));
+	State.SetBytesProcessed(State.iterations()*Size);
+	delete[] pCompressed;
+	delete[] pPacked;
+	delete[] pData;
+}
+BENCHMARK(BM_HuffmanDecompress)->Arg(256)->Arg(1400);
@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+
+// a console with all the config variables of the server registered
+struct CConsoleSetup
+{
+	IKernel *m_pKernel;
+	IStorage *m_pStorage;
+	IConfigManager *m_pConfigManager;
+	IConsole *m_pConsole;
+
+	CConsoleSetup()
+	{
+		m_pKernel = IKernel::Create();
+		m_pStorage = CreateTestStorage();
+		m_pConfigManager = CreateConfigManager();
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pKernel->RegisterInterface(m_pStorage);
+		m_pKernel->RegisterInterface(m_pConfigManager);
+		m_pKernel->RegisterInterface(m_pConsole);
+		m_pConfigManager->Init(CFGFLAG_SERVER);
+		m_pConsole->Init();
+		m_pConsole->StoreCommands(false);
+	}
+
+	~CConsoleSetup()
+	{
+		delete m_pConsole;
+		delete m_pConfigManager;
+		delete m_pStorage;
+		delete m_pKernel;
+	}
+};
+
+static const char *s_apSettings[] = {
+	"sv_name",
+	"sv_port",
+	"sv_max_clients",
+	"sv_rcon_max_tries",
+	"sv_spamprotection",
+	"sv_vote_kick_bantime",
+	"sv_snap_idle_interval",
+	"sv_motd",
+	"password",
+	"sv_high_bandwidth",
+	"sv_warmup",
+};
+
+// a big generated config, almost every line differs
+static void BM_ConsoleExecuteConfig(benchmark::State &State)
+{
+	CConsoleSetup Setup;
+	const char *pFilename = "benchmark_console.cfg";
+	IOHANDLE File = Setup.m_pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	const int NumSettings = sizeof(s_apSettings)/sizeof(s_apSettings[0]);
+	char aLine[128];
+	for(int i = 0; i < 10000; i++)
+	{
+		if(i%12 == 11)
+			str_format(aLine, sizeof(aLine), "sv_warmup %d; sv_timelimit %d", i%64, i%32);
+		else
+			str_format(aLine, sizeof(aLine), "%s %d", s_apSettings[i%NumSettings], i%64);
+		io_write(File, aLine, str_length(aLine));
+		io_write_newline(File);
+	}
+	io_close(File);
+
+	for(auto _ : State)
+		Setup.m_pConsole->ExecuteFile(pFilename);
+	State.SetItemsProcessed(State.iterations()*10000);
+
+	Setup.m_pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+}
+BENCHMARK(BM_ConsoleExecuteConfig);
+
+// the same lines again and again, like vote commands
+static void BM_ConsoleExecuteRepeated(benchmark::State &State)
+{
+	CConsoleSetup Setup;
+	for(auto _ : State)
+	{
+		Setup.m_pConsole->ExecuteLine("sv_warmup 10; sv_timelimit 20");
+		Setup.m_pConsole->ExecuteLine("sv_spamprotection 1");
+	}
+	State.SetItemsProcessed(State.iterations()*3);
+}
+BENCHMARK(BM_ConsoleExecuteRepeated);
@@ -0,0 +1,128 @@
+#include "map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/server.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/snapshot.h>
+#include <game/server/entities/projectile.h>
+#include <game/server/gamecontext.h>
+
+// just enough of a server for the game world: ticks and snapshot ids
+class CBenchmarkServer : public IServer
+{
+	CSnapIDPool m_IDPool;
+
+public:
+	CBenchmarkServer() { m_CurrentGameTick = 0; m_TickSpeed = SERVER_TICK_SPEED; m_Instance = 0; }
+	void NextTick() { m_CurrentGameTick++; }
+
+	virtual const char *ClientName(int ClientID) const { return ""; }
+	virtual const char *ClientClan(int ClientID) const { return ""; }
+	virtual int ClientCountry(int ClientID) const { return -1; }
+	virtual bool ClientIngame(int ClientID) const { return false; }
+	virtual int GetClientInfo(int ClientID, CClientInfo *pInfo) const { return 0; }
+	virtual void GetClientAddr(int ClientID, char *pAddrStr, int Size) const { pAddrStr[0] = 0; }
+	virtual int GetClientVersion(int ClientID) const { return 0; }
+	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) { return 0; }
+	virtual void SetClientName(int ClientID, char const *pName) {}
+	virtual void SetClientClan(int ClientID, char const *pClan) {}
+	virtual void SetClientCountry(int ClientID, int Country) {}
+	virtual void SetClientScore(int ClientID, int Score) {}
+	virtual int SnapNewID() { return m_IDPool.NewID(Tick()); }
+	virtual void SnapFreeID(int ID) { m_IDPool.FreeID(ID, Tick()); }
+	virtual void *SnapNewItem(int Type, int ID, int Size) { return 0; }
+	virtual void SnapSetStaticsize(int ItemType, int Size) {}
+	virtual int MaxSnapshotDelay() { return 0; }
+	virtual void SetRconCID(int ClientID) {}
+	virtual bool IsAuthed(int ClientID) const { return false; }
+	virtual bool IsBanned(int ClientID) { return false; }
+	virtual void Kick(int ClientID, const char *pReason) {}
+	virtual void ChangeMap(const char *pMap) {}
+	virtual void DemoRecorder_HandleAutoStart() {}
+	virtual bool DemoRecorder_IsRecording() { return false; }
+};
+
+// a game context on the benchmark map with a spectating dummy
+struct CGameSetup
+{
+	IKernel *m_pKernel;
+	IStorage *m_pStorage;
+	IConfigManager *m_pConfigManager;
+	IConsole *m_pConsole;
+	CBenchmarkMap *m_pMap;
+	CBenchmarkServer *m_pServer;
+	IGameServer *m_pGameServer;
+
+	CGameSetup()
+	{
+		m_pKernel = IKernel::Create();
+		m_pStorage = CreateTestStorage();
+		m_pConfigManager = CreateConfigManager();
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pMap = new CBenchmarkMap;
+		m_pServer = new CBenchmarkServer;
+		m_pGameServer = CreateGameServer();
+		m_pKernel->RegisterInterface(m_pStorage);
+		m_pKernel->RegisterInterface(m_pConfigManager);
+		m_pKernel->RegisterInterface(m_pConsole);
+		m_pKernel->RegisterInterface(static_cast<IMap *>(m_pMap));
+		m_pKernel->RegisterInterface(static_cast<IServer *>(m_pServer));
+		m_pKernel->RegisterInterface(m_pGameServer);
+		m_pConfigManager->Init(CFGFLAG_SERVER);
+		m_pConsole->Init();
+		m_pGameServer->OnConsoleInit();
+		m_pGameServer->OnInit();
+
+		// the projectiles need an owner
+		GameServer()->OnClientConnected(0, true, true);
+	}
+
+	~CGameSetup()
+	{
+		m_pGameServer->OnShutdown();
+		delete m_pGameServer;
+		delete m_pServer;
+		delete m_pMap;
+		delete m_pConsole;
+		delete m_pConfigManager;
+		delete m_pStorage;
+		delete m_pKernel;
+	}
+
+	CGameContext *GameServer() { return (CGameContext *)m_pGameServer; }
+};
+
+// grenade spam: every tick CHURN grenades are fired across the map, they explode
+// against the platforms or at the end of their life. the life is set so that about
+// the given number are in the air, the world ticks like the one of the server
+static void BM_WorldProjectileChurn(benchmark::State &State)
+{
+	const int CHURN = 32;
+	const int NumLive = State.range(0);
+	CGameSetup Setup;
+	CGameWorld *pWorld = &Setup.GameServer()->m_World;
+
+	unsigned Seed = 1;
+	for(auto _ : State)
+	{
+		Setup.m_pServer->NextTick();
+		for(int c = 0; c < CHURN; c++)
+		{
+			Seed = Seed*1103515245+12345;
+			vec2 Pos(64.0f+(Seed>>8)%((CBenchmarkMap::WIDTH-4)*32), 64.0f+(Seed>>4)%((CBenchmarkMap::HEIGHT-4)*32));
+			vec2 Dir = direction((Seed>>16)%628/100.0f);
+			new(pWorld) CProjectile(pWorld, WEAPON_GRENADE, 0, Pos, Dir, NumLive/CHURN,
+				1, true, 0, SOUND_GRENADE_EXPLODE, WEAPON_GRENADE);
+		}
+		pWorld->Tick();
+		Setup.GameServer()->OnPostSnap();
+	}
+	State.SetItemsProcessed(State.iterations()*CHURN);
+}
+BENCHMARK(BM_WorldProjectileChurn)->Arg(256)->Arg(2048);
@@ -0,0 +1,65 @@
+#include "map.h"
+
+#include <base/system.h>
+
+CBenchmarkMap::CBenchmarkMap()
+{
+	mem_zero(&m_Group, sizeof(m_Group));
+	m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+	m_Group.m_ParallaxX = 100;
+	m_Group.m_ParallaxY = 100;
+	m_Group.m_StartLayer = 0;
+	m_Group.m_NumLayers = 1;
+
+	mem_zero(&m_Layer, sizeof(m_Layer));
+	m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+	m_Layer.m_Version = CMapItemLayerTilemap::CURRENT_VERSION;
+	m_Layer.m_Width = WIDTH;
+	m_Layer.m_Height = HEIGHT;
+	m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+	m_Layer.m_Data = 0;
+
+	m_pTiles = (CTile *)mem_alloc(WIDTH*HEIGHT*sizeof(CTile), 1);
+	mem_zero(m_pTiles, WIDTH*HEIGHT*sizeof(CTile));
+	for(int y = 0; y < HEIGHT; y++)
+	{
+		for(int x = 0; x < WIDTH; x++)
+		{
+			bool Border = x == 0 || y == 0 || x == WIDTH-1 || y == HEIGHT-1;
+			bool Platform = (y%12) == 11 && ((x/8)%3) != 0;
+			bool Pillar = (x%40) == 20 && (y%30) > 15;
+			if(Border || Platform || Pillar)
+				m_pTiles[y*WIDTH+x].m_Index = (x+y)%17 == 0 ? TILE_NOHOOK : TILE_SOLID;
+		}
+	}
+}
+
+CBenchmarkMap::~CBenchmarkMap()
+{
+	mem_free(m_pTiles);
+}
+
+void *CBenchmarkMap::GetItem(int Index, int *pType, int *pID)
+{
+	if(pID)
+		*pID = 0;
+	if(Index == 0)
+	{
+		if(pType)
+			*pType = MAPITEMTYPE_GROUP;
+		return &m_Group;
+	}
+	if(Index == 1)
+	{
+		if(pType)
+			*pType = MAPITEMTYPE_LAYER;
+		return &m_Layer;
+	}
+	return 0;
+}
+
+void CBenchmarkMap::GetType(int Type, int *pStart, int *pNum)
+{
+	*pStart = Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	*pNum = (Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER) ? 1 : 0;
+}
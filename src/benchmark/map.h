@@ -0,0 +1,34 @@
+#ifndef BENCHMARK_MAP_H
+#define BENCHMARK_MAP_H
+
+#include <engine/map.h>
+#include <game/mapitems.h>
+
+// in memory map with a single game layer: solid borders and a fixed pattern
+// of platforms, so collision benchmarks don't depend on map files
+class CBenchmarkMap : public IMap
+{
+	CMapItemGroup m_Group;
+	CMapItemLayerTilemap m_Layer;
+	CTile *m_pTiles;
+
+public:
+	enum
+	{
+		WIDTH=256,
+		HEIGHT=128,
+	};
+
+	CBenchmarkMap();
+	~CBenchmarkMap();
+
+	virtual void *GetData(int Index) { return Index == 0 ? m_pTiles : 0; }
+	virtual void *GetDataSwapped(int Index) { return GetData(Index); }
+	virtual void UnloadData(int Index) {}
+	virtual void *GetItem(int Index, int *pType, int *pID);
+	virtual void GetType(int Type, int *pStart, int *pNum);
+	virtual void *FindItem(int Type, int ID) { return 0; }
+	virtual int NumItems() { return 2; }
+};
+
+#endif // BENCHMARK_MAP_H
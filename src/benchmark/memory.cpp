@@ -0,0 +1,49 @@
+#include <stdlib.h>
+
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+
+// the sizes of small to medium engine allocations, allocated and first written
+// in batches like a map load does
+static const unsigned s_aSizes[] = {16, 64, 200, 1000, 4096, 24, 512, 2048};
+enum { NUM_SIZES = sizeof(s_aSizes)/sizeof(s_aSizes[0]), BATCH = 64 };
+
+static void BM_Malloc(benchmark::State &State)
+{
+	void *apBlocks[BATCH];
+	for(auto _ : State)
+	{
+		for(int i = 0; i < BATCH; i++)
+		{
+			apBlocks[i] = malloc(s_aSizes[i%NUM_SIZES]);
+			*(char *)apBlocks[i] = 0;
+		}
+		benchmark::DoNotOptimize(apBlocks);
+		for(int i = 0; i < BATCH; i++)
+			free(apBlocks[i]);
+	}
+	State.SetItemsProcessed(State.iterations()*BATCH);
+}
+BENCHMARK(BM_Malloc);
+
+// the argument is the memory debug level
+static void BM_MemAlloc(benchmark::State &State)
+{
+	mem_debug(State.range(0));
+	void *apBlocks[BATCH];
+	for(auto _ : State)
+	{
+		for(int i = 0; i < BATCH; i++)
+		{
+			apBlocks[i] = mem_alloc_tagged(s_aSizes[i%NUM_SIZES], 1, MEMTAG_HEAP);
+			*(char *)apBlocks[i] = 0;
+		}
+		benchmark::DoNotOptimize(apBlocks);
+		for(int i = 0; i < BATCH; i++)
+			mem_free(apBlocks[i]);
+	}
+	mem_debug(MEMDEBUG_OFF);
+	State.SetItemsProcessed(State.iterations()*BATCH);
+}
+BENCHMARK(BM_MemAlloc)->Arg(MEMDEBUG_OFF)->Arg(MEMDEBUG_STATS)->Arg(MEMDEBUG_GUARD);
@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/client/mixer.h>
+
+// a busy fight: every voice in use, some of them out of hearing range
+static void BM_MixerMix(benchmark::State &State)
+{
+	const int NumSamples = 8;
+	const int NumFrames = 48000;
+	CMixerSample aSamples[NumSamples];
+	for(int s = 0; s < NumSamples; s++)
+	{
+		aSamples[s].m_Channels = 1 + s%2;
+		aSamples[s].m_NumFrames = NumFrames;
+		aSamples[s].m_PausedAt = 0;
+		aSamples[s].m_pData = (short *)mem_alloc(NumFrames*aSamples[s].m_Channels*sizeof(short), 1);
+		for(int i = 0; i < NumFrames*aSamples[s].m_Channels; i++)
+			aSamples[s].m_pData[i] = (short)((i*(s+3)*97)%20000-10000);
+	}
+
+	const int Frames = 512;
+	CMixer Mixer;
+	Mixer.Init(Frames);
+	Mixer.SetMaxDistance(1500.0f);
+	for(int v = 0; v < CMixer::MAX_VOICES; v++)
+		Mixer.Play(v%CMixer::MAX_CHANNELS, &aSamples[v%NumSamples], CMixer::FLAG_LOOP|CMixer::FLAG_POS, (v-32)*State.range(0), v*13);
+
+	short aOut[Frames*2];
+	for(auto _ : State)
+	{
+		Mixer.Mix(aOut, Frames);
+		benchmark::DoNotOptimize(aOut);
+	}
+	State.SetItemsProcessed(State.iterations()*Frames);
+
+	Mixer.StopAll();
+	Mixer.Mix(aOut, Frames);
+	for(int s = 0; s < NumSamples; s++)
+		mem_free(aSamples[s].m_pData);
+}
+BENCHMARK(BM_MixerMix)->Arg(20)->Arg(80);
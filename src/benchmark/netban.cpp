@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+static NETADDR MakeAddr(int a, int b, int c, int d)
+{
+	NETADDR Addr;
+	mem_zero(&Addr, sizeof(Addr));
+	Addr.type = NETTYPE_IPV4;
+	Addr.ip[0] = a;
+	Addr.ip[1] = b;
+	Addr.ip[2] = c;
+	Addr.ip[3] = d;
+	Addr.port = 8303;
+	return Addr;
+}
+
+// a full ban list: single addresses spread over many subnets and some wide ranges
+static void BM_NetBanIsBanned(benchmark::State &State)
+{
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan *pNetBan = new CNetBan;
+	pNetBan->Init(pConsole, 0);
+
+	for(int i = 0; i < 1000; i++)
+	{
+		NETADDR Addr = MakeAddr(10+i%50, (i*7)&0xff, (i*13)&0xff, (i*31)&0xff);
+		pNetBan->BanAddr(&Addr, 600, "benchmark");
+	}
+	for(int i = 0; i < 200; i++)
+	{
+		CNetRange Range;
+		Range.m_LB = MakeAddr(100+i%20, i&0xff, 0, 0);
+		Range.m_UB = MakeAddr(100+i%20, i&0xff, 255, 255);
+		pNetBan->BanRange(&Range, 600, "benchmark");
+	}
+
+	char aBuf[256];
+	int LastInfoQuery = 0;
+	int i = 0;
+	for(auto _ : State)
+	{
+		// mostly clean addresses, like the connection attempts of a normal server
+		NETADDR Addr = MakeAddr((i*11)&0xff, (i*7)&0xff, (i*3)&0xff, i&0xff);
+		benchmark::DoNotOptimize(pNetBan->IsBanned(&Addr, aBuf, sizeof(aBuf), &LastInfoQuery));
+		i++;
+	}
+
+	delete pNetBan;
+	delete pConsole;
+}
+BENCHMARK(BM_NetBanIsBanned);
+
+// reloading a shared banlist, replayed as console commands or read as binary file
+static void FillBanList(CNetBan *pNetBan)
+{
+	for(int i = 0; i < 1000; i++)
+	{
+		NETADDR Addr = MakeAddr(10+i%50, (i*7)&0xff, (i*13)&0xff, (i*31)&0xff);
+		pNetBan->BanAddr(&Addr, 600, "benchmark");
+	}
+}
+
+static void BM_NetBanReloadConsole(benchmark::State &State)
+{
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan *pNetBan = new CNetBan;
+	pNetBan->Init(pConsole, 0);
+
+	char aaLines[1000][64];
+	for(int i = 0; i < 1000; i++)
+		str_format(aaLines[i], sizeof(aaLines[i]), "ban %d.%d.%d.%d 10 benchmark", 10+i%50, (i*7)&0xff, (i*13)&0xff, (i*31)&0xff);
+
+	for(auto _ : State)
+	{
+		pNetBan->UnbanAll();
+		for(int i = 0; i < 1000; i++)
+			pConsole->ExecuteLine(aaLines[i]);
+	}
+	State.SetItemsProcessed(State.iterations()*1000);
+
+	delete pNetBan;
+	delete pConsole;
+}
+BENCHMARK(BM_NetBanReloadConsole);
+
+static void BM_NetBanReloadBinary(benchmark::State &State)
+{
+	IStorage *pStorage = CreateTestStorage();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan *pNetBan = new CNetBan;
+	pNetBan->Init(pConsole, pStorage);
+	FillBanList(pNetBan);
+	pNetBan->SaveBans("benchmark_bans.bin");
+
+	for(auto _ : State)
+		pNetBan->LoadBans("benchmark_bans.bin");
+	State.SetItemsProcessed(State.iterations()*1000);
+
+	pStorage->RemoveFile("benchmark_bans.bin", IStorage::TYPE_SAVE);
+	delete pNetBan;
+	delete pConsole;
+	delete pStorage;
+}
+BENCHMARK(BM_NetBanReloadBinary);
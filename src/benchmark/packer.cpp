@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/shared/packer.h>
+
+// a typical game message: some ints and a chat line
+static void BM_PackerAddIntString(benchmark::State &State)
+{
+	CPacker Packer;
+	for(auto _ : State)
+	{
+		Packer.Reset();
+		for(int i = 0; i < 32; i++)
+			Packer.AddInt(i*i-100);
+		Packer.AddString("the quick brown fox jumps over the lazy tee", 0);
+		benchmark::DoNotOptimize(Packer.Data());
+	}
+	State.SetItemsProcessed(State.iterations()*33);
+}
+BENCHMARK(BM_PackerAddIntString);
+
+static void BM_UnpackerGetIntString(benchmark::State &State)
+{
+	CPacker Packer;
+	Packer.Reset();
+	for(int i = 0; i < 32; i++)
+		Packer.AddInt(i*i-100);
+	Packer.AddString("the quick brown fox jumps over the lazy tee", 0);
+
+	CUnpacker Unpacker;
+	for(auto _ : State)
+	{
+		Unpacker.Reset(Packer.Data(), Packer.Size());
+		int Sum = 0;
+		for(int i = 0; i < 32; i++)
+			Sum += Unpacker.GetInt();
+		benchmark::DoNotOptimize(Sum);
+		benchmark::DoNotOptimize(Unpacker.GetString());
+	}
+	State.SetItemsProcessed(State.iterations()*33);
+}
+BENCHMARK(BM_UnpackerGetIntString);
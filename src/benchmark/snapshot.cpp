@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+#include <generated/protocol.h>
+
+// a busy 64 player game: characters, player infos and some projectiles
+static int BuildGameSnapshot(CSnapshotBuilder *pBuilder, void *pData, int Tick)
+{
+	pBuilder->Init();
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CNetObj_Character *pChar = (CNetObj_Character *)pBuilder->NewItem(NETOBJTYPE_CHARACTER, i, sizeof(CNetObj_Character));
+		mem_zero(pChar, sizeof(*pChar));
+		pChar->m_Tick = Tick;
+		pChar->m_X = 1000+i*64+(Tick*(i%5))%300;
+		pChar->m_Y = 2000+(i%8)*32;
+		pChar->m_VelX = (i%3)*256-256;
+		pChar->m_Angle = (Tick*7+i*13)%628;
+		pChar->m_Direction = (i%3)-1;
+		pChar->m_HookedPlayer = -1;
+		pChar->m_Health = 10;
+		pChar->m_Armor = i%10;
+		pChar->m_AmmoCount = 10;
+		pChar->m_Weapon = i%5;
+
+		CNetObj_PlayerInfo *pInfo = (CNetObj_PlayerInfo *)pBuilder->NewItem(NETOBJTYPE_PLAYERINFO, i, sizeof(CNetObj_PlayerInfo));
+		pInfo->m_PlayerFlags = 0;
+		pInfo->m_Score = i;
+		pInfo->m_Latency = 20+i;
+	}
+	for(int i = 0; i < 32; i++)
+	{
+		CNetObj_Projectile *pProj = (CNetObj_Projectile *)pBuilder->NewItem(NETOBJTYPE_PROJECTILE, 100+i+(Tick/50)*8, sizeof(CNetObj_Projectile));
+		pProj->m_X = 500+i*40;
+		pProj->m_Y = 700;
+		pProj->m_VelX = 1200;
+		pProj->m_VelY = -300;
+		pProj->m_Type = i%4;
+		pProj->m_StartTick = Tick-(i%10);
+	}
+	return pBuilder->Finish(pData);
+}
+
+static CSnapshotDelta *CreateDelta()
+{
+	CSnapshotDelta *pDelta = new CSnapshotDelta;
+	pDelta->SetStaticsize(NETOBJTYPE_CHARACTER, sizeof(CNetObj_Character));
+	pDelta->SetStaticsize(NETOBJTYPE_PLAYERINFO, sizeof(CNetObj_PlayerInfo));
+	pDelta->SetStaticsize(NETOBJTYPE_PROJECTILE, sizeof(CNetObj_Projectile));
+	return pDelta;
+}
+
+static void BM_SnapshotBuilderFinish(benchmark::State &State)
+{
+	CSnapshotBuilder *pBuilder = new CSnapshotBuilder;
+	static char s_aData[CSnapshot::MAX_SIZE];
+	int Tick = 0;
+	for(auto _ : State)
+		benchmark::DoNotOptimize(BuildGameSnapshot(pBuilder, s_aData, Tick++));
+	delete pBuilder;
+}
+BENCHMARK(BM_SnapshotBuilderFinish);
+
+static void BM_SnapshotCreateDelta(benchmark::State &State)
+{
+	CSnapshotBuilder *pBuilder = new CSnapshotBuilder;
+	CSnapshotDelta *pDelta = CreateDelta();
+	static char s_aFrom[CSnapshot::MAX_SIZE];
+	static char s_aTo[CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	BuildGameSnapshot(pBuilder, s_aFrom, 100);
+	BuildGameSnapshot(pBuilder, s_aTo, 102);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(pDelta->CreateDelta((CSnapshot *)s_aFrom, (CSnapshot *)s_aTo, s_aDelta));
+	delete pDelta;
+	delete pBuilder;
+}
+BENCHMARK(BM_SnapshotCreateDelta);
+
+static void BM_SnapshotUnpackDelta(benchmark::State &State)
+{
+	CSnapshotBuilder *pBuilder = new CSnapshotBuilder;
+	CSnapshotDelta *pDelta = CreateDelta();
+	static char s_aFrom[CSnapshot::MAX_SIZE];
+	static char s_aTo[CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	BuildGameSnapshot(pBuilder, s_aFrom, 100);
+	BuildGameSnapshot(pBuilder, s_aTo, 102);
+	int DeltaSize = pDelta->CreateDelta((CSnapshot *)s_aFrom, (CSnapshot *)s_aTo, s_aDelta);
+	for(auto _ : State)
+		benchmark::DoNotOptimize(pDelta->UnpackDelta((CSnapshot *)s_aFrom, (CSnapshot *)s_aTo, s_aDelta, DeltaSize));
+	delete pDelta;
+	delete pBuilder;
+}
+BENCHMARK(BM_SnapshotUnpackDelta);
@@ -0,0 +1,152 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include "backend_null.h"
+
+CGraphicsBackend_Null::CGraphicsBackend_Null()
+{
+	mem_zero(&m_Stats, sizeof(m_Stats));
+	m_Fence = 0;
+	mem_zero(m_aTextureMemory, sizeof(m_aTextureMemory));
+	m_TextureMemoryUsage = 0;
+}
+
+int CGraphicsBackend_Null::Init(const char *pName, int *pScreen, int *pWindowWidth, int *pWindowHeight, int *pScreenWidth, int *pScreenHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight)
+{
+	*pScreen = 0;
+	GetDesktopResolution(0, pDesktopWidth, pDesktopHeight);
+	if(*pWindowWidth == 0 || *pWindowHeight == 0)
+	{
+		*pWindowWidth = *pDesktopWidth;
+		*pWindowHeight = *pDesktopHeight;
+	}
+	*pScreenWidth = *pWindowWidth;
+	*pScreenHeight = *pWindowHeight;
+
+	dbg_msg("gfx", "using the null backend, nothing will be rendered");
+	return 0;
+}
+
+int CGraphicsBackend_Null::Shutdown()
+{
+	dbg_msg("gfx", "null backend: %lld frames, %lld commands, %lld vertices, %lld texture uploads (%lld bytes), %lld buffer uploads (%lld bytes)",
+		m_Stats.m_NumFrames, m_Stats.m_NumCommands, m_Stats.m_NumVertices,
+		m_Stats.m_NumTextureUploads, m_Stats.m_TextureUploadBytes, m_Stats.m_NumBufferUploads, m_Stats.m_BufferUploadBytes);
+	return 0;
+}
+
+int CGraphicsBackend_Null::GetVideoModes(CVideoMode *pModes, int MaxModes, int Screen)
+{
+	if(MaxModes < 1)
+		return 0;
+	pModes[0].m_Width = SCREEN_WIDTH;
+	pModes[0].m_Height = SCREEN_HEIGHT;
+	return 1;
+}
+
+bool CGraphicsBackend_Null::GetDesktopResolution(int Index, int *pDesktopWidth, int* pDesktopHeight)
+{
+	*pDesktopWidth = SCREEN_WIDTH;
+	*pDesktopHeight = SCREEN_HEIGHT;
+	return true;
+}
+
+void CGraphicsBackend_Null::RunCommand(const CCommandBuffer::CCommand *pBaseCommand)
+{
+	m_Stats.m_NumCommands++;
+
+	switch(pBaseCommand->m_Cmd)
+	{
+	case CCommandBuffer::CMD_SIGNAL:
+		static_cast<const CCommandBuffer::CSignalCommand *>(pBaseCommand)->m_pSemaphore->signal();
+		break;
+	case CCommandBuffer::CMD_TEXTURE_CREATE:
+		{
+			const CCommandBuffer::CTextureCreateCommand *pCommand = static_cast<const CCommandBuffer::CTextureCreateCommand *>(pBaseCommand);
+			int MemSize = pCommand->m_Width*pCommand->m_Height*pCommand->m_PixelSize;
+			m_Stats.m_NumTextureUploads++;
+			m_Stats.m_TextureUploadBytes += MemSize;
+			m_aTextureMemory[pCommand->m_Slot] = MemSize;
+			m_TextureMemoryUsage += MemSize;
+			mem_free(pCommand->m_pData);
+		}
+		break;
+	case CCommandBuffer::CMD_TEXTURE_UPDATE:
+		{
+			const CCommandBuffer::CTextureUpdateCommand *pCommand = static_cast<const CCommandBuffer::CTextureUpdateCommand *>(pBaseCommand);
+			m_Stats.m_NumTextureUploads++;
+			m_Stats.m_TextureUploadBytes += pCommand->m_Width*pCommand->m_Height*(pCommand->m_Format == CCommandBuffer::TEXFORMAT_ALPHA ? 1 : pCommand->m_Format == CCommandBuffer::TEXFORMAT_RGB ? 3 : 4);
+			mem_free(pCommand->m_pData);
+		}
+		break;
+	case CCommandBuffer::CMD_TEXTURE_DESTROY:
+		{
+			const CCommandBuffer::CTextureDestroyCommand *pCommand = static_cast<const CCommandBuffer::CTextureDestroyCommand *>(pBaseCommand);
+			m_TextureMemoryUsage -= m_aTextureMemory[pCommand->m_Slot];
+			m_aTextureMemory[pCommand->m_Slot] = 0;
+		}
+		break;
+	case CCommandBuffer::CMD_BUFFER_CREATE:
+		{
+			const CCommandBuffer::CBufferCreateCommand *pCommand = static_cast<const CCommandBuffer::CBufferCreateCommand *>(pBaseCommand);
+			m_Stats.m_NumBufferUploads++;
+			m_Stats.m_BufferUploadBytes += pCommand->m_NumVertices*sizeof(CCommandBuffer::CVertex);
+			mem_free(pCommand->m_pVertices);
+		}
+		break;
+	case CCommandBuffer::CMD_RENDER:
+		{
+			const CCommandBuffer::CRenderCommand *pCommand = static_cast<const CCommandBuffer::CRenderCommand *>(pBaseCommand);
+			m_Stats.m_NumDrawCalls++;
+			m_Stats.m_NumVertices += pCommand->m_PrimCount * (pCommand->m_PrimType == CCommandBuffer::PRIMTYPE_QUADS ? 4 : 2);
+		}
+		break;
+	case CCommandBuffer::CMD_RENDER_BUFFER:
+		m_Stats.m_NumDrawCalls++;
+		m_Stats.m_NumVertices += static_cast<const CCommandBuffer::CRenderBufferCommand *>(pBaseCommand)->m_PrimCount*4;
+		break;
+	case CCommandBuffer::CMD_SWAP:
+		m_Stats.m_NumFrames++;
+		break;
+	case CCommandBuffer::CMD_VSYNC:
+		*static_cast<const CCommandBuffer::CVSyncCommand *>(pBaseCommand)->m_pRetOk = true;
+		break;
+	case CCommandBuffer::CMD_SCREENSHOT:
+		{
+			// hand out a black image, the caller owns the data
+			const CCommandBuffer::CScreenshotCommand *pCommand = static_cast<const CCommandBuffer::CScreenshotCommand *>(pBaseCommand);
+			int w = pCommand->m_W == -1 ? SCREEN_WIDTH : pCommand->m_W;
+			int h = pCommand->m_H == -1 ? SCREEN_HEIGHT : pCommand->m_H;
+			pCommand->m_pImage->m_Width = w;
+			pCommand->m_pImage->m_Height = h;
+			pCommand->m_pImage->m_Format = CImageInfo::FORMAT_RGB;
+			pCommand->m_pImage->m_pData = mem_alloc(w*h*3, 1);
+			mem_zero(pCommand->m_pImage->m_pData, w*h*3);
+		}
+		break;
+	}
+}
+
+int64 CGraphicsBackend_Null::RunBuffer(CCommandBuffer *pBuffer)
+{
+	unsigned CmdIndex = 0;
+	while(1)
+	{
+		const CCommandBuffer::CCommand *pCommand = pBuffer->GetCommand(&CmdIndex);
+		if(pCommand == 0x0)
+			break;
+		RunCommand(pCommand);
+	}
+	m_Stats.m_NumCommandBuffers++;
+	return ++m_Fence;
+}
+
+bool CGraphicsBackend_Null::GetStats(IEngineGraphics::CBackendStats *pStats) const
+{
+	*pStats = m_Stats;
+	return true;
+}
+
+IGraphicsBackend *CreateNullGraphicsBackend() { return new CGraphicsBackend_Null; }
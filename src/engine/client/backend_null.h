@@ -0,0 +1,56 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_BACKEND_NULL_H
+#define ENGINE_CLIENT_BACKEND_NULL_H
+
+#include "graphics_threaded.h"
+
+// consumes the command buffers on the calling thread without rendering anything,
+// only keeps statistics about them. used to measure the cpu side of rendering
+class CGraphicsBackend_Null : public IGraphicsBackend
+{
+	enum
+	{
+		SCREEN_WIDTH=1280,
+		SCREEN_HEIGHT=720,
+	};
+
+	IEngineGraphics::CBackendStats m_Stats;
+	int64 m_Fence;
+	int m_aTextureMemory[CCommandBuffer::MAX_TEXTURES];
+	int m_TextureMemoryUsage;
+
+	void RunCommand(const CCommandBuffer::CCommand *pBaseCommand);
+
+public:
+	CGraphicsBackend_Null();
+
+	virtual int Init(const char *pName, int *pScreen, int *pWindowWidth, int *pWindowHeight, int *pScreenWidth, int *pScreenHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight);
+	virtual int Shutdown();
+
+	virtual int MemoryUsage() const { return m_TextureMemoryUsage; }
+	virtual int GetTextureArraySize() const { return 1; }
+
+	virtual int GetNumScreens() const { return 1; }
+
+	virtual void Minimize() {}
+	virtual void Maximize() {}
+	virtual bool Fullscreen(bool State) { return false; }
+	virtual void SetWindowBordered(bool State) {}
+	virtual bool SetWindowScreen(int Index) { return Index == 0; }
+	virtual int GetVideoModes(CVideoMode *pModes, int MaxModes, int Screen);
+	virtual bool GetDesktopResolution(int Index, int *pDesktopWidth, int* pDesktopHeight);
+	virtual int GetWindowScreen() { return 0; }
+	virtual int WindowActive() { return 1; }
+	virtual int WindowOpen() { return 1; }
+
+	virtual int64 RunBuffer(CCommandBuffer *pBuffer);
+	virtual bool IsFenceDone(int64 Fence) const { return true; }
+	virtual void WaitForFence(int64 Fence) {}
+	virtual bool IsIdle() const { return true; }
+	virtual void WaitForIdle() {}
+
+	virtual bool GetStats(IEngineGraphics::CBackendStats *pStats) const;
+};
+
+#endif
@@ -29,14 +29,28 @@ void CGraphicsBackend_Threaded::ThreadFunc(void *pUser)
 	while(!pThis->m_Shutdown)
 	{
 		pThis->m_Activity.wait();
-		if(pThis->m_pBuffer)
+
+		CCommandBuffer *pBuffer = 0x0;
+		{
+			scope_lock Lock(&pThis->m_QueueLock);
+			if(pThis->m_QueueSize)
+				pBuffer = pThis->m_apQueue[pThis->m_QueueStart];
+		}
+
+		if(pBuffer)
 		{
 			#ifdef CONF_PLATFORM_MACOSX
 				CAutoreleasePool AutoreleasePool;
 			#endif
-			pThis->m_pProcessor->RunBuffer(pThis->m_pBuffer);
+			pThis->m_pProcessor->RunBuffer(pBuffer);
 			sync_barrier();
-			pThis->m_pBuffer = 0x0;
+
+			{
+				scope_lock Lock(&pThis->m_QueueLock);
+				pThis->m_QueueStart = (pThis->m_QueueStart+1)%MAX_QUEUED_BUFFERS;
+				pThis->m_QueueSize--;
+				pThis->m_CompletedFence++;
+			}
 			pThis->m_BufferDone.signal();
 		}
 	}
@@ -44,9 +58,12 @@ void CGraphicsBackend_Threaded::ThreadFunc(void *pUser)
 
 CGraphicsBackend_Threaded::CGraphicsBackend_Threaded()
 {
-	m_pBuffer = 0x0;
 	m_pProcessor = 0x0;
 	m_pThread = 0x0;
+	m_QueueStart = 0;
+	m_QueueSize = 0;
+	m_SubmittedFence = 0;
+	m_CompletedFence = 0;
 }
 
 void CGraphicsBackend_Threaded::StartProcessor(ICommandProcessor *pProcessor)
@@ -54,7 +71,6 @@ void CGraphicsBackend_Threaded::StartProcessor(ICommandProcessor *pProcessor)
 	m_Shutdown = false;
 	m_pProcessor = pProcessor;
 	m_pThread = thread_init(ThreadFunc, this);
-	m_BufferDone.signal();
 }
 
 void CGraphicsBackend_Threaded::StopProcessor()
@@ -65,22 +81,44 @@ void CGraphicsBackend_Threaded::StopProcessor()
 	thread_destroy(m_pThread);
 }
 
-void CGraphicsBackend_Threaded::RunBuffer(CCommandBuffer *pBuffer)
+int64 CGraphicsBackend_Threaded::RunBuffer(CCommandBuffer *pBuffer)
 {
-	WaitForIdle();
-	m_pBuffer = pBuffer;
+	// wait for room in the queue
+	WaitForFence(m_SubmittedFence - MAX_QUEUED_BUFFERS + 1);
+
+	int64 Fence;
+	{
+		scope_lock Lock(&m_QueueLock);
+		m_apQueue[(m_QueueStart+m_QueueSize)%MAX_QUEUED_BUFFERS] = pBuffer;
+		m_QueueSize++;
+		Fence = ++m_SubmittedFence;
+	}
+
 	m_Activity.signal();
+	return Fence;
+}
+
+bool CGraphicsBackend_Threaded::IsFenceDone(int64 Fence) const
+{
+	scope_lock Lock(&m_QueueLock);
+	return m_CompletedFence >= Fence;
+}
+
+void CGraphicsBackend_Threaded::WaitForFence(int64 Fence)
+{
+	// every finished buffer signals once, so recheck after each wakeup
+	while(!IsFenceDone(Fence))
+		m_BufferDone.wait();
 }
 
 bool CGraphicsBackend_Threaded::IsIdle() const
 {
-	return m_pBuffer == 0x0;
+	return IsFenceDone(m_SubmittedFence);
 }
 
 void CGraphicsBackend_Threaded::WaitForIdle()
 {
-	while(m_pBuffer != 0x0)
-		m_BufferDone.wait();
+	WaitForFence(m_SubmittedFence);
 }
 
 
@@ -260,6 +298,20 @@ void CCommandProcessorFragment_OpenGL::Cmd_Init(const CInitCommand *pCommand)
 	*pCommand->m_pTextureArraySize = m_TextureArraySize;
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// static vertex buffers are drawn from client memory without vbos
+	m_pfnGenBuffers = 0;
+	if(SDL_GL_ExtensionSupported("GL_ARB_vertex_buffer_object"))
+	{
+		m_pfnGenBuffers = (PFNGLGENBUFFERSARBPROC)SDL_GL_GetProcAddress("glGenBuffersARB");
+		m_pfnDeleteBuffers = (PFNGLDELETEBUFFERSARBPROC)SDL_GL_GetProcAddress("glDeleteBuffersARB");
+		m_pfnBindBuffer = (PFNGLBINDBUFFERARBPROC)SDL_GL_GetProcAddress("glBindBufferARB");
+		m_pfnBufferData = (PFNGLBUFFERDATAARBPROC)SDL_GL_GetProcAddress("glBufferDataARB");
+		if(!m_pfnDeleteBuffers || !m_pfnBindBuffer || !m_pfnBufferData)
+			m_pfnGenBuffers = 0;
+	}
+	if(!m_pfnGenBuffers)
+		dbg_msg("render", "vertex buffer objects not supported - using client side arrays");
 }
 
 void CCommandProcessorFragment_OpenGL::Cmd_Texture_Update(const CCommandBuffer::CTextureUpdateCommand *pCommand)
@@ -446,6 +498,36 @@ void CCommandProcessorFragment_OpenGL::Cmd_Clear(const CCommandBuffer::CClearCom
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void CCommandProcessorFragment_OpenGL::Cmd_Buffer_Create(const CCommandBuffer::CBufferCreateCommand *pCommand)
+{
+	CVertexBuffer *pBuffer = &m_aBuffers[pCommand->m_Slot];
+	if(m_pfnGenBuffers)
+	{
+		m_pfnGenBuffers(1, &pBuffer->m_VBO);
+		m_pfnBindBuffer(GL_ARRAY_BUFFER_ARB, pBuffer->m_VBO);
+		m_pfnBufferData(GL_ARRAY_BUFFER_ARB, sizeof(CCommandBuffer::CVertex)*pCommand->m_NumVertices, pCommand->m_pVertices, GL_STATIC_DRAW_ARB);
+		m_pfnBindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+		mem_free(pCommand->m_pVertices);
+		pBuffer->m_pVertices = 0;
+	}
+	else
+	{
+		pBuffer->m_VBO = 0;
+		pBuffer->m_pVertices = pCommand->m_pVertices;
+	}
+}
+
+void CCommandProcessorFragment_OpenGL::Cmd_Buffer_Destroy(const CCommandBuffer::CBufferDestroyCommand *pCommand)
+{
+	CVertexBuffer *pBuffer = &m_aBuffers[pCommand->m_Slot];
+	if(pBuffer->m_VBO)
+		m_pfnDeleteBuffers(1, &pBuffer->m_VBO);
+	if(pBuffer->m_pVertices)
+		mem_free(pBuffer->m_pVertices);
+	pBuffer->m_VBO = 0;
+	pBuffer->m_pVertices = 0;
+}
+
 void CCommandProcessorFragment_OpenGL::Cmd_Render(const CCommandBuffer::CRenderCommand *pCommand)
 {
 	SetState(pCommand->m_State);
@@ -470,6 +552,32 @@ void CCommandProcessorFragment_OpenGL::Cmd_Render(const CCommandBuffer::CRenderC
 	};
 }
 
+void CCommandProcessorFragment_OpenGL::Cmd_Render_Buffer(const CCommandBuffer::CRenderBufferCommand *pCommand)
+{
+	const CVertexBuffer *pBuffer = &m_aBuffers[pCommand->m_Slot];
+	if(!pBuffer->m_VBO && !pBuffer->m_pVertices)
+		return;
+
+	SetState(pCommand->m_State);
+
+	// the buffer has a single color, set it once instead of per vertex
+	const char *pBase = (const char *)pBuffer->m_pVertices;
+	if(pBuffer->m_VBO)
+		m_pfnBindBuffer(GL_ARRAY_BUFFER_ARB, pBuffer->m_VBO);
+	glVertexPointer(2, GL_FLOAT, sizeof(CCommandBuffer::CVertex), pBase);
+	glTexCoordPointer(3, GL_FLOAT, sizeof(CCommandBuffer::CVertex), pBase + sizeof(float)*2);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glColor4f(pCommand->m_Color.r, pCommand->m_Color.g, pCommand->m_Color.b, pCommand->m_Color.a);
+
+	glDrawArrays(GL_QUADS, pCommand->m_Offset*4, pCommand->m_PrimCount*4);
+
+	glEnableClientState(GL_COLOR_ARRAY);
+	if(pBuffer->m_VBO)
+		m_pfnBindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+}
+
 void CCommandProcessorFragment_OpenGL::Cmd_Screenshot(const CCommandBuffer::CScreenshotCommand *pCommand)
 {
 	// fetch image data
@@ -510,7 +618,12 @@ void CCommandProcessorFragment_OpenGL::Cmd_Screenshot(const CCommandBuffer::CScr
 CCommandProcessorFragment_OpenGL::CCommandProcessorFragment_OpenGL()
 {
 	mem_zero(m_aTextures, sizeof(m_aTextures));
+	mem_zero(m_aBuffers, sizeof(m_aBuffers));
 	m_pTextureMemoryUsage = 0;
+	m_pfnGenBuffers = 0;
+	m_pfnDeleteBuffers = 0;
+	m_pfnBindBuffer = 0;
+	m_pfnBufferData = 0;
 }
 
 bool CCommandProcessorFragment_OpenGL::RunCommand(const CCommandBuffer::CCommand * pBaseCommand)
@@ -521,8 +634,11 @@ bool CCommandProcessorFragment_OpenGL::RunCommand(const CCommandBuffer::CCommand
 	case CCommandBuffer::CMD_TEXTURE_CREATE: Cmd_Texture_Create(static_cast<const CCommandBuffer::CTextureCreateCommand *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_TEXTURE_DESTROY: Cmd_Texture_Destroy(static_cast<const CCommandBuffer::CTextureDestroyCommand *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_TEXTURE_UPDATE: Cmd_Texture_Update(static_cast<const CCommandBuffer::CTextureUpdateCommand *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_BUFFER_CREATE: Cmd_Buffer_Create(static_cast<const CCommandBuffer::CBufferCreateCommand *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_BUFFER_DESTROY: Cmd_Buffer_Destroy(static_cast<const CCommandBuffer::CBufferDestroyCommand *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_CLEAR: Cmd_Clear(static_cast<const CCommandBuffer::CClearCommand *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_RENDER: Cmd_Render(static_cast<const CCommandBuffer::CRenderCommand *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_RENDER_BUFFER: Cmd_Render_Buffer(static_cast<const CCommandBuffer::CRenderBufferCommand *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_SCREENSHOT: Cmd_Screenshot(static_cast<const CCommandBuffer::CScreenshotCommand *>(pBaseCommand)); break;
 	default: return false;
 	}
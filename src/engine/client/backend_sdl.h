@@ -52,7 +52,9 @@ public:
 
 	CGraphicsBackend_Threaded();
 
-	virtual void RunBuffer(CCommandBuffer *pBuffer);
+	virtual int64 RunBuffer(CCommandBuffer *pBuffer);
+	virtual bool IsFenceDone(int64 Fence) const;
+	virtual void WaitForFence(int64 Fence);
 	virtual bool IsIdle() const;
 	virtual void WaitForIdle();
 
@@ -61,8 +63,21 @@ protected:
 	void StopProcessor();
 
 private:
+	enum
+	{
+		MAX_QUEUED_BUFFERS=4,
+	};
+
 	ICommandProcessor *m_pProcessor;
-	CCommandBuffer * volatile m_pBuffer;
+
+	// buffers waiting for the render thread, the first one is being processed
+	mutable lock m_QueueLock;
+	CCommandBuffer *m_apQueue[MAX_QUEUED_BUFFERS];
+	int m_QueueStart;
+	int m_QueueSize;
+	int64 m_SubmittedFence;
+	int64 m_CompletedFence;
+
 	volatile bool m_Shutdown;
 	semaphore m_Activity;
 	semaphore m_BufferDone;
@@ -107,6 +122,19 @@ class CCommandProcessorFragment_OpenGL
 	int m_Max3DTexSize;
 	int m_TextureArraySize;
 
+	// static vertex buffers, kept in client memory if vbos are not available
+	class CVertexBuffer
+	{
+	public:
+		GLuint m_VBO;
+		CCommandBuffer::CVertex *m_pVertices;
+	};
+	CVertexBuffer m_aBuffers[CCommandBuffer::MAX_BUFFERS];
+	PFNGLGENBUFFERSARBPROC m_pfnGenBuffers;
+	PFNGLDELETEBUFFERSARBPROC m_pfnDeleteBuffers;
+	PFNGLBINDBUFFERARBPROC m_pfnBindBuffer;
+	PFNGLBUFFERDATAARBPROC m_pfnBufferData;
+
 public:
 	enum
 	{
@@ -132,7 +160,10 @@ private:
 	void Cmd_Texture_Destroy(const CCommandBuffer::CTextureDestroyCommand *pCommand);
 	void Cmd_Texture_Create(const CCommandBuffer::CTextureCreateCommand *pCommand);
 	void Cmd_Clear(const CCommandBuffer::CClearCommand *pCommand);
+	void Cmd_Buffer_Create(const CCommandBuffer::CBufferCreateCommand *pCommand);
+	void Cmd_Buffer_Destroy(const CCommandBuffer::CBufferDestroyCommand *pCommand);
 	void Cmd_Render(const CCommandBuffer::CRenderCommand *pCommand);
+	void Cmd_Render_Buffer(const CCommandBuffer::CRenderBufferCommand *pCommand);
 	void Cmd_Screenshot(const CCommandBuffer::CScreenshotCommand *pCommand);
 
 public:
@@ -282,6 +282,13 @@ CClient::CClient() : m_DemoPlayer(&m_SnapshotDelta), m_DemoRecorder(&m_SnapshotD
 	//
 	m_aCmdConnect[0] = 0;
 
+	m_aCmdBenchmarkDemo[0] = 0;
+	m_BenchmarkFps = 0;
+	m_Benchmarking = false;
+	m_BenchmarkStartTime = 0;
+	m_BenchmarkStartWait = 0;
+	m_FrameBackendWait = 0;
+
 	// map download
 	m_aMapdownloadFilename[0] = 0;
 	m_aMapdownloadFilenameTemp[0] = 0;
@@ -756,6 +763,10 @@ void CClient::DebugRender()
 	str_format(aBuffer, sizeof(aBuffer), "pred: %d ms",
 		(int)((m_PredictedTime.Get(Now)-m_GameTime.Get(Now))*1000/(float)time_freq()));
 	Graphics()->QuadsText(2, 70, 16, aBuffer);
+	int TextCacheHits, TextCacheMisses;
+	m_pTextRender->LayoutCacheStats(&TextCacheHits, &TextCacheMisses);
+	str_format(aBuffer, sizeof(aBuffer), "gfx wait: %.2f ms, text layouts: %d cached, %d new", m_FrameBackendWait*1000/(float)time_freq(), TextCacheHits, TextCacheMisses);
+	Graphics()->QuadsText(2, 86, 16, aBuffer);
 	Graphics()->QuadsEnd();
 
 	// render graphs
@@ -2027,6 +2038,13 @@ void CClient::Run()
 			m_aCmdConnect[0] = 0;
 		}
 
+		// handle pending benchmark
+		if(m_aCmdBenchmarkDemo[0])
+		{
+			BenchmarkStart();
+			m_aCmdBenchmarkDemo[0] = 0;
+		}
+
 		// update input
 		if(Input()->Update())
 			break;	// SDL_QUIT
@@ -2102,12 +2120,15 @@ void CClient::Run()
 			}
 			else if(m_EditorActive)
 				m_EditorActive = false;
-			
+
+			int64 FrameStartTime = time_get();
+
 			m_pTextRender->Update();
 
 			Update();
 
-			const bool SkipFrame = LimitFps();
+			// the benchmark renders every frame as fast as possible
+			const bool SkipFrame = !m_Benchmarking && LimitFps();
 
 			if(!SkipFrame && (!Config()->m_GfxAsyncRender || m_pGraphics->IsIdle()))
 			{
@@ -2128,8 +2149,17 @@ void CClient::Run()
 				// when we are stress testing only render every 10th frame
 				if(!Config()->m_DbgStress || (m_RenderFrames%10) == 0 )
 				{
+					int64 WaitBefore = m_pGraphics->BackendWaitTime();
 					Render();
 					m_pGraphics->Swap();
+					m_FrameBackendWait = m_pGraphics->BackendWaitTime()-WaitBefore;
+				}
+
+				if(m_Benchmarking)
+				{
+					m_lBenchmarkFrameTimes.add(time_get()-FrameStartTime);
+					if(State() != IClient::STATE_DEMOPLAYBACK || m_DemoPlayer.BaseInfo()->m_Paused)
+						BenchmarkFinish();
 				}
 			}
 		}
@@ -2141,7 +2171,7 @@ void CClient::Run()
 			break;
 
 		// beNice
-		if(Config()->m_ClCpuThrottle)
+		if(Config()->m_ClCpuThrottle && !m_Benchmarking)
 			thread_sleep(Config()->m_ClCpuThrottle);
 		else if(Config()->m_DbgStress || !m_pGraphics->WindowActive())
 			thread_sleep(5);
@@ -2398,6 +2428,81 @@ void CClient::Con_AddDemoMarker(IConsole::IResult *pResult, void *pUserData)
 	pSelf->DemoRecorder_AddDemoMarker();
 }
 
+void CClient::Con_BenchmarkDemo(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	str_copy(pSelf->m_aCmdBenchmarkDemo, pResult->GetString(0), sizeof(pSelf->m_aCmdBenchmarkDemo));
+	pSelf->m_BenchmarkFps = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 1, 1000) : 60;
+}
+
+void CClient::BenchmarkStart()
+{
+	const char *pError = DemoPlayer_Play(m_aCmdBenchmarkDemo, IStorage::TYPE_ALL);
+	if(pError)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "unable to play demo '%s': %s", m_aCmdBenchmarkDemo, pError);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+		Quit();
+		return;
+	}
+
+	// every rendered frame advances the demo by the same time, so runs are comparable
+	m_DemoPlayer.SetFixedStep(time_freq()/m_BenchmarkFps);
+	m_lBenchmarkFrameTimes.clear();
+	m_BenchmarkStartTime = time_get();
+	m_BenchmarkStartWait = m_pGraphics->BackendWaitTime();
+	m_Benchmarking = true;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "benchmarking demo '%s' at %d frames per demo second", m_aCmdBenchmarkDemo, m_BenchmarkFps);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+}
+
+void CClient::BenchmarkFinish()
+{
+	m_Benchmarking = false;
+	m_DemoPlayer.SetFixedStep(0);
+
+	const int NumFrames = m_lBenchmarkFrameTimes.size();
+	const double Freq = time_freq() / 1000.0;
+	char aBuf[256];
+	if(NumFrames)
+	{
+		int64 Total = 0;
+		for(int i = 0; i < NumFrames; i++)
+			Total += m_lBenchmarkFrameTimes[i];
+		std::sort(m_lBenchmarkFrameTimes.base_ptr(), m_lBenchmarkFrameTimes.base_ptr()+NumFrames);
+
+		str_format(aBuf, sizeof(aBuf), "%d frames in %.2f s, %.1f fps", NumFrames,
+			(time_get()-m_BenchmarkStartTime)/(double)time_freq(), NumFrames/(Total/(double)time_freq()));
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+		str_format(aBuf, sizeof(aBuf), "frame time: avg %.3f ms, min %.3f ms, median %.3f ms, 99%% %.3f ms, max %.3f ms",
+			Total/Freq/NumFrames, m_lBenchmarkFrameTimes[0]/Freq, m_lBenchmarkFrameTimes[NumFrames/2]/Freq,
+			m_lBenchmarkFrameTimes[min(NumFrames-1, NumFrames*99/100)]/Freq, m_lBenchmarkFrameTimes[NumFrames-1]/Freq);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+		const int64 Wait = m_pGraphics->BackendWaitTime()-m_BenchmarkStartWait;
+		str_format(aBuf, sizeof(aBuf), "waiting for the backend: %.3f ms per frame, %.1f%% of the frame time",
+			Wait/Freq/NumFrames, Total ? Wait*100.0/Total : 0.0);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+
+		IEngineGraphics::CBackendStats Stats;
+		if(m_pGraphics->GetBackendStats(&Stats) && Stats.m_NumFrames)
+		{
+			str_format(aBuf, sizeof(aBuf), "per frame: %.1f draw calls, %.1f commands, %.0f vertices",
+				Stats.m_NumDrawCalls/(double)Stats.m_NumFrames, Stats.m_NumCommands/(double)Stats.m_NumFrames, Stats.m_NumVertices/(double)Stats.m_NumFrames);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+			str_format(aBuf, sizeof(aBuf), "uploads: %lld textures (%lld bytes), %lld vertex buffers (%lld bytes)",
+				Stats.m_NumTextureUploads, Stats.m_TextureUploadBytes, Stats.m_NumBufferUploads, Stats.m_BufferUploadBytes);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+		}
+	}
+	else
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", "no frames were rendered");
+
+	Quit();
+}
+
 void CClient::ServerBrowserUpdate()
 {
 	m_ResortServerBrowser = true;
@@ -2515,6 +2620,7 @@ void CClient::RegisterCommands()
 	m_pConsole->Register("record", "?s[file]", CFGFLAG_CLIENT, Con_Record, this, "Record to the file");
 	m_pConsole->Register("stoprecord", "", CFGFLAG_CLIENT, Con_StopRecord, this, "Stop recording");
 	m_pConsole->Register("add_demomarker", "", CFGFLAG_CLIENT, Con_AddDemoMarker, this, "Add demo timeline marker");
+	m_pConsole->Register("benchmark_demo", "s[file] ?i[fps]", CFGFLAG_CLIENT|CFGFLAG_STORE, Con_BenchmarkDemo, this, "Play a demo as fast as possible with fixed steps, print the frame times and quit");
 
 	// used for server browser update
 	m_pConsole->Chain("br_filter_string", ConchainServerBrowserUpdate, this);
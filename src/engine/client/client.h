@@ -4,6 +4,7 @@
 #define ENGINE_CLIENT_CLIENT_H
 
 #include <base/hash.h>
+#include <base/tl/array.h>
 
 class CGraph
 {
@@ -126,6 +127,17 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	//
 	char m_aCmdConnect[256];
 
+	// headless demo benchmark
+	char m_aCmdBenchmarkDemo[IO_MAX_PATH_LENGTH];
+	int m_BenchmarkFps;
+	bool m_Benchmarking;
+	int64 m_BenchmarkStartTime;
+	int64 m_BenchmarkStartWait;
+	array<int64> m_lBenchmarkFrameTimes;
+
+	// time the last frame spent waiting for the graphics backend
+	int64 m_FrameBackendWait;
+
 	// map download
 	char m_aMapdownloadFilename[IO_MAX_PATH_LENGTH];
 	char m_aMapdownloadFilenameTemp[IO_MAX_PATH_LENGTH];
@@ -262,6 +274,9 @@ public:
 
 	virtual void Quit();
 
+	void BenchmarkStart();
+	void BenchmarkFinish();
+
 	virtual const char *ErrorString() const;
 
 	const char *LoadMap(const char *pName, const char *pFilename, const SHA256_DIGEST *pWantedSha256, unsigned WantedCrc);
@@ -306,6 +321,7 @@ public:
 	static void Con_Record(IConsole::IResult *pResult, void *pUserData);
 	static void Con_StopRecord(IConsole::IResult *pResult, void *pUserData);
 	static void Con_AddDemoMarker(IConsole::IResult *pResult, void *pUserData);
+	static void Con_BenchmarkDemo(IConsole::IResult *pResult, void *pUserData);
 	static void ConchainServerBrowserUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainFullscreen(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainWindowBordered(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
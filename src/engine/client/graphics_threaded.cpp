@@ -42,6 +42,26 @@ void CGraphics_Threaded::FlushVertices()
 	int NumVerts = m_NumVertices;
 	m_NumVertices = 0;
 
+	if(m_Recording)
+	{
+		// keep the vertices for the buffer instead of rendering them
+		if(m_NumRecordedVertices + NumVerts > m_RecordedCapacity)
+		{
+			int NewCapacity = max(m_RecordedCapacity*2, m_NumRecordedVertices + NumVerts);
+			CCommandBuffer::CVertex *pNewVertices = (CCommandBuffer::CVertex *)mem_alloc(sizeof(CCommandBuffer::CVertex)*NewCapacity, sizeof(void*));
+			if(m_pRecordedVertices)
+			{
+				mem_copy(pNewVertices, m_pRecordedVertices, sizeof(CCommandBuffer::CVertex)*m_NumRecordedVertices);
+				mem_free(m_pRecordedVertices);
+			}
+			m_pRecordedVertices = pNewVertices;
+			m_RecordedCapacity = NewCapacity;
+		}
+		mem_copy(m_pRecordedVertices + m_NumRecordedVertices, m_aVertices, sizeof(CCommandBuffer::CVertex)*NumVerts);
+		m_NumRecordedVertices += NumVerts;
+		return;
+	}
+
 	CCommandBuffer::CRenderCommand Cmd;
 	Cmd.m_State = m_State;
 
@@ -58,39 +78,9 @@ void CGraphics_Threaded::FlushVertices()
 	else
 		return;
 
+	// the command buffer grows when it runs full, nothing is dropped
 	Cmd.m_pVertices = (CCommandBuffer::CVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::CVertex)*NumVerts);
-	if(Cmd.m_pVertices == 0x0)
-	{
-		// kick command buffer and try again
-		KickCommandBuffer();
-
-		Cmd.m_pVertices = (CCommandBuffer::CVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::CVertex)*NumVerts);
-		if(Cmd.m_pVertices == 0x0)
-		{
-			dbg_msg("graphics", "failed to allocate data for vertices");
-			return;
-		}
-	}
-
-	// check if we have enough free memory in the commandbuffer
-	if(!m_pCommandBuffer->AddCommand(Cmd))
-	{
-		// kick command buffer and try again
-		KickCommandBuffer();
-
-		Cmd.m_pVertices = (CCommandBuffer::CVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::CVertex)*NumVerts);
-		if(Cmd.m_pVertices == 0x0)
-		{
-			dbg_msg("graphics", "failed to allocate data for vertices");
-			return;
-		}
-
-		if(!m_pCommandBuffer->AddCommand(Cmd))
-		{
-			dbg_msg("graphics", "failed to allocate memory for render command");
-			return;
-		}
-	}
+	m_pCommandBuffer->AddCommand(Cmd);
 
 	mem_copy(Cmd.m_pVertices, m_aVertices, sizeof(CCommandBuffer::CVertex)*NumVerts);
 }
@@ -134,10 +124,15 @@ CGraphics_Threaded::CGraphics_Threaded()
 	m_State.m_WrapModeU = WRAP_REPEAT;
 	m_State.m_WrapModeV = WRAP_REPEAT;
 
+	m_NumCommandBuffers = 0;
 	m_CurrentCommandBuffer = 0;
 	m_pCommandBuffer = 0x0;
-	m_apCommandBuffers[0] = 0x0;
-	m_apCommandBuffers[1] = 0x0;
+	for(int i = 0; i < MAX_CMDBUFFERS; i++)
+	{
+		m_apCommandBuffers[i] = 0x0;
+		m_aCommandBufferFences[i] = 0;
+	}
+	m_BackendWaitTime = 0;
 
 	m_NumVertices = 0;
 
@@ -149,6 +144,11 @@ CGraphics_Threaded::CGraphics_Threaded()
 
 	m_TextureMemoryUsage = 0;
 
+	m_Recording = false;
+	m_pRecordedVertices = 0;
+	m_NumRecordedVertices = 0;
+	m_RecordedCapacity = 0;
+
 	m_RenderEnable = true;
 	m_DoScreenshot = false;
 }
@@ -412,8 +412,6 @@ int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int Sto
 	png_t Png; // ignore_convention
 
 	// open file for reading
-	png_init(0,0); // ignore_convention
-
 	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aCompleteFilename, sizeof(aCompleteFilename));
 	if(File)
 		io_close(File);
@@ -453,12 +451,45 @@ int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int Sto
 	return 1;
 }
 
+int CGraphics_Threaded::LoadPNGJob(void *pUser)
+{
+	CImageLoadJob *pJob = (CImageLoadJob *)pUser;
+	if(pJob->m_pfnPrepare && pJob->m_pfnPrepare(pJob))
+	{
+		pJob->m_Loaded = true;
+		return 1;
+	}
+
+	pJob->m_Loaded = pJob->m_pGraphics->LoadPNG(&pJob->m_Image, pJob->m_aFilename, pJob->m_StorageType) != 0;
+	if(pJob->m_Loaded && pJob->m_pfnProcess)
+		pJob->m_pfnProcess(pJob);
+	return pJob->m_Loaded;
+}
+
+void CGraphics_Threaded::LoadPNGAsync(CImageLoadJob *pJob, const char *pFilename, int StorageType)
+{
+	pJob->m_pGraphics = this;
+	str_copy(pJob->m_aFilename, pFilename, sizeof(pJob->m_aFilename));
+	pJob->m_StorageType = StorageType;
+	pJob->m_Loaded = false;
+	mem_zero(&pJob->m_Image, sizeof(pJob->m_Image));
+	m_ImageJobPool.Add(&pJob->m_Job, LoadPNGJob, pJob);
+}
+
 void CGraphics_Threaded::KickCommandBuffer()
 {
-	m_pBackend->RunBuffer(m_pCommandBuffer);
+	m_aCommandBufferFences[m_CurrentCommandBuffer] = m_pBackend->RunBuffer(m_pCommandBuffer);
+
+	// continue with the oldest buffer, the backend might still be busy with it
+	m_CurrentCommandBuffer = (m_CurrentCommandBuffer+1)%m_NumCommandBuffers;
+	int64 Fence = m_aCommandBufferFences[m_CurrentCommandBuffer];
+	if(!m_pBackend->IsFenceDone(Fence))
+	{
+		int64 WaitStart = time_get();
+		m_pBackend->WaitForFence(Fence);
+		m_BackendWaitTime += time_get()-WaitStart;
+	}
 
-	// swap buffer
-	m_CurrentCommandBuffer ^= 1;
 	m_pCommandBuffer = m_apCommandBuffers[m_CurrentCommandBuffer];
 	m_pCommandBuffer->Reset();
 }
@@ -710,6 +741,94 @@ void CGraphics_Threaded::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
 	AddVertices(4*Num);
 }
 
+bool CGraphics_Threaded::QuadBuffersSupported() const
+{
+	// the recorded texture coordinates must not depend on the tileset fallback
+	return m_pBackend->GetTextureArraySize() == 1;
+}
+
+void CGraphics_Threaded::QuadsBeginRecording()
+{
+	QuadsBegin();
+	m_Recording = true;
+	m_NumRecordedVertices = 0;
+}
+
+int CGraphics_Threaded::QuadsRecorded() const
+{
+	return (m_NumRecordedVertices + m_NumVertices) / 4;
+}
+
+IGraphics::CBufferHandle CGraphics_Threaded::QuadsEndRecording()
+{
+	dbg_assert(m_Recording, "called Graphics()->QuadsEndRecording without begin");
+	FlushVertices();
+	m_Recording = false;
+	m_Drawing = 0;
+
+	if(m_NumRecordedVertices == 0 || m_FirstFreeBuffer < 0)
+	{
+		if(m_NumRecordedVertices)
+			dbg_msg("graphics", "failed to create vertex buffer, all slots are in use");
+		return CBufferHandle();
+	}
+
+	// grab buffer
+	int Buffer = m_FirstFreeBuffer;
+	m_FirstFreeBuffer = m_aBufferIndices[Buffer];
+	m_aBufferIndices[Buffer] = -1;
+	m_aBufferDimensions[Buffer] = m_State.m_Dimension;
+
+	// the command processor takes over the vertices
+	CCommandBuffer::CBufferCreateCommand Cmd;
+	Cmd.m_Slot = Buffer;
+	Cmd.m_NumVertices = m_NumRecordedVertices;
+	Cmd.m_pVertices = m_pRecordedVertices;
+	m_pRecordedVertices = 0;
+	m_NumRecordedVertices = 0;
+	m_RecordedCapacity = 0;
+
+	m_pCommandBuffer->AddCommand(Cmd);
+
+	return CreateBufferHandle(Buffer);
+}
+
+void CGraphics_Threaded::QuadsDrawBuffer(CBufferHandle Buffer, int Offset, int Num)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS && !m_Recording, "called Graphics()->QuadsDrawBuffer without begin");
+	if(!Buffer.IsValid() || Num <= 0)
+		return;
+
+	// keep the order with quads drawn before
+	FlushVertices();
+
+	CCommandBuffer::CRenderBufferCommand Cmd;
+	Cmd.m_State = m_State;
+	Cmd.m_State.m_Dimension = m_aBufferDimensions[Buffer.Id()];
+	Cmd.m_State.m_TextureArrayIndex = 0;
+	Cmd.m_Color = m_aColor[0];
+	Cmd.m_Slot = Buffer.Id();
+	Cmd.m_Offset = Offset;
+	Cmd.m_PrimCount = Num;
+
+	m_pCommandBuffer->AddCommand(Cmd);
+}
+
+void CGraphics_Threaded::UnloadBuffer(CBufferHandle *pBuffer)
+{
+	if(!pBuffer->IsValid())
+		return;
+
+	CCommandBuffer::CBufferDestroyCommand Cmd;
+	Cmd.m_Slot = pBuffer->Id();
+	m_pCommandBuffer->AddCommand(Cmd);
+
+	m_aBufferIndices[pBuffer->Id()] = m_FirstFreeBuffer;
+	m_FirstFreeBuffer = pBuffer->Id();
+
+	pBuffer->Invalidate();
+}
+
 void CGraphics_Threaded::QuadsText(float x, float y, float Size, const char *pText)
 {
 	float StartX = x;
@@ -796,21 +915,36 @@ int CGraphics_Threaded::Init()
 	m_pConfig = Kernel()->RequestInterface<IConfigManager>()->Values();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 
+	// images are decoded in parallel, pnglite only needs to be set up once
+	png_init(0,0); // ignore_convention
+	m_ImageJobPool.Init(m_pConfig->m_GfxLoadThreads);
+
 	// init textures
 	m_FirstFreeTexture = 0;
 	for(int i = 0; i < MAX_TEXTURES-1; i++)
 		m_aTextureIndices[i] = i+1;
 	m_aTextureIndices[MAX_TEXTURES-1] = -1;
 
-	m_pBackend = CreateGraphicsBackend();
+	// init vertex buffers
+	m_FirstFreeBuffer = 0;
+	for(int i = 0; i < MAX_BUFFERS-1; i++)
+		m_aBufferIndices[i] = i+1;
+	m_aBufferIndices[MAX_BUFFERS-1] = -1;
+
+	m_pBackend = m_pConfig->m_GfxNullBackend ? CreateNullGraphicsBackend() : CreateGraphicsBackend();
 	if(InitWindow() != 0)
 		return -1;
 
 	m_ScreenHiDPIScale = m_ScreenWidth / (float)m_pConfig->m_GfxScreenWidth;
 
 	// create command buffers
-	for(int i = 0; i < NUM_CMDBUFFERS; i++)
+	m_NumCommandBuffers = clamp(m_pConfig->m_GfxCommandBuffers, 2, (int)MAX_CMDBUFFERS);
+	for(int i = 0; i < m_NumCommandBuffers; i++)
+	{
 		m_apCommandBuffers[i] = new CCommandBuffer(128*1024, 2*1024*1024);
+		m_aCommandBufferFences[i] = 0;
+	}
+	m_CurrentCommandBuffer = 0;
 	m_pCommandBuffer = m_apCommandBuffers[0];
 
 	// create null texture, will get id=0
@@ -863,8 +997,16 @@ void CGraphics_Threaded::Shutdown()
 	m_pBackend = 0x0;
 
 	// delete the command buffers
-	for(int i = 0; i < NUM_CMDBUFFERS; i++)
+	for(int i = 0; i < m_NumCommandBuffers; i++)
+	{
 		delete m_apCommandBuffers[i];
+		m_apCommandBuffers[i] = 0x0;
+	}
+	m_NumCommandBuffers = 0;
+
+	if(m_pRecordedVertices)
+		mem_free(m_pRecordedVertices);
+	m_pRecordedVertices = 0;
 }
 
 int CGraphics_Threaded::GetNumScreens() const
@@ -919,6 +1061,16 @@ int CGraphics_Threaded::WindowOpen()
 
 }
 
+bool CGraphics_Threaded::GetBackendStats(CBackendStats *pStats) const
+{
+	return m_pBackend->GetStats(pStats);
+}
+
+int64 CGraphics_Threaded::BackendWaitTime() const
+{
+	return m_BackendWaitTime;
+}
+
 void CGraphics_Threaded::ReadBackbuffer(unsigned char **ppPixels, int x, int y, int w, int h)
 {
 	if(!ppPixels)
@@ -999,7 +1151,9 @@ bool CGraphics_Threaded::IsIdle() const
 
 void CGraphics_Threaded::WaitForIdle()
 {
+	int64 WaitStart = time_get();
 	m_pBackend->WaitForIdle();
+	m_BackendWaitTime += time_get()-WaitStart;
 }
 
 int CGraphics_Threaded::GetVideoModes(CVideoMode *pModes, int MaxModes, int Screen)
@@ -6,19 +6,40 @@ class CCommandBuffer
 {
 	class CBuffer
 	{
+		// blocks allocated after the buffer ran full, they are freed on reset
+		struct COverflow
+		{
+			COverflow *m_pNext;
+		};
+
 		unsigned char *m_pData;
 		unsigned m_Size;
 		unsigned m_Used;
+		COverflow *m_pOverflow;
+		unsigned m_OverflowUsed;
+
+		void Resize(unsigned NewSize)
+		{
+			unsigned char *pNewData = new unsigned char[NewSize];
+			mem_copy(pNewData, m_pData, m_Used);
+			delete [] m_pData;
+			m_pData = pNewData;
+			m_Size = NewSize;
+		}
+
 	public:
 		CBuffer(unsigned BufferSize)
 		{
 			m_Size = BufferSize;
 			m_pData = new unsigned char[m_Size];
 			m_Used = 0;
+			m_pOverflow = 0x0;
+			m_OverflowUsed = 0;
 		}
 
 		~CBuffer()
 		{
+			Reset();
 			delete [] m_pData;
 			m_pData = 0x0;
 			m_Used = 0;
@@ -27,6 +48,20 @@ class CCommandBuffer
 
 		void Reset()
 		{
+			while(m_pOverflow)
+			{
+				COverflow *pNext = m_pOverflow->m_pNext;
+				mem_free(m_pOverflow);
+				m_pOverflow = pNext;
+			}
+
+			// make room for everything that was needed this time
+			if(m_OverflowUsed)
+			{
+				m_Used = 0;
+				Resize(m_Size + m_OverflowUsed);
+				m_OverflowUsed = 0;
+			}
 			m_Used = 0;
 		}
 
@@ -39,9 +74,32 @@ class CCommandBuffer
 			return pPtr;
 		}
 
+		// the buffer is moved, only for data nobody points into
+		void *AllocGrow(unsigned Requested)
+		{
+			if(Requested + m_Used > m_Size)
+				Resize(m_Used + Requested > m_Size*2 ? m_Used + Requested : m_Size*2);
+			return Alloc(Requested);
+		}
+
+		// earlier allocations stay in place
+		void *AllocOverflow(unsigned Requested)
+		{
+			void *pPtr = Alloc(Requested);
+			if(pPtr)
+				return pPtr;
+
+			COverflow *pBlock = (COverflow *)mem_alloc(sizeof(COverflow) + Requested, sizeof(void*));
+			pBlock->m_pNext = m_pOverflow;
+			m_pOverflow = pBlock;
+			m_OverflowUsed += Requested;
+			return pBlock + 1;
+		}
+
 		unsigned char *DataPtr() { return m_pData; }
 		unsigned DataSize() const { return m_Size; }
 		unsigned DataUsed() const { return m_Used; }
+		unsigned OverflowUsed() const { return m_OverflowUsed; }
 	};
 
 public:
@@ -51,6 +109,7 @@ public:
 	enum
 	{
 		MAX_TEXTURES=1024*4,
+		MAX_BUFFERS=1024,
 	};
 
 	enum
@@ -74,9 +133,14 @@ public:
 		CMD_TEXTURE_DESTROY,
 		CMD_TEXTURE_UPDATE,
 
+		// vertex buffer commands
+		CMD_BUFFER_CREATE,
+		CMD_BUFFER_DESTROY,
+
 		// rendering
 		CMD_CLEAR,
 		CMD_RENDER,
+		CMD_RENDER_BUFFER,
 
 		// swap
 		CMD_SWAP,
@@ -182,6 +246,16 @@ public:
 		CVertex *m_pVertices; // you should use the command buffer data to allocate vertices for this command
 	};
 
+	struct CRenderBufferCommand : public CCommand
+	{
+		CRenderBufferCommand() : CCommand(CMD_RENDER_BUFFER) {}
+		CState m_State;
+		CColor m_Color;
+		int m_Slot;
+		unsigned m_Offset; // in quads
+		unsigned m_PrimCount;
+	};
+
 	struct CScreenshotCommand : public CCommand
 	{
 		CScreenshotCommand() : CCommand(CMD_SCREENSHOT) {}
@@ -244,30 +318,45 @@ public:
 		int m_Slot;
 	};
 
+	struct CBufferCreateCommand : public CCommand
+	{
+		CBufferCreateCommand() : CCommand(CMD_BUFFER_CREATE) {}
+
+		int m_Slot;
+		int m_NumVertices;
+		CVertex *m_pVertices; // will be freed by the command processor
+	};
+
+	struct CBufferDestroyCommand : public CCommand
+	{
+		CBufferDestroyCommand() : CCommand(CMD_BUFFER_DESTROY) {}
+
+		int m_Slot;
+	};
+
 	//
 	CCommandBuffer(unsigned CmdBufferSize, unsigned DataBufferSize)
 	: m_CmdBuffer(CmdBufferSize), m_DataBuffer(DataBufferSize)
 	{
 	}
 
+	// never fails, when the buffer is full the data goes into an overflow
+	// block and the buffer is enlarged on the next reset
 	void *AllocData(unsigned WantedSize)
 	{
-		return m_DataBuffer.Alloc(WantedSize);
+		return m_DataBuffer.AllocOverflow(WantedSize);
 	}
 
 	template<class T>
-	bool AddCommand(const T &Command)
+	void AddCommand(const T &Command)
 	{
 		// make sure that we don't do something stupid like ->AddCommand(&Cmd);
 		(void)static_cast<const CCommand *>(&Command);
 
-		// allocate and copy the command into the buffer
-		CCommand *pCmd = (CCommand *)m_CmdBuffer.Alloc(sizeof(Command));
-		if(!pCmd)
-			return false;
+		// allocate and copy the command into the buffer, it grows when full
+		CCommand *pCmd = (CCommand *)m_CmdBuffer.AllocGrow(sizeof(Command));
 		mem_copy(pCmd, &Command, sizeof(Command));
 		pCmd->m_Size = sizeof(Command);
-		return true;
 	}
 
 	CCommand *GetCommand(unsigned *pIndex)
@@ -323,19 +412,27 @@ public:
 	virtual int WindowActive() = 0;
 	virtual int WindowOpen() = 0;
 
-	virtual void RunBuffer(CCommandBuffer *pBuffer) = 0;
+	// buffers are processed in the order they are passed in, the returned fence
+	// is done once the backend is finished with the buffer and it can be reused
+	virtual int64 RunBuffer(CCommandBuffer *pBuffer) = 0;
+	virtual bool IsFenceDone(int64 Fence) const = 0;
+	virtual void WaitForFence(int64 Fence) = 0;
 	virtual bool IsIdle() const = 0;
 	virtual void WaitForIdle() = 0;
+
+	// returns false if the backend does not keep statistics
+	virtual bool GetStats(IEngineGraphics::CBackendStats *pStats) const { return false; }
 };
 
 class CGraphics_Threaded : public IEngineGraphics
 {
 	enum
 	{
-		NUM_CMDBUFFERS = 2,
+		MAX_CMDBUFFERS = 4,
 
 		MAX_VERTICES = 32*1024,
 		MAX_TEXTURES = 1024*4,
+		MAX_BUFFERS = 1024,
 
 		DRAWING_QUADS=1,
 		DRAWING_LINES=2
@@ -344,15 +441,22 @@ class CGraphics_Threaded : public IEngineGraphics
 	CCommandBuffer::CState m_State;
 	IGraphicsBackend *m_pBackend;
 
-	CCommandBuffer *m_apCommandBuffers[NUM_CMDBUFFERS];
+	// buffers are reused round robin once the backend passed their fence
+	CCommandBuffer *m_apCommandBuffers[MAX_CMDBUFFERS];
+	int64 m_aCommandBufferFences[MAX_CMDBUFFERS];
 	CCommandBuffer *m_pCommandBuffer;
-	unsigned m_CurrentCommandBuffer;
+	int m_NumCommandBuffers;
+	int m_CurrentCommandBuffer;
+	int64 m_BackendWaitTime;
 
 	//
 	class IStorage *m_pStorage;
 	class CConfig *m_pConfig;
 	class IConsole *m_pConsole;
 
+	CJobPool m_ImageJobPool;
+	static int LoadPNGJob(void *pUser);
+
 	CCommandBuffer::CVertex m_aVertices[MAX_VERTICES];
 	int m_NumVertices;
 
@@ -373,6 +477,16 @@ class CGraphics_Threaded : public IEngineGraphics
 	int m_FirstFreeTexture;
 	int m_TextureMemoryUsage;
 
+	int m_aBufferIndices[MAX_BUFFERS];
+	int m_aBufferDimensions[MAX_BUFFERS];
+	int m_FirstFreeBuffer;
+
+	// quads recorded for a static buffer
+	bool m_Recording;
+	CCommandBuffer::CVertex *m_pRecordedVertices;
+	int m_NumRecordedVertices;
+	int m_RecordedCapacity;
+
 	void FlushVertices();
 	void AddVertices(int Count);
 	void Rotate4(const CCommandBuffer::CPoint &rCenter, CCommandBuffer::CVertex *pPoints);
@@ -411,6 +525,7 @@ public:
 	// simple uncompressed RGBA loaders
 	virtual IGraphics::CTextureHandle LoadTexture(const char *pFilename, int StorageType, int StoreFormat, int Flags);
 	virtual int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType);
+	virtual void LoadPNGAsync(CImageLoadJob *pJob, const char *pFilename, int StorageType);
 
 	void ScreenshotDirect(const char *pFilename);
 
@@ -437,6 +552,13 @@ public:
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
 	virtual void QuadsText(float x, float y, float Size, const char *pText);
 
+	virtual bool QuadBuffersSupported() const;
+	virtual void QuadsBeginRecording();
+	virtual int QuadsRecorded() const;
+	virtual CBufferHandle QuadsEndRecording();
+	virtual void QuadsDrawBuffer(CBufferHandle Buffer, int Offset, int Num);
+	virtual void UnloadBuffer(CBufferHandle *pBuffer);
+
 	virtual int GetNumScreens() const;
 	virtual void Minimize();
 	virtual void Maximize();
@@ -448,6 +570,9 @@ public:
 	virtual int WindowActive();
 	virtual int WindowOpen();
 
+	virtual bool GetBackendStats(CBackendStats *pStats) const;
+	virtual int64 BackendWaitTime() const;
+
 	virtual int Init();
 	virtual void Shutdown();
 
@@ -465,3 +590,4 @@ public:
 };
 
 extern IGraphicsBackend *CreateGraphicsBackend();
+extern IGraphicsBackend *CreateNullGraphicsBackend();
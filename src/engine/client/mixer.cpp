@@ -0,0 +1,351 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include "mixer.h"
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CONF_MIXER_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+CMixer::CMixer()
+{
+	mem_zero(m_aVoices, sizeof(m_aVoices));
+	m_pMixBuffer = 0;
+	m_MaxFrames = 0;
+	m_NumCulled = 0;
+
+	for(int i = 0; i < MAX_VOICES; i++)
+	{
+		m_aVoiceSerial[i] = 0;
+		m_aVoiceDone[i] = 0;
+		m_apVoiceSample[i] = 0;
+	}
+	m_NextVoice = 0;
+
+	m_QueueWrite = 0;
+	m_QueueRead = 0;
+
+	for(int i = 0; i < MAX_CHANNELS; i++)
+		m_aChannelVolumes[i] = 255;
+	m_CenterX = 0;
+	m_CenterY = 0;
+	m_MaxDistance = 1500.0f;
+	m_MasterVolume = 100;
+}
+
+CMixer::~CMixer()
+{
+	if(m_pMixBuffer)
+		mem_free(m_pMixBuffer);
+}
+
+void CMixer::Init(unsigned MaxFrames)
+{
+	if(m_pMixBuffer)
+		mem_free(m_pMixBuffer);
+	m_MaxFrames = MaxFrames;
+	m_pMixBuffer = (int *)mem_alloc(m_MaxFrames*2*sizeof(int), 16);
+}
+
+bool CMixer::PushCommand(const CCommand &Cmd, bool Wait)
+{
+	// the mixing thread empties the queue every few milliseconds
+	while(m_QueueWrite - m_QueueRead >= (unsigned)QUEUE_SIZE)
+	{
+		if(!Wait)
+			return false;
+		thread_yield();
+	}
+
+	m_aQueue[m_QueueWrite%QUEUE_SIZE] = Cmd;
+	sync_barrier();
+	m_QueueWrite = m_QueueWrite+1;
+	return true;
+}
+
+int CMixer::Play(int ChannelID, CMixerSample *pSample, int Flags, int x, int y)
+{
+	if(!pSample || !pSample->m_pData)
+		return -1;
+
+	// search for voice
+	int VoiceID = -1;
+	for(int i = 0; i < MAX_VOICES; i++)
+	{
+		int id = (m_NextVoice + i) % MAX_VOICES;
+		if(m_aVoiceSerial[id] == m_aVoiceDone[id])
+		{
+			VoiceID = id;
+			break;
+		}
+	}
+	if(VoiceID == -1)
+		return -1;
+
+	CCommand Cmd;
+	Cmd.m_Type = CMD_PLAY;
+	Cmd.m_Voice = VoiceID;
+	Cmd.m_Serial = m_aVoiceSerial[VoiceID]+1;
+	Cmd.m_pSample = pSample;
+	Cmd.m_Channel = ChannelID;
+	Cmd.m_Flags = Flags;
+	Cmd.m_X = x;
+	Cmd.m_Y = y;
+	if(!PushCommand(Cmd, false))
+		return -1;
+
+	m_aVoiceSerial[VoiceID] = Cmd.m_Serial;
+	m_apVoiceSample[VoiceID] = pSample;
+	m_NextVoice = VoiceID+1;
+	return VoiceID;
+}
+
+void CMixer::Stop(const CMixerSample *pSample)
+{
+	for(int i = 0; i < MAX_VOICES; i++)
+	{
+		if(m_apVoiceSample[i] == pSample)
+			m_apVoiceSample[i] = 0;
+	}
+
+	CCommand Cmd;
+	mem_zero(&Cmd, sizeof(Cmd));
+	Cmd.m_Type = CMD_STOP;
+	Cmd.m_pSample = (CMixerSample *)pSample;
+	PushCommand(Cmd, true);
+}
+
+void CMixer::StopAll()
+{
+	for(int i = 0; i < MAX_VOICES; i++)
+		m_apVoiceSample[i] = 0;
+
+	CCommand Cmd;
+	mem_zero(&Cmd, sizeof(Cmd));
+	Cmd.m_Type = CMD_STOPALL;
+	PushCommand(Cmd, true);
+}
+
+bool CMixer::IsPlaying(const CMixerSample *pSample) const
+{
+	for(int i = 0; i < MAX_VOICES; i++)
+	{
+		if(m_apVoiceSample[i] == pSample && m_aVoiceSerial[i] != m_aVoiceDone[i])
+			return true;
+	}
+	return false;
+}
+
+void CMixer::FreeVoice(CVoice *pVoice, bool Pause)
+{
+	if(Pause)
+		pVoice->m_pSample->m_PausedAt = (pVoice->m_Flags&FLAG_LOOP) ? pVoice->m_Tick : 0;
+	pVoice->m_pSample = 0;
+
+	// hand the voice back to the main thread
+	sync_barrier();
+	m_aVoiceDone[pVoice - m_aVoices] = pVoice->m_Serial;
+}
+
+void CMixer::RunCommands()
+{
+	unsigned Write = m_QueueWrite;
+	sync_barrier();
+
+	while(m_QueueRead != Write)
+	{
+		const CCommand &Cmd = m_aQueue[m_QueueRead%QUEUE_SIZE];
+		if(Cmd.m_Type == CMD_PLAY)
+		{
+			CVoice *pVoice = &m_aVoices[Cmd.m_Voice];
+			pVoice->m_pSample = Cmd.m_pSample;
+			pVoice->m_Channel = Cmd.m_Channel;
+			pVoice->m_Tick = (Cmd.m_Flags&FLAG_LOOP) ? Cmd.m_pSample->m_PausedAt : 0;
+			pVoice->m_Flags = Cmd.m_Flags;
+			pVoice->m_X = Cmd.m_X;
+			pVoice->m_Y = Cmd.m_Y;
+			pVoice->m_Serial = Cmd.m_Serial;
+		}
+		else
+		{
+			for(int i = 0; i < MAX_VOICES; i++)
+			{
+				if(m_aVoices[i].m_pSample && (Cmd.m_Type == CMD_STOPALL || m_aVoices[i].m_pSample == Cmd.m_pSample))
+					FreeVoice(&m_aVoices[i], true);
+			}
+		}
+
+		sync_barrier();
+		m_QueueRead = m_QueueRead+1;
+	}
+}
+
+void CMixer::MixVoices(unsigned Frames)
+{
+	const int CenterX = m_CenterX;
+	const int CenterY = m_CenterY;
+	const float MaxDistance = m_MaxDistance;
+
+	for(int i = 0; i < MAX_VOICES; i++)
+	{
+		CVoice *v = &m_aVoices[i];
+		if(!v->m_pSample)
+			continue;
+
+		CMixerSample *pSample = v->m_pSample;
+		unsigned End = pSample->m_NumFrames-v->m_Tick;
+
+		// make sure that we don't go outside the sound data
+		if(Frames < End)
+			End = Frames;
+
+		int Lvol = m_aChannelVolumes[v->m_Channel];
+		int Rvol = Lvol;
+
+		// volume calculation
+		if(v->m_Flags&FLAG_POS)
+		{
+			int dx = v->m_X - CenterX;
+			int dy = v->m_Y - CenterY;
+			float DistSq = (float)dx*dx+(float)dy*dy;
+			if(DistSq < MaxDistance*MaxDistance)
+			{
+				// linear falloff
+				float Dist = sqrtf(DistSq);
+				float Falloff = 1.0f - Dist/MaxDistance;
+
+				// amplitude after falloff
+				float FalloffAmp = Lvol * Falloff;
+
+				// distribute volume to the channels depending on x difference
+				float Lpan = 0.5f - dx/MaxDistance/2.0f;
+				float Rpan = 1.0f - Lpan;
+
+				// apply square root to preserve sound power after panning
+				Lvol = FalloffAmp*sqrtf(Lpan);
+				Rvol = FalloffAmp*sqrtf(Rpan);
+			}
+			else
+			{
+				Lvol = 0;
+				Rvol = 0;
+			}
+		}
+
+		// voices out of hearing range only advance
+		if(Lvol || Rvol)
+			MixFrames(m_pMixBuffer, &pSample->m_pData[v->m_Tick*pSample->m_Channels], pSample->m_Channels, End, Lvol, Rvol);
+		else
+			m_NumCulled++;
+		v->m_Tick += End;
+
+		// free voice if not used any more
+		if(v->m_Tick == pSample->m_NumFrames)
+		{
+			if(v->m_Flags&FLAG_LOOP)
+				v->m_Tick = 0;
+			else
+				FreeVoice(v, false);
+		}
+	}
+}
+
+void CMixer::Mix(short *pFinalOut, unsigned Frames)
+{
+	RunCommands();
+
+	m_NumCulled = 0;
+	if(!m_MaxFrames)
+	{
+		mem_zero(pFinalOut, Frames*2*sizeof(short));
+		return;
+	}
+
+	while(Frames)
+	{
+		unsigned Chunk = min(Frames, m_MaxFrames);
+		mem_zero(m_pMixBuffer, Chunk*2*sizeof(int));
+		MixVoices(Chunk);
+		ClampFrames(pFinalOut, m_pMixBuffer, Chunk, m_MasterVolume);
+
+		pFinalOut += Chunk*2;
+		Frames -= Chunk;
+	}
+}
+
+void CMixer::MixFramesScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	const short *pInR = Channels == 1 ? pIn : pIn+1;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		pOut[s*2] += pIn[s*Channels]*Lvol;
+		pOut[s*2+1] += pInR[s*Channels]*Rvol;
+	}
+}
+
+void CMixer::MixFrames(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	unsigned s = 0;
+#if defined(CONF_MIXER_SSE2)
+	// 4 frames at a time, the 32 bit products are put together from
+	// the low and high halves of the 16 bit multiplications
+	const __m128i Vol = _mm_set_epi16(Rvol, Lvol, Rvol, Lvol, Rvol, Lvol, Rvol, Lvol);
+	for(; s+4 <= Frames; s += 4)
+	{
+		__m128i In;
+		if(Channels == 1)
+		{
+			In = _mm_loadl_epi64((const __m128i *)(pIn+s));
+			In = _mm_unpacklo_epi16(In, In);
+		}
+		else
+			In = _mm_loadu_si128((const __m128i *)(pIn+s*2));
+
+		__m128i Lo = _mm_mullo_epi16(In, Vol);
+		__m128i Hi = _mm_mulhi_epi16(In, Vol);
+		__m128i *pDst = (__m128i *)(pOut+s*2);
+		_mm_storeu_si128(pDst, _mm_add_epi32(_mm_loadu_si128(pDst), _mm_unpacklo_epi16(Lo, Hi)));
+		_mm_storeu_si128(pDst+1, _mm_add_epi32(_mm_loadu_si128(pDst+1), _mm_unpackhi_epi16(Lo, Hi)));
+	}
+#endif
+	MixFramesScalar(pOut+s*2, pIn+s*Channels, Channels, Frames-s, Lvol, Rvol);
+}
+
+void CMixer::ClampFramesScalar(short *pOut, const int *pIn, unsigned Frames, int MasterVol)
+{
+	const float Scale = MasterVol/(101.0f*256.0f);
+	for(unsigned i = 0; i < Frames*2; i++)
+	{
+		float Value = pIn[i]*Scale;
+		if(Value > 32767.0f)
+			Value = 32767.0f;
+		else if(Value < -32767.0f)
+			Value = -32767.0f;
+		pOut[i] = (short)(int)Value;
+	}
+}
+
+void CMixer::ClampFrames(short *pOut, const int *pIn, unsigned Frames, int MasterVol)
+{
+	unsigned i = 0;
+#if defined(CONF_MIXER_SSE2)
+	const __m128 Scale = _mm_set1_ps(MasterVol/(101.0f*256.0f));
+	const __m128 Max = _mm_set1_ps(32767.0f);
+	const __m128 Min = _mm_set1_ps(-32767.0f);
+	for(; i+4 <= Frames; i += 4)
+	{
+		__m128 A = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pIn+i*2))), Scale);
+		__m128 B = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pIn+i*2+4))), Scale);
+		A = _mm_max_ps(_mm_min_ps(A, Max), Min);
+		B = _mm_max_ps(_mm_min_ps(B, Max), Min);
+		_mm_storeu_si128((__m128i *)(pOut+i*2), _mm_packs_epi32(_mm_cvttps_epi32(A), _mm_cvttps_epi32(B)));
+	}
+#endif
+	ClampFramesScalar(pOut+i*2, pIn+i*2, Frames-i, MasterVol);
+}
@@ -0,0 +1,123 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_MIXER_H
+#define ENGINE_CLIENT_MIXER_H
+
+#include <base/system.h>
+
+// 16 bit sample data as the mixer plays it, mono or interleaved stereo
+struct CMixerSample
+{
+	short *m_pData;
+	int m_NumFrames;
+	int m_Channels;
+	int m_PausedAt; // only touched by the mixing thread once the sample is played
+};
+
+// software mixer of the client sound. it does not know about the audio device,
+// so it can just as well mix into memory.
+//
+// the voices belong to the thread that calls Mix. Play, Stop and StopAll are
+// called from the main thread and only queue a command, the mixing thread picks
+// the commands up at the start of the next Mix without any lock.
+class CMixer
+{
+public:
+	enum
+	{
+		MAX_VOICES = 64,
+		MAX_CHANNELS = 16,
+		QUEUE_SIZE = 256,
+
+		// same as the ISound flags
+		FLAG_LOOP = 1,
+		FLAG_POS = 2,
+	};
+
+	CMixer();
+	~CMixer();
+
+	void Init(unsigned MaxFrames);
+
+	// main thread
+	int Play(int ChannelID, CMixerSample *pSample, int Flags, int x, int y);
+	void Stop(const CMixerSample *pSample);
+	void StopAll();
+	bool IsPlaying(const CMixerSample *pSample) const;
+
+	void SetChannelVolume(int ChannelID, int Vol) { m_aChannelVolumes[ChannelID] = Vol; }
+	void SetListenerPos(int x, int y) { m_CenterX = x; m_CenterY = y; }
+	void SetMaxDistance(float Distance) { m_MaxDistance = Distance; }
+	void SetMasterVolume(int Volume) { m_MasterVolume = Volume; }
+
+	// mixing thread, writes interleaved stereo
+	void Mix(short *pFinalOut, unsigned Frames);
+
+	// voices of the last Mix that were out of hearing range and not mixed
+	int NumCulledVoices() const { return m_NumCulled; }
+
+	// the inner loops, the scalar versions are what the vectorized ones must match
+	static void MixFrames(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol);
+	static void MixFramesScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol);
+	static void ClampFrames(short *pOut, const int *pIn, unsigned Frames, int MasterVol);
+	static void ClampFramesScalar(short *pOut, const int *pIn, unsigned Frames, int MasterVol);
+
+private:
+	enum
+	{
+		CMD_PLAY = 0,
+		CMD_STOP,
+		CMD_STOPALL,
+	};
+
+	struct CCommand
+	{
+		int m_Type;
+		int m_Voice;
+		unsigned m_Serial;
+		CMixerSample *m_pSample;
+		int m_Channel;
+		int m_Flags;
+		int m_X, m_Y;
+	};
+
+	struct CVoice
+	{
+		CMixerSample *m_pSample;
+		int m_Channel;
+		int m_Tick;
+		int m_Flags;
+		int m_X, m_Y;
+		unsigned m_Serial;
+	};
+
+	// mixing thread
+	CVoice m_aVoices[MAX_VOICES];
+	int *m_pMixBuffer;
+	unsigned m_MaxFrames;
+	int m_NumCulled;
+
+	// a voice is free again once the mixing thread reports the serial it was started with
+	unsigned m_aVoiceSerial[MAX_VOICES];
+	volatile unsigned m_aVoiceDone[MAX_VOICES];
+	const CMixerSample *m_apVoiceSample[MAX_VOICES];
+	int m_NextVoice;
+
+	// single producer, single consumer
+	CCommand m_aQueue[QUEUE_SIZE];
+	volatile unsigned m_QueueWrite;
+	volatile unsigned m_QueueRead;
+
+	volatile int m_aChannelVolumes[MAX_CHANNELS];
+	volatile int m_CenterX;
+	volatile int m_CenterY;
+	volatile float m_MaxDistance;
+	volatile int m_MasterVolume;
+
+	bool PushCommand(const CCommand &Cmd, bool Wait);
+	void RunCommands();
+	void FreeVoice(CVoice *pVoice, bool Pause);
+	void MixVoices(unsigned Frames);
+};
+
+#endif
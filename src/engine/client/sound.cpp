@@ -10,6 +10,7 @@
 
 #include "SDL.h"
 
+#include "mixer.h"
 #include "sound.h"
 
 extern "C"
@@ -21,190 +22,43 @@ extern "C"
 enum
 {
 	NUM_SAMPLES = 512,
-	NUM_VOICES = 64,
-	NUM_CHANNELS = 16,
+	NUM_CHANNELS = CMixer::MAX_CHANNELS,
 };
 
-struct CSample
+struct CSample : public CMixerSample
 {
-	short *m_pData;
-	int m_NumFrames;
 	int m_Rate;
-	int m_Channels;
 	int m_LoopStart;
 	int m_LoopEnd;
-	int m_PausedAt;
 };
 
-struct CChannel
-{
-	int m_Vol; // 0 - 255
-};
-
-struct CVoice
-{
-	CSample *m_pSample;
-	CChannel *m_pChannel;
-	int m_Tick;
-	int m_Vol; // 0 - 255
-	int m_Flags;
-	int m_X, m_Y;
-};
-
-static CSample m_aSamples[NUM_SAMPLES] = {{0}};
-static CVoice m_aVoices[NUM_VOICES] = {{0}};
-static CChannel m_aChannels[NUM_CHANNELS];
-
-static LOCK m_SoundLock = 0;
-
-static int m_CenterX = 0;
-static int m_CenterY = 0;
+static CSample m_aSamples[NUM_SAMPLES];
 
-static float m_MaxDistance = 1500.0f;
+// the voices live in the mixer, the audio callback takes the commands
+// of the main thread from its queue without holding a lock
+static CMixer m_Mixer;
 
 static int m_MixingRate = 48000;
-static volatile int m_SoundVolume = 100;
-
-static int m_NextVoice = 0;
-static int *m_pMixBuffer = 0;	// buffer only used by the thread callback function
-static unsigned m_MaxFrames = 0;
+static int m_SoundVolume = -1;
 
 static IOHANDLE s_File;
 
-// TODO: there should be a faster way todo this
-static short Int2Short(int i)
-{
-	if(i > 0x7fff)
-		return 0x7fff;
-	else if(i < -0x7fff)
-		return -0x7fff;
-	return i;
-}
-
-static void Mix(short *pFinalOut, unsigned Frames)
+static void SdlCallback(void *pUnused, Uint8 *pStream, int Len)
 {
-	int MasterVol;
-	mem_zero(m_pMixBuffer, m_MaxFrames*2*sizeof(int));
-	Frames = min(Frames, m_MaxFrames);
-
-	// aquire lock while we are mixing
-	lock_wait(m_SoundLock);
-
-	MasterVol = m_SoundVolume;
-
-	for(unsigned i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample)
-		{
-			// mix voice
-			CVoice *v = &m_aVoices[i];
-			int *pOut = m_pMixBuffer;
-
-			int Step = v->m_pSample->m_Channels; // setup input sources
-			short *pInL = &v->m_pSample->m_pData[v->m_Tick*Step];
-			short *pInR = &v->m_pSample->m_pData[v->m_Tick*Step+1];
-
-			unsigned End = v->m_pSample->m_NumFrames-v->m_Tick;
-
-			int Rvol = v->m_pChannel->m_Vol;
-			int Lvol = v->m_pChannel->m_Vol;
-
-			// make sure that we don't go outside the sound data
-			if(Frames < End)
-				End = Frames;
-
-			// check if we have a mono sound
-			if(v->m_pSample->m_Channels == 1)
-				pInR = pInL;
-
-			// volume calculation
-			if(v->m_Flags&ISound::FLAG_POS)
-			{
-				int dx = v->m_X - m_CenterX;
-				int dy = v->m_Y - m_CenterY;
-				float Dist = sqrtf((float)dx*dx+dy*dy);
-				if(Dist >= 0.0f && Dist < m_MaxDistance)
-				{
-					// linear falloff
-					float Falloff = 1.0f - Dist/m_MaxDistance;
-
-					// amplitude after falloff
-					float FalloffAmp = v->m_pChannel->m_Vol * Falloff;
-
-					// distribute volume to the channels depending on x difference
-					float Lpan = 0.5f - dx/m_MaxDistance/2.0f;
-					float Rpan = 1.0f - Lpan;
-
-					// apply square root to preserve sound power after panning
-					float LampFactor = sqrt(Lpan);
-					float RampFactor = sqrt(Rpan);
-
-					// volume of the channels
-					Lvol = FalloffAmp*LampFactor;
-					Rvol = FalloffAmp*RampFactor;
-				}
-				else
-				{
-					Lvol = 0;
-					Rvol = 0;
-				}
-			}
-
-			// process all frames
-			for(unsigned s = 0; s < End; s++)
-			{
-				*pOut++ += (*pInL)*Lvol;
-				*pOut++ += (*pInR)*Rvol;
-				pInL += Step;
-				pInR += Step;
-				v->m_Tick++;
-			}
-
-			// free voice if not used any more
-			if(v->m_Tick == v->m_pSample->m_NumFrames)
-			{
-				if(v->m_Flags&ISound::FLAG_LOOP)
-					v->m_Tick = 0;
-				else
-					v->m_pSample = 0;
-			}
-		}
-	}
-
-
-	// release the lock
-	lock_unlock(m_SoundLock);
-
-	{
-		// clamp accumulated values
-		// TODO: this seams slow
-		for(unsigned i = 0; i < Frames; i++)
-		{
-			int j = i<<1;
-			int vl = ((m_pMixBuffer[j]*MasterVol)/101)>>8;
-			int vr = ((m_pMixBuffer[j+1]*MasterVol)/101)>>8;
-
-			pFinalOut[j] = Int2Short(vl);
-			pFinalOut[j+1] = Int2Short(vr);
-		}
-	}
+	(void)pUnused;
+	unsigned Frames = Len/2/2;
+	m_Mixer.Mix((short *)pStream, Frames);
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
-	swap_endian(pFinalOut, sizeof(short), Frames * 2);
+	swap_endian(pStream, sizeof(short), Frames * 2);
 #endif
 }
 
-static void SdlCallback(void *pUnused, Uint8 *pStream, int Len)
-{
-	(void)pUnused;
-	Mix((short *)pStream, Len/2/2);
-}
-
 
 int CSound::Init()
 {
 	for(int i = 0; i < NUM_CHANNELS; ++i)
-		m_aChannels[i].m_Vol = 255;
+		m_Mixer.SetChannelVolume(i, 255);
 
 	m_SoundEnabled = 0;
 	m_pConfig = Kernel()->RequestInterface<IConfigManager>()->Values();
@@ -213,8 +67,6 @@ int CSound::Init()
 
 	SDL_AudioSpec Format;
 
-	m_SoundLock = lock_create();
-
 	if(!m_pConfig->m_SndInit)
 		return 0;
 
@@ -243,8 +95,7 @@ int CSound::Init()
 	else
 		dbg_msg("client/sound", "sound init successful");
 
-	m_MaxFrames = m_pConfig->m_SndBufferSize*2;
-	m_pMixBuffer = (int *)mem_alloc(m_MaxFrames*2*sizeof(int), 1);
+	m_Mixer.Init(m_pConfig->m_SndBufferSize*2);
 
 	SDL_PauseAudio(0);
 
@@ -263,9 +114,8 @@ int CSound::Update()
 
 	if(WantedVolume != m_SoundVolume)
 	{
-		lock_wait(m_SoundLock);
 		m_SoundVolume = WantedVolume;
-		lock_unlock(m_SoundLock);
+		m_Mixer.SetMasterVolume(WantedVolume);
 	}
 
 	return 0;
@@ -275,12 +125,6 @@ int CSound::Shutdown()
 {
 	SDL_CloseAudio();
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
-	lock_destroy(m_SoundLock);
-	if(m_pMixBuffer)
-	{
-		mem_free(m_pMixBuffer);
-		m_pMixBuffer = 0;
-	}
 	return 0;
 }
 
@@ -389,12 +233,10 @@ ISound::CSampleHandle CSound::LoadWV(const char *pFilename)
 	if(!m_pStorage)
 		return CSampleHandle();
 
-	lock_wait(m_SoundLock);
 	s_File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
 	if(!s_File)
 	{
 		dbg_msg("sound/wv", "failed to open file. filename='%s'", pFilename);
-		lock_unlock(m_SoundLock);
 		return CSampleHandle();
 	}
 
@@ -403,7 +245,6 @@ ISound::CSampleHandle CSound::LoadWV(const char *pFilename)
 	{
 		io_close(s_File);
 		s_File = 0;
-		lock_unlock(m_SoundLock);
 		return CSampleHandle();
 	}
 	pSample = &m_aSamples[SampleID];
@@ -438,7 +279,6 @@ ISound::CSampleHandle CSound::LoadWV(const char *pFilename)
 			dbg_msg("sound/wv", "file is not mono or stereo. filename='%s'", pFilename);
 			io_close(s_File);
 			s_File = 0;
-			lock_unlock(m_SoundLock);
 			return CSampleHandle();
 		}
 
@@ -454,7 +294,6 @@ ISound::CSampleHandle CSound::LoadWV(const char *pFilename)
 			dbg_msg("sound/wv", "bps is %d, not 16, filname='%s'", BitsPerSample, pFilename);
 			io_close(s_File);
 			s_File = 0;
-			lock_unlock(m_SoundLock);
 			return CSampleHandle();
 		}
 
@@ -487,65 +326,31 @@ ISound::CSampleHandle CSound::LoadWV(const char *pFilename)
 		dbg_msg("sound/wv", "loaded %s", pFilename);
 
 	RateConvert(SampleID);
-	lock_unlock(m_SoundLock);
 	return CreateSampleHandle(SampleID);
 }
 
 void CSound::SetListenerPos(float x, float y)
 {
-	m_CenterX = (int)x;
-	m_CenterY = (int)y;
+	m_Mixer.SetListenerPos((int)x, (int)y);
 }
 
 void CSound::SetMaxDistance(float Distance)
 {
-	m_MaxDistance = Distance;
+	m_Mixer.SetMaxDistance(Distance);
 }
 
 void CSound::SetChannelVolume(int ChannelID, float Vol)
 {
-	m_aChannels[ChannelID].m_Vol = (int)(Vol*255.0f);
+	m_Mixer.SetChannelVolume(ChannelID, (int)(Vol*255.0f));
 }
 
 int CSound::Play(int ChannelID, CSampleHandle SampleID, int Flags, float x, float y)
 {
-	if(!SampleID.IsValid())
+	// without the audio callback nobody would empty the command queue
+	if(!m_SoundEnabled || !SampleID.IsValid())
 		return -1;
 
-	int VoiceID = -1;
-	int i;
-
-	lock_wait(m_SoundLock);
-
-	// search for voice
-	for(i = 0; i < NUM_VOICES; i++)
-	{
-		int id = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[id].m_pSample)
-		{
-			VoiceID = id;
-			m_NextVoice = id+1;
-			break;
-		}
-	}
-
-	// voice found, use it
-	if(VoiceID != -1)
-	{
-		m_aVoices[VoiceID].m_pSample = &m_aSamples[SampleID.Id()];
-		m_aVoices[VoiceID].m_pChannel = &m_aChannels[ChannelID];
-		if(Flags & FLAG_LOOP)
-			m_aVoices[VoiceID].m_Tick = m_aSamples[SampleID.Id()].m_PausedAt;
-		else
-			m_aVoices[VoiceID].m_Tick = 0;
-		m_aVoices[VoiceID].m_Vol = 255;
-		m_aVoices[VoiceID].m_Flags = Flags;
-		m_aVoices[VoiceID].m_X = (int)x;
-		m_aVoices[VoiceID].m_Y = (int)y;
-	}
-
-	lock_unlock(m_SoundLock);
-	return VoiceID;
+	return m_Mixer.Play(ChannelID, &m_aSamples[SampleID.Id()], Flags, (int)x, (int)y);
 }
 
 int CSound::PlayAt(int ChannelID, CSampleHandle SampleID, int Flags, float x, float y)
@@ -561,54 +366,24 @@ int CSound::Play(int ChannelID, CSampleHandle SampleID, int Flags)
 void CSound::Stop(CSampleHandle SampleID)
 {
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	CSample *pSample = &m_aSamples[SampleID.Id()];
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample == pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-			m_aVoices[i].m_pSample = 0;
-		}
-	}
-	lock_unlock(m_SoundLock);
+	if(!m_SoundEnabled || !SampleID.IsValid())
+		return;
+	m_Mixer.Stop(&m_aSamples[SampleID.Id()]);
 }
 
 void CSound::StopAll()
 {
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-		}
-		m_aVoices[i].m_pSample = 0;
-	}
-	lock_unlock(m_SoundLock);
+	if(!m_SoundEnabled)
+		return;
+	m_Mixer.StopAll();
 }
 
 bool CSound::IsPlaying(CSampleHandle SampleID)
 {
-	bool Ret = false;
-	lock_wait(m_SoundLock);
-	CSample *pSample = &m_aSamples[SampleID.Id()];
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample == pSample)
-		{
-			Ret = true;
-		}
-	}
-	lock_unlock(m_SoundLock);
-	return Ret;
+	if(!m_SoundEnabled || !SampleID.IsValid())
+		return false;
+	return m_Mixer.IsPlaying(&m_aSamples[SampleID.Id()]);
 }
 
 IEngineSound *CreateEngineSound() { return new CSound; }
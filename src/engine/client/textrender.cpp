@@ -533,6 +533,111 @@ void CGlyphMap::PagesAccessReset()
 	}
 }
 
+CTextLayoutCache::CTextLayoutCache()
+{
+	m_pEntries = new CEntry[NUM_ENTRIES];
+	m_Frame = 0;
+	m_NumTotalPages = -1;
+	m_NumHits = 0;
+	m_NumMisses = 0;
+	m_LastFrameHits = 0;
+	m_LastFrameMisses = 0;
+	Clear();
+}
+
+CTextLayoutCache::~CTextLayoutCache()
+{
+	delete [] m_pEntries;
+}
+
+bool CTextLayoutCache::MakeKey(CKey *pKey, const char *pText, int Length)
+{
+	if(Length >= MAX_TEXT_LENGTH)
+		return false;
+
+	mem_zero(pKey, sizeof(*pKey));
+
+	// fnv-1a, strings that end before the given length are not cached
+	unsigned Hash = 2166136261u;
+	for(int i = 0; i < Length; i++)
+	{
+		if(pText[i] == 0)
+			return false;
+		Hash = (Hash ^ (unsigned char)pText[i]) * 16777619u;
+	}
+	pKey->m_Hash = Hash;
+	pKey->m_Length = Length;
+	return true;
+}
+
+const CTextLayoutCache::CEntry *CTextLayoutCache::Find(const CKey &Key, const char *pText)
+{
+	for(int i = 0; i < MAX_PROBES; i++)
+	{
+		CEntry *pEntry = &m_pEntries[(Key.m_Hash+i)&(NUM_ENTRIES-1)];
+		if(pEntry->m_Used && mem_comp(&pEntry->m_Key, &Key, sizeof(Key)) == 0 && mem_comp(pEntry->m_aText, pText, Key.m_Length) == 0)
+		{
+			pEntry->m_LastUse = m_Frame;
+			m_NumHits++;
+			return pEntry;
+		}
+	}
+	m_NumMisses++;
+	return 0;
+}
+
+CTextLayoutCache::CEntry *CTextLayoutCache::Insert(const CKey &Key, const char *pText)
+{
+	// take a free slot or the one that was not used for the longest time
+	CEntry *pBest = 0;
+	for(int i = 0; i < MAX_PROBES; i++)
+	{
+		CEntry *pEntry = &m_pEntries[(Key.m_Hash+i)&(NUM_ENTRIES-1)];
+		if(!pEntry->m_Used)
+		{
+			pBest = pEntry;
+			break;
+		}
+		if(!pBest || pEntry->m_LastUse < pBest->m_LastUse)
+			pBest = pEntry;
+	}
+
+	pBest->m_Key = Key;
+	mem_copy(pBest->m_aText, pText, Key.m_Length);
+	pBest->m_Used = true;
+	pBest->m_LastUse = m_Frame;
+	pBest->m_lGlyphs.set_size(0);
+	return pBest;
+}
+
+void CTextLayoutCache::Clear()
+{
+	for(int i = 0; i < NUM_ENTRIES; i++)
+	{
+		m_pEntries[i].m_Used = false;
+		m_pEntries[i].m_lGlyphs.clear();
+	}
+}
+
+void CTextLayoutCache::Validate(int NumTotalPages)
+{
+	// atlas pages were dropped or the atlas was recreated
+	if(NumTotalPages != m_NumTotalPages)
+	{
+		Clear();
+		m_NumTotalPages = NumTotalPages;
+	}
+}
+
+void CTextLayoutCache::NextFrame()
+{
+	m_LastFrameHits = m_NumHits;
+	m_LastFrameMisses = m_NumMisses;
+	m_NumHits = 0;
+	m_NumMisses = 0;
+	m_Frame++;
+}
+
 CWordWidthHint CTextRender::MakeWord(CTextCursor *pCursor, const char *pText, const char *pEnd, 
 								int FontSizeIndex, float Size, int PixelSize, vec2 ScreenScale)
 {
@@ -673,6 +778,60 @@ void CTextRender::TextRefreshGlyphs(CTextCursor *pCursor)
 	}
 }
 
+void CTextRender::ApplyLayout(CTextCursor *pCursor, const CTextLayoutCache::CEntry *pEntry)
+{
+	const vec4 TextColor = vec4(m_TextR, m_TextG, m_TextB, m_TextA);
+	const vec4 SecondaryColor = vec4(m_TextSecondaryR, m_TextSecondaryG, m_TextSecondaryB, m_TextSecondaryA);
+	const int NumGlyphs = pEntry->m_lGlyphs.size();
+	pCursor->m_Glyphs.set_size(NumGlyphs);
+	for(int i = 0; i < NumGlyphs; i++)
+	{
+		const CTextLayoutCache::CCachedGlyph &rCached = pEntry->m_lGlyphs[i];
+		CScaledGlyph *pScaled = &pCursor->m_Glyphs[i];
+		pScaled->m_pGlyph = rCached.m_pGlyph;
+		pScaled->m_Size = rCached.m_Size;
+		pScaled->m_NumChars = rCached.m_NumChars;
+		pScaled->m_Line = rCached.m_Line;
+		pScaled->m_Advance = rCached.m_Advance;
+		pScaled->m_TextColor = TextColor;
+		pScaled->m_SecondaryColor = SecondaryColor;
+	}
+
+	pCursor->m_Width = pEntry->m_Width;
+	pCursor->m_Height = pEntry->m_Height;
+	pCursor->m_NextLineAdvanceY = pEntry->m_NextLineAdvanceY;
+	pCursor->m_Advance = pEntry->m_Advance;
+	pCursor->m_LineCount = pEntry->m_LineCount;
+	pCursor->m_CharCount = pEntry->m_CharCount;
+	pCursor->m_Truncated = pEntry->m_Truncated;
+	pCursor->m_StartOfLine = pEntry->m_StartOfLine;
+}
+
+void CTextRender::StoreLayout(CTextLayoutCache::CEntry *pEntry, const CTextCursor *pCursor)
+{
+	const int NumGlyphs = pCursor->m_Glyphs.size();
+	pEntry->m_lGlyphs.set_size(NumGlyphs);
+	for(int i = 0; i < NumGlyphs; i++)
+	{
+		const CScaledGlyph &rScaled = pCursor->m_Glyphs[i];
+		CTextLayoutCache::CCachedGlyph *pCached = &pEntry->m_lGlyphs[i];
+		pCached->m_pGlyph = rScaled.m_pGlyph;
+		pCached->m_Size = rScaled.m_Size;
+		pCached->m_NumChars = rScaled.m_NumChars;
+		pCached->m_Line = rScaled.m_Line;
+		pCached->m_Advance = rScaled.m_Advance;
+	}
+
+	pEntry->m_Width = pCursor->m_Width;
+	pEntry->m_Height = pCursor->m_Height;
+	pEntry->m_NextLineAdvanceY = pCursor->m_NextLineAdvanceY;
+	pEntry->m_Advance = pCursor->m_Advance;
+	pEntry->m_LineCount = pCursor->m_LineCount;
+	pEntry->m_CharCount = pCursor->m_CharCount;
+	pEntry->m_Truncated = pCursor->m_Truncated;
+	pEntry->m_StartOfLine = pCursor->m_StartOfLine;
+}
+
 int CTextRender::LoadFontCollection(const void *pFilename, const void *pBuf, long FileSize)
 {
 	FT_Face FtFace;
@@ -742,11 +901,16 @@ void CTextRender::Init()
 void CTextRender::Update()
 {
 	if(m_pGlyphMap)
+	{
 		m_pGlyphMap->PagesAccessReset();
+		m_LayoutCache.Validate(m_pGlyphMap->NumTotalPages());
+	}
+	m_LayoutCache.NextFrame();
 }
 
 void CTextRender::Shutdown()
 {
+	m_LayoutCache.Clear();
 	delete m_pGlyphMap;
 	if(m_paVariants)
 		mem_free(m_paVariants);
@@ -931,6 +1095,31 @@ void CTextRender::TextDeferred(CTextCursor *pCursor, const char *pText, int Leng
 	if(Length < 0)
 		Length = str_length(pText);
 
+	// a cursor that starts empty can take the layout of an earlier call with the same text
+	CTextLayoutCache::CKey CacheKey;
+	bool Cacheable = pCursor->m_Glyphs.size() == 0 && pCursor->m_LineCount == 1 && pCursor->m_StartOfLine &&
+		pCursor->m_Width == 0 && pCursor->m_NextLineAdvanceY == 0 && pCursor->m_Advance.x == 0 && pCursor->m_Advance.y == 0 &&
+		CTextLayoutCache::MakeKey(&CacheKey, pText, Length);
+	if(Cacheable)
+	{
+		CacheKey.m_PixelSize = PixelSize;
+		CacheKey.m_Flags = Flags;
+		CacheKey.m_MaxLines = MaxLines;
+		CacheKey.m_FontSize = pCursor->m_FontSize;
+		CacheKey.m_MaxWidth = MaxWidth;
+		CacheKey.m_LineSpacing = pCursor->m_LineSpacing;
+		CacheKey.m_ScreenScaleY = ScreenScale.y;
+
+		m_LayoutCache.Validate(m_pGlyphMap->NumTotalPages());
+		const CTextLayoutCache::CEntry *pEntry = m_LayoutCache.Find(CacheKey, pText);
+		if(pEntry)
+		{
+			ApplyLayout(pCursor, pEntry);
+			TextRefreshGlyphs(pCursor);
+			return;
+		}
+	}
+
 	const char *pCur = (char *)pText;
 	const char *pEnd = (char *)pText + Length;
 
@@ -1056,6 +1245,11 @@ void CTextRender::TextDeferred(CTextCursor *pCursor, const char *pText, int Leng
 		}
 	}
 
+	// glyphs rendered for this layout can drop atlas pages, the cache is cleared then
+	m_LayoutCache.Validate(m_pGlyphMap->NumTotalPages());
+	if(Cacheable)
+		StoreLayout(m_LayoutCache.Insert(CacheKey, pText), pCursor);
+
 	TextRefreshGlyphs(pCursor);
 }
 
@@ -1258,4 +1452,10 @@ vec2 CTextRender::CaretPosition(CTextCursor *pCursor, int NumChars)
 	return pCursor->m_CursorPos + pLastScaled->m_Advance + vec2(pLastScaled->m_pGlyph->m_AdvanceX, 0) * pLastScaled->m_Size;
 }
 
+void CTextRender::LayoutCacheStats(int *pHits, int *pMisses) const
+{
+	*pHits = m_LayoutCache.LastFrameHits();
+	*pMisses = m_LayoutCache.LastFrameMisses();
+}
+
 IEngineTextRender *CreateEngineTextRender() { return new CTextRender; }
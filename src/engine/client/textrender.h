@@ -147,6 +147,86 @@ struct CWordWidthHint
 	bool m_IsBroken;
 };
 
+// layouts of recently laid out strings, so text that is drawn every frame
+// skips utf8 decoding, glyph lookup, kerning and wrapping
+class CTextLayoutCache
+{
+public:
+	enum
+	{
+		NUM_ENTRIES = 512,
+		MAX_PROBES = 8,
+		MAX_TEXT_LENGTH = 256,
+	};
+
+	// everything besides the text that changes the layout
+	struct CKey
+	{
+		unsigned m_Hash;
+		int m_Length;
+		int m_PixelSize;
+		int m_Flags;
+		int m_MaxLines;
+		float m_FontSize;
+		float m_MaxWidth;
+		float m_LineSpacing;
+		float m_ScreenScaleY;
+	};
+
+	struct CCachedGlyph
+	{
+		CGlyph *m_pGlyph;
+		float m_Size;
+		int m_NumChars;
+		int m_Line;
+		vec2 m_Advance;
+	};
+
+	struct CEntry
+	{
+		CKey m_Key;
+		char m_aText[MAX_TEXT_LENGTH];
+		bool m_Used;
+		int m_LastUse;
+
+		// cursor state after the layout
+		float m_Width;
+		float m_Height;
+		float m_NextLineAdvanceY;
+		vec2 m_Advance;
+		int m_LineCount;
+		int m_CharCount;
+		bool m_Truncated;
+		bool m_StartOfLine;
+		array<CCachedGlyph> m_lGlyphs;
+	};
+
+private:
+	CEntry *m_pEntries;
+	int m_Frame;
+	int m_NumTotalPages;
+
+	int m_NumHits;
+	int m_NumMisses;
+	int m_LastFrameHits;
+	int m_LastFrameMisses;
+
+public:
+	CTextLayoutCache();
+	~CTextLayoutCache();
+
+	static bool MakeKey(CKey *pKey, const char *pText, int Length);
+
+	const CEntry *Find(const CKey &Key, const char *pText);
+	CEntry *Insert(const CKey &Key, const char *pText);
+	void Clear();
+	void Validate(int NumTotalPages);
+	void NextFrame();
+
+	int LastFrameHits() const { return m_LastFrameHits; }
+	int LastFrameMisses() const { return m_LastFrameMisses; }
+};
+
 class CTextRender : public IEngineTextRender
 {
 	IGraphics *m_pGraphics;
@@ -164,6 +244,7 @@ class CTextRender : public IEngineTextRender
 
 	CGlyphMap *m_pGlyphMap;
 	void *m_apFontData[MAX_FACES];
+	CTextLayoutCache m_LayoutCache;
 
 	// support regional variant fonts
 	int m_NumVariants;
@@ -182,6 +263,8 @@ class CTextRender : public IEngineTextRender
 	CWordWidthHint MakeWord(CTextCursor *pCursor, const char *pText, const char *pEnd, 
 						int FontSizeIndex, float Size, int PixelSize, vec2 ScreenScale);
 	void TextRefreshGlyphs(CTextCursor *pCursor);
+	void ApplyLayout(CTextCursor *pCursor, const CTextLayoutCache::CEntry *pEntry);
+	void StoreLayout(CTextLayoutCache::CEntry *pEntry, const CTextCursor *pCursor);
 
 	void DrawText(CTextCursor *pCursor, vec2 Offset, int Texture, bool IsSecondary, float Alpha, int StartGlyph, int NumGlyphs);
 
@@ -215,6 +298,8 @@ public:
 	void DrawTextShadowed(CTextCursor *pCursor, vec2 ShadowOffset, float Alpha, int StartGlyph, int NumGlyphs);
 
 	vec2 CaretPosition(CTextCursor *pCursor, int NumChars);
+
+	void LayoutCacheStats(int *pHits, int *pMisses) const;
 };
 
 #endif
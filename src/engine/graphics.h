@@ -3,9 +3,11 @@
 #ifndef ENGINE_GRAPHICS_H
 #define ENGINE_GRAPHICS_H
 
+#include <base/system.h>
 #include <base/vmath.h>
 
 #include "kernel.h"
+#include <engine/shared/jobs.h>
 
 
 class CImageInfo
@@ -36,6 +38,41 @@ public:
 	void *m_pData;
 };
 
+/*
+	Structure: CImageLoadJob
+		A png image that is decoded on a worker thread, see <IGraphics::LoadPNGAsync>.
+		The image can be used once <Done> returns true. <m_Loaded> tells if the
+		decode was successful, the caller owns <m_Image.m_pData> afterwards.
+*/
+class CImageLoadJob
+{
+public:
+	typedef bool (*FPrepare)(CImageLoadJob *pJob);
+	typedef void (*FProcess)(CImageLoadJob *pJob);
+
+	CJob m_Job;
+	class IGraphics *m_pGraphics;
+	char m_aFilename[IO_MAX_PATH_LENGTH];
+	int m_StorageType;
+	CImageInfo m_Image;
+	bool m_Loaded;
+
+	// optional, runs on the worker thread before the decode. returning true
+	// means it filled in the image itself and the decode is skipped
+	FPrepare m_pfnPrepare;
+	// optional, runs on the worker thread after a successful decode
+	FProcess m_pfnProcess;
+	void *m_pUser;
+
+	CImageLoadJob() : m_pGraphics(0), m_StorageType(0), m_Loaded(false), m_pfnPrepare(0), m_pfnProcess(0), m_pUser(0)
+	{
+		m_aFilename[0] = 0;
+		mem_zero(&m_Image, sizeof(m_Image));
+	}
+
+	bool Done() const { return m_Job.Status() == CJob::STATE_DONE; }
+};
+
 /*
 	Structure: CVideoMode
 */
@@ -95,6 +132,20 @@ public:
 		void Invalidate() { m_Id = -1; }
 	};
 
+	class CBufferHandle
+	{
+		friend class IGraphics;
+		int m_Id;
+	public:
+		CBufferHandle()
+		: m_Id(-1)
+		{}
+
+		bool IsValid() const { return Id() >= 0; }
+		int Id() const { return m_Id; }
+		void Invalidate() { m_Id = -1; }
+	};
+
 	int ScreenWidth() const { return m_ScreenWidth; }
 	int ScreenHeight() const { return m_ScreenHeight; }
 	float ScreenAspect() const { return (float)ScreenWidth()/(float)ScreenHeight(); }
@@ -121,6 +172,7 @@ public:
 	virtual int MemoryUsage() const = 0;
 
 	virtual int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType) = 0;
+	virtual void LoadPNGAsync(CImageLoadJob *pJob, const char *pFilename, int StorageType) = 0;
 
 	virtual int UnloadTexture(CTextureHandle *Index) = 0;
 	virtual CTextureHandle LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags) = 0;
@@ -164,6 +216,17 @@ public:
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num) = 0;
 	virtual void QuadsText(float x, float y, float Size, const char *pText) = 0;
 
+	// static quad buffers: quads drawn between QuadsBeginRecording and
+	// QuadsEndRecording are stored in a buffer instead of being rendered,
+	// ranges of it can then be drawn with QuadsDrawBuffer between
+	// QuadsBegin and QuadsEnd using the current color, texture and blending
+	virtual bool QuadBuffersSupported() const = 0;
+	virtual void QuadsBeginRecording() = 0;
+	virtual int QuadsRecorded() const = 0;
+	virtual CBufferHandle QuadsEndRecording() = 0;
+	virtual void QuadsDrawBuffer(CBufferHandle Buffer, int Offset, int Num) = 0;
+	virtual void UnloadBuffer(CBufferHandle *pBuffer) = 0;
+
 	struct CColorVertex
 	{
 		int m_Index;
@@ -196,12 +259,33 @@ protected:
 		Tex.m_Id = Index;
 		return Tex;
 	}
+
+	inline CBufferHandle CreateBufferHandle(int Index)
+	{
+		CBufferHandle Buffer;
+		Buffer.m_Id = Index;
+		return Buffer;
+	}
 };
 
 class IEngineGraphics : public IGraphics
 {
 	MACRO_INTERFACE("enginegraphics", 0)
 public:
+	// what the backend was asked to do, only recorded by the null backend
+	struct CBackendStats
+	{
+		int64 m_NumFrames;
+		int64 m_NumCommandBuffers;
+		int64 m_NumCommands;
+		int64 m_NumDrawCalls;
+		int64 m_NumVertices;
+		int64 m_NumTextureUploads;
+		int64 m_TextureUploadBytes;
+		int64 m_NumBufferUploads;
+		int64 m_BufferUploadBytes;
+	};
+
 	virtual int Init() = 0;
 	virtual void Shutdown() = 0;
 
@@ -217,6 +301,10 @@ public:
 	virtual int WindowActive() = 0;
 	virtual int WindowOpen() = 0;
 
+	virtual bool GetBackendStats(CBackendStats *pStats) const = 0;
+	// total time the main thread spent waiting for the backend to catch up
+	virtual int64 BackendWaitTime() const = 0;
+
 };
 
 extern IEngineGraphics *CreateEngineGraphics(); // NOTE: not used
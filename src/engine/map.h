@@ -27,6 +27,7 @@ public:
 	virtual bool Load(const char *pMapName, class IStorage *pStorage=0) = 0;
 	virtual bool IsLoaded() = 0;
 	virtual void Unload() = 0;
+	virtual int MemoryUsage() const = 0; // bytes of map data held in memory
 	virtual SHA256_DIGEST Sha256() = 0;
 	virtual unsigned Crc() = 0;
 };
@@ -11,8 +11,14 @@ class IServer : public IInterface
 protected:
 	int m_CurrentGameTick;
 	int m_TickSpeed;
+	int m_Instance;
 
 public:
+	enum
+	{
+		MAX_INSTANCES=16,
+	};
+
 	/*
 		Structure: CClientInfo
 	*/
@@ -24,6 +30,8 @@ public:
 
 	int Tick() const { return m_CurrentGameTick; }
 	int TickSpeed() const { return m_TickSpeed; }
+	// index of this server among the ones the process hosts, see --instances
+	int Instance() const { return m_Instance; }
 
 	virtual const char *ClientName(int ClientID) const = 0;
 	virtual const char *ClientClan(int ClientID) const = 0;
@@ -55,6 +63,10 @@ public:
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
+	// ticks a client can go without a snapshot on top of the snapshot rate, the game
+	// has to keep its events that long so that the client gets them with its next one
+	virtual int MaxSnapshotDelay() = 0;
+
 	enum
 	{
 		RCON_CID_SERV=-1,
@@ -96,12 +108,18 @@ public:
 	virtual bool IsClientReady(int ClientID) const = 0;
 	virtual bool IsClientPlayer(int ClientID) const = 0;
 	virtual bool IsClientSpectator(int ClientID) const = 0;
+	virtual bool IsClientAlive(int ClientID) const = 0;
 
 	virtual const char *GameType() const = 0;
 	virtual const char *Version() const = 0;
 	virtual const char *NetVersion() const = 0;
 	virtual const char *NetVersionHashUsed() const = 0;
 	virtual const char *NetVersionHashReal() const = 0;
+	virtual const char *GetItemName(int Type) const = 0;
+
+	// raw tuning parameters, used to record and replay the simulation
+	virtual int GetTuning(void *pData, int MaxSize) const = 0;
+	virtual void SetTuning(const void *pData, int Size) = 0;
 
 	virtual bool TimeScore() const { return false; }
 };
@@ -0,0 +1,82 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/tl/algorithm.h>
+
+#include "profiler.h"
+
+CTickProfiler::CTickProfiler()
+{
+	m_Enabled = false;
+	Reset();
+}
+
+void CTickProfiler::SetEnabled(bool Enabled)
+{
+	if(Enabled && !m_Enabled)
+		Reset();
+	m_Enabled = Enabled;
+}
+
+void CTickProfiler::Reset()
+{
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		m_aPhases[i].m_NumSamples = 0;
+		m_aPhases[i].m_NextSample = 0;
+		m_aPhases[i].m_Max = 0;
+	}
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		ResetClient(i);
+	m_ResetTime = time_get();
+}
+
+void CTickProfiler::ResetClient(int ClientID)
+{
+	mem_zero(&m_aClients[ClientID], sizeof(m_aClients[ClientID]));
+}
+
+void CTickProfiler::AddSample(int Phase, int64 Duration)
+{
+	// the clock is not guaranteed to be monotonic
+	Duration = max(Duration, (int64)0);
+
+	CPhase *pPhase = &m_aPhases[Phase];
+	pPhase->m_aSamples[pPhase->m_NextSample] = Duration;
+	pPhase->m_NextSample = (pPhase->m_NextSample+1)%MAX_SAMPLES;
+	pPhase->m_NumSamples = min(pPhase->m_NumSamples+1, (int)MAX_SAMPLES);
+	pPhase->m_Max = max(pPhase->m_Max, Duration);
+}
+
+void CTickProfiler::AddClientSnap(int ClientID, int64 BuildTime, int64 CompressTime)
+{
+	CClient *pClient = &m_aClients[ClientID];
+	pClient->m_SnapBuildTime += max(BuildTime, (int64)0);
+	pClient->m_SnapCompressTime += max(CompressTime, (int64)0);
+	pClient->m_NumSnaps++;
+}
+
+void CTickProfiler::GetPhaseStats(int Phase, int64 *pP50, int64 *pP99, int64 *pMax) const
+{
+	const CPhase *pPhase = &m_aPhases[Phase];
+	if(pPhase->m_NumSamples == 0)
+	{
+		*pP50 = *pP99 = *pMax = 0;
+		return;
+	}
+
+	// sort a copy, this only happens on request
+	int64 aSorted[MAX_SAMPLES];
+	mem_copy(aSorted, pPhase->m_aSamples, pPhase->m_NumSamples*sizeof(int64));
+	sort(plain_range<int64>(aSorted, aSorted+pPhase->m_NumSamples));
+
+	*pP50 = ToMicroseconds(aSorted[(pPhase->m_NumSamples-1)*50/100]);
+	*pP99 = ToMicroseconds(aSorted[(pPhase->m_NumSamples-1)*99/100]);
+	*pMax = ToMicroseconds(pPhase->m_Max);
+}
+
+const char *CTickProfiler::PhaseName(int Phase)
+{
+	static const char *s_apNames[NUM_PHASES] = { "tick", "snap", "net", "register" };
+	return s_apNames[Phase];
+}
@@ -0,0 +1,90 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_PROFILER_H
+#define ENGINE_SERVER_PROFILER_H
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+
+class CTickProfiler
+{
+public:
+	enum
+	{
+		PHASE_TICK=0,
+		PHASE_SNAP,
+		PHASE_NETWORK,
+		PHASE_REGISTER,
+		NUM_PHASES,
+
+		MAX_SAMPLES=512, // about 10 seconds of ticks
+	};
+
+	class CPhase
+	{
+	public:
+		int64 m_aSamples[MAX_SAMPLES];
+		int m_NumSamples;
+		int m_NextSample;
+		int64 m_Max;
+	};
+
+	class CClient
+	{
+	public:
+		int64 m_SnapBuildTime;
+		int64 m_SnapCompressTime;
+		int m_NumSnaps;
+		int64 m_BytesSent;
+	};
+
+private:
+	CPhase m_aPhases[NUM_PHASES];
+	CClient m_aClients[MAX_CLIENTS];
+	bool m_Enabled;
+	int64 m_ResetTime;
+
+public:
+	CTickProfiler();
+
+	bool IsEnabled() const { return m_Enabled; }
+	void SetEnabled(bool Enabled);
+	void Reset();
+	void ResetClient(int ClientID);
+
+	void AddSample(int Phase, int64 Duration);
+	void AddClientSnap(int ClientID, int64 BuildTime, int64 CompressTime);
+	void AddClientBytes(int ClientID, int Bytes) { if(m_Enabled) m_aClients[ClientID].m_BytesSent += Bytes; }
+
+	// all times are returned in microseconds
+	void GetPhaseStats(int Phase, int64 *pP50, int64 *pP99, int64 *pMax) const;
+	const CClient *GetClient(int ClientID) const { return &m_aClients[ClientID]; }
+	int64 TimeSinceReset() const { return time_get()-m_ResetTime; }
+
+	static const char *PhaseName(int Phase);
+	static int64 ToMicroseconds(int64 Time) { return Time*1000000/time_freq(); }
+};
+
+// measures the lifetime of the scope, does nothing if the profiler is disabled
+class CProfileScope
+{
+	CTickProfiler *m_pProfiler;
+	int m_Phase;
+	int64 m_StartTime;
+
+public:
+	CProfileScope(CTickProfiler *pProfiler, int Phase)
+	{
+		m_pProfiler = pProfiler->IsEnabled() ? pProfiler : 0;
+		m_Phase = Phase;
+		m_StartTime = m_pProfiler ? time_get() : 0;
+	}
+
+	~CProfileScope()
+	{
+		if(m_pProfiler)
+			m_pProfiler->AddSample(m_Phase, time_get()-m_StartTime);
+	}
+};
+
+#endif
@@ -45,7 +45,7 @@ void CRegister::RegisterSendFwcheckresponse(NETADDR *pAddr, TOKEN Token)
 
 void CRegister::RegisterSendHeartbeat(NETADDR Addr)
 {
-	static unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
+	unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
 	unsigned short Port = m_pConfig->m_SvPort;
 	CNetChunk Packet;
 
@@ -55,7 +55,7 @@ void CRegister::RegisterSendHeartbeat(NETADDR Addr)
 	Packet.m_Address = Addr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 	Packet.m_DataSize = sizeof(SERVERBROWSE_HEARTBEAT) + 2;
-	Packet.m_pData = &aData;
+	Packet.m_pData = aData;
 
 	// supply the set port that the master can use if it has problems
 	if(m_pConfig->m_SvExternalPort)
@@ -0,0 +1,327 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+
+#include "replay.h"
+
+static const unsigned char gs_aReplayMarker[8] = {'T', 'W', 'R', 'E', 'P', 'L', 'A', 'Y'};
+
+CReplayRecorder::CReplayRecorder()
+{
+	m_pConsole = 0;
+	m_File = 0;
+	m_NumTicks = 0;
+	m_NumTuning = 0;
+}
+
+int CReplayRecorder::Start(IStorage *pStorage, IConsole *pConsole, const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc, unsigned Seed)
+{
+	m_pConsole = pConsole;
+	if(m_File)
+	{
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_recorder", "Replay recording is already active");
+		return -1;
+	}
+
+	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!m_File)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "Unable to open '%s' for recording", pFilename);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_recorder", aBuf);
+		return -1;
+	}
+
+	io_write(m_File, gs_aReplayMarker, sizeof(gs_aReplayMarker));
+
+	CPacker Header;
+	Header.Reset();
+	Header.AddInt(CReplay::VERSION);
+	Header.AddString(pMap, 0);
+	Header.AddInt(MapCrc);
+	Header.AddRaw(MapSha256.data, sizeof(MapSha256.data));
+	Header.AddInt(Seed);
+	Write(&Header);
+
+	m_NumTicks = 0;
+	m_NumTuning = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aLatency[i] = -1;
+		m_aAuthed[i] = -1;
+	}
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "Recording replay to '%s'", pFilename);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_recorder", aBuf);
+	return 0;
+}
+
+int CReplayRecorder::Stop()
+{
+	if(!m_File)
+		return -1;
+
+	io_close(m_File);
+	m_File = 0;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "Replay recording stopped after %d ticks", m_NumTicks);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_recorder", aBuf);
+	return 0;
+}
+
+void CReplayRecorder::Write(const CPacker *pPacker)
+{
+	if(!m_File || pPacker->Error())
+		return;
+
+	unsigned char aSize[2];
+	aSize[0] = (pPacker->Size()>>8)&0xff;
+	aSize[1] = pPacker->Size()&0xff;
+	io_write(m_File, aSize, sizeof(aSize));
+	io_write(m_File, pPacker->Data(), pPacker->Size());
+}
+
+void CReplayRecorder::RecordConfig(const CConfig *pConfig)
+{
+	// only the server variables shape the game, passwords are left out
+	char aBuf[1024*2];
+	CPacker Packer;
+
+	#define MACRO_CONFIG_INT(Name,ScriptName,def,min,max,flags,desc) \
+		if(((flags)&CFGFLAG_SERVER) && !((flags)&CFGFLAG_CLIENT) && !str_find(#ScriptName, "password")) \
+		{ \
+			str_format(aBuf, sizeof(aBuf), "%s %i", #ScriptName, pConfig->m_##Name); \
+			Packer.Reset(); Packer.AddInt(CReplay::REC_CONFIG); Packer.AddString(aBuf, 0); Write(&Packer); \
+		}
+	#define MACRO_CONFIG_STR(Name,ScriptName,len,def,flags,desc) \
+		if(((flags)&CFGFLAG_SERVER) && !((flags)&CFGFLAG_CLIENT) && !str_find(#ScriptName, "password")) \
+		{ \
+			char aEscaped[1024]; \
+			EscapeParam(aEscaped, pConfig->m_##Name, sizeof(aEscaped)); \
+			str_format(aBuf, sizeof(aBuf), "%s \"%s\"", #ScriptName, aEscaped); \
+			Packer.Reset(); Packer.AddInt(CReplay::REC_CONFIG); Packer.AddString(aBuf, 0); Write(&Packer); \
+		}
+	#define MACRO_CONFIG_UTF8STR(Name,ScriptName,size,len,def,flags,desc) MACRO_CONFIG_STR(Name,ScriptName,size,def,flags,desc)
+
+	#include <engine/shared/config_variables.h>
+
+	#undef MACRO_CONFIG_INT
+	#undef MACRO_CONFIG_STR
+	#undef MACRO_CONFIG_UTF8STR
+}
+
+void CReplayRecorder::RecordTuning(const void *pData, int Size)
+{
+	int Num = min(Size/(int)sizeof(int), (int)CReplay::MAX_TUNING_PARAMS);
+	if(Num == m_NumTuning && mem_comp(m_aTuning, pData, Num*sizeof(int)) == 0)
+		return;
+	mem_copy(m_aTuning, pData, Num*sizeof(int));
+	m_NumTuning = Num;
+
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_TUNING);
+	Packer.AddInt(Num);
+	for(int i = 0; i < Num; i++)
+		Packer.AddInt(m_aTuning[i]);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordConnect(int ClientID, bool AsSpec, int Version)
+{
+	m_aLatency[ClientID] = -1;
+	m_aAuthed[ClientID] = -1;
+
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_CONNECT);
+	Packer.AddInt(ClientID);
+	Packer.AddInt(AsSpec);
+	Packer.AddInt(Version);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordEnter(int ClientID)
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_ENTER);
+	Packer.AddInt(ClientID);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordDrop(int ClientID, const char *pReason)
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_DROP);
+	Packer.AddInt(ClientID);
+	Packer.AddString(pReason, 128);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordClientState(int ClientID, int Latency, int Authed)
+{
+	if(m_aLatency[ClientID] == Latency && m_aAuthed[ClientID] == Authed)
+		return;
+	m_aLatency[ClientID] = Latency;
+	m_aAuthed[ClientID] = Authed;
+
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_CLIENTSTATE);
+	Packer.AddInt(ClientID);
+	Packer.AddInt(Latency);
+	Packer.AddInt(Authed);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordMessage(int ClientID, const void *pData, int Size)
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_MESSAGE);
+	Packer.AddInt(ClientID);
+	Packer.AddInt(Size);
+	Packer.AddRaw(pData, Size);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordInput(int Type, int ClientID, const int *pData)
+{
+	// the input buffer is much larger than the actual input, leave out the unused tail
+	int Size = MAX_INPUT_SIZE;
+	while(Size > 0 && pData[Size-1] == 0)
+		Size--;
+
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(Type);
+	Packer.AddInt(ClientID);
+	Packer.AddInt(Size);
+	for(int i = 0; i < Size; i++)
+		Packer.AddInt(pData[i]);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordTick(int Tick)
+{
+	m_NumTicks++;
+
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_TICK);
+	Packer.AddInt(Tick);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordTickEnd()
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_TICKEND);
+	Write(&Packer);
+}
+
+void CReplayRecorder::RecordSnapshot(int Tick, int Crc)
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt(CReplay::REC_SNAP);
+	Packer.AddInt(Tick);
+	Packer.AddInt(Crc);
+	Write(&Packer);
+}
+
+
+CReplayReader::CReplayReader()
+{
+	m_File = 0;
+	m_aMap[0] = 0;
+	m_MapCrc = 0;
+	m_Seed = 0;
+	m_Error = false;
+}
+
+int CReplayReader::Open(IStorage *pStorage, IConsole *pConsole, const char *pFilename)
+{
+	Close();
+	m_Error = false;
+
+	m_File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!m_File)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "could not open '%s'", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_reader", aBuf);
+		return -1;
+	}
+
+	unsigned char aMarker[sizeof(gs_aReplayMarker)];
+	CUnpacker Header;
+	if(io_read(m_File, aMarker, sizeof(aMarker)) != sizeof(aMarker) || mem_comp(aMarker, gs_aReplayMarker, sizeof(aMarker)) != 0 ||
+		NextRecord(&Header) != CReplay::VERSION)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "'%s' is not a replay file of version %d", pFilename, CReplay::VERSION);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_reader", aBuf);
+		Close();
+		return -1;
+	}
+
+	str_copy(m_aMap, Header.GetString(CUnpacker::SANITIZE_CC), sizeof(m_aMap));
+	m_MapCrc = Header.GetInt();
+	const unsigned char *pSha256 = Header.GetRaw(sizeof(m_MapSha256.data));
+	if(pSha256)
+		mem_copy(m_MapSha256.data, pSha256, sizeof(m_MapSha256.data));
+	m_Seed = Header.GetInt();
+	if(Header.Error())
+	{
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay_reader", "replay header is corrupt");
+		Close();
+		return -1;
+	}
+	return 0;
+}
+
+void CReplayReader::Close()
+{
+	if(m_File)
+	{
+		io_close(m_File);
+		m_File = 0;
+	}
+}
+
+int CReplayReader::NextRecord(CUnpacker *pUnpacker)
+{
+	if(!m_File)
+		return -1;
+
+	unsigned char aSize[2];
+	int Read = io_read(m_File, aSize, sizeof(aSize));
+	if(Read != sizeof(aSize))
+	{
+		// a partial size means the file was cut off
+		m_Error = Read != 0;
+		return -1;
+	}
+
+	int Size = (aSize[0]<<8)|aSize[1];
+	if(Size > (int)sizeof(m_aBuffer) || io_read(m_File, m_aBuffer, Size) != (unsigned)Size)
+	{
+		m_Error = true;
+		return -1;
+	}
+
+	pUnpacker->Reset(m_aBuffer, Size);
+	int Type = pUnpacker->GetInt();
+	return pUnpacker->Error() ? -1 : Type;
+}
@@ -0,0 +1,99 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_REPLAY_H
+#define ENGINE_SERVER_REPLAY_H
+
+#include <base/hash.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+
+// A replay is everything the game server received during one map session:
+// the server config, tuning, client joins/drops, game messages and inputs,
+// in the order the game saw them, plus a crc of every snapshot.
+class CReplay
+{
+public:
+	enum
+	{
+		VERSION=1,
+
+		REC_CONFIG=0,
+		REC_TUNING,
+		REC_CONNECT,
+		REC_ENTER,
+		REC_DROP,
+		REC_CLIENTSTATE,
+		REC_MESSAGE,
+		REC_DIRECTINPUT,
+		REC_PREDICTEDINPUT,
+		REC_TICK,
+		REC_TICKEND,
+		REC_SNAP,
+		NUM_RECS,
+
+		MAX_TUNING_PARAMS=64,
+	};
+};
+
+class CReplayRecorder
+{
+	class IConsole *m_pConsole;
+	IOHANDLE m_File;
+	int m_NumTicks;
+
+	// last recorded state, only changes are written
+	int m_aTuning[CReplay::MAX_TUNING_PARAMS];
+	int m_NumTuning;
+	int m_aLatency[MAX_CLIENTS];
+	int m_aAuthed[MAX_CLIENTS];
+
+	void Write(const CPacker *pPacker);
+
+public:
+	CReplayRecorder();
+
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc, unsigned Seed);
+	int Stop();
+	bool IsRecording() const { return m_File != 0; }
+
+	void RecordConfig(const class CConfig *pConfig);
+	void RecordTuning(const void *pData, int Size);
+	void RecordConnect(int ClientID, bool AsSpec, int Version);
+	void RecordEnter(int ClientID);
+	void RecordDrop(int ClientID, const char *pReason);
+	void RecordClientState(int ClientID, int Latency, int Authed);
+	void RecordMessage(int ClientID, const void *pData, int Size);
+	void RecordInput(int Type, int ClientID, const int *pData);
+	void RecordTick(int Tick);
+	void RecordTickEnd();
+	void RecordSnapshot(int Tick, int Crc);
+};
+
+class CReplayReader
+{
+	IOHANDLE m_File;
+	char m_aMap[64];
+	SHA256_DIGEST m_MapSha256;
+	unsigned m_MapCrc;
+	unsigned m_Seed;
+	unsigned char m_aBuffer[1024*2];
+	bool m_Error;
+
+public:
+	CReplayReader();
+	~CReplayReader() { Close(); }
+
+	int Open(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename);
+	void Close();
+
+	// returns the record type and prepares the unpacker for its data, -1 at the end of the file
+	int NextRecord(CUnpacker *pUnpacker);
+	bool Error() const { return m_Error; }
+
+	const char *Map() const { return m_aMap; }
+	SHA256_DIGEST MapSha256() const { return m_MapSha256; }
+	unsigned MapCrc() const { return m_MapCrc; }
+	unsigned Seed() const { return m_Seed; }
+};
+
+#endif
@@ -27,7 +27,9 @@
 
 #include <mastersrv/mastersrv.h>
 
+#include "profiler.h"
 #include "register.h"
+#include "replay.h"
 #include "server.h"
 
 #if defined(CONF_FAMILY_WINDOWS)
@@ -36,98 +38,10 @@
 #endif
 
 #include <signal.h>
+#include <stdlib.h> // srand
 
 volatile bool InterruptSignaled = false;
 
-CSnapIDPool::CSnapIDPool()
-{
-	Reset();
-}
-
-void CSnapIDPool::Reset()
-{
-	for(int i = 0; i < MAX_IDS; i++)
-	{
-		m_aIDs[i].m_Next = i+1;
-		m_aIDs[i].m_State = 0;
-	}
-
-	m_aIDs[MAX_IDS-1].m_Next = -1;
-	m_FirstFree = 0;
-	m_FirstTimed = -1;
-	m_LastTimed = -1;
-	m_Usage = 0;
-	m_InUsage = 0;
-}
-
-
-void CSnapIDPool::RemoveFirstTimeout()
-{
-	int NextTimed = m_aIDs[m_FirstTimed].m_Next;
-
-	// add it to the free list
-	m_aIDs[m_FirstTimed].m_Next = m_FirstFree;
-	m_aIDs[m_FirstTimed].m_State = 0;
-	m_FirstFree = m_FirstTimed;
-
-	// remove it from the timed list
-	m_FirstTimed = NextTimed;
-	if(m_FirstTimed == -1)
-		m_LastTimed = -1;
-
-	m_Usage--;
-}
-
-int CSnapIDPool::NewID()
-{
-	int64 Now = time_get();
-
-	// process timed ids
-	while(m_FirstTimed != -1 && m_aIDs[m_FirstTimed].m_Timeout < Now)
-		RemoveFirstTimeout();
-
-	int ID = m_FirstFree;
-	dbg_assert(ID != -1, "id error");
-	if(ID == -1)
-		return ID;
-	m_FirstFree = m_aIDs[m_FirstFree].m_Next;
-	m_aIDs[ID].m_State = 1;
-	m_Usage++;
-	m_InUsage++;
-	return ID;
-}
-
-void CSnapIDPool::TimeoutIDs()
-{
-	// process timed ids
-	while(m_FirstTimed != -1)
-		RemoveFirstTimeout();
-}
-
-void CSnapIDPool::FreeID(int ID)
-{
-	if(ID < 0)
-		return;
-	dbg_assert(m_aIDs[ID].m_State == 1, "id is not allocated");
-
-	m_InUsage--;
-	m_aIDs[ID].m_State = 2;
-	m_aIDs[ID].m_Timeout = time_get()+time_freq()*5;
-	m_aIDs[ID].m_Next = -1;
-
-	if(m_LastTimed != -1)
-	{
-		m_aIDs[m_LastTimed].m_Next = ID;
-		m_LastTimed = ID;
-	}
-	else
-	{
-		m_FirstTimed = ID;
-		m_LastTimed = ID;
-	}
-}
-
-
 void CServerBan::InitServerBan(IConsole *pConsole, IStorage *pStorage, CServer* pServer)
 {
 	CNetBan::Init(pConsole, pStorage);
@@ -215,6 +129,20 @@ int CServerBan::BanRange(const CNetRange *pRange, int Seconds, const char *pReas
 	return -1;
 }
 
+void CServerBan::OnBansLoaded()
+{
+	// drop the clients that are banned now
+	char aBuf[256];
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(Server()->m_aClients[i].m_State == CServer::CClient::STATE_EMPTY)
+			continue;
+
+		if(IsBanned(Server()->m_NetServer.ClientAddr(i), aBuf, sizeof(aBuf), 0))
+			Server()->m_NetServer.Drop(i, aBuf);
+	}
+}
+
 void CServerBan::ConBanExt(IConsole::IResult *pResult, void *pUser)
 {
 	CServerBan *pThis = static_cast<CServerBan *>(pUser);
@@ -245,9 +173,22 @@ void CServer::CClient::Reset()
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
 
 	m_Snapshots.PurgeAll();
+	m_SnapBytes = 0;
 	m_LastAckedSnapshot = -1;
 	m_LastInputTick = -1;
 	m_SnapRate = CClient::SNAPRATE_INIT;
+	m_SnapInterval = 1;
+	m_SnapBackoff = 1;
+	m_SnapGoodRounds = 0;
+	m_SnapHoldRounds = 0;
+	for(int i = 0; i < SNAP_HISTORY; i++)
+		m_aSnapHistoryTick[i] = -1;
+	mem_zero(m_aSnapHistoryBytes, sizeof(m_aSnapHistoryBytes));
+	m_SnapHistoryIndex = 0;
+	m_SnapAckedTick = -1;
+	m_SnapThroughput = 0;
+	m_SnapSentBytes = 0;
+	m_SnapSendRate = 0;
 	m_Score = 0;
 	m_MapChunk = 0;
 }
@@ -259,7 +200,10 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 	m_pGameServer = 0;
 
 	m_CurrentGameTick = 0;
+	m_Instance = 0;
 	m_RunServer = true;
+	m_RconLineReentry = 0;
+	m_SnapRound = 0;
 
 	m_pCurrentMapData = 0;
 	m_CurrentMapSize = 0;
@@ -277,6 +221,14 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 	m_RconPasswordSet = 0;
 	m_GeneratedRconPassword = 0;
 
+	m_LastProfilerDump = 0;
+	m_LastSnapStatsDump = 0;
+	ResetSnapStats();
+
+	m_aReplayFilename[0] = 0;
+	m_Replaying = false;
+	m_ReplaySnapCrc = 0;
+
 	Init();
 }
 
@@ -332,6 +284,10 @@ void CServer::Kick(int ClientID, const char *pReason)
  		return;
 	}
 
+	// drops come from the recording while replaying
+	if(m_Replaying)
+		return;
+
 	m_NetServer.Drop(ClientID, pReason);
 }
 
@@ -480,6 +436,10 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 	if(!pMsg)
 		return -1;
 
+	// there is nobody to send to while replaying
+	if(m_Replaying)
+		return 0;
+
 	// drop invalid packet
 	if(ClientID != -1 && (ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == CClient::STATE_EMPTY || m_aClients[ClientID].m_Quitting))
 		return 0;
@@ -509,17 +469,92 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 				{
 					Packet.m_ClientID = i;
 					m_NetServer.Send(&Packet);
+					m_Profiler.AddClientBytes(i, Packet.m_DataSize);
 				}
 		}
 		else
+		{
 			m_NetServer.Send(&Packet);
+			m_Profiler.AddClientBytes(ClientID, Packet.m_DataSize);
+		}
 	}
 	return 0;
 }
 
+// decides if a client gets a snapshot this round. the acks of a client that keeps
+// up arrive about its latency after the snapshot was sent, when they lag further
+// behind its interval is raised so that the bytes sent fit the bytes acked, at
+// least it is doubled. after a second without lag it is lowered again. clients
+// that only watch get a longer interval, the ones sharing an interval are spread
+// over the rounds by their id
+bool CServer::ScheduleSnapshot(int ClientID)
+{
+	CClient *pClient = &m_aClients[ClientID];
+	if(!Config()->m_SvSnapScheduler || m_Replaying)
+	{
+		pClient->m_SnapInterval = 1;
+		return true;
+	}
+
+	const int RoundTicks = Config()->m_SvHighBandwidth ? 1 : 2;
+	const int RoundsPerSecond = SERVER_TICK_SPEED/RoundTicks;
+
+	// throughput of the snapshots acked since the last round
+	int AckedBytes = 0;
+	if(pClient->m_LastAckedSnapshot > pClient->m_SnapAckedTick)
+	{
+		for(int h = 0; h < CClient::SNAP_HISTORY; h++)
+		{
+			if(pClient->m_aSnapHistoryTick[h] > pClient->m_SnapAckedTick && pClient->m_aSnapHistoryTick[h] <= pClient->m_LastAckedSnapshot)
+				AckedBytes += pClient->m_aSnapHistoryBytes[h];
+		}
+		pClient->m_SnapAckedTick = pClient->m_LastAckedSnapshot;
+	}
+	pClient->m_SnapThroughput += (AckedBytes*RoundsPerSecond-pClient->m_SnapThroughput)/8;
+	pClient->m_SnapSendRate += (pClient->m_SnapSentBytes*RoundsPerSecond-pClient->m_SnapSendRate)/8;
+	pClient->m_SnapSentBytes = 0;
+
+	const int LatencyTicks = pClient->m_Latency*SERVER_TICK_SPEED/1000;
+	const int Lag = m_CurrentGameTick-pClient->m_LastAckedSnapshot;
+	const int ExpectedLag = LatencyTicks + pClient->m_SnapInterval*RoundTicks + SERVER_TICK_SPEED/5;
+	if(Lag > ExpectedLag)
+	{
+		// wait for the acks of the lowered rate before lowering it again
+		if(pClient->m_SnapHoldRounds == 0)
+		{
+			int Backoff = pClient->m_SnapBackoff*2;
+			if(pClient->m_SnapSendRate > pClient->m_SnapThroughput)
+			{
+				if(pClient->m_SnapThroughput > 0)
+					Backoff = max(Backoff, pClient->m_SnapInterval*pClient->m_SnapSendRate/pClient->m_SnapThroughput);
+				else
+					Backoff = Config()->m_SvSnapMaxInterval;
+			}
+			pClient->m_SnapBackoff = min(Backoff, Config()->m_SvSnapMaxInterval);
+			pClient->m_SnapHoldRounds = LatencyTicks/RoundTicks + RoundsPerSecond/2;
+		}
+		pClient->m_SnapGoodRounds = 0;
+	}
+	else if(++pClient->m_SnapGoodRounds >= RoundsPerSecond)
+	{
+		pClient->m_SnapBackoff = max(pClient->m_SnapBackoff-1, 1);
+		pClient->m_SnapGoodRounds = 0;
+	}
+	if(pClient->m_SnapHoldRounds > 0)
+		pClient->m_SnapHoldRounds--;
+
+	int Interval = pClient->m_SnapBackoff;
+	if(!GameServer()->IsClientPlayer(ClientID) || !GameServer()->IsClientAlive(ClientID))
+		Interval = max(Interval, Config()->m_SvSnapIdleInterval);
+	pClient->m_SnapInterval = min(Interval, Config()->m_SvSnapMaxInterval);
+
+	return (m_SnapRound+ClientID)%pClient->m_SnapInterval == 0;
+}
+
 void CServer::DoSnapshot()
 {
 	GameServer()->OnPreSnap();
+	m_SnapRound++;
 
 	// create snapshot for demo recording
 	if(m_DemoRecorder.IsRecording())
@@ -536,6 +571,19 @@ void CServer::DoSnapshot()
 		m_DemoRecorder.RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	// spectator view crc to verify that a replay reproduces the game
+	if(m_ReplayRecorder.IsRecording() || m_Replaying)
+	{
+		char aData[CSnapshot::MAX_SIZE];
+		CSnapshot *pData = (CSnapshot*)aData;
+		m_SnapshotBuilder.Init();
+		GameServer()->OnSnap(-1);
+		m_SnapshotBuilder.Finish(pData);
+		m_ReplaySnapCrc = pData->Crc();
+		if(m_ReplayRecorder.IsRecording())
+			m_ReplayRecorder.RecordSnapshot(Tick(), m_ReplaySnapCrc);
+	}
+
 	// create snapshots for all clients
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -551,6 +599,9 @@ void CServer::DoSnapshot()
 		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick()%10) != 0)
 			continue;
 
+		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL && !ScheduleSnapshot(i))
+			continue;
+
 		{
 			char aData[CSnapshot::MAX_SIZE];
 			CSnapshot *pData = (CSnapshot*)aData;	// Fix compiler warning for strict-aliasing
@@ -563,6 +614,7 @@ void CServer::DoSnapshot()
 			int DeltashotSize;
 			int DeltaTick = -1;
 			int DeltaSize;
+			int64 BuildStart = m_Profiler.IsEnabled() ? time_get() : 0;
 
 			m_SnapshotBuilder.Init();
 
@@ -595,6 +647,7 @@ void CServer::DoSnapshot()
 			}
 
 			// create delta
+			int64 CompressStart = m_Profiler.IsEnabled() ? time_get() : 0;
 			DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
 
 			if(DeltaSize)
@@ -607,6 +660,24 @@ void CServer::DoSnapshot()
 				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
 				NumPackets = (SnapshotSize+MaxSize-1)/MaxSize;
 
+				CClient *pClient = &m_aClients[i];
+				pClient->m_aSnapHistoryTick[pClient->m_SnapHistoryIndex] = m_CurrentGameTick;
+				pClient->m_aSnapHistoryBytes[pClient->m_SnapHistoryIndex] = SnapshotSize;
+				pClient->m_SnapHistoryIndex = (pClient->m_SnapHistoryIndex+1)%CClient::SNAP_HISTORY;
+				pClient->m_SnapSentBytes += SnapshotSize;
+
+				if(Config()->m_SvSnapStats)
+				{
+					int aTypeBytes[MAX_SNAPSTATS_TYPES] = {0};
+					m_SnapOverheadBytes += m_SnapshotDelta.AccountDelta(aDeltaData, DeltaSize, aTypeBytes, MAX_SNAPSTATS_TYPES);
+					for(int t = 0; t < MAX_SNAPSTATS_TYPES; t++)
+						m_aSnapTypeBytes[t] += aTypeBytes[t];
+					m_aClients[i].m_SnapBytes += SnapshotSize;
+				}
+
+				if(m_Profiler.IsEnabled())
+					m_Profiler.AddClientSnap(i, CompressStart-BuildStart, time_get()-CompressStart);
+
 				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
 				{
 					int Chunk = Left < MaxSize ? Left : MaxSize;
@@ -638,6 +709,9 @@ void CServer::DoSnapshot()
 			}
 			else
 			{
+				if(m_Profiler.IsEnabled())
+					m_Profiler.AddClientSnap(i, CompressStart-BuildStart, time_get()-CompressStart);
+
 				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
 				Msg.AddInt(m_CurrentGameTick);
 				Msg.AddInt(m_CurrentGameTick-DeltaTick);
@@ -657,6 +731,8 @@ int CServer::NewClientCallback(int ClientID, void *pUser)
 	// Remove non human player on same slot
 	if(pThis->GameServer()->IsClientBot(ClientID))
 	{
+		if(pThis->m_ReplayRecorder.IsRecording())
+			pThis->m_ReplayRecorder.RecordDrop(ClientID, "removing dummy");
 		pThis->GameServer()->OnClientDrop(ClientID, "removing dummy");
 	}
 
@@ -671,6 +747,7 @@ int CServer::NewClientCallback(int ClientID, void *pUser)
 	pThis->m_aClients[ClientID].m_NoRconNote = false;
 	pThis->m_aClients[ClientID].m_Quitting = false;
 	pThis->m_aClients[ClientID].Reset();
+	pThis->m_Profiler.ResetClient(ClientID);
 
 	return 0;
 }
@@ -689,6 +766,8 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	if(pThis->m_aClients[ClientID].m_State >= CClient::STATE_READY)
 	{
 		pThis->m_aClients[ClientID].m_Quitting = true;
+		if(pThis->m_ReplayRecorder.IsRecording())
+			pThis->m_ReplayRecorder.RecordDrop(ClientID, pReason);
 		pThis->GameServer()->OnClientDrop(ClientID, pReason);
 	}
 
@@ -734,11 +813,10 @@ void CServer::SendRconLine(int ClientID, const char *pLine)
 void CServer::SendRconLineAuthed(const char *pLine, void *pUser, bool Highlighted)
 {
 	CServer *pThis = (CServer *)pUser;
-	static volatile int ReentryGuard = 0;
 	int i;
 
-	if(ReentryGuard) return;
-	ReentryGuard++;
+	if(pThis->m_RconLineReentry) return;
+	pThis->m_RconLineReentry++;
 
 	for(i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -746,7 +824,7 @@ void CServer::SendRconLineAuthed(const char *pLine, void *pUser, bool Highlighte
 			pThis->SendRconLine(i, pLine);
 	}
 
-	ReentryGuard--;
+	pThis->m_RconLineReentry--;
 }
 
 void CServer::SendRconCmdAdd(const IConsole::CCommandInfo *pCommandInfo, int ClientID)
@@ -903,6 +981,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 				bool ConnectAsSpec = m_aClients[ClientID].m_State == CClient::STATE_CONNECTING_AS_SPEC;
 				m_aClients[ClientID].m_State = CClient::STATE_READY;
+				if(m_ReplayRecorder.IsRecording())
+					m_ReplayRecorder.RecordConnect(ClientID, ConnectAsSpec, m_aClients[ClientID].m_Version);
 				GameServer()->OnClientConnected(ClientID, ConnectAsSpec);
 				SendConnectionReady(ClientID);
 			}
@@ -919,6 +999,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 				m_aClients[ClientID].m_State = CClient::STATE_INGAME;
 				SendServerInfo(ClientID);
+				if(m_ReplayRecorder.IsRecording())
+					m_ReplayRecorder.RecordEnter(ClientID);
 				GameServer()->OnClientEnter(ClientID);
 			}
 		}
@@ -977,7 +1059,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 			// call the mod with the fresh input data
 			if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+			{
+				if(m_ReplayRecorder.IsRecording())
+					m_ReplayRecorder.RecordInput(CReplay::REC_DIRECTINPUT, ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
 				GameServer()->OnClientDirectInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
+			}
 		}
 		else if(Msg == NETMSG_RCON_CMD)
 		{
@@ -1095,7 +1181,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	{
 		// game message
 		if((pPacket->m_Flags&NET_CHUNKFLAG_VITAL) != 0 && m_aClients[ClientID].m_State >= CClient::STATE_READY)
+		{
+			if(m_ReplayRecorder.IsRecording())
+				m_ReplayRecorder.RecordMessage(ClientID, pPacket->m_pData, pPacket->m_DataSize);
 			GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+		}
 	}
 }
 
@@ -1178,6 +1268,7 @@ void CServer::SendServerInfo(int ClientID)
 
 void CServer::PumpNetwork()
 {
+	CProfileScope ProfileScope(&m_Profiler, CTickProfiler::PHASE_NETWORK);
 	CNetChunk Packet;
 	TOKEN ResponseToken;
 
@@ -1291,6 +1382,14 @@ void CServer::InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterS
 	m_Register.Init(pNetServer, pMasterServer, pConfig, pConsole);
 }
 
+void CServer::PrintMapChangeStats(int64 StartTime)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "map change took %.2fms, %d KiB of map data in memory",
+		(time_get()-StartTime)*1000.0/time_freq(), m_pMap->MemoryUsage()/1024);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
 void CServer::InitInterfaces(CConfig *pConfig, IConsole *pConsole, IGameServer *pGameServer, IEngineMap *pMap, IStorage *pStorage)
 {
 	m_pConfig = pConfig;
@@ -1313,6 +1412,7 @@ int CServer::Run()
 	m_pStorage->ListDirectory(IStorage::TYPE_ALL, "maps/", MapListEntryCallback, &Userdata);
 
 	// load map
+	int64 MapChangeStart = time_get();
 	if(!LoadMap(Config()->m_SvMap))
 	{
 		dbg_msg("server", "failed to load map. mapname='%s'", Config()->m_SvMap);
@@ -1349,6 +1449,7 @@ int CServer::Run()
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 
 	GameServer()->OnInit();
+	PrintMapChangeStats(MapChangeStart);
 	str_format(aBuf, sizeof(aBuf), "netversion %s", GameServer()->NetVersion());
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 	if(str_comp(GameServer()->NetVersionHashUsed(), GameServer()->NetVersionHashReal()))
@@ -1361,6 +1462,8 @@ int CServer::Run()
 	// process pending commands
 	m_pConsole->StoreCommands(false);
 
+	m_Profiler.SetEnabled(Config()->m_SvProfiler);
+
 	if(m_GeneratedRconPassword)
 	{
 		dbg_msg("server", "+-------------------------+");
@@ -1380,6 +1483,7 @@ int CServer::Run()
 				m_MapReload = false;
 
 				// load map
+				MapChangeStart = time_get();
 				if(LoadMap(Config()->m_SvMap))
 				{
 					// new map loaded
@@ -1402,7 +1506,15 @@ int CServer::Run()
 					m_GameStartTime = time_get();
 					m_CurrentGameTick = 0;
 					Kernel()->ReregisterInterface(GameServer());
+
+					// a replay covers a single map session
+					if(m_ReplayRecorder.IsRecording())
+						m_ReplayRecorder.Stop();
+					if(m_aReplayFilename[0])
+						StartReplayRecording();
+
 					GameServer()->OnInit();
+					PrintMapChangeStats(MapChangeStart);
 				}
 				else
 				{
@@ -1422,6 +1534,21 @@ int CServer::Run()
 				if((m_CurrentGameTick%2) == 0)
 					ShouldSnap = true;
 
+				CProfileScope ProfileScope(&m_Profiler, CTickProfiler::PHASE_TICK);
+
+				if(m_ReplayRecorder.IsRecording())
+				{
+					m_ReplayRecorder.RecordTick(Tick());
+
+					int aTuning[CReplay::MAX_TUNING_PARAMS];
+					m_ReplayRecorder.RecordTuning(aTuning, GameServer()->GetTuning(aTuning, sizeof(aTuning)));
+					for(int c = 0; c < MAX_CLIENTS; c++)
+					{
+						if(m_aClients[c].m_State >= CClient::STATE_READY)
+							m_ReplayRecorder.RecordClientState(c, m_aClients[c].m_Latency, m_aClients[c].m_Authed);
+					}
+				}
+
 				// apply new input
 				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
@@ -1432,30 +1559,56 @@ int CServer::Run()
 						if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
 						{
 							if(m_aClients[c].m_State == CClient::STATE_INGAME)
+							{
+								if(m_ReplayRecorder.IsRecording())
+									m_ReplayRecorder.RecordInput(CReplay::REC_PREDICTEDINPUT, c, m_aClients[c].m_aInputs[i].m_aData);
 								GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
+							}
 							break;
 						}
 					}
 				}
 
 				GameServer()->OnTick();
+
+				if(m_ReplayRecorder.IsRecording())
+					m_ReplayRecorder.RecordTickEnd();
 			}
 
 			// snap game
 			if(NewTicks)
 			{
 				if(Config()->m_SvHighBandwidth || ShouldSnap)
+				{
+					CProfileScope ProfileScope(&m_Profiler, CTickProfiler::PHASE_SNAP);
 					DoSnapshot();
+				}
 
 				UpdateClientRconCommands();
 				UpdateClientMapListEntries();
 			}
 
 			// master server stuff
-			m_Register.RegisterUpdate(m_NetServer.NetType());
+			{
+				CProfileScope ProfileScope(&m_Profiler, CTickProfiler::PHASE_REGISTER);
+				m_Register.RegisterUpdate(m_NetServer.NetType());
+			}
 
 			PumpNetwork();
 
+			if(Config()->m_SvSnapStats && Config()->m_SvSnapStatsDump && time_get() > m_LastSnapStatsDump+Config()->m_SvSnapStatsDump*time_freq())
+			{
+				m_LastSnapStatsDump = time_get();
+				PrintSnapStats(8, IConsole::OUTPUT_LEVEL_ADDINFO);
+			}
+
+			// periodic machine readable profiler output
+			if(m_Profiler.IsEnabled() && Config()->m_SvProfilerDump && time_get() > m_LastProfilerDump+Config()->m_SvProfilerDump*time_freq())
+			{
+				m_LastProfilerDump = time_get();
+				PrintProfilerLine(IConsole::OUTPUT_LEVEL_ADDINFO);
+			}
+
 			// wait for incoming data
 			m_NetServer.Wait(clamp(int((TickStartTime(m_CurrentGameTick+1)-time_get())*1000/time_freq()), 1, 1000/SERVER_TICK_SPEED/2));
 
@@ -1466,6 +1619,9 @@ int CServer::Run()
 			}
 		}
 	}
+	if(m_ReplayRecorder.IsRecording())
+		m_ReplayRecorder.Stop();
+
 	// disconnect all clients on shutdown
 	m_NetServer.Close();
 	m_Econ.Shutdown();
@@ -1486,6 +1642,200 @@ int CServer::Run()
 	return 0;
 }
 
+void CServer::StartReplayRecording()
+{
+	// the game's random numbers are reproduced from this seed
+	unsigned Seed = (unsigned)time_get();
+	if(m_ReplayRecorder.Start(Storage(), Console(), m_aReplayFilename, m_aCurrentMap, m_CurrentMapSha256, m_CurrentMapCrc, Seed) == 0)
+	{
+		m_ReplayRecorder.RecordConfig(Config());
+		srand(Seed);
+	}
+	m_aReplayFilename[0] = 0;
+}
+
+int CServer::RunReplay(const char *pFilename)
+{
+	m_PrintCBIndex = Console()->RegisterPrintCallback(Config()->m_ConsoleOutputLevel, SendRconLineAuthed, this);
+
+	CReplayReader Reader;
+	if(Reader.Open(Storage(), Console(), pFilename) != 0)
+		return -1;
+	m_Replaying = true;
+
+	// restore the recorded server config
+	CUnpacker Unpacker;
+	int Type;
+	while((Type = Reader.NextRecord(&Unpacker)) == CReplay::REC_CONFIG)
+		Console()->ExecuteLine(Unpacker.GetString(CUnpacker::SANITIZE_CC));
+
+	if(!LoadMap(Reader.Map()) || m_CurrentMapCrc != Reader.MapCrc() || !(m_CurrentMapSha256 == Reader.MapSha256()))
+	{
+		dbg_msg("replay", "failed to load the recorded map. mapname='%s'", Reader.Map());
+		return -1;
+	}
+
+	srand(Reader.Seed());
+	GameServer()->OnInit();
+	m_pConsole->StoreCommands(false);
+	m_Profiler.SetEnabled(true);
+
+	int NumTicks = 0;
+	int NumSnaps = 0;
+	int NumMismatches = 0;
+	int FirstMismatch = -1;
+	int LastSnapTick = -1;
+	int64 TickStart = 0;
+	int64 StartTime = time_get();
+
+	for(; Type != -1; Type = Reader.NextRecord(&Unpacker))
+	{
+		int ClientID = 0;
+		if(Type >= CReplay::REC_CONNECT && Type <= CReplay::REC_PREDICTEDINPUT)
+		{
+			ClientID = Unpacker.GetInt();
+			if(ClientID < 0 || ClientID >= MAX_CLIENTS)
+			{
+				Type = -1;
+				break;
+			}
+		}
+
+		if(Type == CReplay::REC_TUNING)
+		{
+			int aTuning[CReplay::MAX_TUNING_PARAMS];
+			int Num = clamp(Unpacker.GetInt(), 0, (int)CReplay::MAX_TUNING_PARAMS);
+			for(int i = 0; i < Num; i++)
+				aTuning[i] = Unpacker.GetInt();
+			GameServer()->SetTuning(aTuning, Num*sizeof(int));
+		}
+		else if(Type == CReplay::REC_CONNECT)
+		{
+			bool AsSpec = Unpacker.GetInt() != 0;
+			m_aClients[ClientID].Reset();
+			m_aClients[ClientID].m_State = CClient::STATE_READY;
+			m_aClients[ClientID].m_Version = Unpacker.GetInt();
+			GameServer()->OnClientConnected(ClientID, AsSpec);
+		}
+		else if(Type == CReplay::REC_ENTER)
+		{
+			m_aClients[ClientID].m_State = CClient::STATE_INGAME;
+			m_aClients[ClientID].m_SnapRate = CClient::SNAPRATE_FULL;
+			GameServer()->OnClientEnter(ClientID);
+		}
+		else if(Type == CReplay::REC_DROP)
+		{
+			const char *pReason = Unpacker.GetString(CUnpacker::SANITIZE_CC);
+			m_aClients[ClientID].m_Quitting = true;
+			GameServer()->OnClientDrop(ClientID, pReason);
+			m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
+			m_aClients[ClientID].m_aName[0] = 0;
+			m_aClients[ClientID].m_aClan[0] = 0;
+			m_aClients[ClientID].m_Country = -1;
+			m_aClients[ClientID].m_Authed = AUTHED_NO;
+			m_aClients[ClientID].m_Quitting = false;
+			m_aClients[ClientID].m_Snapshots.PurgeAll();
+		}
+		else if(Type == CReplay::REC_CLIENTSTATE)
+		{
+			m_aClients[ClientID].m_Latency = Unpacker.GetInt();
+			m_aClients[ClientID].m_Authed = Unpacker.GetInt();
+		}
+		else if(Type == CReplay::REC_MESSAGE)
+		{
+			int Size = Unpacker.GetInt();
+			const unsigned char *pData = Unpacker.GetRaw(Size);
+			if(pData)
+			{
+				CUnpacker Msg;
+				Msg.Reset(pData, Size);
+				int MsgID = Msg.GetInt()>>1;
+				GameServer()->OnMessage(MsgID, &Msg, ClientID);
+			}
+		}
+		else if(Type == CReplay::REC_DIRECTINPUT || Type == CReplay::REC_PREDICTEDINPUT)
+		{
+			int *pInput = Type == CReplay::REC_DIRECTINPUT ? m_aClients[ClientID].m_LatestInput.m_aData : m_aClients[ClientID].m_aInputs[0].m_aData;
+			int Size = clamp(Unpacker.GetInt(), 0, (int)MAX_INPUT_SIZE);
+			mem_zero(pInput, MAX_INPUT_SIZE*sizeof(int));
+			for(int i = 0; i < Size; i++)
+				pInput[i] = Unpacker.GetInt();
+			if(Type == CReplay::REC_DIRECTINPUT)
+				GameServer()->OnClientDirectInput(ClientID, pInput);
+			else
+				GameServer()->OnClientPredictedInput(ClientID, pInput);
+		}
+		else if(Type == CReplay::REC_TICK)
+		{
+			m_CurrentGameTick = Unpacker.GetInt();
+			TickStart = time_get();
+		}
+		else if(Type == CReplay::REC_TICKEND)
+		{
+			GameServer()->OnTick();
+			m_Profiler.AddSample(CTickProfiler::PHASE_TICK, time_get()-TickStart);
+			NumTicks++;
+		}
+		else if(Type == CReplay::REC_SNAP)
+		{
+			int SnapTick = Unpacker.GetInt();
+			int Crc = Unpacker.GetInt();
+
+			// pretend every client acked the previous snapshot, so the deltas are as small as in a real game
+			for(int i = 0; i < MAX_CLIENTS; i++)
+			{
+				m_aClients[i].m_LastAckedSnapshot = LastSnapTick;
+				m_aClients[i].m_SnapRate = CClient::SNAPRATE_FULL;
+			}
+			LastSnapTick = SnapTick;
+
+			{
+				CProfileScope ProfileScope(&m_Profiler, CTickProfiler::PHASE_SNAP);
+				DoSnapshot();
+			}
+			NumSnaps++;
+
+			if(m_ReplaySnapCrc != Crc)
+			{
+				if(FirstMismatch == -1)
+					FirstMismatch = SnapTick;
+				NumMismatches++;
+			}
+		}
+		else
+		{
+			Type = -1;
+			break;
+		}
+	}
+
+	int64 Duration = max(time_get()-StartTime, (int64)1);
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "replayed %d ticks and %d snapshots in %d ms, %d ticks/s", NumTicks, NumSnaps,
+		(int)(Duration*1000/time_freq()), (int)(NumTicks*time_freq()/Duration));
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+	PrintProfilerLine(IConsole::OUTPUT_LEVEL_STANDARD);
+
+	bool Corrupt = Reader.Error() || Unpacker.Error();
+	if(Corrupt)
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", "replay file is truncated or corrupt");
+	if(NumMismatches)
+		str_format(aBuf, sizeof(aBuf), "snapshot crc mismatch in %d of %d snapshots, first at tick %d", NumMismatches, NumSnaps, FirstMismatch);
+	else
+		str_format(aBuf, sizeof(aBuf), "all %d snapshot crcs match", NumSnaps);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+
+	GameServer()->OnShutdown();
+	m_pMap->Unload();
+	if(m_pCurrentMapData)
+	{
+		mem_free(m_pCurrentMapData);
+		m_pCurrentMapData = 0;
+	}
+	m_Replaying = false;
+	return (NumMismatches || Corrupt) ? 1 : 0;
+}
+
 int CServer::MapListEntryCallback(const char *pFilename, int IsDir, int DirType, void *pUser)
 {
 	CSubdirCallbackUserdata *pUserdata = (CSubdirCallbackUserdata *)pUser;
@@ -1559,8 +1909,10 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 			{
 				const char *pAuthStr = pThis->m_aClients[i].m_Authed == CServer::AUTHED_ADMIN ? "(Admin)" :
 										pThis->m_aClients[i].m_Authed == CServer::AUTHED_MOD ? "(Mod)" : "";
-				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s client=%x name='%s' score=%d %s", i, aAddrStr,
-					pThis->m_aClients[i].m_Version, pThis->m_aClients[i].m_aName, pThis->m_aClients[i].m_Score, pAuthStr);
+				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s client=%x name='%s' score=%d snap_interval=%d snap_acked=%dB/s %s", i, aAddrStr,
+					pThis->m_aClients[i].m_Version, pThis->m_aClients[i].m_aName, pThis->m_aClients[i].m_Score,
+					pThis->m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL ? pThis->m_aClients[i].m_SnapInterval : 0,
+					pThis->m_aClients[i].m_SnapThroughput, pAuthStr);
 			}
 			else
 				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s connecting", i, aAddrStr);
@@ -1569,6 +1921,163 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::PrintProfilerLine(int OutputLevel)
+{
+	char aBuf[512];
+	int Length = 0;
+	str_format(aBuf, sizeof(aBuf), "tick=%d", Tick());
+	for(int p = 0; p < CTickProfiler::NUM_PHASES; p++)
+	{
+		int64 P50, P99, Max;
+		m_Profiler.GetPhaseStats(p, &P50, &P99, &Max);
+		Length = str_length(aBuf);
+		const char *pName = CTickProfiler::PhaseName(p);
+		str_format(aBuf+Length, sizeof(aBuf)-Length, " %s_p50=%d %s_p99=%d %s_max=%d", pName, (int)P50, pName, (int)P99, pName, (int)Max);
+	}
+
+	int64 BytesSent = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		BytesSent += m_Profiler.GetClient(i)->m_BytesSent;
+	int64 Elapsed = max(m_Profiler.TimeSinceReset(), (int64)1);
+	Length = str_length(aBuf);
+	str_format(aBuf+Length, sizeof(aBuf)-Length, " sent_bps=%d", (int)(BytesSent*time_freq()/Elapsed));
+	Console()->Print(OutputLevel, "profiler", aBuf);
+}
+
+void CServer::ConProfiler(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	if(!pThis->m_Profiler.IsEnabled())
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "profiler is disabled, enable it with sv_profiler 1");
+		return;
+	}
+
+	char aBuf[256];
+	for(int p = 0; p < CTickProfiler::NUM_PHASES; p++)
+	{
+		int64 P50, P99, Max;
+		pThis->m_Profiler.GetPhaseStats(p, &P50, &P99, &Max);
+		str_format(aBuf, sizeof(aBuf), "phase=%s p50=%dus p99=%dus max=%dus", CTickProfiler::PhaseName(p), (int)P50, (int)P99, (int)Max);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+	}
+
+	int64 Elapsed = max(pThis->m_Profiler.TimeSinceReset(), (int64)1);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(pThis->m_aClients[i].m_State == CClient::STATE_EMPTY)
+			continue;
+
+		const CTickProfiler::CClient *pClient = pThis->m_Profiler.GetClient(i);
+		int NumSnaps = max(pClient->m_NumSnaps, 1);
+		str_format(aBuf, sizeof(aBuf), "id=%d snaps=%d build_avg=%dus compress_avg=%dus sent=%dKiB sent_bps=%d", i, pClient->m_NumSnaps,
+			(int)CTickProfiler::ToMicroseconds(pClient->m_SnapBuildTime/NumSnaps), (int)CTickProfiler::ToMicroseconds(pClient->m_SnapCompressTime/NumSnaps),
+			(int)(pClient->m_BytesSent/1024), (int)(pClient->m_BytesSent*time_freq()/Elapsed));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+	}
+
+	pThis->PrintProfilerLine(IConsole::OUTPUT_LEVEL_STANDARD);
+}
+
+void CServer::ConProfilerReset(IConsole::IResult *pResult, void *pUser)
+{
+	static_cast<CServer *>(pUser)->m_Profiler.Reset();
+}
+
+void CServer::ResetSnapStats()
+{
+	mem_zero(m_aSnapTypeBytes, sizeof(m_aSnapTypeBytes));
+	m_SnapOverheadBytes = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_aClients[i].m_SnapBytes = 0;
+	m_SnapStatsStartTime = time_get();
+}
+
+void CServer::PrintSnapStats(int Num, int OutputLevel)
+{
+	char aBuf[256];
+	int64 Elapsed = max(time_get()-m_SnapStatsStartTime, (int64)1);
+	int64 Total = m_SnapOverheadBytes;
+	for(int t = 0; t < MAX_SNAPSTATS_TYPES; t++)
+		Total += m_aSnapTypeBytes[t];
+
+	str_format(aBuf, sizeof(aBuf), "total=%d bps=%d overhead=%d", (int)(Total/1024), (int)(Total*time_freq()/Elapsed), (int)(m_SnapOverheadBytes/1024));
+	Console()->Print(OutputLevel, "snapstats", aBuf);
+
+	// top item types
+	bool aShown[MAX_SNAPSTATS_TYPES] = {false};
+	for(int n = 0; n < Num; n++)
+	{
+		int Best = -1;
+		for(int t = 0; t < MAX_SNAPSTATS_TYPES; t++)
+			if(!aShown[t] && m_aSnapTypeBytes[t] > 0 && (Best == -1 || m_aSnapTypeBytes[t] > m_aSnapTypeBytes[Best]))
+				Best = t;
+		if(Best == -1)
+			break;
+		aShown[Best] = true;
+		str_format(aBuf, sizeof(aBuf), "type=%d name=%s kib=%d bps=%d share=%d%%", Best, GameServer()->GetItemName(Best), (int)(m_aSnapTypeBytes[Best]/1024),
+			(int)(m_aSnapTypeBytes[Best]*time_freq()/Elapsed), (int)(m_aSnapTypeBytes[Best]*100/max(Total, (int64)1)));
+		Console()->Print(OutputLevel, "snapstats", aBuf);
+	}
+
+	// top clients
+	bool aClientShown[MAX_CLIENTS] = {false};
+	for(int n = 0; n < Num; n++)
+	{
+		int Best = -1;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(!aClientShown[i] && m_aClients[i].m_State == CClient::STATE_INGAME && m_aClients[i].m_SnapBytes > 0 &&
+				(Best == -1 || m_aClients[i].m_SnapBytes > m_aClients[Best].m_SnapBytes))
+				Best = i;
+		if(Best == -1)
+			break;
+		aClientShown[Best] = true;
+		str_format(aBuf, sizeof(aBuf), "id=%d name='%s' kib=%d bps=%d", Best, ClientName(Best), (int)(m_aClients[Best].m_SnapBytes/1024),
+			(int)(m_aClients[Best].m_SnapBytes*time_freq()/Elapsed));
+		Console()->Print(OutputLevel, "snapstats", aBuf);
+	}
+}
+
+void CServer::ConSnapStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	if(!pThis->Config()->m_SvSnapStats)
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snapstats", "snapshot accounting is disabled, enable it with sv_snap_stats 1");
+		return;
+	}
+	pThis->PrintSnapStats(pResult->NumArguments() ? clamp(pResult->GetInteger(0), 1, (int)MAX_SNAPSTATS_TYPES) : 8, IConsole::OUTPUT_LEVEL_STANDARD);
+}
+
+void CServer::ConSnapStatsReset(IConsole::IResult *pResult, void *pUser)
+{
+	static_cast<CServer *>(pUser)->ResetSnapStats();
+}
+
+void CServer::ConReplayRecord(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	if(pResult->NumArguments())
+		str_format(pThis->m_aReplayFilename, sizeof(pThis->m_aReplayFilename), "replays/%s.replay", pResult->GetString(0));
+	else
+	{
+		char aDate[20];
+		str_timestamp(aDate, sizeof(aDate));
+		str_format(pThis->m_aReplayFilename, sizeof(pThis->m_aReplayFilename), "replays/replay_%s.replay", aDate);
+	}
+
+	// the replay has to start with a fresh game
+	pThis->m_MapReload = true;
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "reloading the map to start the replay recording");
+}
+
+void CServer::ConReplayStop(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	pThis->m_aReplayFilename[0] = 0;
+	pThis->m_ReplayRecorder.Stop();
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = false;
@@ -1744,6 +2253,16 @@ void CServer::ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, ICo
 	}
 }
 
+void CServer::ConchainProfilerUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments())
+	{
+		CServer *pThis = static_cast<CServer *>(pUserData);
+		pThis->m_Profiler.SetEnabled(pThis->Config()->m_SvProfiler);
+	}
+}
+
 void CServer::RegisterCommands()
 {
 	// register console commands
@@ -1757,6 +2276,13 @@ void CServer::RegisterCommands()
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
 
+	Console()->Register("profiler", "", CFGFLAG_SERVER, ConProfiler, this, "Show tick phase timings and per client snapshot costs");
+	Console()->Register("profiler_reset", "", CFGFLAG_SERVER, ConProfilerReset, this, "Reset the profiler statistics");
+	Console()->Register("snap_stats", "?i[num]", CFGFLAG_SERVER, ConSnapStats, this, "Show the snapshot item types and clients using the most bandwidth");
+	Console()->Register("snap_stats_reset", "", CFGFLAG_SERVER, ConSnapStatsReset, this, "Reset the snapshot bandwidth statistics");
+	Console()->Register("replay_record", "?s[file]", CFGFLAG_SERVER, ConReplayRecord, this, "Reload the map and record the game inputs for replay benchmarks");
+	Console()->Register("replay_stop", "", CFGFLAG_SERVER, ConReplayStop, this, "Stop recording the replay");
+
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
@@ -1768,6 +2294,7 @@ void CServer::RegisterCommands()
 	Console()->Chain("console_output_level", ConchainConsoleOutputLevelUpdate, this);
 	Console()->Chain("sv_rcon_password", ConchainRconPasswordSet, this);
 	Console()->Chain("sv_map", ConchainMapUpdate, this);
+	Console()->Chain("sv_profiler", ConchainProfilerUpdate, this);
 
 	// register console commands in sub parts
 	m_ServerBan.InitServerBan(Console(), Storage(), this);
@@ -1778,12 +2305,12 @@ void CServer::RegisterCommands()
 
 int CServer::SnapNewID()
 {
-	return m_IDPool.NewID();
+	return m_IDPool.NewID(Tick());
 }
 
 void CServer::SnapFreeID(int ID)
 {
-	m_IDPool.FreeID(ID);
+	m_IDPool.FreeID(ID, Tick());
 }
 
 
@@ -1799,8 +2326,104 @@ void CServer::SnapSetStaticsize(int ItemType, int Size)
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
+int CServer::MaxSnapshotDelay()
+{
+	if(!Config()->m_SvSnapScheduler || m_Replaying)
+		return 0;
+	const int RoundTicks = Config()->m_SvHighBandwidth ? 1 : 2;
+	return (Config()->m_SvSnapMaxInterval-1)*RoundTicks;
+}
+
 static CServer *CreateServer() { return new CServer(); }
 
+// one of the servers the process hosts. each has its own kernel, config,
+// console, map and game. the storage and the engine with its job pool are shared
+struct CServerInstance
+{
+	IKernel *m_pKernel;
+	CServer *m_pServer;
+	IEngineMap *m_pEngineMap;
+	IGameServer *m_pGameServer;
+	IConsole *m_pConsole;
+	IEngineMasterServer *m_pEngineMasterServer;
+	IConfigManager *m_pConfigManager;
+	void *m_pThread;
+	int m_Result;
+};
+
+static bool CreateServerInstance(CServerInstance *pInstance, int Index, IEngine *pEngine, IStorage *pStorage)
+{
+	CServer *pServer = CreateServer();
+	pServer->SetInstance(Index);
+	IKernel *pKernel = IKernel::Create();
+
+	// create the components
+	int FlagMask = CFGFLAG_SERVER|CFGFLAG_ECON;
+	IEngineMap *pEngineMap = CreateEngineMap();
+	IGameServer *pGameServer = CreateGameServer();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER|CFGFLAG_ECON);
+	IEngineMasterServer *pEngineMasterServer = CreateEngineMasterServer();
+	IConfigManager *pConfigManager = CreateConfigManager();
+
+	pInstance->m_pKernel = pKernel;
+	pInstance->m_pServer = pServer;
+	pInstance->m_pEngineMap = pEngineMap;
+	pInstance->m_pGameServer = pGameServer;
+	pInstance->m_pConsole = pConsole;
+	pInstance->m_pEngineMasterServer = pEngineMasterServer;
+	pInstance->m_pConfigManager = pConfigManager;
+	pInstance->m_pThread = 0;
+	pInstance->m_Result = 0;
+
+	pServer->InitRegister(&pServer->m_NetServer, pEngineMasterServer, pConfigManager->Values(), pConsole);
+
+	{
+		bool RegisterFail = false;
+
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pServer); // register as both
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pEngine);
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IEngineMap*>(pEngineMap)); // register as both
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMap*>(pEngineMap));
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pGameServer);
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConsole);
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pStorage);
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConfigManager);
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IEngineMasterServer*>(pEngineMasterServer)); // register as both
+		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMasterServer*>(pEngineMasterServer));
+
+		if(RegisterFail)
+			return false;
+	}
+
+	// the shared engine takes its config and console from the first instance
+	if(Index == 0)
+		pEngine->Init();
+	pConfigManager->Init(FlagMask);
+	pConsole->Init();
+	pEngineMasterServer->Init();
+	pEngineMasterServer->Load();
+
+	pServer->InitInterfaces(pConfigManager->Values(), pConsole, pGameServer, pEngineMap, pStorage);
+	return true;
+}
+
+static void DestroyServerInstance(CServerInstance *pInstance)
+{
+	delete pInstance->m_pServer;
+	delete pInstance->m_pKernel;
+	delete pInstance->m_pEngineMap;
+	delete pInstance->m_pGameServer;
+	delete pInstance->m_pConsole;
+	delete pInstance->m_pEngineMasterServer;
+	delete pInstance->m_pConfigManager;
+}
+
+static void RunServerInstance(void *pUser)
+{
+	CServerInstance *pInstance = (CServerInstance *)pUser;
+	pInstance->m_Result = pInstance->m_pServer->Run();
+}
+
 
 void HandleSigInt(int Param)
 {
@@ -1833,6 +2456,15 @@ int main(int argc, const char **argv) // ignore_convention
 		}
 	}
 
+	// teeworlds_srv --replay <file> [commands]: rerun a recorded game as fast as possible
+	const char *pReplayFile = 0;
+	int FirstArg = 1;
+	if(argc > 2 && str_comp("--replay", argv[1]) == 0) // ignore_convention
+	{
+		pReplayFile = argv[2]; // ignore_convention
+		FirstArg = 3;
+	}
+
 	if(secure_random_init() != 0)
 	{
 		dbg_msg("secure", "could not initialize secure RNG");
@@ -1841,80 +2473,88 @@ int main(int argc, const char **argv) // ignore_convention
 
 	signal(SIGINT, HandleSigInt);
 
-	CServer *pServer = CreateServer();
-	IKernel *pKernel = IKernel::Create();
+	// teeworlds_srv --instances <file> [<file> ...]: host a server per config file in this process
+	const char *apInstanceConfigs[IServer::MAX_INSTANCES];
+	int NumInstances = 1;
+	bool MultiInstance = argc > 2 && str_comp("--instances", argv[1]) == 0; // ignore_convention
+	if(MultiInstance)
+	{
+		NumInstances = argc-2; // ignore_convention
+		if(NumInstances > IServer::MAX_INSTANCES || pReplayFile)
+		{
+			dbg_msg("server", "at most %d instances are supported and replays run alone", int(IServer::MAX_INSTANCES));
+			return -1;
+		}
+		for(int i = 0; i < NumInstances; i++)
+			apInstanceConfigs[i] = argv[i+2]; // ignore_convention
+		UseDefaultConfig = false;
+	}
 
-	// create the components
-	int FlagMask = CFGFLAG_SERVER|CFGFLAG_ECON;
 	IEngine *pEngine = CreateEngine("Teeworlds_Server");
-	IEngineMap *pEngineMap = CreateEngineMap();
-	IGameServer *pGameServer = CreateGameServer();
-	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER|CFGFLAG_ECON);
-	IEngineMasterServer *pEngineMasterServer = CreateEngineMasterServer();
 	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_SERVER, argc, argv); // ignore_convention
-	IConfigManager *pConfigManager = CreateConfigManager();
-
-	pServer->InitRegister(&pServer->m_NetServer, pEngineMasterServer, pConfigManager->Values(), pConsole);
 
+	CServerInstance aInstances[IServer::MAX_INSTANCES];
+	for(int i = 0; i < NumInstances; i++)
 	{
-		bool RegisterFail = false;
-
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pServer); // register as both
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pEngine);
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IEngineMap*>(pEngineMap)); // register as both
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMap*>(pEngineMap));
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pGameServer);
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConsole);
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pStorage);
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConfigManager);
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IEngineMasterServer*>(pEngineMasterServer)); // register as both
-		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMasterServer*>(pEngineMasterServer));
-
-		if(RegisterFail)
+		if(!CreateServerInstance(&aInstances[i], i, pEngine, pStorage))
 			return -1;
-	}
 
-	pEngine->Init();
-	pConfigManager->Init(FlagMask);
-	pConsole->Init();
-	pEngineMasterServer->Init();
-	pEngineMasterServer->Load();
+		CServer *pServer = aInstances[i].m_pServer;
+		IConsole *pConsole = aInstances[i].m_pConsole;
+		if(!UseDefaultConfig)
+		{
+			// register all console commands
+			pServer->RegisterCommands();
 
-	pServer->InitInterfaces(pConfigManager->Values(), pConsole, pGameServer, pEngineMap, pStorage);
-	if(!UseDefaultConfig)
-	{
-		// register all console commands
-		pServer->RegisterCommands();
+			if(MultiInstance)
+				pConsole->ExecuteFile(apInstanceConfigs[i]);
+			else
+			{
+				// execute autoexec file, a replay brings its own config
+				if(!pReplayFile)
+					pConsole->ExecuteFile("autoexec.cfg");
 
-		// execute autoexec file
-		pConsole->ExecuteFile("autoexec.cfg");
+				// parse the command line arguments
+				if(argc > FirstArg) // ignore_convention
+					pConsole->ParseArguments(argc-FirstArg, &argv[FirstArg]); // ignore_convention
+			}
+		}
 
-		// parse the command line arguments
-		if(argc > 1) // ignore_convention
-			pConsole->ParseArguments(argc-1, &argv[1]); // ignore_convention
+		// restore empty config strings to their defaults
+		aInstances[i].m_pConfigManager->RestoreStrings();
 	}
 
-	// restore empty config strings to their defaults
-	pConfigManager->RestoreStrings();
-
 	pEngine->InitLogfile();
 
-	pServer->InitRconPasswordIfUnset();
+	for(int i = 0; i < NumInstances; i++)
+		aInstances[i].m_pServer->InitRconPasswordIfUnset();
 
 	// run the server
 	dbg_msg("server", "starting...");
-	int Ret = pServer->Run();
+	int Ret = 0;
+	if(MultiInstance)
+	{
+		// every instance ticks on its own thread
+		for(int i = 0; i < NumInstances; i++)
+			aInstances[i].m_pThread = thread_init(RunServerInstance, &aInstances[i]);
+		for(int i = 0; i < NumInstances; i++)
+		{
+			thread_wait(aInstances[i].m_pThread);
+			if(aInstances[i].m_Result)
+			{
+				dbg_msg("server", "instance %d (%s) stopped with an error", i, apInstanceConfigs[i]);
+				Ret = aInstances[i].m_Result;
+			}
+		}
+	}
+	else
+		Ret = pReplayFile ? aInstances[0].m_pServer->RunReplay(pReplayFile) : aInstances[0].m_pServer->Run();
 
 	// free
-	delete pServer;
-	delete pKernel;
+	for(int i = 0; i < NumInstances; i++)
+		DestroyServerInstance(&aInstances[i]);
 	delete pEngine;
-	delete pEngineMap;
-	delete pGameServer;
-	delete pConsole;
-	delete pEngineMasterServer;
 	delete pStorage;
-	delete pConfigManager;
 
 	return Ret;
 }
@@ -5,41 +5,10 @@
 
 #include <engine/server.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/snapshot.h>
 
-class CSnapIDPool
-{
-	enum
-	{
-		MAX_IDS = 16*1024,
-	};
-
-	class CID
-	{
-	public:
-		short m_Next;
-		short m_State; // 0 = free, 1 = allocated, 2 = timed
-		int m_Timeout;
-	};
-
-	CID m_aIDs[MAX_IDS];
-
-	int m_FirstFree;
-	int m_FirstTimed;
-	int m_LastTimed;
-	int m_Usage;
-	int m_InUsage;
-
-public:
-
-	CSnapIDPool();
-
-	void Reset();
-	void RemoveFirstTimeout();
-	int NewID();
-	void TimeoutIDs();
-	void FreeID(int ID);
-};
-
+#include "profiler.h"
+#include "replay.h"
 
 class CServerBan : public CNetBan
 {
@@ -47,6 +16,9 @@ class CServerBan : public CNetBan
 
 	template<class T> int BanExt(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason);
 
+protected:
+	virtual void OnBansLoaded();
+
 public:
 	class CServer *Server() const { return m_pServer; }
 
@@ -118,6 +90,24 @@ public:
 		int m_LastAckedSnapshot;
 		int m_LastInputTick;
 		CSnapshotStorage m_Snapshots;
+		int64 m_SnapBytes;
+
+		// snapshot scheduling, see CServer::ScheduleSnapshot
+		enum
+		{
+			SNAP_HISTORY=32,
+		};
+		int m_SnapInterval; // snapshot rounds between two snapshots
+		int m_SnapBackoff; // the interval the lagging acks allow
+		int m_SnapGoodRounds;
+		int m_SnapHoldRounds;
+		int m_aSnapHistoryTick[SNAP_HISTORY];
+		int m_aSnapHistoryBytes[SNAP_HISTORY];
+		int m_SnapHistoryIndex;
+		int m_SnapAckedTick;
+		int m_SnapThroughput; // acked snapshot bytes per second, smoothed
+		int m_SnapSentBytes; // since the last round
+		int m_SnapSendRate; // sent snapshot bytes per second, smoothed
 
 		CInput m_LatestInput;
 		CInput m_aInputs[200]; // TODO: handle input better
@@ -148,6 +138,23 @@ public:
 	CNetServer m_NetServer;
 	CEcon m_Econ;
 	CServerBan m_ServerBan;
+	CTickProfiler m_Profiler;
+
+	// compressed snapshot bytes per item type
+	enum
+	{
+		MAX_SNAPSTATS_TYPES=64,
+	};
+	int64 m_aSnapTypeBytes[MAX_SNAPSTATS_TYPES];
+	int64 m_SnapOverheadBytes;
+	int64 m_SnapStatsStartTime;
+	int64 m_LastSnapStatsDump;
+
+	// replay recording starts with the next map load
+	CReplayRecorder m_ReplayRecorder;
+	char m_aReplayFilename[128];
+	bool m_Replaying;
+	int m_ReplaySnapCrc;
 
 	IEngineMap *m_pMap;
 
@@ -156,7 +163,10 @@ public:
 	bool m_MapReload;
 	int m_RconClientID;
 	int m_RconAuthLevel;
+	int m_RconLineReentry;
+	int m_SnapRound;
 	int m_PrintCBIndex;
+	int64 m_LastProfilerDump;
 
 	// map
 	enum
@@ -197,6 +207,7 @@ public:
 	CMapChecker m_MapChecker;
 
 	CServer();
+	void SetInstance(int Instance) { m_Instance = Instance; }
 
 	virtual void SetClientName(int ClientID, const char *pName);
 	virtual void SetClientClan(int ClientID, char const *pClan);
@@ -227,6 +238,7 @@ public:
 
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID);
 
+	bool ScheduleSnapshot(int ClientID);
 	void DoSnapshot();
 
 	static int NewClientCallback(int ClientID, void *pUser);
@@ -254,13 +266,20 @@ public:
 	virtual void ChangeMap(const char *pMap);
 	const char *GetMapName();
 	int LoadMap(const char *pMapName);
+	void PrintMapChangeStats(int64 StartTime);
 
 	void InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, CConfig *pConfig, IConsole *pConsole);
 	void InitInterfaces(CConfig *pConfig, IConsole *pConsole, IGameServer *pGameServer, IEngineMap *pMap, IStorage *pStorage);
 	int Run();
+	int RunReplay(const char *pFilename);
+	void StartReplayRecording();
 
 	static int MapListEntryCallback(const char *pFilename, int IsDir, int DirType, void *pUser);
 
+	void PrintProfilerLine(int OutputLevel);
+	void ResetSnapStats();
+	void PrintSnapStats(int Num, int OutputLevel);
+
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
 	static void ConStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
@@ -269,6 +288,12 @@ public:
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConSaveConfig(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
+	static void ConProfiler(IConsole::IResult *pResult, void *pUser);
+	static void ConProfilerReset(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapStats(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapStatsReset(IConsole::IResult *pResult, void *pUser);
+	static void ConReplayRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConReplayStop(IConsole::IResult *pResult, void *pUser);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainPlayerSlotsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -277,6 +302,7 @@ public:
 	static void ConchainConsoleOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainRconPasswordSet(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainProfilerUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
 	void RegisterCommands();
 
@@ -285,6 +311,7 @@ public:
 	virtual void SnapFreeID(int ID);
 	virtual void *SnapNewItem(int Type, int ID, int Size);
 	void SnapSetStaticsize(int ItemType, int Size);
+	virtual int MaxSnapshotDelay();
 };
 
 #endif
@@ -31,6 +31,9 @@ enum
 	CFGFLAG_BASICACCESS=64,
 };
 
+// escapes \ and " so the string can be used as a quoted console parameter
+void EscapeParam(char *pDst, const char *pSrc, int size);
+
 class CConfigManager : public IConfigManager
 {
 	enum
@@ -14,11 +14,13 @@ MACRO_CONFIG_INT(PlayerCountry, player_country, -1, -1, 1000, CFGFLAG_SAVE|CFGFL
 MACRO_CONFIG_STR(Password, password, 32, "", CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Password to the server")
 MACRO_CONFIG_STR(Logfile, logfile, 128, "", CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Filename to log all output to")
 MACRO_CONFIG_INT(LogfileTimestamp, logfile_timestamp, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Add a time stamp to the log file's name")
+MACRO_CONFIG_INT(LogFlushInterval, log_flush_interval, 100, 0, 5000, CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Write the log from a background thread and flush it every this many milliseconds (0 = write every line right away)")
 MACRO_CONFIG_INT(ConsoleOutputLevel, console_output_level, 0, 0, 2, CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Adjusts the amount of information in the console")
 MACRO_CONFIG_INT(ShowConsoleWindow, show_console_window, 1, 0, 3, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Show console window (0 = never, 1 = debug, 2 = release, 3 = always")
 
 MACRO_CONFIG_INT(ClCpuThrottle, cl_cpu_throttle, 0, 0, 100, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Throttles the main thread")
 MACRO_CONFIG_INT(ClEditor, cl_editor, 0, 0, 1, CFGFLAG_CLIENT, "View the editor")
+MACRO_CONFIG_INT(ClSkinCache, cl_skin_cache, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Keep processed skin parts in a cache on disk to speed up loading")
 MACRO_CONFIG_INT(ClLoadCountryFlags, cl_load_country_flags, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Load and show country flags")
 
 MACRO_CONFIG_INT(ClAutoDemoRecord, cl_auto_demo_record, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Automatically record demos")
@@ -65,10 +67,13 @@ MACRO_CONFIG_INT(GfxHighDetail, gfx_high_detail, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_C
 MACRO_CONFIG_INT(GfxTextureQuality, gfx_texture_quality, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Don't scale textures down")
 MACRO_CONFIG_INT(GfxFsaaSamples, gfx_fsaa_samples, 0, 0, 16, CFGFLAG_SAVE|CFGFLAG_CLIENT, "FSAA Samples")
 MACRO_CONFIG_INT(GfxFinish, gfx_finish, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Wait till the gpu finished the current frame before starting the new one")
+MACRO_CONFIG_INT(GfxLoadThreads, gfx_load_threads, 4, 1, 16, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of threads used to decode images while loading")
 MACRO_CONFIG_INT(GfxAsyncRender, gfx_asyncrender, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Do rendering async from the the update")
 MACRO_CONFIG_INT(GfxMaxFps, gfx_maxfps, 144, 30, 2000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Maximum fps (when limit fps is enabled)")
 MACRO_CONFIG_INT(GfxLimitFps, gfx_limitfps, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Limit fps")
 MACRO_CONFIG_INT(GfxUseX11XRandRWM, gfx_use_x11xrandr_wm, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Let SDL use the X11 XRandR window manager")
+MACRO_CONFIG_INT(GfxCommandBuffers, gfx_cmdbuffers, 3, 2, 4, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of command buffers the renderer can queue ahead of the gpu (needs a restart)")
+MACRO_CONFIG_INT(GfxNullBackend, gfx_null_backend, 0, 0, 1, CFGFLAG_CLIENT, "Use a backend that renders nothing and only records statistics (needs a restart)")
 
 MACRO_CONFIG_INT(InpGrab, inp_grab, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Disable OS mouse settings such as mouse acceleration, use raw mouse input mode")
 MACRO_CONFIG_INT(InpMousesens, inp_mousesens, 100, 1, 100000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Ingame mouse sensitivity")
@@ -98,6 +103,13 @@ MACRO_CONFIG_INT(SvRconMaxTries, sv_rcon_max_tries, 3, 0, 100, CFGFLAG_SAVE|CFGF
 MACRO_CONFIG_INT(SvRconBantime, sv_rcon_bantime, 5, 0, 1440, CFGFLAG_SAVE|CFGFLAG_SERVER, "The time a client gets banned if remote console authentication fails. 0 makes it just use kick")
 MACRO_CONFIG_INT(SvAutoDemoRecord, sv_auto_demo_record, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_SERVER, "Automatically record demos")
 MACRO_CONFIG_INT(SvAutoDemoMax, sv_auto_demo_max, 10, 0, 1000, CFGFLAG_SAVE|CFGFLAG_SERVER, "Maximum number of automatically recorded demos (0 = no limit)")
+MACRO_CONFIG_INT(SvProfiler, sv_profiler, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_SERVER, "Measure tick phase timings and per client snapshot costs")
+MACRO_CONFIG_INT(SvProfilerDump, sv_profiler_dump, 0, 0, 3600, CFGFLAG_SAVE|CFGFLAG_SERVER, "Print a profiler summary line every x seconds (0 = never)")
+MACRO_CONFIG_INT(SvSnapScheduler, sv_snap_scheduler, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_SERVER, "Adapt the snapshot rate of each client to its connection and whether it is playing")
+MACRO_CONFIG_INT(SvSnapIdleInterval, sv_snap_idle_interval, 2, 1, 10, CFGFLAG_SAVE|CFGFLAG_SERVER, "Send spectators and dead players every x-th snapshot")
+MACRO_CONFIG_INT(SvSnapMaxInterval, sv_snap_max_interval, 8, 1, 25, CFGFLAG_SAVE|CFGFLAG_SERVER, "Send lagging clients at least every x-th snapshot")
+MACRO_CONFIG_INT(SvSnapStats, sv_snap_stats, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_SERVER, "Account compressed snapshot bandwidth per item type and client")
+MACRO_CONFIG_INT(SvSnapStatsDump, sv_snap_stats_dump, 0, 0, 3600, CFGFLAG_SAVE|CFGFLAG_SERVER, "Print the top snapshot bandwidth users every x seconds (0 = never)")
 
 MACRO_CONFIG_STR(EcBindaddr, ec_bindaddr, 128, "localhost", CFGFLAG_SAVE|CFGFLAG_ECON, "Address to bind the external console to. Anything but 'localhost' is dangerous")
 MACRO_CONFIG_INT(EcPort, ec_port, 0, 0, 0, CFGFLAG_SAVE|CFGFLAG_ECON, "Port to use for the external console")
@@ -114,6 +126,7 @@ MACRO_CONFIG_INT(DbgStressNetwork, dbg_stress_network, 0, 0, 0, CFGFLAG_CLIENT|C
 MACRO_CONFIG_INT(DbgPref, dbg_pref, 0, 0, 1, CFGFLAG_SERVER, "Performance outputs")
 MACRO_CONFIG_INT(DbgGraphs, dbg_graphs, 0, 0, 1, CFGFLAG_CLIENT, "Performance graphs")
 MACRO_CONFIG_INT(DbgHitch, dbg_hitch, 0, 0, 0, CFGFLAG_SERVER, "Hitch warnings")
+MACRO_CONFIG_INT(DbgMem, dbg_mem, 0, 0, 2, CFGFLAG_CLIENT|CFGFLAG_SERVER, "Memory tracking (1 = statistics per subsystem, 2 = also guard blocks and list leaks at exit)")
 MACRO_CONFIG_STR(DbgStressServer, dbg_stress_server, 32, "localhost", CFGFLAG_CLIENT, "Server to stress")
 MACRO_CONFIG_INT(DbgResizable, dbg_resizable, 0, 0, 0, CFGFLAG_CLIENT, "Enables window resizing")
 
@@ -373,13 +373,30 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr)
 			pEnd++;
 		}
 
-		if(ParseStart(&Result, pStr, (pEnd-pStr) + 1) != 0)
-			return;
+		CCommand *pCommand;
+		const CParsedLine *pParsed = Stroke ? FindParsedLine(pStr, pEnd-pStr) : 0;
+		if(pParsed)
+		{
+			RestoreParsedLine(pParsed, &Result);
+			pCommand = pParsed->m_pCommand;
+		}
+		else
+		{
+			if(ParseStart(&Result, pStr, (pEnd-pStr) + 1) != 0)
+				return;
 
-		if(!*Result.m_pCommand)
-			return;
+			if(!*Result.m_pCommand)
+				return;
 
-		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+			// releasing only concerns stroke commands
+			if(!Stroke && Result.m_pCommand[0] != '+')
+			{
+				pStr = pNextPart;
+				continue;
+			}
+
+			pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+		}
 
 		if(pCommand)
 		{
@@ -395,20 +412,26 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr)
 
 				if(Stroke || IsStrokeCommand)
 				{
-					if(ParseArgs(&Result, pCommand->m_pParams))
+					if(!pParsed && ParseArgs(&Result, pCommand->m_pParams))
 					{
 						char aBuf[256];
 						str_format(aBuf, sizeof(aBuf), "Invalid arguments... Usage: %s %s", pCommand->m_pName, pCommand->m_pParams);
 						Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 					}
-					else if(m_StoreCommands && pCommand->m_Flags&CFGFLAG_STORE)
+					else
 					{
-						m_ExecutionQueue.AddEntry();
-						m_ExecutionQueue.m_pLast->m_pCommand = pCommand;
-						m_ExecutionQueue.m_pLast->m_Result = Result;
+						if(!pParsed && !IsStrokeCommand)
+							AddParsedLine(pStr, pEnd-pStr, pCommand, &Result);
+
+						if(m_StoreCommands && pCommand->m_Flags&CFGFLAG_STORE)
+						{
+							m_ExecutionQueue.AddEntry();
+							m_ExecutionQueue.m_pLast->m_pCommand = pCommand;
+							m_ExecutionQueue.m_pLast->m_Result = Result;
+						}
+						else
+							pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
 					}
-					else
-						pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
 				}
 			}
 			else if(Stroke)
@@ -457,9 +480,22 @@ int CConsole::PossibleMaps(const char *pStr, FPossibleCallback pfnCallback, void
 	return Index;
 }
 
+unsigned CConsole::HashName(const char *pName)
+{
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a'-'A';
+		Hash = (Hash^c)*16777619u;
+	}
+	return Hash&(HASH_SIZE-1);
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[HashName(pName)]; pCommand; pCommand = pCommand->m_pHashNext)
 	{
 		if(pCommand->m_Flags&FlagMask && str_comp_nocase(pCommand->m_pName, pName) == 0)
 		{
@@ -470,6 +506,70 @@ CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 	return 0x0;
 }
 
+void CConsole::RemoveCommandHash(CCommand *pCommand)
+{
+	for(CCommand **ppCommand = &m_apCommandHash[HashName(pCommand->m_pName)]; *ppCommand; ppCommand = &(*ppCommand)->m_pHashNext)
+	{
+		if(*ppCommand == pCommand)
+		{
+			*ppCommand = pCommand->m_pHashNext;
+			break;
+		}
+	}
+	pCommand->m_pHashNext = 0;
+}
+
+unsigned CConsole::HashLine(const char *pStr, int Length)
+{
+	unsigned Hash = 2166136261u;
+	for(int i = 0; i < Length; i++)
+		Hash = (Hash^(unsigned char)pStr[i])*16777619u;
+	return Hash;
+}
+
+const CConsole::CParsedLine *CConsole::FindParsedLine(const char *pStr, int Length) const
+{
+	if(Length <= 0 || Length >= PARSE_CACHE_LINE_LENGTH)
+		return 0;
+
+	const CParsedLine *pParsed = &m_aParseCache[HashLine(pStr, Length)%PARSE_CACHE_SIZE];
+	if(pParsed->m_Length != Length || pParsed->m_FlagMask != m_FlagMask || mem_comp(pParsed->m_aLine, pStr, Length) != 0)
+		return 0;
+	return pParsed;
+}
+
+void CConsole::AddParsedLine(const char *pStr, int Length, CCommand *pCommand, const CResult *pResult)
+{
+	if(Length <= 0 || Length >= PARSE_CACHE_LINE_LENGTH || pResult->NumArguments() > PARSE_CACHE_MAX_ARGS)
+		return;
+
+	CParsedLine *pParsed = &m_aParseCache[HashLine(pStr, Length)%PARSE_CACHE_SIZE];
+	pParsed->m_Length = Length;
+	pParsed->m_FlagMask = m_FlagMask;
+	mem_copy(pParsed->m_aLine, pStr, Length);
+	mem_copy(pParsed->m_aParsed, pResult->m_aStringStorage, Length+1);
+	pParsed->m_pCommand = pCommand;
+	pParsed->m_NumArgs = pResult->NumArguments();
+	pParsed->m_CommandOffset = pResult->m_pCommand-pResult->m_aStringStorage;
+	for(int i = 0; i < pParsed->m_NumArgs; i++)
+		pParsed->m_aArgOffsets[i] = pResult->m_apArgs[i]-pResult->m_aStringStorage;
+}
+
+void CConsole::RestoreParsedLine(const CParsedLine *pParsed, CResult *pResult) const
+{
+	mem_copy(pResult->m_aStringStorage, pParsed->m_aParsed, pParsed->m_Length+1);
+	pResult->m_pCommand = pResult->m_aStringStorage+pParsed->m_CommandOffset;
+	pResult->m_pArgsStart = pResult->m_aStringStorage+pParsed->m_Length;
+	for(int i = 0; i < pParsed->m_NumArgs; i++)
+		pResult->AddArgument(pResult->m_aStringStorage+pParsed->m_aArgOffsets[i]);
+}
+
+void CConsole::ClearParseCache()
+{
+	for(int i = 0; i < PARSE_CACHE_SIZE; i++)
+		m_aParseCache[i].m_Length = 0;
+}
+
 void CConsole::ExecuteLine(const char *pStr)
 {
 	CConsole::ExecuteLineStroked(1, pStr); // press it
@@ -808,6 +908,9 @@ CConsole::CConsole(int FlagMask)
 	m_pLastMapEntry = 0;
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
+	mem_zero(m_apMapHash, sizeof(m_apMapHash));
+	ClearParseCache();
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -852,23 +955,29 @@ void CConsole::Init()
 	m_pConfig = Kernel()->RequestInterface<IConfigManager>()->Values();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 
-	// TODO: this should disappear
+	// the variable data lives as long as the console, several consoles can exist in one process
 	#define MACRO_CONFIG_INT(Name,ScriptName,Def,Min,Max,Flags,Desc) \
 	{ \
-		static CIntVariableData Data = { this, &m_pConfig->m_##Name, Min, Max }; \
-		Register(#ScriptName, "?i", Flags, IntVariableCommand, &Data, Desc); \
+		CIntVariableData Data = { this, &m_pConfig->m_##Name, Min, Max }; \
+		CIntVariableData *pData = (CIntVariableData *)m_VariableData.Allocate(sizeof(Data)); \
+		*pData = Data; \
+		Register(#ScriptName, "?i", Flags, IntVariableCommand, pData, Desc); \
 	}
 
 	#define MACRO_CONFIG_STR(Name,ScriptName,Len,Def,Flags,Desc) \
 	{ \
-		static CStrVariableData Data = { this, m_pConfig->m_##Name, Len, Len }; \
-		Register(#ScriptName, "?r", Flags, StrVariableCommand, &Data, Desc); \
+		CStrVariableData Data = { this, m_pConfig->m_##Name, Len, Len }; \
+		CStrVariableData *pData = (CStrVariableData *)m_VariableData.Allocate(sizeof(Data)); \
+		*pData = Data; \
+		Register(#ScriptName, "?r", Flags, StrVariableCommand, pData, Desc); \
 	}
 
 	#define MACRO_CONFIG_UTF8STR(Name,ScriptName,Size,Len,Def,Flags,Desc) \
 	{ \
-		static CStrVariableData Data = { this, m_pConfig->m_##Name, Size, Len }; \
-		Register(#ScriptName, "?r", Flags, StrVariableCommand, &Data, Desc); \
+		CStrVariableData Data = { this, m_pConfig->m_##Name, Size, Len }; \
+		CStrVariableData *pData = (CStrVariableData *)m_VariableData.Allocate(sizeof(Data)); \
+		*pData = Data; \
+		Register(#ScriptName, "?r", Flags, StrVariableCommand, pData, Desc); \
 	}
 
 	#include "config_variables.h"
@@ -925,6 +1034,11 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+
+	// like in the sorted list, a new command comes before the ones with the same name
+	unsigned Hash = HashName(pCommand->m_pName);
+	pCommand->m_pHashNext = m_apCommandHash[Hash];
+	m_apCommandHash[Hash] = pCommand;
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -949,6 +1063,7 @@ void CConsole::Register(const char *pName, const char *pParams,
 
 	if(DoAdd)
 		AddCommandSorted(pCommand);
+	ClearParseCache();
 }
 
 void CConsole::RegisterTemp(const char *pName, const char *pParams,	int Flags, const char *pHelp)
@@ -983,6 +1098,7 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams,	int Flags, c
 	pCommand->m_Temp = true;
 
 	AddCommandSorted(pCommand);
+	ClearParseCache();
 }
 
 void CConsole::DeregisterTemp(const char *pName)
@@ -1012,8 +1128,10 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHash(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
+		ClearParseCache();
 	}
 }
 
@@ -1033,6 +1151,18 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(int i = 0; i < HASH_SIZE; i++)
+	{
+		for(CCommand **ppCommand = &m_apCommandHash[i]; *ppCommand; )
+		{
+			if((*ppCommand)->m_Temp)
+				*ppCommand = (*ppCommand)->m_pHashNext;
+			else
+				ppCommand = &(*ppCommand)->m_pHashNext;
+		}
+	}
+	ClearParseCache();
+
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
 }
@@ -1050,38 +1180,34 @@ void CConsole::RegisterTempMap(const char *pName)
 	if(!m_pFirstMapEntry)
 		m_pFirstMapEntry = pEntry;
 	str_copy(pEntry->m_aName, pName, TEMPMAP_NAME_LENGTH);
+
+	unsigned Hash = HashName(pEntry->m_aName);
+	pEntry->m_pHashNext = m_apMapHash[Hash];
+	m_apMapHash[Hash] = pEntry;
 }
 
 void CConsole::DeregisterTempMap(const char *pName)
 {
-	if(!m_pFirstMapEntry)
-		return;
-
-	CHeap *pNewTempMapListHeap = new CHeap();
-	CMapListEntryTemp *pNewFirstEntry = 0;
-	CMapListEntryTemp *pNewLastEntry = 0;
-
-	for(CMapListEntryTemp *pSrc = m_pFirstMapEntry; pSrc; pSrc = pSrc->m_pNext)
+	// the entries stay in the heap until all maps are removed
+	for(CMapListEntryTemp **ppEntry = &m_apMapHash[HashName(pName)]; *ppEntry; )
 	{
-		if(str_comp_nocase(pName, pSrc->m_aName) == 0)
+		CMapListEntryTemp *pEntry = *ppEntry;
+		if(str_comp_nocase(pName, pEntry->m_aName) != 0)
+		{
+			ppEntry = &pEntry->m_pHashNext;
 			continue;
+		}
 
-		CMapListEntryTemp *pDst = (CMapListEntryTemp *)pNewTempMapListHeap->Allocate(sizeof(CMapListEntryTemp));
-		pDst->m_pNext = 0;
-		pDst->m_pPrev = m_pLastMapEntry;
-		if(pDst->m_pPrev)
-			pDst->m_pPrev->m_pNext = pDst;
-		m_pLastMapEntry = pDst;
-		if(!m_pFirstMapEntry)
-			m_pFirstMapEntry = pDst;
-
-		str_copy(pDst->m_aName, pSrc->m_aName, TEMPMAP_NAME_LENGTH);
+		*ppEntry = pEntry->m_pHashNext;
+		if(pEntry->m_pPrev)
+			pEntry->m_pPrev->m_pNext = pEntry->m_pNext;
+		else
+			m_pFirstMapEntry = pEntry->m_pNext;
+		if(pEntry->m_pNext)
+			pEntry->m_pNext->m_pPrev = pEntry->m_pPrev;
+		else
+			m_pLastMapEntry = pEntry->m_pPrev;
 	}
-
-	delete m_pTempMapListHeap;
-	m_pTempMapListHeap = pNewTempMapListHeap;
-	m_pFirstMapEntry = pNewFirstEntry;
-	m_pLastMapEntry = pNewLastEntry;
 }
 
 void CConsole::DeregisterTempMapAll()
@@ -1090,6 +1216,7 @@ void CConsole::DeregisterTempMapAll()
 		m_pTempMapListHeap->Reset();
 	m_pFirstMapEntry = 0;
 	m_pLastMapEntry = 0;
+	mem_zero(m_apMapHash, sizeof(m_apMapHash));
 }
 
 void CConsole::Con_Chain(IResult *pResult, void *pUserData)
@@ -1137,7 +1264,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[HashName(pName)]; pCommand; pCommand = pCommand->m_pHashNext)
 	{
 		if(pCommand->m_Flags&FlagMask && pCommand->m_Temp == Temp)
 		{
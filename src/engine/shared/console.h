@@ -14,6 +14,7 @@ class CConsole : public IConsole
 	public:
 		CCommand(bool BasicAccess) : CCommandInfo(BasicAccess) {}
 		CCommand *m_pNext;
+		CCommand *m_pHashNext;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -53,6 +54,7 @@ class CConsole : public IConsole
 
 	CCommand *m_pRecycleList;
 	CHeap m_TempCommands;
+	CHeap m_VariableData;
 
 	static void Con_Chain(IResult *pResult, void *pUserData);
 	static void Con_Echo(IResult *pResult, void *pUserData);
@@ -89,12 +91,12 @@ class CConsole : public IConsole
 		const char *m_pCommand;
 		const char *m_apArgs[MAX_PARTS];
 
+		// only the first m_NumArgs arguments are valid, no need to clear the rest
 		CResult() : IResult()
 		{
-			mem_zero(m_aStringStorage, sizeof(m_aStringStorage));
+			m_aStringStorage[0] = 0;
 			m_pArgsStart = 0;
 			m_pCommand = 0;
-			mem_zero(m_apArgs, sizeof(m_apArgs));
 		}
 
 		CResult &operator =(const CResult &Other)
@@ -163,18 +165,58 @@ class CConsole : public IConsole
 		}
 	} m_ExecutionQueue;
 
+	enum
+	{
+		HASH_SIZE = 1024,
+
+		PARSE_CACHE_SIZE = 64,
+		PARSE_CACHE_LINE_LENGTH = 128,
+		PARSE_CACHE_MAX_ARGS = 8,
+	};
+
+	// case insensitive, like the lookup
+	static unsigned HashName(const char *pName);
+
+	// all commands by name, including the temporary ones
+	CCommand *m_apCommandHash[HASH_SIZE];
+
 	void AddCommandSorted(CCommand *pCommand);
+	void RemoveCommandHash(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
+	// lines that were parsed before. votes and scripts run the same lines again
+	// and again, those skip the parsing and the command lookup. the cache is
+	// cleared whenever a command is added or removed
+	struct CParsedLine
+	{
+		int m_Length; // 0 for an unused entry
+		int m_FlagMask;
+		char m_aLine[PARSE_CACHE_LINE_LENGTH];
+		char m_aParsed[PARSE_CACHE_LINE_LENGTH];
+		CCommand *m_pCommand;
+		int m_NumArgs;
+		unsigned char m_CommandOffset;
+		unsigned char m_aArgOffsets[PARSE_CACHE_MAX_ARGS];
+	};
+	CParsedLine m_aParseCache[PARSE_CACHE_SIZE];
+
+	static unsigned HashLine(const char *pStr, int Length);
+	const CParsedLine *FindParsedLine(const char *pStr, int Length) const;
+	void AddParsedLine(const char *pStr, int Length, CCommand *pCommand, const CResult *pResult);
+	void RestoreParsedLine(const CParsedLine *pParsed, CResult *pResult) const;
+	void ClearParseCache();
+
 	struct CMapListEntryTemp {
 		CMapListEntryTemp *m_pPrev;
 		CMapListEntryTemp *m_pNext;
+		CMapListEntryTemp *m_pHashNext;
 		char m_aName[TEMPMAP_NAME_LENGTH];
 	};
 
 	CHeap *m_pTempMapListHeap;
 	CMapListEntryTemp *m_pFirstMapEntry;
 	CMapListEntryTemp *m_pLastMapEntry;
+	CMapListEntryTemp *m_apMapHash[HASH_SIZE];
 
 public:
 	CConsole(int FlagMask);
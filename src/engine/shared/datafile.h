@@ -25,6 +25,7 @@ public:
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	int GetDataSize(int Index) const;
+	int LoadedDataSize() const; // bytes of data currently held in memory
 	void ReplaceData(int Index, char *pData, int Size);
 	void UnloadData(int Index);
 	void *GetItem(int Index, int *pType, int *pID);
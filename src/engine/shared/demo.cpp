@@ -348,6 +348,7 @@ CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_FixedStep = 0;
 }
 
 void CDemoPlayer::Init(class IConsole *pConsole, class IStorage *pStorage)
@@ -777,7 +778,7 @@ void CDemoPlayer::SetSpeed(float Speed)
 int CDemoPlayer::Update()
 {
 	int64 Now = time_get();
-	int64 Deltatime = Now-m_Info.m_LastUpdate;
+	int64 Deltatime = m_FixedStep ? m_FixedStep : Now-m_Info.m_LastUpdate;
 	m_Info.m_LastUpdate = Now;
 
 	if(!IsPlaying() || m_Info.m_Info.m_Paused)
@@ -97,6 +97,7 @@ private:
 
 	CPlaybackInfo m_Info;
 	int m_DemoType;
+	int64 m_FixedStep;
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
@@ -117,6 +118,8 @@ public:
 	void Unpause();
 	int Stop();
 	void SetSpeed(float Speed);
+	// advance by a fixed time on every update instead of the real time that passed, 0 to disable
+	void SetFixedStep(int64 Step) { m_FixedStep = Step; }
 	int SetPos(float Percent);
 	int SetPos(int WantedTick);
 	const CInfo *BaseInfo() const { return &m_Info.m_Info; }
@@ -48,6 +48,50 @@ public:
 		}
 	}
 
+	static void Con_MemStats(IConsole::IResult *pResult, void *pUserData)
+	{
+		CEngine *pEngine = static_cast<CEngine *>(pUserData);
+		IConsole *pConsole = pEngine->m_pConsole;
+
+		if(mem_debug_level() == MEMDEBUG_OFF)
+		{
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mem", "memory statistics are off, turn them on with dbg_mem 1");
+			return;
+		}
+
+		char aBuf[256];
+		MEMSTATS Total;
+		mem_zero(&Total, sizeof(Total));
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mem", "tag        live KiB   peak KiB     blocks     allocs");
+		for(int i = 0; i < NUM_MEMTAGS; i++)
+		{
+			MEMSTATS Stats;
+			mem_stats(i, &Stats);
+			str_format(aBuf, sizeof(aBuf), "%-8s %10lld %10lld %10lld %10lld", mem_tag_name(i),
+				Stats.live_bytes/1024, Stats.peak_bytes/1024, Stats.live_blocks, Stats.num_allocs);
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mem", aBuf);
+			Total.live_bytes += Stats.live_bytes;
+			Total.live_blocks += Stats.live_blocks;
+			Total.num_allocs += Stats.num_allocs;
+		}
+		str_format(aBuf, sizeof(aBuf), "%-8s %10lld %10s %10lld %10lld", "total", Total.live_bytes/1024, "-", Total.live_blocks, Total.num_allocs);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mem", aBuf);
+
+		if(mem_debug_level() >= MEMDEBUG_GUARD)
+		{
+			str_format(aBuf, sizeof(aBuf), "guards %s, %d guarded blocks allocated", mem_check() ? "intact" : "overwritten",
+				mem_print_blocks(0));
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mem", aBuf);
+		}
+	}
+
+	static void ConchainDbgMem(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+	{
+		pfnCallback(pResult, pCallbackUserData);
+		if(pResult->NumArguments())
+			mem_debug(static_cast<CEngine *>(pUserData)->m_pConfig->m_DbgMem);
+	}
+
 	CEngine(const char *pAppname)
 	{
 		srand(time_get());
@@ -76,6 +120,7 @@ public:
 	~CEngine()
 	{
 		StopLogging();
+		dbg_logger_sync();
 	}
 
 	void Init()
@@ -88,6 +133,7 @@ public:
 			return;
 
 		m_pConsole->Register("dbg_lognetwork", "", CFGFLAG_SERVER|CFGFLAG_CLIENT, Con_DbgLognetwork, this, "Log the network");
+		m_pConsole->Register("mem_stats", "", CFGFLAG_SERVER|CFGFLAG_CLIENT, Con_MemStats, this, "Show the memory usage per subsystem");
 	}
 
 	void InitLogfile()
@@ -108,6 +154,13 @@ public:
 			else
 				dbg_msg("engine/logfile", "failed to open '%s' for logging", aLogFilename);
 		}
+
+		if(m_pConfig->m_LogFlushInterval)
+			dbg_logger_async(m_pConfig->m_LogFlushInterval);
+
+		// memory tracking can be changed later on too
+		mem_debug(m_pConfig->m_DbgMem);
+		m_pConsole->Chain("dbg_mem", ConchainDbgMem, this);
 	}
 
 	void QueryNetLogHandles(IOHANDLE *pHDLSend, IOHANDLE *pHDLRecv)
@@ -1,44 +1,52 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/map.h>
 #include <engine/storage.h>
 #include <game/mapitems.h>
 #include "datafile.h"
 
-class CMap : public IEngineMap
+// the data of one map file. servers of one process that load the same map
+// share it, so it is only held in memory once
+class CMapData
 {
-	CDataFileReader m_DataFile;
 public:
-	CMap() {}
+	CDataFileReader m_DataFile;
 
-	virtual void *GetData(int Index) { return m_DataFile.GetData(Index); }
-	virtual void *GetDataSwapped(int Index) { return m_DataFile.GetDataSwapped(Index); }
-	virtual void UnloadData(int Index) { m_DataFile.UnloadData(Index); }
-	virtual void *GetItem(int Index, int *pType, int *pID) { return m_DataFile.GetItem(Index, pType, pID); }
-	virtual void GetType(int Type, int *pStart, int *pNum) { m_DataFile.GetType(Type, pStart, pNum); }
-	virtual void *FindItem(int Type, int ID) { return m_DataFile.FindItem(Type, ID); }
-	virtual int NumItems() { return m_DataFile.NumItems(); }
+	// the skip compressed tile layers (version > 3) by data index. they are
+	// expanded on first access, so data nobody asks for stays compressed
+	struct CTileData
+	{
+		int m_NumTiles; // 0 if the data is no compressed tile layer
+		bool m_Expanded;
+	};
+	CTileData *m_pTileData;
+	int m_NumTileData;
 
-	virtual void Unload()
+	LOCK m_Lock; // guards the data loading and expanding
+	int m_Refs; // guarded by MapDataLock()
+	CMapData *m_pNext;
+
+	CMapData() : m_pTileData(0), m_NumTileData(0), m_Refs(0), m_pNext(0) { m_Lock = lock_create(); }
+	~CMapData()
 	{
-		m_DataFile.Close();
+		mem_free(m_pTileData);
+		lock_destroy(m_Lock);
 	}
 
-	virtual bool Load(const char *pMapName, IStorage *pStorage)
+	bool Init()
 	{
-		if(!pStorage)
-			pStorage = Kernel()->RequestInterface<IStorage>();
-		if(!pStorage)
-			return false;
-		if(!m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL))
-			return false;
 		// check version
 		CMapItemVersion *pItem = (CMapItemVersion *)m_DataFile.FindItem(MAPITEMTYPE_VERSION, 0);
 		if(!pItem || pItem->m_Version != CMapItemVersion::CURRENT_VERSION)
 			return false;
 
-		// replace compressed tile layers with uncompressed ones
+		// find the compressed tile layers, they get expanded when their data is used
+		m_NumTileData = m_DataFile.NumData();
+		m_pTileData = static_cast<CTileData *>(mem_alloc_tagged(max(m_NumTileData, 1) * sizeof(CTileData), 1, MEMTAG_MAP));
+		mem_zero(m_pTileData, max(m_NumTileData, 1) * sizeof(CTileData));
+
 		int GroupsStart, GroupsNum, LayersStart, LayersNum;
 		m_DataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
 		m_DataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
@@ -63,25 +71,8 @@ public:
 							dbg_msg("engine", "map layer too big (%d * %d * %u causes an integer overflow)", pTilemap->m_Width, pTilemap->m_Height, unsigned(sizeof(CTile)));
 							return false;
 						}
-						CTile *pTiles = static_cast<CTile *>(mem_alloc(TilemapSize, 1));
-						if(!pTiles)
-							return false;
-
-						// extract original tile data
-						int i = 0;
-						CTile *pSavedTiles = static_cast<CTile *>(m_DataFile.GetData(pTilemap->m_Data));
-						while(i < TilemapCount)
-						{
-							for(unsigned Counter = 0; Counter <= pSavedTiles->m_Skip && i < TilemapCount; Counter++)
-							{
-								pTiles[i] = *pSavedTiles;
-								pTiles[i++].m_Skip = 0;
-							}
-
-							pSavedTiles++;
-						}
-
-						m_DataFile.ReplaceData(pTilemap->m_Data, reinterpret_cast<char *>(pTiles), TilemapSize);
+						if(pTilemap->m_Data >= 0 && pTilemap->m_Data < m_NumTileData)
+							m_pTileData[pTilemap->m_Data].m_NumTiles = TilemapCount;
 					}
 				}
 			}
@@ -91,19 +82,200 @@ public:
 		return true;
 	}
 
+	bool NeedsExpand(int Index) const
+	{
+		return Index >= 0 && Index < m_NumTileData && m_pTileData[Index].m_NumTiles && !m_pTileData[Index].m_Expanded;
+	}
+
+	bool ExpandTiles(int Index)
+	{
+		const int TilemapCount = m_pTileData[Index].m_NumTiles;
+		const int TilemapSize = TilemapCount * sizeof(CTile);
+		CTile *pSavedTiles = static_cast<CTile *>(m_DataFile.GetData(Index));
+		if(!pSavedTiles)
+			return false;
+		const CTile *pSavedEnd = pSavedTiles + m_DataFile.GetDataSize(Index) / sizeof(CTile);
+
+		CTile *pTiles = static_cast<CTile *>(mem_alloc_tagged(TilemapSize, 1, MEMTAG_MAP));
+		if(!pTiles)
+			return false;
+
+		// extract original tile data
+		int i = 0;
+		while(i < TilemapCount && pSavedTiles < pSavedEnd)
+		{
+			for(unsigned Counter = 0; Counter <= pSavedTiles->m_Skip && i < TilemapCount; Counter++)
+			{
+				pTiles[i] = *pSavedTiles;
+				pTiles[i++].m_Skip = 0;
+			}
+
+			pSavedTiles++;
+		}
+		if(i < TilemapCount)
+			mem_zero(&pTiles[i], (TilemapCount - i) * sizeof(CTile));
+
+		m_DataFile.ReplaceData(Index, reinterpret_cast<char *>(pTiles), TilemapSize);
+		m_pTileData[Index].m_Expanded = true;
+		return true;
+	}
+
+	void *GetData(int Index, bool Swap)
+	{
+		void *pData = 0;
+		lock_wait(m_Lock);
+		// tile data is bytes only, it never needs to be swapped
+		if(!NeedsExpand(Index) || ExpandTiles(Index))
+			pData = Swap ? m_DataFile.GetDataSwapped(Index) : m_DataFile.GetData(Index);
+		lock_unlock(m_Lock);
+		return pData;
+	}
+
+	void UnloadData(int Index);
+
+	int MemoryUsage()
+	{
+		lock_wait(m_Lock);
+		int Size = m_DataFile.LoadedDataSize();
+		lock_unlock(m_Lock);
+		return Size;
+	}
+};
+
+// guards the list of the loaded map data and their refs. created on first use,
+// a static initializer could run after a map of another translation unit loads
+static LOCK MapDataLock()
+{
+	static LOCK s_Lock = lock_create();
+	return s_Lock;
+}
+
+static CMapData *gs_pFirstMapData = 0;
+
+// returns the already loaded data of the same map if there is one, pData is freed then
+static CMapData *AcquireMapData(CMapData *pData)
+{
+	lock_wait(MapDataLock());
+	for(CMapData *pShared = gs_pFirstMapData; pShared; pShared = pShared->m_pNext)
+	{
+		if(pShared->m_DataFile.Sha256() == pData->m_DataFile.Sha256() && pShared->m_DataFile.Crc() == pData->m_DataFile.Crc())
+		{
+			const int NumOthers = pShared->m_Refs++;
+			lock_unlock(MapDataLock());
+			dbg_msg("map", "sharing the map data with %d other users", NumOthers);
+			delete pData;
+			return pShared;
+		}
+	}
+	pData->m_Refs = 1;
+	pData->m_pNext = gs_pFirstMapData;
+	gs_pFirstMapData = pData;
+	lock_unlock(MapDataLock());
+	return pData;
+}
+
+static void ReleaseMapData(CMapData *pData)
+{
+	lock_wait(MapDataLock());
+	if(--pData->m_Refs > 0)
+	{
+		lock_unlock(MapDataLock());
+		return;
+	}
+	for(CMapData **ppData = &gs_pFirstMapData; *ppData; ppData = &(*ppData)->m_pNext)
+	{
+		if(*ppData == pData)
+		{
+			*ppData = pData->m_pNext;
+			break;
+		}
+	}
+	lock_unlock(MapDataLock());
+	delete pData;
+}
+
+void CMapData::UnloadData(int Index)
+{
+	// other servers might still use shared data, hold the refs until it is unloaded
+	lock_wait(MapDataLock());
+	lock_wait(m_Lock);
+	if(m_Refs == 1)
+	{
+		// the next access reads the compressed data again
+		if(Index >= 0 && Index < m_NumTileData)
+			m_pTileData[Index].m_Expanded = false;
+		m_DataFile.UnloadData(Index);
+	}
+	lock_unlock(m_Lock);
+	lock_unlock(MapDataLock());
+}
+
+class CMap : public IEngineMap
+{
+	CMapData *m_pData;
+
+public:
+	CMap() : m_pData(0) {}
+	~CMap() { Unload(); }
+
+	virtual void *GetData(int Index) { return m_pData ? m_pData->GetData(Index, false) : 0; }
+	virtual void *GetDataSwapped(int Index) { return m_pData ? m_pData->GetData(Index, true) : 0; }
+	virtual void UnloadData(int Index) { if(m_pData) m_pData->UnloadData(Index); }
+	virtual void *GetItem(int Index, int *pType, int *pID) { return m_pData ? m_pData->m_DataFile.GetItem(Index, pType, pID) : 0; }
+	virtual void GetType(int Type, int *pStart, int *pNum)
+	{
+		if(m_pData)
+			m_pData->m_DataFile.GetType(Type, pStart, pNum);
+		else
+			*pStart = *pNum = 0;
+	}
+	virtual void *FindItem(int Type, int ID) { return m_pData ? m_pData->m_DataFile.FindItem(Type, ID) : 0; }
+	virtual int NumItems() { return m_pData ? m_pData->m_DataFile.NumItems() : 0; }
+
+	virtual void Unload()
+	{
+		if(m_pData)
+			ReleaseMapData(m_pData);
+		m_pData = 0;
+	}
+
+	virtual bool Load(const char *pMapName, IStorage *pStorage)
+	{
+		if(!pStorage)
+			pStorage = Kernel()->RequestInterface<IStorage>();
+		if(!pStorage)
+			return false;
+
+		CMapData *pData = new CMapData;
+		if(!pData->m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL) || !pData->Init())
+		{
+			delete pData;
+			return false;
+		}
+
+		Unload();
+		m_pData = AcquireMapData(pData);
+		return true;
+	}
+
 	virtual bool IsLoaded()
 	{
-		return m_DataFile.IsOpen();
+		return m_pData != 0;
+	}
+
+	virtual int MemoryUsage() const
+	{
+		return m_pData ? m_pData->MemoryUsage() : 0;
 	}
 
 	virtual SHA256_DIGEST Sha256()
 	{
-		return m_DataFile.Sha256();
+		return m_pData->m_DataFile.Sha256();
 	}
 
 	virtual unsigned Crc()
 	{
-		return m_DataFile.Crc();
+		return m_pData->m_DataFile.Crc();
 	}
 };
 
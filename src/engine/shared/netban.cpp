@@ -7,6 +7,48 @@
 #include "netban.h"
 
 
+// binary banlist, all integers are little endian
+static const char s_aBanFileMagic[8] = {'T', 'W', 'B', 'A', 'N', 'L', 'S', 'T'};
+enum
+{
+	BANFILE_VERSION=1,
+
+	BANFILE_KIND_ADDR=0,
+	BANFILE_KIND_RANGE,
+};
+
+struct CBanFileHeader
+{
+	char m_aMagic[8];
+	unsigned char m_aVersion[4];
+	unsigned char m_aNumBans[4];
+};
+
+struct CBanFileRecord
+{
+	unsigned char m_Kind;
+	unsigned char m_NetType;
+	unsigned char m_aPadding[2];
+	unsigned char m_aExpires[4];
+	unsigned char m_aLB[16];
+	unsigned char m_aUB[16];
+	char m_aReason[64];
+};
+
+static void BanFilePackInt(unsigned char *pDst, int Value)
+{
+	pDst[0] = Value&0xff;
+	pDst[1] = (Value>>8)&0xff;
+	pDst[2] = (Value>>16)&0xff;
+	pDst[3] = (Value>>24)&0xff;
+}
+
+static int BanFileUnpackInt(const unsigned char *pSrc)
+{
+	return (int)(pSrc[0] | (pSrc[1]<<8) | (pSrc[2]<<16) | ((unsigned)pSrc[3]<<24));
+}
+
+
 CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
 {
 	if(pAddr->type==NETTYPE_IPV4)
@@ -44,6 +86,71 @@ int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
 }
 
 
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::HeapUp(int Index)
+{
+	CBan<T> *pBan = m_apExpiring[Index];
+	while(Index > 0)
+	{
+		int Parent = (Index-1)/2;
+		if(m_apExpiring[Parent]->m_Info.m_Expires <= pBan->m_Info.m_Expires)
+			break;
+		HeapSet(Index, m_apExpiring[Parent]);
+		Index = Parent;
+	}
+	HeapSet(Index, pBan);
+}
+
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::HeapDown(int Index)
+{
+	CBan<T> *pBan = m_apExpiring[Index];
+	while(true)
+	{
+		int Child = Index*2+1;
+		if(Child >= m_NumExpiring)
+			break;
+		if(Child+1 < m_NumExpiring && m_apExpiring[Child+1]->m_Info.m_Expires < m_apExpiring[Child]->m_Info.m_Expires)
+			++Child;
+		if(pBan->m_Info.m_Expires <= m_apExpiring[Child]->m_Info.m_Expires)
+			break;
+		HeapSet(Index, m_apExpiring[Child]);
+		Index = Child;
+	}
+	HeapSet(Index, pBan);
+}
+
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::HeapInsert(CBan<T> *pBan)
+{
+	if(pBan->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER)
+	{
+		pBan->m_HeapIndex = -1;
+		return;
+	}
+
+	HeapSet(m_NumExpiring++, pBan);
+	HeapUp(pBan->m_HeapIndex);
+}
+
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::HeapRemove(CBan<T> *pBan)
+{
+	int Index = pBan->m_HeapIndex;
+	if(Index < 0)
+		return;
+
+	pBan->m_HeapIndex = -1;
+	if(Index == --m_NumExpiring)
+		return;
+
+	// move the last entry into the gap, it can go either way from there
+	CBan<T> *pMoved = m_apExpiring[m_NumExpiring];
+	HeapSet(Index, pMoved);
+	HeapUp(Index);
+	HeapDown(pMoved->m_HeapIndex);
+}
+
 template<class T, int HashCount>
 typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo,  const CNetHash *pNetHash)
 {
@@ -69,39 +176,16 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	pBan->m_pHashNext = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
 	m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
 
-	// insert it into the used list
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
-	}
+	// append it to the used list
+	pBan->m_pNext = 0;
+	pBan->m_pPrev = m_pLastUsed;
+	if(m_pLastUsed)
+		m_pLastUsed->m_pNext = pBan;
 	else
-	{
 		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	m_pLastUsed = pBan;
+
+	HeapInsert(pBan);
 
 	// update ban count
 	++m_CountUsed;
@@ -127,11 +211,15 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	// remove from used list
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
+	else
+		m_pLastUsed = pBan->m_pPrev;
 	if(pBan->m_pPrev)
 		pBan->m_pPrev->m_pNext = pBan->m_pNext;
 	else
 		m_pFirstUsed = pBan->m_pNext;
 
+	HeapRemove(pBan);
+
 	// add to recycle list
 	if(m_pFirstFree)
 		m_pFirstFree->m_pPrev = pBan;
@@ -148,49 +236,9 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 template<class T, int HashCount>
 void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
+	HeapRemove(pBan);
 	pBan->m_Info = *pInfo;
-
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
-
-	// insert it into the used list
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
-	}
-	else
-	{
-		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	HeapInsert(pBan);
 }
 
 template<class T, int HashCount>
@@ -199,7 +247,9 @@ void CNetBan::CBanPool<T, HashCount>::Reset()
 	mem_zero(m_paaHashList, sizeof(m_paaHashList));
 	mem_zero(m_aBans, sizeof(m_aBans));
 	m_pFirstUsed = 0;
+	m_pLastUsed = 0;
 	m_CountUsed = 0;
+	m_NumExpiring = 0;
 
 	for(int i = 1; i < MAX_BANS-1; ++i)
 	{
@@ -357,6 +407,8 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("bans_save", "s[file]", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_save_binary", "s[file]", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansSaveBinary, this, "Save banlist in a binary file");
+	Console()->Register("bans_load", "s[file]", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansLoad, this, "Replace banlist with the one of a binary file");
 }
 
 void CNetBan::Update()
@@ -365,17 +417,17 @@ void CNetBan::Update()
 
 	// remove expired bans
 	char aBuf[256], aNetStr[256];
-	while(m_BanAddrPool.First() && m_BanAddrPool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanAddrPool.First()->m_Info.m_Expires < Now)
+	for(CBanAddr *pBan = m_BanAddrPool.FirstExpiring(); pBan && pBan->m_Info.m_Expires < Now; pBan = m_BanAddrPool.FirstExpiring())
 	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanAddrPool.First()->m_Data, aNetStr, sizeof(aNetStr)));
+		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&pBan->m_Data, aNetStr, sizeof(aNetStr)));
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanAddrPool.Remove(m_BanAddrPool.First());
+		m_BanAddrPool.Remove(pBan);
 	}
-	while(m_BanRangePool.First() && m_BanRangePool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanRangePool.First()->m_Info.m_Expires < Now)
+	for(CBanRange *pBan = m_BanRangePool.FirstExpiring(); pBan && pBan->m_Info.m_Expires < Now; pBan = m_BanRangePool.FirstExpiring())
 	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanRangePool.First()->m_Data, aNetStr, sizeof(aNetStr)));
+		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&pBan->m_Data, aNetStr, sizeof(aNetStr)));
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanRangePool.Remove(m_BanRangePool.First());
+		m_BanRangePool.Remove(pBan);
 	}
 }
 
@@ -616,6 +668,180 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
 
+bool CNetBan::SaveBans(const char *pFilename)
+{
+	char aTempFilename[IO_MAX_PATH_LENGTH];
+	str_format(aTempFilename, sizeof(aTempFilename), "%s.tmp", pFilename);
+	IOHANDLE File = Storage()->OpenFile(aTempFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	CBanFileHeader Header;
+	mem_copy(Header.m_aMagic, s_aBanFileMagic, sizeof(Header.m_aMagic));
+	BanFilePackInt(Header.m_aVersion, BANFILE_VERSION);
+	BanFilePackInt(Header.m_aNumBans, m_BanAddrPool.Num()+m_BanRangePool.Num());
+	bool Success = io_write(File, &Header, sizeof(Header)) == sizeof(Header);
+
+	CBanFileRecord Record;
+	for(CBanAddr *pBan = m_BanAddrPool.First(); pBan && Success; pBan = pBan->m_pNext)
+	{
+		mem_zero(&Record, sizeof(Record));
+		Record.m_Kind = BANFILE_KIND_ADDR;
+		Record.m_NetType = pBan->m_Data.type;
+		BanFilePackInt(Record.m_aExpires, pBan->m_Info.m_Expires);
+		mem_copy(Record.m_aLB, pBan->m_Data.ip, sizeof(Record.m_aLB));
+		str_copy(Record.m_aReason, pBan->m_Info.m_aReason, sizeof(Record.m_aReason));
+		Success = io_write(File, &Record, sizeof(Record)) == sizeof(Record);
+	}
+	for(CBanRange *pBan = m_BanRangePool.First(); pBan && Success; pBan = pBan->m_pNext)
+	{
+		mem_zero(&Record, sizeof(Record));
+		Record.m_Kind = BANFILE_KIND_RANGE;
+		Record.m_NetType = pBan->m_Data.m_LB.type;
+		BanFilePackInt(Record.m_aExpires, pBan->m_Info.m_Expires);
+		mem_copy(Record.m_aLB, pBan->m_Data.m_LB.ip, sizeof(Record.m_aLB));
+		mem_copy(Record.m_aUB, pBan->m_Data.m_UB.ip, sizeof(Record.m_aUB));
+		str_copy(Record.m_aReason, pBan->m_Info.m_aReason, sizeof(Record.m_aReason));
+		Success = io_write(File, &Record, sizeof(Record)) == sizeof(Record);
+	}
+	io_close(File);
+
+	if(!Success)
+	{
+		Storage()->RemoveFile(aTempFilename, IStorage::TYPE_SAVE);
+		return false;
+	}
+
+	// rename does not replace existing files everywhere
+	if(!Storage()->RenameFile(aTempFilename, pFilename, IStorage::TYPE_SAVE))
+	{
+		Storage()->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+		if(!Storage()->RenameFile(aTempFilename, pFilename, IStorage::TYPE_SAVE))
+		{
+			Storage()->RemoveFile(aTempFilename, IStorage::TYPE_SAVE);
+			return false;
+		}
+	}
+	return true;
+}
+
+int CNetBan::LoadBans(const char *pFilename)
+{
+	char aBuf[256];
+	IOHANDLE File = Storage()->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to open banlist '%s'", pFilename);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return -1;
+	}
+
+	void *pData;
+	unsigned Size;
+	io_read_all(File, &pData, &Size);
+	io_close(File);
+
+	// check the whole file before the current banlist is touched
+	const CBanFileHeader *pHeader = (const CBanFileHeader *)pData;
+	const CBanFileRecord *pRecords = (const CBanFileRecord *)(pHeader+1);
+	int NumRecords = -1;
+	if(Size >= sizeof(CBanFileHeader) && mem_comp(pHeader->m_aMagic, s_aBanFileMagic, sizeof(pHeader->m_aMagic)) == 0 &&
+		BanFileUnpackInt(pHeader->m_aVersion) == BANFILE_VERSION)
+	{
+		NumRecords = BanFileUnpackInt(pHeader->m_aNumBans);
+		if(NumRecords < 0 || Size != sizeof(CBanFileHeader)+NumRecords*sizeof(CBanFileRecord))
+			NumRecords = -1;
+	}
+	for(int i = 0; i < NumRecords; ++i)
+	{
+		const CBanFileRecord *pRecord = &pRecords[i];
+		if((pRecord->m_Kind != BANFILE_KIND_ADDR && pRecord->m_Kind != BANFILE_KIND_RANGE) ||
+			(pRecord->m_NetType != NETTYPE_IPV4 && pRecord->m_NetType != NETTYPE_IPV6))
+			NumRecords = -1;
+	}
+	if(NumRecords < 0)
+	{
+		mem_free(pData);
+		str_format(aBuf, sizeof(aBuf), "failed to load banlist '%s' (invalid file)", pFilename);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return -1;
+	}
+
+	m_BanAddrPool.Reset();
+	m_BanRangePool.Reset();
+
+	int Now = time_timestamp();
+	int NumLoaded = 0, NumSkipped = 0;
+	for(int i = 0; i < NumRecords; ++i)
+	{
+		const CBanFileRecord *pRecord = &pRecords[i];
+
+		CBanInfo Info = {0};
+		Info.m_Expires = BanFileUnpackInt(pRecord->m_aExpires);
+		Info.m_LastInfoQuery = Now;
+		str_copy(Info.m_aReason, pRecord->m_aReason, sizeof(Info.m_aReason));
+		if(Info.m_Expires != CBanInfo::EXPIRES_NEVER && Info.m_Expires < Now)
+			continue;
+
+		NETADDR Addr;
+		mem_zero(&Addr, sizeof(Addr));
+		Addr.type = pRecord->m_NetType;
+		mem_copy(Addr.ip, pRecord->m_aLB, sizeof(Addr.ip));
+
+		bool Added = false;
+		if(pRecord->m_Kind == BANFILE_KIND_ADDR)
+		{
+			CNetHash NetHash(&Addr);
+			if(IsBannable(&Addr) && !m_BanAddrPool.Find(&Addr, &NetHash))
+				Added = m_BanAddrPool.Add(&Addr, &Info, &NetHash) != 0;
+		}
+		else
+		{
+			CNetRange Range;
+			Range.m_LB = Addr;
+			Range.m_UB = Addr;
+			mem_copy(Range.m_UB.ip, pRecord->m_aUB, sizeof(Range.m_UB.ip));
+			if(Range.IsValid() && IsBannable(&Range))
+			{
+				CNetHash NetHash(&Range);
+				if(!m_BanRangePool.Find(&Range, &NetHash))
+					Added = m_BanRangePool.Add(&Range, &Info, &NetHash) != 0;
+			}
+		}
+
+		if(Added)
+			++NumLoaded;
+		else
+			++NumSkipped;
+	}
+	mem_free(pData);
+
+	str_format(aBuf, sizeof(aBuf), "loaded %d bans from '%s' (%d skipped)", NumLoaded, pFilename, NumSkipped);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+
+	OnBansLoaded();
+	return NumLoaded;
+}
+
+void CNetBan::ConBansSaveBinary(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+	char aBuf[256];
+	const char *pFilename = pResult->GetString(0);
+
+	if(pThis->SaveBans(pFilename))
+		str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pFilename);
+	else
+		str_format(aBuf, sizeof(aBuf), "failed to save banlist to '%s'", pFilename);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+}
+
+void CNetBan::ConBansLoad(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+	pThis->LoadBans(pResult->GetString(0));
+}
+
 // explicitly instantiate template for src/engine/server/server.cpp
 template void CNetBan::MakeBanInfo<CNetRange>(CBan<CNetRange> *pBan, char *pBuf, unsigned BufferSize, int Type, int *pLastInfoQuery);
 template void CNetBan::MakeBanInfo<NETADDR>(CBan<NETADDR> *pBan, char *pBuf, unsigned BufferSize, int Type, int *pLastInfoQuery);
@@ -623,3 +849,7 @@ template int CNetBan::Ban<CNetBan::CBanPool<NETADDR, 1> >(CNetBan::CBanPool<NETA
 template int CNetBan::Ban<CNetBan::CBanPool<CNetRange, 16> >(CNetBan::CBanPool<CNetRange, 16> *pBanPool, const CNetRange *pData, int Seconds, const char *pReason);
 template bool CNetBan::IsBannable<NETADDR>(const NETADDR *pData);
 template bool CNetBan::IsBannable<CNetRange>(const CNetRange *pData);
+
+// and the pools for the derived classes in src/test/netban.cpp
+template class CNetBan::CBanPool<NETADDR, 1>;
+template class CNetBan::CBanPool<CNetRange, 16>;
@@ -98,6 +98,9 @@ protected:
 		// used or free list
 		CBan *m_pNext;
 		CBan *m_pPrev;
+
+		// position in the expiry heap, -1 for bans that never expire
+		int m_HeapIndex;
 	};
 
 	template<class T, int HashCount> class CBanPool
@@ -114,6 +117,7 @@ protected:
 		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
+		CBan<CDataType> *FirstExpiring() const { return m_NumExpiring ? m_apExpiring[0] : 0; }
 		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
 		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
 		{
@@ -136,8 +140,19 @@ protected:
 		CBan<CDataType> *m_paaHashList[HashCount][256];
 		CBan<CDataType> m_aBans[MAX_BANS];
 		CBan<CDataType> *m_pFirstFree;
-		CBan<CDataType> *m_pFirstUsed;
+		CBan<CDataType> *m_pFirstUsed;	// in the order the bans were added
+		CBan<CDataType> *m_pLastUsed;
 		int m_CountUsed;
+
+		// min heap on the expiry time
+		CBan<CDataType> *m_apExpiring[MAX_BANS];
+		int m_NumExpiring;
+
+		void HeapInsert(CBan<CDataType> *pBan);
+		void HeapRemove(CBan<CDataType> *pBan);
+		void HeapSet(int Index, CBan<CDataType> *pBan) { m_apExpiring[Index] = pBan; pBan->m_HeapIndex = Index; }
+		void HeapUp(int Index);
+		void HeapDown(int Index);
 	};
 
 	typedef CBanPool<NETADDR, 1> CBanAddrPool;
@@ -155,6 +170,9 @@ protected:
 	CBanRangePool m_BanRangePool;
 	NETADDR m_LocalhostIPV4, m_LocalhostIPV6;
 
+	// called after LoadBans replaced the banlist
+	virtual void OnBansLoaded() {}
+
 public:
 	enum
 	{
@@ -180,11 +198,20 @@ public:
 	template<class T> bool IsBannable(const T *pData);
 	bool IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize, int *pLastInfoQuery);
 
+	// binary banlist. it is written to a temporary file that is renamed at the
+	// end, so other processes never read a half written list. loading keeps
+	// the current list if the file is broken, otherwise the list is replaced
+	// as a whole. returns the number of loaded bans or -1
+	bool SaveBans(const char *pFilename);
+	int LoadBans(const char *pFilename);
+
 	static void ConBan(class IConsole::IResult *pResult, void *pUser);
 	static void ConUnban(class IConsole::IResult *pResult, void *pUser);
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansSaveBinary(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansLoad(class IConsole::IResult *pResult, void *pUser);
 };
 
 #endif
@@ -3,6 +3,8 @@
 #ifndef ENGINE_SHARED_NETWORK_H
 #define ENGINE_SHARED_NETWORK_H
 
+#include <base/tl/threading.h>
+
 #include "ringbuffer.h"
 #include "huffman.h"
 
@@ -278,10 +280,10 @@ private:
 	class CConnlessPacketInfo
 	{
 	private:
-		static int m_UniqueID;
+		static volatile unsigned m_UniqueID; // shared by the servers of the process
 
 	public:
-		CConnlessPacketInfo() : m_TrackID(CConnlessPacketInfo::m_UniqueID++) {}
+		CConnlessPacketInfo() : m_TrackID(atomic_inc(&CConnlessPacketInfo::m_UniqueID)-1) {}
 
 		NETADDR m_Addr;
 		int m_DataSize;
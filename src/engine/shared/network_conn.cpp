@@ -41,7 +41,10 @@ void CNetConnection::SetToken(TOKEN Token)
 
 TOKEN CNetConnection::GenerateToken(const NETADDR *pPeerAddr)
 {
-	return random_int() & NET_TOKEN_MASK;
+	// keep the tokens unpredictable and out of the game's rand() sequence
+	TOKEN Token;
+	secure_random_fill(&Token, sizeof(Token));
+	return Token & NET_TOKEN_MASK;
 }
 
 const char *CNetConnection::ErrorString()
@@ -17,7 +17,7 @@ static unsigned int Hash(char *pData, int Size)
 	return (aDigest[0] ^ aDigest[1] ^ aDigest[2] ^ aDigest[3]);
 }
 
-int CNetTokenCache::CConnlessPacketInfo::m_UniqueID = 0;
+volatile unsigned CNetTokenCache::CConnlessPacketInfo::m_UniqueID = 0;
 
 void CNetTokenManager::Init(CNetBase *pNetBase, int SeedTime)
 {
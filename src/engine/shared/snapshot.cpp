@@ -1,9 +1,11 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/tl/base.h>
 #include <base/tl/algorithm.h>
 #include "snapshot.h"
 #include "compression.h"
+#include "protocol.h"
 
 // CSnapshot
 
@@ -293,6 +295,55 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, CSnapshot *pTo, void *pD
 	return (int)((char*)pData-(char*)pDstData);
 }
 
+static int PackedSize(const int *pData, int Num)
+{
+	unsigned char aBuf[16];
+	int Size = 0;
+	for(int i = 0; i < Num; i++)
+		Size += (int)(CVariableInt::Pack(aBuf, pData[i]) - aBuf);
+	return Size;
+}
+
+// adds the compressed size of every item in a delta created by CreateDelta to
+// pTypeBytes[Type] and returns the size of the remaining overhead
+int CSnapshotDelta::AccountDelta(const void *pSrcData, int DataSize, int *pTypeBytes, int NumTypes) const
+{
+	const CData *pDelta = (const CData *)pSrcData;
+	const int *pData = (const int *)pDelta->m_pData;
+	const int *pEnd = (const int *)(((const char *)pSrcData + DataSize));
+	int Overhead = PackedSize((const int *)pSrcData, 3);
+
+	for(int i = 0; i < pDelta->m_NumDeletedItems && pData < pEnd; i++, pData++)
+	{
+		int Type = (*pData>>16)&0xffff;
+		if(Type < NumTypes)
+			pTypeBytes[Type] += PackedSize(pData, 1);
+		else
+			Overhead += PackedSize(pData, 1);
+	}
+
+	for(int i = 0; i < pDelta->m_NumUpdateItems && pData+2 <= pEnd; i++)
+	{
+		const int *pItem = pData;
+		int Type = *pData++;
+		pData++;
+		int ItemSize;
+		if(Type >= 0 && Type < MAX_NETOBJSIZES && m_aItemSizes[Type])
+			ItemSize = m_aItemSizes[Type]/4;
+		else
+			ItemSize = *pData++;
+		pData = min(pData+ItemSize, pEnd);
+
+		int Size = PackedSize(pItem, (int)(pData-pItem));
+		if(Type >= 0 && Type < NumTypes)
+			pTypeBytes[Type] += Size;
+		else
+			Overhead += Size;
+	}
+
+	return Overhead;
+}
+
 static int RangeCheck(const void *pEnd, const void *pPtr, int Size)
 {
 	if((const char *)pPtr + Size > (const char *)pEnd)
@@ -464,7 +515,7 @@ void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, i
 	if(CreateAlt)
 		TotalSize += DataSize;
 
-	CHolder *pHolder = (CHolder *)mem_alloc(TotalSize, 1);
+	CHolder *pHolder = (CHolder *)mem_alloc_tagged(TotalSize, 1, MEMTAG_SNAPSHOT);
 
 	// set data
 	pHolder->m_Tick = Tick;
@@ -673,3 +724,103 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 
 	return pObj->Data();
 }
+
+// CSnapIDPool
+
+CSnapIDPool::CSnapIDPool()
+{
+	Reset();
+}
+
+void CSnapIDPool::Reset()
+{
+	for(int i = 0; i < MAX_IDS; i++)
+	{
+		m_aIDs[i].m_Next = i+1;
+		m_aIDs[i].m_State = 0;
+	}
+
+	m_aIDs[MAX_IDS-1].m_Next = -1;
+	m_FirstFree = 0;
+	m_FirstTimed = -1;
+	m_LastTimed = -1;
+	m_Usage = 0;
+	m_InUsage = 0;
+	m_LastTick = 0;
+}
+
+
+void CSnapIDPool::RemoveFirstTimeout()
+{
+	int NextTimed = m_aIDs[m_FirstTimed].m_Next;
+
+	// add it to the free list
+	m_aIDs[m_FirstTimed].m_Next = m_FirstFree;
+	m_aIDs[m_FirstTimed].m_State = 0;
+	m_FirstFree = m_FirstTimed;
+
+	// remove it from the timed list
+	m_FirstTimed = NextTimed;
+	if(m_FirstTimed == -1)
+		m_LastTimed = -1;
+
+	m_Usage--;
+}
+
+void CSnapIDPool::CheckTick(int Tick)
+{
+	// the tick was reset, the timeouts of the old ticks can't be compared anymore
+	if(Tick < m_LastTick)
+		TimeoutIDs();
+	m_LastTick = Tick;
+}
+
+int CSnapIDPool::NewID(int Tick)
+{
+	CheckTick(Tick);
+
+	// process timed ids
+	while(m_FirstTimed != -1 && m_aIDs[m_FirstTimed].m_Timeout < Tick)
+		RemoveFirstTimeout();
+
+	int ID = m_FirstFree;
+	dbg_assert(ID != -1, "id error");
+	if(ID == -1)
+		return ID;
+	m_FirstFree = m_aIDs[m_FirstFree].m_Next;
+	m_aIDs[ID].m_State = 1;
+	m_Usage++;
+	m_InUsage++;
+	return ID;
+}
+
+void CSnapIDPool::TimeoutIDs()
+{
+	// process timed ids
+	while(m_FirstTimed != -1)
+		RemoveFirstTimeout();
+}
+
+void CSnapIDPool::FreeID(int ID, int Tick)
+{
+	if(ID < 0)
+		return;
+	dbg_assert(m_aIDs[ID].m_State == 1, "id is not allocated");
+	CheckTick(Tick);
+
+	m_InUsage--;
+	m_aIDs[ID].m_State = 2;
+	m_aIDs[ID].m_Timeout = Tick+SERVER_TICK_SPEED*5;
+	m_aIDs[ID].m_Next = -1;
+
+	if(m_LastTimed != -1)
+	{
+		m_aIDs[m_LastTimed].m_Next = ID;
+		m_LastTimed = ID;
+	}
+	else
+	{
+		m_FirstTimed = ID;
+		m_LastTimed = ID;
+	}
+}
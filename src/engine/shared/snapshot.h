@@ -89,6 +89,7 @@ public:
 	void SetStaticsize(int ItemType, int Size);
 	CData *EmptyDelta();
 	int CreateDelta(const class CSnapshot *pFrom, class CSnapshot *pTo, void *pData);
+	int AccountDelta(const void *pData, int DataSize, int *pTypeBytes, int NumTypes) const;
 	int UnpackDelta(const class CSnapshot *pFrom, class CSnapshot *pTo, const void *pData, int DataSize);
 };
 
@@ -149,5 +150,45 @@ public:
 	int Finish(void *pSnapdata);
 };
 
+// ids of the snapshot items. a freed id is kept for some seconds before it is reused, so
+// the clients do not mistake a new item for the old one. the game tick restarts at 0 with
+// a new map, then the kept ids are released at once
+class CSnapIDPool
+{
+public:
+	enum
+	{
+		MAX_IDS = 16*1024,
+	};
+
+private:
+	class CID
+	{
+	public:
+		short m_Next;
+		short m_State; // 0 = free, 1 = allocated, 2 = timed
+		int m_Timeout; // tick after which the id can be reused
+	};
+
+	CID m_aIDs[MAX_IDS];
+
+	int m_FirstFree;
+	int m_FirstTimed;
+	int m_LastTimed;
+	int m_Usage;
+	int m_InUsage;
+	int m_LastTick;
+
+public:
+
+	CSnapIDPool();
+
+	void Reset();
+	void RemoveFirstTimeout();
+	void CheckTick(int Tick);
+	int NewID(int Tick);
+	void TimeoutIDs();
+	void FreeID(int ID, int Tick);
+};
 
 #endif // ENGINE_SNAPSHOT_H
@@ -71,7 +71,11 @@ public:
 					fs_makedir(GetPath(TYPE_SAVE, "maps", aPath, sizeof(aPath)));
 					fs_makedir(GetPath(TYPE_SAVE, "downloadedmaps", aPath, sizeof(aPath)));
 					fs_makedir(GetPath(TYPE_SAVE, "skins", aPath, sizeof(aPath)));
+					fs_makedir(GetPath(TYPE_SAVE, "cache", aPath, sizeof(aPath)));
+					fs_makedir(GetPath(TYPE_SAVE, "cache/skins", aPath, sizeof(aPath)));
 				}
+				else if(StorageType == STORAGETYPE_SERVER)
+					fs_makedir(GetPath(TYPE_SAVE, "replays", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "dumps", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "demos", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "demos/auto", aPath, sizeof(aPath)));
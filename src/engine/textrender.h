@@ -225,6 +225,9 @@ public:
 	virtual void Init() = 0;
 	virtual void Update() = 0;
 	virtual void Shutdown() = 0;
+
+	// layout cache hits and misses of the last frame
+	virtual void LayoutCacheStats(int *pHits, int *pMisses) const = 0;
 };
 
 extern IEngineTextRender *CreateEngineTextRender();
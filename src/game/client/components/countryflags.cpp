@@ -43,6 +43,7 @@ void CCountryFlags::LoadCountryflagsIndexfile()
 	}
 
 	// extract data
+	array<CFlagJob> lJobs;
 	const json_value &rInit = (*pJsonData)["country codes"];
 	if(rInit.type == json_object)
 	{
@@ -74,34 +75,23 @@ void CCountryFlags::LoadCountryflagsIndexfile()
 					CCountryFlag CountryFlag;
 					CountryFlag.m_CountryCode = CountryCode;
 					str_copy(CountryFlag.m_aCountryCodeString, pCountryName, sizeof(CountryFlag.m_aCountryCodeString));
-					if(Config()->m_ClLoadCountryFlags)
-					{
-						// load the graphic file
-						CImageInfo Info;
-						str_format(aBuf, sizeof(aBuf), "countryflags/%s.png", pCountryName);
-						if(!Graphics()->LoadPNG(&Info, aBuf, IStorage::TYPE_ALL))
-						{
-							char aMsg[64];
-							str_format(aMsg, sizeof(aMsg), "failed to load '%s'", aBuf);
-							Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aMsg);
-							continue;
-						}
-						CountryFlag.m_Texture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-						mem_free(Info.m_pData);
-					}
 					// blocked?
 					CountryFlag.m_Blocked = false;
 					const json_value Check = rStart[i]["blocked"];
 					if(Check.type == json_boolean && Check)
 						CountryFlag.m_Blocked = true;
-					m_aCountryFlags.add_unsorted(CountryFlag);
 
-					// print message
-					if(Config()->m_Debug)
+					// load the graphic file on the image loading threads
+					CFlagJob Job;
+					Job.m_Flag = CountryFlag;
+					Job.m_pImage = 0;
+					if(Config()->m_ClLoadCountryFlags)
 					{
-						str_format(aBuf, sizeof(aBuf), "loaded country flag '%s'", pCountryName);
-						Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aBuf);
+						Job.m_pImage = new CImageLoadJob;
+						str_format(aBuf, sizeof(aBuf), "countryflags/%s.png", pCountryName);
+						Graphics()->LoadPNGAsync(Job.m_pImage, aBuf, IStorage::TYPE_ALL);
 					}
+					lJobs.add(Job);
 				}
 			}
 		}
@@ -109,6 +99,46 @@ void CCountryFlags::LoadCountryflagsIndexfile()
 
 	// clean up
 	json_value_free(pJsonData);
+
+	// upload the flags
+	for(int i = 0; i < lJobs.size(); i++)
+	{
+		CFlagJob *pJob = &lJobs[i];
+		if(pJob->m_pImage)
+		{
+			while(!pJob->m_pImage->Done())
+			{
+				m_pClient->m_pMenus->RenderLoading(0);
+				thread_yield();
+			}
+
+			const CImageInfo &Info = pJob->m_pImage->m_Image;
+			bool Loaded = pJob->m_pImage->m_Loaded;
+			if(Loaded)
+			{
+				pJob->m_Flag.m_Texture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
+				mem_free(Info.m_pData);
+			}
+			else
+			{
+				char aMsg[64];
+				str_format(aMsg, sizeof(aMsg), "failed to load '%s'", pJob->m_pImage->m_aFilename);
+				Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aMsg);
+			}
+			delete pJob->m_pImage;
+			if(!Loaded)
+				continue;
+		}
+		m_aCountryFlags.add_unsorted(pJob->m_Flag);
+
+		// print message
+		if(Config()->m_Debug)
+		{
+			char aBuf[64];
+			str_format(aBuf, sizeof(aBuf), "loaded country flag '%s'", pJob->m_Flag.m_aCountryCodeString);
+			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aBuf);
+		}
+	}
 	m_aCountryFlags.sort_range();
 
 	// find index of default item
@@ -3,6 +3,7 @@
 #ifndef GAME_CLIENT_COMPONENTS_COUNTRYFLAGS_H
 #define GAME_CLIENT_COMPONENTS_COUNTRYFLAGS_H
 #include <base/vmath.h>
+#include <base/tl/array.h>
 #include <base/tl/sorted_array.h>
 #include <game/client/component.h>
 
@@ -34,6 +35,12 @@ private:
 		CODE_UB=999,
 		CODE_RANGE=CODE_UB-CODE_LB+1,
 	};
+	struct CFlagJob
+	{
+		CCountryFlag m_Flag;
+		CImageLoadJob *m_pImage;
+	};
+
 	sorted_array<CCountryFlag> m_aCountryFlags;
 	int m_CodeIndexLUT[CODE_RANGE];
 
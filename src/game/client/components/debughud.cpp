@@ -31,7 +31,7 @@ void CDebugHud::RenderNetCorrections()
 	float Velspeed = length(vec2(m_pClient->m_Snap.m_pLocalCharacter->m_VelX/256.0f, m_pClient->m_Snap.m_pLocalCharacter->m_VelY/256.0f))*50;
 	float Ramp = VelocityRamp(Velspeed, m_pClient->m_Tuning.m_VelrampStart, m_pClient->m_Tuning.m_VelrampRange, m_pClient->m_Tuning.m_VelrampCurvature);
 
-	const char *paStrings[] = {"velspeed:", "velspeed*ramp:", "ramp:", "Pos", " x:", " y:", "netmsg failed on:", "netobj num failures:", "netobj failed on:"};
+	const char *paStrings[] = {"velspeed:", "velspeed*ramp:", "ramp:", "Pos", " x:", " y:", "netmsg failed on:", "netobj num failures:", "netobj failed on:", "predicted ticks/s:"};
 	const int Num = sizeof(paStrings)/sizeof(char *);
 
 	static CTextCursor s_CursorLabels(5.0f);
@@ -84,6 +84,10 @@ void CDebugHud::RenderNetCorrections()
 	TextRender()->TextNewline(&s_CursorValues);
 
 	TextRender()->TextDeferred(&s_CursorValues, m_pClient->NetobjFailedOn(), -1);
+	TextRender()->TextNewline(&s_CursorValues);
+
+	str_format(aBuf, sizeof(aBuf), "%d", m_pClient->PredictedTicksPerSecond());
+	TextRender()->TextDeferred(&s_CursorValues, aBuf, -1);
 
 	TextRender()->DrawTextOutlined(&s_CursorLabels);
 	TextRender()->DrawTextOutlined(&s_CursorValues);
@@ -2,11 +2,13 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <engine/graphics.h>
 #include <engine/map.h>
+#include <engine/shared/config.h>
 #include <engine/storage.h>
 #include <game/client/component.h>
 #include <game/mapitems.h>
 
 #include "mapimages.h"
+#include "menus.h"
 
 CMapImages::CMapImages()
 {
@@ -30,6 +32,11 @@ void CMapImages::LoadMapImages(IMap *pMap, class CLayers *pLayers, int MapType)
 	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &m_Info[MapType].m_Count);
 	m_Info[MapType].m_Count = clamp(m_Info[MapType].m_Count, 0, int(MAX_TEXTURES));
 
+	// external images are decoded on the image loading threads while the embedded ones are uploaded
+	CImageLoadJob *pJobs = new CImageLoadJob[m_Info[MapType].m_Count];
+	int aTextureFlags[MAX_TEXTURES];
+	bool aExternal[MAX_TEXTURES];
+
 	// load new textures
 	for(int i = 0; i < m_Info[MapType].m_Count; i++)
 	{
@@ -46,14 +53,16 @@ void CMapImages::LoadMapImages(IMap *pMap, class CLayers *pLayers, int MapType)
 		}
 		if(FoundTileLayer)
 			TextureFlags = FoundQuadLayer ? IGraphics::TEXLOAD_MULTI_DIMENSION : IGraphics::TEXLOAD_ARRAY_256;
+		aTextureFlags[i] = TextureFlags;
 
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
-		if(pImg->m_External || (pImg->m_Version > 1 && pImg->m_Format != CImageInfo::FORMAT_RGB && pImg->m_Format != CImageInfo::FORMAT_RGBA))
+		aExternal[i] = pImg->m_External || (pImg->m_Version > 1 && pImg->m_Format != CImageInfo::FORMAT_RGB && pImg->m_Format != CImageInfo::FORMAT_RGBA);
+		if(aExternal[i])
 		{
 			char Buf[IO_MAX_PATH_LENGTH];
 			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
 			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_Info[MapType].m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, TextureFlags);
+			Graphics()->LoadPNGAsync(&pJobs[i], Buf, IStorage::TYPE_ALL);
 		}
 		else
 		{
@@ -63,6 +72,28 @@ void CMapImages::LoadMapImages(IMap *pMap, class CLayers *pLayers, int MapType)
 		}
 	}
 
+	for(int i = 0; i < m_Info[MapType].m_Count; i++)
+	{
+		if(!aExternal[i])
+			continue;
+
+		while(!pJobs[i].Done())
+		{
+			m_pClient->m_pMenus->RenderLoading(0);
+			thread_yield();
+		}
+
+		const CImageInfo &Info = pJobs[i].m_Image;
+		if(pJobs[i].m_Loaded)
+		{
+			m_Info[MapType].m_aTextures[i] = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, aTextureFlags[i]);
+			mem_free(Info.m_pData);
+		}
+		else // fails again and hands out the invalid texture
+			m_Info[MapType].m_aTextures[i] = Graphics()->LoadTexture(pJobs[i].m_aFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, aTextureFlags[i]);
+	}
+	delete[] pJobs;
+
 	// easter time, preload easter tileset
 	if(m_pClient->IsEaster())
 		GetEasterTexture();
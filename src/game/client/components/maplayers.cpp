@@ -25,6 +25,10 @@ CMapLayers::CMapLayers(int Type)
 	m_pMenuMap = 0;
 	m_pMenuLayers = 0;
 	m_OnlineStartTime = 0;
+	m_pTileBuffers = 0;
+	m_NumTileBuffers = 0;
+	m_pMenuTileBuffers = 0;
+	m_NumMenuTileBuffers = 0;
 }
 
 void CMapLayers::OnStateChange(int NewState, int OldState)
@@ -84,6 +88,7 @@ void CMapLayers::LoadBackgroundMap()
 	m_pMenuLayers->Init(Kernel(), m_pMenuMap);
 	m_pClient->m_pMapimages->OnMenuMapLoad(m_pMenuMap);
 	LoadEnvPoints(m_pMenuLayers, m_lEnvPointsMenu);
+	BuildTileBuffers(m_pMenuLayers, &m_pMenuTileBuffers, &m_NumMenuTileBuffers, true);
 }
 
 int CMapLayers::GetInitAmount() const
@@ -115,6 +120,7 @@ void CMapLayers::OnMapLoad()
 	if(Layers())
 	{
 		LoadEnvPoints(Layers(), m_lEnvPoints);
+		BuildTileBuffers(Layers(), &m_pTileBuffers, &m_NumTileBuffers, false);
 
 		// easter time, place eggs
 		if(m_pClient->IsEaster())
@@ -122,8 +128,60 @@ void CMapLayers::OnMapLoad()
 	}
 }
 
+void CMapLayers::BuildTileBuffers(CLayers *pLayers, CTileBuffer **ppBuffers, int *pNumBuffers, bool AllLayers)
+{
+	UnloadTileBuffers(ppBuffers, pNumBuffers);
+	if(!Graphics()->QuadBuffersSupported())
+		return;
+
+	*ppBuffers = new CTileBuffer[pLayers->NumLayers()];
+	*pNumBuffers = pLayers->NumLayers();
+
+	// only build the layers that are rendered by this component, the game layer is never drawn
+	bool PassedGameLayer = false;
+	for(int g = 0; g < pLayers->NumGroups(); g++)
+	{
+		CMapItemGroup *pGroup = pLayers->GetGroup(g);
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			CMapItemLayer *pLayer = pLayers->GetLayer(pGroup->m_StartLayer+l);
+			if(pLayer == (CMapItemLayer*)pLayers->GameLayer())
+			{
+				PassedGameLayer = true;
+				continue;
+			}
+			if(pLayer->m_Type != LAYERTYPE_TILES || (!AllLayers && PassedGameLayer != (m_Type == TYPE_FOREGROUND)))
+				continue;
+
+			CMapItemLayerTilemap *pTMap = (CMapItemLayerTilemap *)pLayer;
+			CTile *pTiles = (CTile *)pLayers->Map()->GetData(pTMap->m_Data);
+			RenderTools()->BuildTileBuffer(&(*ppBuffers)[pGroup->m_StartLayer+l], pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f);
+		}
+	}
+}
+
+void CMapLayers::UnloadTileBuffers(CTileBuffer **ppBuffers, int *pNumBuffers)
+{
+	for(int i = 0; i < *pNumBuffers; i++)
+		RenderTools()->UnloadTileBuffer(&(*ppBuffers)[i]);
+	delete[] *ppBuffers;
+	*ppBuffers = 0;
+	*pNumBuffers = 0;
+}
+
+const CTileBuffer *CMapLayers::GetTileBuffer(const CLayers *pLayers, int Layer) const
+{
+	static const CTileBuffer s_EmptyBuffer;
+	if(pLayers == m_pMenuLayers)
+		return Layer < m_NumMenuTileBuffers ? &m_pMenuTileBuffers[Layer] : &s_EmptyBuffer;
+	return Layer < m_NumTileBuffers ? &m_pTileBuffers[Layer] : &s_EmptyBuffer;
+}
+
 void CMapLayers::OnShutdown()
 {
+	UnloadTileBuffers(&m_pTileBuffers, &m_NumTileBuffers);
+	UnloadTileBuffers(&m_pMenuTileBuffers, &m_NumMenuTileBuffers);
+
 	if(m_pEggTiles)
 	{
 		mem_free(m_pEggTiles);
@@ -351,12 +409,13 @@ void CMapLayers::OnRender()
 							Graphics()->TextureSet(m_pClient->m_pMapimages->Get(pTMap->m_Image));
 
 						CTile *pTiles = (CTile *)pLayers->Map()->GetData(pTMap->m_Data);
+						const CTileBuffer *pTileBuffer = GetTileBuffer(pLayers, pGroup->m_StartLayer+l);
 						Graphics()->BlendNone();
 						vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f);
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+						RenderTools()->RenderTileBuffer(pTileBuffer, pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
 														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 						Graphics()->BlendNormal();
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+						RenderTools()->RenderTileBuffer(pTileBuffer, pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
 														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 					}
 					else if(pLayer->m_Type == LAYERTYPE_QUADS)
@@ -418,6 +477,7 @@ void CMapLayers::BackgroundMapUpdate()
 	if(m_Type == TYPE_BACKGROUND && m_pMenuMap)
 	{
 		// unload map
+		UnloadTileBuffers(&m_pMenuTileBuffers, &m_NumMenuTileBuffers);
 		m_pMenuMap->Unload();
 		if(Config()->m_ClShowMenuMap)
 			LoadBackgroundMap();
@@ -4,6 +4,7 @@
 #define GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #include <base/tl/array.h>
 #include <game/client/component.h>
+#include <game/client/render.h>
 
 class CMapLayers : public CComponent
 {
@@ -20,6 +21,12 @@ class CMapLayers : public CComponent
 	int m_EggLayerWidth;
 	int m_EggLayerHeight;
 
+	// static buffers of the tile layers this component renders, indexed by layer
+	CTileBuffer *m_pTileBuffers;
+	int m_NumTileBuffers;
+	CTileBuffer *m_pMenuTileBuffers;
+	int m_NumMenuTileBuffers;
+
 	static void EnvelopeEval(float TimeOffset, int Env, float *pChannels, void *pUser);
 
 	void LoadEnvPoints(const CLayers *pLayers, array<CEnvPoint>& lEnvPoints);
@@ -27,6 +34,10 @@ class CMapLayers : public CComponent
 
 	void PlaceEasterEggs(const CLayers *pLayers);
 
+	void BuildTileBuffers(CLayers *pLayers, CTileBuffer **ppBuffers, int *pNumBuffers, bool AllLayers);
+	void UnloadTileBuffers(CTileBuffer **ppBuffers, int *pNumBuffers);
+	const CTileBuffer *GetTileBuffer(const CLayers *pLayers, int Layer) const;
+
 public:
 	enum
 	{
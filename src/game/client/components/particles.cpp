@@ -3,63 +3,229 @@
 #include <base/math.h>
 #include <engine/graphics.h>
 #include <engine/demo.h>
+#include <engine/shared/config.h>
 
 #include <generated/client_data.h>
+#include <game/collision.h>
 #include <game/client/render.h>
 
 #include "particles.h"
 
 CParticles::CParticles()
 {
+	mem_zero(m_aGroups, sizeof(m_aGroups));
+	m_pNewPosX = 0;
+	m_pNewPosY = 0;
+	m_pHits = 0;
+	m_ScratchCapacity = 0;
+
 	OnReset();
 	m_RenderTrail.m_pParts = this;
 	m_RenderExplosions.m_pParts = this;
 	m_RenderGeneral.m_pParts = this;
 }
 
+CParticles::~CParticles()
+{
+	for(int i = 0; i < NUM_GROUPS; i++)
+		FreeGroup(&m_aGroups[i]);
+
+	if(m_ScratchCapacity)
+	{
+		mem_free(m_pNewPosX);
+		mem_free(m_pNewPosY);
+		mem_free(m_pHits);
+	}
+}
 
 void CParticles::OnReset()
 {
-	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
+	// reset particles, the memory is kept for the next round
+	for(int i = 0; i < NUM_GROUPS; i++)
+		m_aGroups[i].m_Num = 0;
+}
+
+int CParticles::NumParticles() const
+{
+	int Num = 0;
+	for(int i = 0; i < NUM_GROUPS; i++)
+		Num += m_aGroups[i].m_Num;
+	return Num;
+}
+
+void CParticles::FreeGroup(CGroup *pGroup)
+{
+	if(pGroup->m_pMemory)
+		mem_free(pGroup->m_pMemory);
+	mem_zero(pGroup, sizeof(*pGroup));
+}
+
+void CParticles::Grow(CGroup *pGroup)
+{
+	const int Capacity = max((int)MIN_CAPACITY, pGroup->m_Capacity*2);
+
+	// one block for all attributes, the colors go first to keep them aligned
+	const int NumFloats = 12;
+	unsigned char *pMemory = (unsigned char *)mem_alloc(Capacity*(sizeof(vec4) + NumFloats*sizeof(float) + sizeof(int)), 16);
+	CGroup New;
+	New.m_Num = pGroup->m_Num;
+	New.m_Capacity = Capacity;
+	New.m_pMemory = pMemory;
+	New.m_pColor = (vec4 *)pMemory;
+	float *pFloats = (float *)(pMemory + Capacity*sizeof(vec4));
+	float **appFloats[NumFloats] = { &New.m_pPosX, &New.m_pPosY, &New.m_pVelX, &New.m_pVelY, &New.m_pLife, &New.m_pLifeSpan,
+		&New.m_pStartSize, &New.m_pEndSize, &New.m_pRot, &New.m_pRotspeed, &New.m_pGravity, &New.m_pFriction };
+	for(int i = 0; i < NumFloats; i++)
+		*appFloats[i] = pFloats + i*Capacity;
+	New.m_pSpr = (int *)(pFloats + NumFloats*Capacity);
+
+	if(pGroup->m_Num)
 	{
-		m_aParticles[i].m_PrevPart = i-1;
-		m_aParticles[i].m_NextPart = i+1;
+		const int Num = pGroup->m_Num;
+		mem_copy(New.m_pColor, pGroup->m_pColor, Num*sizeof(vec4));
+		float *apOldFloats[NumFloats] = { pGroup->m_pPosX, pGroup->m_pPosY, pGroup->m_pVelX, pGroup->m_pVelY, pGroup->m_pLife, pGroup->m_pLifeSpan,
+			pGroup->m_pStartSize, pGroup->m_pEndSize, pGroup->m_pRot, pGroup->m_pRotspeed, pGroup->m_pGravity, pGroup->m_pFriction };
+		for(int i = 0; i < NumFloats; i++)
+			mem_copy(*appFloats[i], apOldFloats[i], Num*sizeof(float));
+		mem_copy(New.m_pSpr, pGroup->m_pSpr, Num*sizeof(int));
 	}
 
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES-1].m_NextPart = -1;
-	m_FirstFree = 0;
+	FreeGroup(pGroup);
+	*pGroup = New;
 
-	for(int i = 0; i < NUM_GROUPS; i++)
-		m_aFirstPart[i] = -1;
+	// the collision pass works on one group at a time
+	if(Capacity > m_ScratchCapacity)
+	{
+		if(m_ScratchCapacity)
+		{
+			mem_free(m_pNewPosX);
+			mem_free(m_pNewPosY);
+			mem_free(m_pHits);
+		}
+		m_pNewPosX = (float *)mem_alloc(Capacity*sizeof(float), 16);
+		m_pNewPosY = (float *)mem_alloc(Capacity*sizeof(float), 16);
+		m_pHits = (int *)mem_alloc(Capacity*sizeof(int), 16);
+		m_ScratchCapacity = Capacity;
+	}
 }
 
 void CParticles::Add(int Group, CParticle *pPart)
 {
 	if(m_pClient->IsWorldPaused() || m_pClient->IsDemoPlaybackPaused())
 		return;
-	if (m_FirstFree == -1)
+	if(NumParticles() >= Config()->m_ClParticlesMax)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
+	CGroup *pGroup = &m_aGroups[Group];
+	if(pGroup->m_Num == pGroup->m_Capacity)
+		Grow(pGroup);
 
 	// copy data
-	m_aParticles[Id] = *pPart;
+	int i = pGroup->m_Num++;
+	pGroup->m_pPosX[i] = pPart->m_Pos.x;
+	pGroup->m_pPosY[i] = pPart->m_Pos.y;
+	pGroup->m_pVelX[i] = pPart->m_Vel.x;
+	pGroup->m_pVelY[i] = pPart->m_Vel.y;
+	pGroup->m_pLife[i] = 0;
+	pGroup->m_pLifeSpan[i] = pPart->m_LifeSpan;
+	pGroup->m_pStartSize[i] = pPart->m_StartSize;
+	pGroup->m_pEndSize[i] = pPart->m_EndSize;
+	pGroup->m_pRot[i] = pPart->m_Rot;
+	pGroup->m_pRotspeed[i] = pPart->m_Rotspeed;
+	pGroup->m_pGravity[i] = pPart->m_Gravity;
+	pGroup->m_pFriction[i] = pPart->m_Friction;
+	pGroup->m_pSpr[i] = pPart->m_Spr;
+	pGroup->m_pColor[i] = pPart->m_Color;
+}
 
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
+void CParticles::UpdateGroup(CGroup *pGroup, float TimePassed, int FrictionCount)
+{
+	const int Num = pGroup->m_Num;
+	float *pPosX = pGroup->m_pPosX;
+	float *pPosY = pGroup->m_pPosY;
+	float *pVelX = pGroup->m_pVelX;
+	float *pVelY = pGroup->m_pVelY;
+	float *pLife = pGroup->m_pLife;
+	float *pRot = pGroup->m_pRot;
+	const float *pRotspeed = pGroup->m_pRotspeed;
+	const float *pGravity = pGroup->m_pGravity;
+	const float *pFriction = pGroup->m_pFriction;
+	float *pNewPosX = m_pNewPosX;
+	float *pNewPosY = m_pNewPosY;
+	int *pHits = m_pHits;
+
+	// integrate, these are plain loops over the attribute arrays so they get vectorized
+	for(int i = 0; i < Num; i++)
+		pVelY[i] += pGravity[i]*TimePassed;
+
+	for(int f = 0; f < FrictionCount; f++) // apply friction
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			pVelX[i] *= pFriction[i];
+			pVelY[i] *= pFriction[i];
+		}
+	}
+
+	for(int i = 0; i < Num; i++)
+	{
+		pNewPosX[i] = pPosX[i] + pVelX[i]*TimePassed;
+		pNewPosY[i] = pPosY[i] + pVelY[i]*TimePassed;
+		pLife[i] += TimePassed;
+		pRot[i] += TimePassed*pRotspeed[i];
+	}
+
+	// look up all new positions first, only the particles that hit something take the bounce path
+	const CCollision *pCollision = Collision();
+	for(int i = 0; i < Num; i++)
+		pHits[i] = pCollision->CheckPoint(pNewPosX[i], pNewPosY[i]);
 
-	// set some parameters
-	m_aParticles[Id].m_Life = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		if(!pHits[i])
+		{
+			pPosX[i] = pNewPosX[i];
+			pPosY[i] = pNewPosY[i];
+			continue;
+		}
+
+		vec2 Pos = vec2(pPosX[i], pPosY[i]);
+		vec2 Vel = vec2(pVelX[i], pVelY[i])*TimePassed;
+		pCollision->MovePoint(&Pos, &Vel, 0.1f+0.9f*random_float(), NULL);
+		pPosX[i] = Pos.x;
+		pPosY[i] = Pos.y;
+		pVelX[i] = Vel.x*(1.0f/TimePassed);
+		pVelY[i] = Vel.y*(1.0f/TimePassed);
+	}
+
+	// remove dead particles, keeping the order of the others
+	const float *pLifeSpan = pGroup->m_pLifeSpan;
+	int NumAlive = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		if(pLife[i] > pLifeSpan[i])
+			continue;
+
+		if(NumAlive != i)
+		{
+			pPosX[NumAlive] = pPosX[i];
+			pPosY[NumAlive] = pPosY[i];
+			pVelX[NumAlive] = pVelX[i];
+			pVelY[NumAlive] = pVelY[i];
+			pLife[NumAlive] = pLife[i];
+			pGroup->m_pLifeSpan[NumAlive] = pLifeSpan[i];
+			pGroup->m_pStartSize[NumAlive] = pGroup->m_pStartSize[i];
+			pGroup->m_pEndSize[NumAlive] = pGroup->m_pEndSize[i];
+			pRot[NumAlive] = pRot[i];
+			pGroup->m_pRotspeed[NumAlive] = pRotspeed[i];
+			pGroup->m_pGravity[NumAlive] = pGravity[i];
+			pGroup->m_pFriction[NumAlive] = pFriction[i];
+			pGroup->m_pSpr[NumAlive] = pGroup->m_pSpr[i];
+			pGroup->m_pColor[NumAlive] = pGroup->m_pColor[i];
+		}
+		NumAlive++;
+	}
+	pGroup->m_Num = NumAlive;
 }
 
 void CParticles::Update(float TimePassed)
@@ -82,46 +248,8 @@ void CParticles::Update(float TimePassed)
 
 	for(int g = 0; g < NUM_GROUPS; g++)
 	{
-		int i = m_aFirstPart[g];
-		while(i != -1)
-		{
-			int Next = m_aParticles[i].m_NextPart;
-			//m_aParticles[i].vel += flow_get(m_aParticles[i].pos)*time_passed * m_aParticles[i].flow_affected;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity*TimePassed;
-
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
-
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel*TimePassed;
-			Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, 0.1f+0.9f*random_float(), NULL);
-			m_aParticles[i].m_Vel = Vel* (1.0f/TimePassed);
-
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
-
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					m_aFirstPart[g] = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
-
-			i = Next;
-		}
+		if(m_aGroups[g].m_Num)
+			UpdateGroup(&m_aGroups[g], TimePassed, FrictionCount);
 	}
 }
 
@@ -143,26 +271,21 @@ void CParticles::RenderGroup(int Group)
 	Graphics()->TextureSet(g_pData->m_aImages[IMAGE_PARTICLES].m_Id);
 	Graphics()->QuadsBegin();
 
-	int i = m_aFirstPart[Group];
-	while(i != -1)
+	// newest first, like the particles were always drawn
+	const CGroup *pGroup = &m_aGroups[Group];
+	for(int i = pGroup->m_Num-1; i >= 0; i--)
 	{
-		RenderTools()->SelectSprite(m_aParticles[i].m_Spr);
-		float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-		vec2 p = m_aParticles[i].m_Pos;
-		float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
+		RenderTools()->SelectSprite(pGroup->m_pSpr[i]);
+		float a = pGroup->m_pLife[i] / pGroup->m_pLifeSpan[i];
+		float Size = mix(pGroup->m_pStartSize[i], pGroup->m_pEndSize[i], a);
 
-		Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
+		Graphics()->QuadsSetRotation(pGroup->m_pRot[i]);
 
-		Graphics()->SetColor(
-			m_aParticles[i].m_Color.r,
-			m_aParticles[i].m_Color.g,
-			m_aParticles[i].m_Color.b,
-			m_aParticles[i].m_Color.a); // pow(a, 0.75f) *
+		const vec4 &Color = pGroup->m_pColor[i];
+		Graphics()->SetColor(Color.r, Color.g, Color.b, Color.a); // pow(a, 0.75f) *
 
-		IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
+		IGraphics::CQuadItem QuadItem(pGroup->m_pPosX[i], pGroup->m_pPosY[i], Size, Size);
 		Graphics()->QuadsDraw(&QuadItem, 1);
-
-		i = m_aParticles[i].m_NextPart;
 	}
 	Graphics()->QuadsEnd();
 	Graphics()->BlendNormal();
@@ -41,11 +41,6 @@ struct CParticle
 	float m_Friction;
 
 	vec4 m_Color;
-
-	// set by the particle system
-	float m_Life;
-	int m_PrevPart;
-	int m_NextPart;
 };
 
 class CParticles : public CComponent
@@ -61,6 +56,7 @@ public:
 	};
 
 	CParticles();
+	~CParticles();
 
 	void Add(int Group, CParticle *pPart);
 
@@ -71,12 +67,45 @@ private:
 
 	enum
 	{
-		MAX_PARTICLES=1024*8,
+		MIN_CAPACITY=256,
+	};
+
+	// the particles of a group stored as one array per attribute, the live
+	// particles are always [0, m_Num) in the order they were added
+	struct CGroup
+	{
+		int m_Num;
+		int m_Capacity;
+		void *m_pMemory;
+
+		float *m_pPosX;
+		float *m_pPosY;
+		float *m_pVelX;
+		float *m_pVelY;
+		float *m_pLife;
+		float *m_pLifeSpan;
+		float *m_pStartSize;
+		float *m_pEndSize;
+		float *m_pRot;
+		float *m_pRotspeed;
+		float *m_pGravity;
+		float *m_pFriction;
+		int *m_pSpr;
+		vec4 *m_pColor;
 	};
 
-	CParticle m_aParticles[MAX_PARTICLES];
-	int m_FirstFree;
-	int m_aFirstPart[NUM_GROUPS];
+	CGroup m_aGroups[NUM_GROUPS];
+
+	// scratch space for the collision pass
+	float *m_pNewPosX;
+	float *m_pNewPosY;
+	int *m_pHits;
+	int m_ScratchCapacity;
+
+	int NumParticles() const;
+	void Grow(CGroup *pGroup);
+	void FreeGroup(CGroup *pGroup);
+	void UpdateGroup(CGroup *pGroup, float TimePassed, int FrictionCount);
 
 	void RenderGroup(int Group);
 	void Update(float TimePassed);
@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <base/color.h>
+#include <base/hash.h>
 #include <base/system.h>
 #include <base/math.h>
 
@@ -25,31 +26,170 @@ int *CSkins::ms_apColorVariables[NUM_SKINPARTS] = {0};
 
 const float MIN_EYE_BODY_COLOR_DIST = 80.f; // between body and eyes (LAB color space)
 
+static const char gs_aSkinCacheMarker[8] = {'T', 'W', 'S', 'K', 'C', 'A', 'C', 'H'};
+enum
+{
+	SKINCACHE_VERSION=1,
+	SKINCACHE_TMP_LIFETIME=60*60, // unfinished writes of other clients are kept this long
+};
+
 int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
 {
 	CSkins *pSelf = (CSkins *)pUser;
 	if(IsDir || !str_endswith(pName, ".png"))
 		return 0;
 
+	// only queue the file here, it is decoded on the image loading threads
+	CSkinPartJob *pJob = new CSkinPartJob;
+	pJob->m_Part = pSelf->m_ScanningPart;
+	pJob->m_DirType = DirType;
+	str_copy(pJob->m_aName, pName, sizeof(pJob->m_aName));
+	pJob->m_pStorage = pSelf->Storage();
+	pJob->m_aCacheFilename[0] = 0;
+	pJob->m_FromCache = false;
+	pJob->m_pColorData = 0;
+	pJob->m_BloodColor = vec3(1.0f, 1.0f, 1.0f);
+	pJob->m_Image.m_pfnPrepare = pSelf->Config()->m_ClSkinCache ? LoadCachedSkinPart : 0;
+	pJob->m_Image.m_pfnProcess = ProcessSkinPart;
+	pJob->m_Image.m_pUser = pJob;
+
 	char aBuf[IO_MAX_PATH_LENGTH];
-	str_format(aBuf, sizeof(aBuf), "skins/%s/%s", CSkins::ms_apSkinPartNames[pSelf->m_ScanningPart], pName);
-	CImageInfo Info;
-	if(!pSelf->Graphics()->LoadPNG(&Info, aBuf, DirType))
+	str_format(aBuf, sizeof(aBuf), "skins/%s/%s", CSkins::ms_apSkinPartNames[pJob->m_Part], pName);
+	pSelf->Graphics()->LoadPNGAsync(&pJob->m_Image, aBuf, DirType);
+	pSelf->m_lpSkinPartJobs.add(pJob);
+	return 0;
+}
+
+bool CSkins::LoadCachedSkinPart(CImageLoadJob *pImage)
+{
+	CSkinPartJob *pJob = (CSkinPartJob *)pImage->m_pUser;
+
+	// the cache is addressed by the content of the png file
+	void *pFileData;
+	unsigned FileSize;
+	if(pJob->m_pStorage->ReadFile(pImage->m_aFilename, pImage->m_StorageType, &pFileData, &FileSize))
+		return false;
+	SHA256_DIGEST Sha256 = sha256(pFileData, FileSize);
+	mem_free(pFileData);
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+	str_format(pJob->m_aCacheFilename, sizeof(pJob->m_aCacheFilename), "cache/skins/%s.bin", aSha256);
+
+	IOHANDLE File = pJob->m_pStorage->OpenFile(pJob->m_aCacheFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	CSkinCacheHeader Header;
+	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header) || mem_comp(Header.m_aMarker, gs_aSkinCacheMarker, sizeof(Header.m_aMarker)) != 0 ||
+		Header.m_Version != SKINCACHE_VERSION || (Header.m_Format != CImageInfo::FORMAT_RGB && Header.m_Format != CImageInfo::FORMAT_RGBA) ||
+		Header.m_Width <= 0 || Header.m_Width > (2<<12) || Header.m_Height <= 0 || Header.m_Height > (2<<12))
 	{
-		str_format(aBuf, sizeof(aBuf), "failed to load skin part '%s'", pName);
-		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+		io_close(File);
+		return false;
+	}
+
+	unsigned Size = Header.m_Width*Header.m_Height*(Header.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3);
+	if(io_length(File) != (long)(sizeof(Header)+2*Size))
+	{
+		io_close(File);
+		return false;
+	}
+
+	void *pData = mem_alloc(Size, 1);
+	void *pColorData = mem_alloc(Size, 1);
+	bool Complete = io_read(File, pData, Size) == Size && io_read(File, pColorData, Size) == Size;
+	io_close(File);
+	if(!Complete)
+	{
+		mem_free(pData);
+		mem_free(pColorData);
+		return false;
+	}
+
+	pImage->m_Image.m_Width = Header.m_Width;
+	pImage->m_Image.m_Height = Header.m_Height;
+	pImage->m_Image.m_Format = Header.m_Format;
+	pImage->m_Image.m_pData = pData;
+	pJob->m_pColorData = pColorData;
+	pJob->m_BloodColor = vec3(Header.m_aBloodColor[0], Header.m_aBloodColor[1], Header.m_aBloodColor[2]);
+	pJob->m_FromCache = true;
+	return true;
+}
+
+void CSkins::SaveCachedSkinPart(const CSkinPartJob *pJob)
+{
+	// write to a temporary file first, so that neither a crash nor a second
+	// client writing the same entry leaves a torn file under the final name
+	const CImageInfo &Info = pJob->m_Image.m_Image;
+	char aTempFilename[IO_MAX_PATH_LENGTH];
+	str_format(aTempFilename, sizeof(aTempFilename), "%s.%d.tmp", pJob->m_aCacheFilename, pid());
+	IOHANDLE File = pJob->m_pStorage->OpenFile(aTempFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	CSkinCacheHeader Header;
+	mem_copy(Header.m_aMarker, gs_aSkinCacheMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = SKINCACHE_VERSION;
+	Header.m_Width = Info.m_Width;
+	Header.m_Height = Info.m_Height;
+	Header.m_Format = Info.m_Format;
+	Header.m_aBloodColor[0] = pJob->m_BloodColor.r;
+	Header.m_aBloodColor[1] = pJob->m_BloodColor.g;
+	Header.m_aBloodColor[2] = pJob->m_BloodColor.b;
+
+	unsigned Size = Info.m_Width*Info.m_Height*(Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3);
+	bool Success = io_write(File, &Header, sizeof(Header)) == sizeof(Header) &&
+		io_write(File, Info.m_pData, Size) == Size &&
+		io_write(File, pJob->m_pColorData, Size) == Size;
+	io_close(File);
+
+	// on windows the rename fails if another client finished the entry first
+	if(!Success || !pJob->m_pStorage->RenameFile(aTempFilename, pJob->m_aCacheFilename, IStorage::TYPE_SAVE))
+		pJob->m_pStorage->RemoveFile(aTempFilename, IStorage::TYPE_SAVE);
+}
+
+int CSkins::SkinCachePrune(const CFsFileInfo *pInfo, int IsDir, int DirType, void *pUser)
+{
+	CSkins *pSelf = (CSkins *)pUser;
+	if(IsDir)
 		return 0;
+
+	// drop the entries of skin parts that are gone or changed and leftovers of
+	// interrupted writes, but not files another client might still be writing
+	if(str_endswith(pInfo->m_pName, ".tmp"))
+	{
+		if(time_timestamp() - pInfo->m_TimeModified < SKINCACHE_TMP_LIFETIME)
+			return 0;
+	}
+	else
+	{
+		CSkinCacheEntry Entry;
+		str_copy(Entry.m_aFilename, pInfo->m_pName, sizeof(Entry.m_aFilename));
+		if(str_comp(Entry.m_aFilename, pInfo->m_pName) == 0 && !find_binary(pSelf->m_aSkinCacheEntries.all(), Entry).empty())
+			return 0;
 	}
 
-	CSkinPart Part;
-	Part.m_OrgTexture = pSelf->Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-	Part.m_BloodColor = vec3(1.0f, 1.0f, 1.0f);
+	char aBuf[IO_MAX_PATH_LENGTH];
+	str_format(aBuf, sizeof(aBuf), "cache/skins/%s", pInfo->m_pName);
+	pSelf->Storage()->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+	if(pSelf->Config()->m_Debug)
+	{
+		str_format(aBuf, sizeof(aBuf), "removed stale cache entry '%s'", pInfo->m_pName);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+	}
+	return 0;
+}
 
+void CSkins::ProcessSkinPart(CImageLoadJob *pImage)
+{
+	CSkinPartJob *pJob = (CSkinPartJob *)pImage->m_pUser;
+	const CImageInfo &Info = pImage->m_Image;
 	unsigned char *d = (unsigned char *)Info.m_pData;
 	int Pitch = Info.m_Width*4;
 
 	// dig out blood color
-	if(pSelf->m_ScanningPart == SKINPART_BODY)
+	if(pJob->m_Part == SKINPART_BODY)
 	{
 		int PartX = Info.m_Width/2;
 		int PartY = 0;
@@ -68,39 +208,62 @@ int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
 				}
 			}
 
-		Part.m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
+		pJob->m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
 	}
 
 	// create colorless version
 	int Step = Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int Size = Info.m_Width*Info.m_Height*Step;
+	unsigned char *pColor = (unsigned char *)mem_alloc(Size, 1);
+	mem_copy(pColor, d, Size);
 
 	// make the texture gray scale
 	for(int i = 0; i < Info.m_Width*Info.m_Height; i++)
 	{
-		int v = (d[i*Step]+d[i*Step+1]+d[i*Step+2])/3;
-		d[i*Step] = v;
-		d[i*Step+1] = v;
-		d[i*Step+2] = v;
+		int v = (pColor[i*Step]+pColor[i*Step+1]+pColor[i*Step+2])/3;
+		pColor[i*Step] = v;
+		pColor[i*Step+1] = v;
+		pColor[i*Step+2] = v;
+	}
+	pJob->m_pColorData = pColor;
+
+	// the cache filename is only set when the cache was looked up and missed
+	if(pJob->m_aCacheFilename[0])
+		SaveCachedSkinPart(pJob);
+}
+
+void CSkins::AddSkinPart(CSkinPartJob *pJob)
+{
+	char aBuf[IO_MAX_PATH_LENGTH];
+	const CImageInfo &Info = pJob->m_Image.m_Image;
+	if(!pJob->m_Image.m_Loaded)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to load skin part '%s'", pJob->m_aName);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+		return;
 	}
 
-	Part.m_ColorTexture = pSelf->Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
+	CSkinPart Part;
+	Part.m_OrgTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
+	Part.m_ColorTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, pJob->m_pColorData, Info.m_Format, 0);
+	Part.m_BloodColor = pJob->m_BloodColor;
 	mem_free(Info.m_pData);
+	mem_free(pJob->m_pColorData);
 
 	// set skin part data
+	const char *pName = pJob->m_aName;
 	Part.m_Flags = 0;
 	if(pName[0] == 'x' && pName[1] == '_')
 		Part.m_Flags |= SKINFLAG_SPECIAL;
-	if(DirType != IStorage::TYPE_SAVE)
+	if(pJob->m_DirType != IStorage::TYPE_SAVE)
 		Part.m_Flags |= SKINFLAG_STANDARD;
 	str_utf8_copy_num(Part.m_aName, pName, min(str_length(pName) - 3, int(sizeof(Part.m_aName))), MAX_SKIN_LENGTH);
-	if(pSelf->Config()->m_Debug)
+	if(Config()->m_Debug)
 	{
 		str_format(aBuf, sizeof(aBuf), "load skin part %s", Part.m_aName);
-		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
 	}
-	pSelf->m_aaSkinParts[pSelf->m_ScanningPart].add(Part);
-
-	return 0;
+	m_aaSkinParts[pJob->m_Part].add(Part);
 }
 
 int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
@@ -236,6 +399,11 @@ void CSkins::OnInit()
 	ms_apColorVariables[SKINPART_FEET] = &Config()->m_PlayerColorFeet;
 	ms_apColorVariables[SKINPART_EYES] = &Config()->m_PlayerColorEyes;
 
+	// queue all skin parts for decoding
+	int64 LoadStart = time_get();
+	int NumCached = 0;
+	m_lpSkinPartJobs.clear();
+	m_aSkinCacheEntries.clear();
 	for(int p = 0; p < NUM_SKINPARTS; p++)
 	{
 		m_aaSkinParts[p].clear();
@@ -250,11 +418,35 @@ void CSkins::OnInit()
 			m_aaSkinParts[p].add(NoneSkinPart);
 		}
 
-		// load skin parts
 		char aBuf[64];
 		str_format(aBuf, sizeof(aBuf), "skins/%s", ms_apSkinPartNames[p]);
 		m_ScanningPart = p;
 		Storage()->ListDirectory(IStorage::TYPE_ALL, aBuf, SkinPartScan, this);
+	}
+
+	// upload the skin parts as they are done, the jobs finish roughly in queue order
+	int Job = 0;
+	for(int p = 0; p < NUM_SKINPARTS; p++)
+	{
+		for(; Job < m_lpSkinPartJobs.size() && m_lpSkinPartJobs[Job]->m_Part == p; Job++)
+		{
+			CSkinPartJob *pJob = m_lpSkinPartJobs[Job];
+			while(!pJob->m_Image.Done())
+			{
+				m_pClient->m_pMenus->RenderLoading(0);
+				thread_yield();
+			}
+			if(pJob->m_FromCache)
+				NumCached++;
+			if(pJob->m_aCacheFilename[0])
+			{
+				CSkinCacheEntry Entry;
+				str_copy(Entry.m_aFilename, str_startswith(pJob->m_aCacheFilename, "cache/skins/"), sizeof(Entry.m_aFilename));
+				m_aSkinCacheEntries.add(Entry);
+			}
+			AddSkinPart(pJob);
+			delete pJob;
+		}
 
 		// add dummy skin part
 		if(!m_aaSkinParts[p].size())
@@ -269,6 +461,16 @@ void CSkins::OnInit()
 		m_pClient->m_pMenus->RenderLoading(5);
 	}
 
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "loaded %d skin parts in %.2fms, %d from cache", m_lpSkinPartJobs.size(), (time_get()-LoadStart)*1000.0f/time_freq(), NumCached);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+	m_lpSkinPartJobs.clear();
+
+	// evict the cache entries that none of the loaded skin parts use
+	if(Config()->m_ClSkinCache)
+		Storage()->ListDirectoryFileInfo(IStorage::TYPE_SAVE, "cache/skins", SkinCachePrune, this);
+	m_aSkinCacheEntries.clear();
+
 	// create dummy skin
 	m_DummySkin.m_Flags = SKINFLAG_STANDARD;
 	str_copy(m_DummySkin.m_aName, "dummy", sizeof(m_DummySkin.m_aName));
@@ -2,7 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef GAME_CLIENT_COMPONENTS_SKINS_H
 #define GAME_CLIENT_COMPONENTS_SKINS_H
+#include <base/hash.h>
 #include <base/vmath.h>
+#include <base/tl/array.h>
 #include <base/tl/sorted_array.h>
 #include <game/client/component.h>
 
@@ -79,12 +81,54 @@ public:
 	void SaveSkinfile(const char *pSaveSkinName);
 
 private:
+	// a skin part that is decoded and prepared on a worker thread
+	struct CSkinPartJob
+	{
+		CImageLoadJob m_Image;
+		class IStorage *m_pStorage;
+		int m_Part;
+		int m_DirType;
+		char m_aName[IO_MAX_PATH_LENGTH];
+		char m_aCacheFilename[IO_MAX_PATH_LENGTH];
+		bool m_FromCache;
+		void *m_pColorData;
+		vec3 m_BloodColor;
+	};
+
+	// processed skin part as it is stored in the cache, followed by the
+	// original and the colorless image data
+	struct CSkinCacheHeader
+	{
+		char m_aMarker[8];
+		int m_Version;
+		int m_Width;
+		int m_Height;
+		int m_Format;
+		float m_aBloodColor[3];
+	};
+
+	// cache file that belongs to one of the loaded skin parts
+	struct CSkinCacheEntry
+	{
+		char m_aFilename[SHA256_MAXSTRSIZE+4];
+
+		bool operator<(const CSkinCacheEntry &Other) const { return str_comp(m_aFilename, Other.m_aFilename) < 0; }
+		bool operator==(const CSkinCacheEntry &Other) const { return str_comp(m_aFilename, Other.m_aFilename) == 0; }
+	};
+
 	int m_ScanningPart;
 	sorted_array<CSkinPart> m_aaSkinParts[NUM_SKINPARTS];
 	sorted_array<CSkin> m_aSkins;
 	CSkin m_DummySkin;
+	array<CSkinPartJob *> m_lpSkinPartJobs;
+	sorted_array<CSkinCacheEntry> m_aSkinCacheEntries;
 
 	static int SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser);
+	static bool LoadCachedSkinPart(CImageLoadJob *pImage);
+	static void ProcessSkinPart(CImageLoadJob *pImage);
+	static void SaveCachedSkinPart(const CSkinPartJob *pJob);
+	static int SkinCachePrune(const CFsFileInfo *pInfo, int IsDir, int DirType, void *pUser);
+	void AddSkinPart(CSkinPartJob *pJob);
 	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
 };
 
@@ -353,6 +353,11 @@ void CGameClient::OnInit()
 	m_UI.Init(Config(), Graphics(), Input(), TextRender());
 	m_RenderTools.Init(Config(), Graphics(), UI());
 
+	InvalidatePrediction();
+	m_PredictionTicks = 0;
+	m_PredictionTicksPerSecond = 0;
+	m_PredictionStatsStart = time_get();
+
 	int64 Start = time_get();
 
 	// Render load screen at 0% to get graphics sooner.
@@ -453,6 +458,7 @@ void CGameClient::OnConnected()
 {
 	m_Layers.Init(Kernel());
 	m_Collision.Init(Layers());
+	InvalidatePrediction();
 
 	for(int i = 0; i < m_All.m_Num; i++)
 	{
@@ -472,6 +478,7 @@ void CGameClient::OnReset()
 	{
 		// clear out the invalid pointers
 		m_LastNewPredictedTick = -1;
+		InvalidatePrediction();
 		mem_zero(&m_Snap, sizeof(m_Snap));
 
 		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
@@ -1543,26 +1550,44 @@ void CGameClient::OnPredict()
 			m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
 		}
 
+		InvalidatePrediction();
 		return;
 	}
 
-	// repredict character
-	CWorldCore World;
-	World.m_Tuning = m_Tuning;
-
-	// search for players
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	// The world at `m_PredictedTick` is kept from the last call. As long as
+	// it was predicted from the same snapshot, tuning and local inputs, we
+	// only need to advance it by the new ticks instead of starting over.
+	int StartTick = Client()->GameTick() + 1;
+	unsigned InputHash = PredictionInputHash(StartTick, m_PredictedTick);
+	if(m_PredictionSnapTick != Client()->GameTick() || InputHash != m_PredictionInputHash ||
+		m_PredictedTick > Client()->PredGameTick() ||
+		mem_comp(&m_PredictionWorld.m_Tuning, &m_Tuning, sizeof(m_Tuning)) != 0)
 	{
-		if(!m_Snap.m_aCharacters[i].m_Active)
-			continue;
+		// repredict character
+		m_PredictionWorld = CWorldCore();
+		m_PredictionWorld.m_Tuning = m_Tuning;
+
+		// search for players
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_Snap.m_aCharacters[i].m_Active)
+				continue;
 
-		m_aClients[i].m_Predicted.Init(&World, Collision());
-		World.m_apCharacters[i] = &m_aClients[i].m_Predicted;
-		m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
+			m_aClients[i].m_Predicted.Init(&m_PredictionWorld, Collision());
+			m_PredictionWorld.m_apCharacters[i] = &m_aClients[i].m_Predicted;
+			m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
+		}
+
+		m_PredictionSnapTick = Client()->GameTick();
+		m_PredictionInputHash = PredictionInputHash(StartTick, StartTick-1);
 	}
+	else
+		StartTick = m_PredictedTick + 1;
+
+	CWorldCore &World = m_PredictionWorld;
 
 	// predict
-	for(int Tick = Client()->GameTick() + 1;
+	for(int Tick = StartTick;
 		Tick <= Client()->PredGameTick();
 		Tick++)
 	{
@@ -1627,9 +1652,44 @@ void CGameClient::OnPredict()
 				);
 			}
 		}
+
+		m_PredictionInputHash = PredictionInputHash(Tick, Tick, m_PredictionInputHash);
+		m_PredictionTicks++;
 	}
 
 	m_PredictedTick = Client()->PredGameTick();
+
+	// update the prediction stats once per second
+	int64 Now = time_get();
+	if(Now-m_PredictionStatsStart > time_freq())
+	{
+		m_PredictionTicksPerSecond = m_PredictionTicks;
+		m_PredictionTicks = 0;
+		m_PredictionStatsStart = Now;
+	}
+}
+
+unsigned CGameClient::PredictionInputHash(int FromTick, int ToTick, unsigned Hash) const
+{
+	// only the local character is predicted with inputs
+	if(m_LocalClientID == -1)
+		return Hash;
+
+	for(int Tick = FromTick; Tick <= ToTick; Tick++)
+	{
+		const int *pInput = Client()->GetInput(Tick);
+		if(!pInput)
+			continue;
+		for(unsigned i = 0; i < sizeof(CNetObj_PlayerInput)/sizeof(int); i++)
+			Hash = (Hash ^ (unsigned)pInput[i]) * 16777619u;
+	}
+	return Hash;
+}
+
+void CGameClient::InvalidatePrediction()
+{
+	m_PredictionSnapTick = -1;
+	m_PredictedTick = -1;
 }
 
 
@@ -58,6 +58,17 @@ class CGameClient : public IGameClient
 	int m_PredictedTick;
 	int m_LastNewPredictedTick;
 
+	// prediction cache, the predicted cores live in `m_PredictionWorld`
+	CWorldCore m_PredictionWorld;
+	int m_PredictionSnapTick;
+	unsigned m_PredictionInputHash;
+	int m_PredictionTicks;
+	int m_PredictionTicksPerSecond;
+	int64 m_PredictionStatsStart;
+
+	unsigned PredictionInputHash(int FromTick, int ToTick, unsigned Hash = 2166136261u) const;
+	void InvalidatePrediction();
+
 	int m_LastGameStartTick;
 	int m_LastFlagCarrierRed;
 	int m_LastFlagCarrierBlue;
@@ -99,6 +110,7 @@ public:
 	const char *NetobjFailedOn() { return m_NetObjHandler.FailedObjOn(); }
 	int NetobjNumFailures() { return m_NetObjHandler.NumObjFailures(); }
 	const char *NetmsgFailedOn() { return m_NetObjHandler.FailedMsgOn(); }
+	int PredictedTicksPerSecond() const { return m_PredictionTicksPerSecond; }
 
 	bool m_SuppressEvents;
 
@@ -46,11 +46,40 @@ public:
 typedef void (*ENVELOPE_EVAL)(float TimeOffset, int Env, float *pChannels, void *pUser);
 class CTextCursor;
 
+// a tile layer stored in a static quad buffer, split into chunks that are culled against the screen
+class CTileBuffer
+{
+public:
+	enum
+	{
+		CHUNK_SIZE=32, // in tiles
+	};
+
+	struct CChunk
+	{
+		int m_Offset; // first quad, the opaque tiles come before the transparent ones
+		int m_NumOpaque;
+		int m_NumTransparent;
+	};
+
+	IGraphics::CBufferHandle m_Buffer;
+	CChunk *m_pChunks;
+	int m_NumChunksX;
+	int m_NumChunksY;
+
+	CTileBuffer() : m_pChunks(0), m_NumChunksX(0), m_NumChunksY(0) {}
+	bool IsBuilt() const { return m_pChunks != 0; }
+};
+
 class CRenderTools
 {
 	void DrawRoundRectExt(float x, float y, float w, float h, float r, int Corners);
 	void DrawRoundRectExt4(float x, float y, float w, float h, vec4 ColorTopLeft, vec4 ColorTopRight, vec4 ColorBottomLeft, vec4 ColorBottomRight, float r, int Corners);
 
+	void RenderTile(const CTile *pTile, float x, float y, float Scale);
+	void RenderTiles(CTile *pTiles, int w, int h, float Scale, bool Opaque, int RenderFlags, int StartX, int StartY, int EndX, int EndY, bool OutsideOnly);
+	vec4 TilemapColor(vec4 Color, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
+
 
 	class CConfig *m_pConfig;
 	class IGraphics *m_pGraphics;
@@ -83,6 +112,9 @@ public:
 	static void RenderEvalEnvelope(CEnvPoint *pPoints, int NumPoints, int Channels, float Time, float *pResult);
 	void RenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser);
 	void RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
+	void BuildTileBuffer(CTileBuffer *pBuffer, CTile *pTiles, int w, int h, float Scale);
+	void UnloadTileBuffer(CTileBuffer *pBuffer);
+	void RenderTileBuffer(const CTileBuffer *pBuffer, CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
 
 	// helpers
 	void MapScreenToWorld(float CenterX, float CenterY, float ParallaxX, float ParallaxY,
@@ -330,12 +330,8 @@ void CRenderTools::RenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENV
 	Graphics()->WrapNormal();
 }
 
-void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags,
-									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+vec4 CRenderTools::TilemapColor(vec4 Color, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
 {
-	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
-
 	float r=1, g=1, b=1, a=1;
 	if(ColorEnv >= 0)
 	{
@@ -346,19 +342,70 @@ void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4
 		b = aChannels[2];
 		a = aChannels[3];
 	}
+	return vec4(Color.r*r, Color.g*g, Color.b*b, Color.a*a);
+}
 
-	Graphics()->QuadsBegin();
-	const float Alpha = Color.a*a;
-	Graphics()->SetColor(Color.r*r*Alpha, Color.g*g*Alpha, Color.b*b*Alpha, Alpha);
+void CRenderTools::RenderTile(const CTile *pTile, float x, float y, float Scale)
+{
+	unsigned char Flags = pTile->m_Flags;
+
+	float x0 = 0;
+	float y0 = 0;
+	float x1 = 1;
+	float y1 = 0;
+	float x2 = 1;
+	float y2 = 1;
+	float x3 = 0;
+	float y3 = 1;
+
+	if(Flags&TILEFLAG_VFLIP)
+	{
+		x0 = x2;
+		x1 = x3;
+		x2 = x3;
+		x3 = x0;
+	}
 
-	int StartY = (int)(ScreenY0/Scale)-1;
-	int StartX = (int)(ScreenX0/Scale)-1;
-	int EndY = (int)(ScreenY1/Scale)+1;
-	int EndX = (int)(ScreenX1/Scale)+1;
+	if(Flags&TILEFLAG_HFLIP)
+	{
+		y0 = y3;
+		y2 = y1;
+		y3 = y1;
+		y1 = y0;
+	}
 
+	if(Flags&TILEFLAG_ROTATE)
+	{
+		float Tmp = x0;
+		x0 = x3;
+		x3 = x2;
+		x2 = x1;
+		x1 = Tmp;
+		Tmp = y0;
+		y0 = y3;
+		y3 = y2;
+		y2 = y1;
+		y1 = Tmp;
+	}
+
+	Graphics()->QuadsSetSubsetFree(x0, y0, x1, y1, x2, y2, x3, y3, pTile->m_Index);
+	IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
+	Graphics()->QuadsDrawTL(&QuadItem, 1);
+}
+
+void CRenderTools::RenderTiles(CTile *pTiles, int w, int h, float Scale, bool Opaque, int RenderFlags,
+									int StartX, int StartY, int EndX, int EndY, bool OutsideOnly)
+{
 	for(int y = StartY; y < EndY; y++)
 		for(int x = StartX; x < EndX; x++)
 		{
+			// the inside is already drawn from the tile buffer
+			if(OutsideOnly && x >= 0 && x < w && y >= 0 && y < h)
+			{
+				x = w-1;
+				continue;
+			}
+
 			int mx = x;
 			int my = y;
 
@@ -387,13 +434,10 @@ void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4
 
 			int c = mx + my*w;
 
-			unsigned char Index = pTiles[c].m_Index;
-			if(Index)
+			if(pTiles[c].m_Index)
 			{
-				unsigned char Flags = pTiles[c].m_Flags;
-
 				bool Render = false;
-				if(Flags&TILEFLAG_OPAQUE && Color.a*a > 254.0f/255.0f)
+				if(pTiles[c].m_Flags&TILEFLAG_OPAQUE && Opaque)
 				{
 					if(RenderFlags&LAYERRENDERFLAG_OPAQUE)
 						Render = true;
@@ -405,53 +449,149 @@ void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4
 				}
 
 				if(Render)
-				{
-					float x0 = 0;
-					float y0 = 0;
-					float x1 = 1;
-					float y1 = 0;
-					float x2 = 1;
-					float y2 = 1;
-					float x3 = 0;
-					float y3 = 1;
-
-					if(Flags&TILEFLAG_VFLIP)
-					{
-						x0 = x2;
-						x1 = x3;
-						x2 = x3;
-						x3 = x0;
-					}
+					RenderTile(&pTiles[c], x, y, Scale);
+			}
+			x += pTiles[c].m_Skip;
+		}
+}
 
-					if(Flags&TILEFLAG_HFLIP)
-					{
-						y0 = y3;
-						y2 = y1;
-						y3 = y1;
-						y1 = y0;
-					}
+void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags,
+									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+{
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+	Color = TilemapColor(Color, pfnEval, pUser, ColorEnv, ColorEnvOffset);
 
-					if(Flags&TILEFLAG_ROTATE)
+	Graphics()->QuadsBegin();
+	Graphics()->SetColor(Color.r*Color.a, Color.g*Color.a, Color.b*Color.a, Color.a);
+
+	int StartY = (int)(ScreenY0/Scale)-1;
+	int StartX = (int)(ScreenX0/Scale)-1;
+	int EndY = (int)(ScreenY1/Scale)+1;
+	int EndX = (int)(ScreenX1/Scale)+1;
+
+	RenderTiles(pTiles, w, h, Scale, Color.a > 254.0f/255.0f, RenderFlags, StartX, StartY, EndX, EndY, false);
+
+	Graphics()->QuadsEnd();
+}
+
+void CRenderTools::BuildTileBuffer(CTileBuffer *pBuffer, CTile *pTiles, int w, int h, float Scale)
+{
+	UnloadTileBuffer(pBuffer);
+	if(!Graphics()->QuadBuffersSupported())
+		return;
+
+	pBuffer->m_NumChunksX = (w + CTileBuffer::CHUNK_SIZE-1) / CTileBuffer::CHUNK_SIZE;
+	pBuffer->m_NumChunksY = (h + CTileBuffer::CHUNK_SIZE-1) / CTileBuffer::CHUNK_SIZE;
+	pBuffer->m_pChunks = new CTileBuffer::CChunk[pBuffer->m_NumChunksX*pBuffer->m_NumChunksY];
+
+	// record chunk by chunk, so a row of chunks ends up next to each other in the buffer
+	Graphics()->QuadsBeginRecording();
+	for(int cy = 0; cy < pBuffer->m_NumChunksY; cy++)
+		for(int cx = 0; cx < pBuffer->m_NumChunksX; cx++)
+		{
+			CTileBuffer::CChunk *pChunk = &pBuffer->m_pChunks[cy*pBuffer->m_NumChunksX + cx];
+			pChunk->m_Offset = Graphics()->QuadsRecorded();
+
+			int StartX = cx*CTileBuffer::CHUNK_SIZE;
+			int StartY = cy*CTileBuffer::CHUNK_SIZE;
+			int EndX = min(StartX+(int)CTileBuffer::CHUNK_SIZE, w);
+			int EndY = min(StartY+(int)CTileBuffer::CHUNK_SIZE, h);
+			for(int Pass = 0; Pass < 2; Pass++)
+			{
+				for(int y = StartY; y < EndY; y++)
+					for(int x = StartX; x < EndX; x++)
 					{
-						float Tmp = x0;
-						x0 = x3;
-						x3 = x2;
-						x2 = x1;
-						x1 = Tmp;
-						Tmp = y0;
-						y0 = y3;
-						y3 = y2;
-						y2 = y1;
-						y1 = Tmp;
+						const CTile *pTile = &pTiles[y*w + x];
+						if(pTile->m_Index && ((pTile->m_Flags&TILEFLAG_OPAQUE) != 0) == (Pass == 0))
+							RenderTile(pTile, x, y, Scale);
 					}
 
-					Graphics()->QuadsSetSubsetFree(x0, y0, x1, y1, x2, y2, x3, y3, Index);
-					IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
-					Graphics()->QuadsDrawTL(&QuadItem, 1);
+				if(Pass == 0)
+					pChunk->m_NumOpaque = Graphics()->QuadsRecorded() - pChunk->m_Offset;
+			}
+			pChunk->m_NumTransparent = Graphics()->QuadsRecorded() - pChunk->m_Offset - pChunk->m_NumOpaque;
+		}
+	pBuffer->m_Buffer = Graphics()->QuadsEndRecording();
+}
+
+void CRenderTools::UnloadTileBuffer(CTileBuffer *pBuffer)
+{
+	Graphics()->UnloadBuffer(&pBuffer->m_Buffer);
+	delete[] pBuffer->m_pChunks;
+	pBuffer->m_pChunks = 0;
+	pBuffer->m_NumChunksX = 0;
+	pBuffer->m_NumChunksY = 0;
+}
+
+void CRenderTools::RenderTileBuffer(const CTileBuffer *pBuffer, CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags,
+									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+{
+	if(!pBuffer->IsBuilt())
+	{
+		RenderTilemap(pTiles, w, h, Scale, Color, RenderFlags, pfnEval, pUser, ColorEnv, ColorEnvOffset);
+		return;
+	}
+
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+	Color = TilemapColor(Color, pfnEval, pUser, ColorEnv, ColorEnvOffset);
+	const bool Opaque = Color.a > 254.0f/255.0f;
+
+	Graphics()->QuadsBegin();
+	Graphics()->SetColor(Color.r*Color.a, Color.g*Color.a, Color.b*Color.a, Color.a);
+
+	int StartY = (int)(ScreenY0/Scale)-1;
+	int StartX = (int)(ScreenX0/Scale)-1;
+	int EndY = (int)(ScreenY1/Scale)+1;
+	int EndX = (int)(ScreenX1/Scale)+1;
+
+	// draw the visible chunks, ranges that follow each other in the buffer are merged into one draw
+	int ChunkX0 = max(StartX, 0) / CTileBuffer::CHUNK_SIZE;
+	int ChunkY0 = max(StartY, 0) / CTileBuffer::CHUNK_SIZE;
+	int ChunkX1 = min((min(EndX, w)-1) / CTileBuffer::CHUNK_SIZE, pBuffer->m_NumChunksX-1);
+	int ChunkY1 = min((min(EndY, h)-1) / CTileBuffer::CHUNK_SIZE, pBuffer->m_NumChunksY-1);
+	int RangeOffset = 0;
+	int RangeNum = 0;
+	bool Visible = EndX > 0 && EndY > 0 && StartX < w && StartY < h;
+	for(int cy = ChunkY0; Visible && cy <= ChunkY1; cy++)
+		for(int cx = ChunkX0; cx <= ChunkX1; cx++)
+		{
+			const CTileBuffer::CChunk *pChunk = &pBuffer->m_pChunks[cy*pBuffer->m_NumChunksX + cx];
+			int Offset = pChunk->m_Offset;
+			int Num = 0;
+			if(Opaque)
+			{
+				if(RenderFlags&LAYERRENDERFLAG_OPAQUE)
+					Num += pChunk->m_NumOpaque;
+				if(RenderFlags&LAYERRENDERFLAG_TRANSPARENT)
+				{
+					if(Num == 0)
+						Offset += pChunk->m_NumOpaque;
+					Num += pChunk->m_NumTransparent;
 				}
 			}
-			x += pTiles[c].m_Skip;
+			else if(RenderFlags&LAYERRENDERFLAG_TRANSPARENT)
+				Num = pChunk->m_NumOpaque + pChunk->m_NumTransparent;
+
+			if(Num == 0)
+				continue;
+			if(RangeNum && RangeOffset + RangeNum == Offset)
+				RangeNum += Num;
+			else
+			{
+				Graphics()->QuadsDrawBuffer(pBuffer->m_Buffer, RangeOffset, RangeNum);
+				RangeOffset = Offset;
+				RangeNum = Num;
+			}
 		}
+	Graphics()->QuadsDrawBuffer(pBuffer->m_Buffer, RangeOffset, RangeNum);
+
+	// tiles outside of the layer repeat the border and are not part of the buffer
+	if(RenderFlags&TILERENDERFLAG_EXTEND && (StartX < 0 || StartY < 0 || EndX > w || EndY > h))
+		RenderTiles(pTiles, w, h, Scale, Opaque, RenderFlags, StartX, StartY, EndX, EndY, true);
 
 	Graphics()->QuadsEnd();
 }
@@ -15,17 +15,32 @@
 CCollision::CCollision()
 {
 	m_pTiles = 0;
+	m_NumTiles = 0;
 	m_Width = 0;
 	m_Height = 0;
 	m_pLayers = 0;
 }
 
+CCollision::~CCollision()
+{
+	mem_free(m_pTiles);
+}
+
 void CCollision::Init(class CLayers *pLayers)
 {
 	m_pLayers = pLayers;
 	m_Width = m_pLayers->GameLayer()->m_Width;
 	m_Height = m_pLayers->GameLayer()->m_Height;
-	m_pTiles = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data));
+
+	// the tiles are converted, so they must not be written back into the map
+	// data that other servers of the process might be using
+	if(m_NumTiles != m_Width*m_Height)
+	{
+		mem_free(m_pTiles);
+		m_NumTiles = m_Width*m_Height;
+		m_pTiles = (CTile *)mem_alloc_tagged(m_NumTiles*sizeof(CTile), 1, MEMTAG_MAP);
+	}
+	mem_copy(m_pTiles, m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data), m_NumTiles*sizeof(CTile));
 
 	for(int i = 0; i < m_Width*m_Height; i++)
 	{
@@ -7,7 +7,8 @@
 
 class CCollision
 {
-	class CTile *m_pTiles;
+	class CTile *m_pTiles; // own copy of the game layer, the map data can be shared
+	int m_NumTiles;
 	int m_Width;
 	int m_Height;
 	class CLayers *m_pLayers;
@@ -24,6 +25,7 @@ public:
 	};
 
 	CCollision();
+	~CCollision();
 	void Init(class CLayers *pLayers);
 	bool CheckPoint(float x, float y, int Flag=COLFLAG_SOLID) const { return IsTile(round_to_int(x), round_to_int(y), Flag); }
 	bool CheckPoint(vec2 Pos, int Flag=COLFLAG_SOLID) const { return CheckPoint(Pos.x, Pos.y, Flag); }
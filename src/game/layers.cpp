@@ -13,14 +13,15 @@ CLayers::CLayers()
 	m_pMap = 0;
 }
 
-void CLayers::Init(class IKernel *pKernel, IMap *pMap)
+void CLayers::Init(class IKernel *pKernel, IMap *pMap, bool TilemapSkip)
 {
 	m_pMap = pMap ? pMap : pKernel->RequestInterface<IMap>();
 	m_pMap->GetType(MAPITEMTYPE_GROUP, &m_GroupsStart, &m_GroupsNum);
 	m_pMap->GetType(MAPITEMTYPE_LAYER, &m_LayersStart, &m_LayersNum);
 
 	InitGameLayer();
-	InitTilemapSkip();
+	if(TilemapSkip)
+		InitTilemapSkip();
 }
 
 void CLayers::InitGameLayer()
@@ -21,7 +21,9 @@ class CLayers
 
 public:
 	CLayers();
-	void Init(class IKernel *pKernel, class IMap *pMap=0);
+	// TilemapSkip fills in the skip counts the renderer uses, which means
+	// reading every tile layer. without it only the game layer gets loaded
+	void Init(class IKernel *pKernel, class IMap *pMap=0, bool TilemapSkip=true);
 	int NumGroups() const { return m_GroupsNum; }
 	int NumLayers() const { return m_LayersNum; }
 	class IMap *Map() const { return m_pMap; }
@@ -23,40 +23,123 @@
 	} \
 	private:
 
-#define MACRO_ALLOC_POOL_ID() \
-	public: \
-	void *operator new(size_t Size, int id); \
-	void operator delete(void *p, int id); \
-	void operator delete(void *p); \
-	private:
+// objects of one size carved out of blocks of SLOTS_PER_BLOCK. freed slots go on
+// a free list and are handed out first again, so the objects that churn stay
+// close together. the slots can be walked in memory order, which only depends on
+// the order of the allocations. the blocks are only given back when the pool dies
+class CSlabPool
+{
+	struct CSlot
+	{
+		CSlabPool *m_pPool;
+		CSlot *m_pNextFree;
+		bool m_Used;
+	};
 
-#define MACRO_ALLOC_POOL_ID_IMPL(POOLTYPE, PoolSize) \
-	static char ms_PoolData##POOLTYPE[PoolSize][sizeof(POOLTYPE)] = {{0}}; \
-	static int ms_PoolUsed##POOLTYPE[PoolSize] = {0}; \
-	void *POOLTYPE::operator new(size_t Size, int id) \
-	{ \
-		dbg_assert(sizeof(POOLTYPE) == Size, "size error"); \
-		dbg_assert(!ms_PoolUsed##POOLTYPE[id], "already used"); \
-		/*dbg_msg("pool", "++ %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 1; \
-		mem_zero(ms_PoolData##POOLTYPE[id], Size); \
-		return ms_PoolData##POOLTYPE[id]; \
-	} \
-	void POOLTYPE::operator delete(void *p, int id) \
-	{ \
-		dbg_assert(ms_PoolUsed##POOLTYPE[id], "not used"); \
-		dbg_assert(id == (POOLTYPE*)p - (POOLTYPE*)ms_PoolData##POOLTYPE, "invalid id"); \
-		/*dbg_msg("pool", "-- %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 0; \
-		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
-	} \
-	void POOLTYPE::operator delete(void *p) \
-	{ \
-		int id = (POOLTYPE*)p - (POOLTYPE*)ms_PoolData##POOLTYPE; \
-		dbg_assert(ms_PoolUsed##POOLTYPE[id], "not used"); \
-		/*dbg_msg("pool", "-- %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 0; \
-		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
+	enum
+	{
+		SLOTS_PER_BLOCK = 64,
+		SLOT_ALIGN = 16,
+	};
+
+	int m_ObjectSize;
+	int m_SlotSize;
+	char **m_apBlocks;
+	int m_NumBlocks;
+	int m_MaxBlocks;
+	CSlot *m_pFirstFree;
+	int m_NumUsed;
+
+	CSlot *GetSlot(int Index) const
+	{
+		return (CSlot *)(m_apBlocks[Index/SLOTS_PER_BLOCK]+(Index%SLOTS_PER_BLOCK)*m_SlotSize);
+	}
+
+	void AllocBlock()
+	{
+		if(m_NumBlocks == m_MaxBlocks)
+		{
+			m_MaxBlocks = m_MaxBlocks ? m_MaxBlocks*2 : 4;
+			char **apBlocks = (char **)mem_alloc(m_MaxBlocks*sizeof(char *), 1);
+			if(m_NumBlocks)
+				mem_copy(apBlocks, m_apBlocks, m_NumBlocks*sizeof(char *));
+			mem_free(m_apBlocks);
+			m_apBlocks = apBlocks;
+		}
+
+		char *pBlock = (char *)mem_alloc(m_SlotSize*SLOTS_PER_BLOCK, SLOT_ALIGN);
+		m_apBlocks[m_NumBlocks++] = pBlock;
+		for(int i = SLOTS_PER_BLOCK-1; i >= 0; i--)
+		{
+			CSlot *pSlot = (CSlot *)(pBlock+i*m_SlotSize);
+			pSlot->m_pPool = this;
+			pSlot->m_pNextFree = m_pFirstFree;
+			pSlot->m_Used = false;
+			m_pFirstFree = pSlot;
+		}
+	}
+
+public:
+	CSlabPool() : m_ObjectSize(0), m_SlotSize(0), m_apBlocks(0), m_NumBlocks(0), m_MaxBlocks(0), m_pFirstFree(0), m_NumUsed(0) {}
+	~CSlabPool()
+	{
+		dbg_assert(m_NumUsed == 0, "slab pool destroyed while in use");
+		for(int i = 0; i < m_NumBlocks; i++)
+			mem_free(m_apBlocks[i]);
+		mem_free(m_apBlocks);
+	}
+
+	void Init(int ObjectSize)
+	{
+		dbg_assert(m_NumBlocks == 0, "slab pool already in use");
+		m_ObjectSize = ObjectSize;
+		m_SlotSize = (sizeof(CSlot)+ObjectSize+SLOT_ALIGN-1)&~(SLOT_ALIGN-1);
 	}
 
+	int ObjectSize() const { return m_ObjectSize; }
+	int NumSlots() const { return m_NumBlocks*SLOTS_PER_BLOCK; }
+	int NumUsed() const { return m_NumUsed; }
+
+	// the object in the slot, 0 if the slot is free
+	void *Object(int Index) const
+	{
+		CSlot *pSlot = GetSlot(Index);
+		return pSlot->m_Used ? pSlot+1 : 0;
+	}
+
+	// the memory is zeroed like the one of MACRO_ALLOC_HEAP
+	void *Alloc()
+	{
+		if(!m_pFirstFree)
+			AllocBlock();
+		CSlot *pSlot = m_pFirstFree;
+		m_pFirstFree = pSlot->m_pNextFree;
+		pSlot->m_pNextFree = 0;
+		pSlot->m_Used = true;
+		m_NumUsed++;
+		mem_zero(pSlot+1, m_ObjectSize);
+		return pSlot+1;
+	}
+
+	// frees an object of any pool
+	static void Free(void *pPtr)
+	{
+		CSlot *pSlot = (CSlot *)pPtr-1;
+		CSlabPool *pPool = pSlot->m_pPool;
+		pSlot->m_pNextFree = pPool->m_pFirstFree;
+		pSlot->m_Used = false;
+		pPool->m_pFirstFree = pSlot;
+		pPool->m_NumUsed--;
+	}
+};
+
+// objects that live in the slab pool POOL of their owner, allocated with new(pOwner) CType(...).
+// the owner provides void *AllocObject(int Pool, int Size)
+#define MACRO_ALLOC_SLAB(OWNERTYPE, POOL) \
+	public: \
+	void *operator new(size_t Size, OWNERTYPE *pOwner) { return pOwner->AllocObject(POOL, Size); } \
+	void operator delete(void *pPtr, OWNERTYPE *pOwner) { CSlabPool::Free(pPtr); } \
+	void operator delete(void *pPtr) { CSlabPool::Free(pPtr); } \
+	private:
+
 #endif
@@ -38,8 +38,6 @@ CInputCount CountInput(int Prev, int Cur)
 }
 
 
-MACRO_ALLOC_POOL_ID_IMPL(CCharacter, MAX_CLIENTS)
-
 // Character, "physical" player's part
 CCharacter::CCharacter(CGameWorld *pWorld)
 : CEntity(pWorld, CGameWorld::ENTTYPE_CHARACTER, vec2(0, 0), ms_PhysSize)
@@ -47,6 +45,10 @@ CCharacter::CCharacter(CGameWorld *pWorld)
 	m_Health = 0;
 	m_Armor = 0;
 	m_TriggeredEvents = 0;
+	for(int i = 0; i < EVENT_HISTORY; i++)
+		m_aEventHistoryTick[i] = -1;
+	mem_zero(m_aEventHistory, sizeof(m_aEventHistory));
+	m_EventHistoryIndex = 0;
 }
 
 void CCharacter::Reset()
@@ -340,7 +342,7 @@ void CCharacter::FireWeapon()
 
 		case WEAPON_GUN:
 		{
-			new CProjectile(GameWorld(), WEAPON_GUN,
+			new(GameWorld()) CProjectile(GameWorld(), WEAPON_GUN,
 				m_pPlayer->GetCID(),
 				ProjStartPos,
 				Direction,
@@ -361,7 +363,7 @@ void CCharacter::FireWeapon()
 				a += Spreading[i+2];
 				float v = 1-(absolute(i)/(float)ShotSpread);
 				float Speed = mix((float)GameServer()->Tuning()->m_ShotgunSpeeddiff, 1.0f, v);
-				new CProjectile(GameWorld(), WEAPON_SHOTGUN,
+				new(GameWorld()) CProjectile(GameWorld(), WEAPON_SHOTGUN,
 					m_pPlayer->GetCID(),
 					ProjStartPos,
 					vec2(cosf(a), sinf(a))*Speed,
@@ -374,7 +376,7 @@ void CCharacter::FireWeapon()
 
 		case WEAPON_GRENADE:
 		{
-			new CProjectile(GameWorld(), WEAPON_GRENADE,
+			new(GameWorld()) CProjectile(GameWorld(), WEAPON_GRENADE,
 				m_pPlayer->GetCID(),
 				ProjStartPos,
 				Direction,
@@ -386,7 +388,7 @@ void CCharacter::FireWeapon()
 
 		case WEAPON_LASER:
 		{
-			new CLaser(GameWorld(), m_Pos, Direction, GameServer()->Tuning()->m_LaserReach, m_pPlayer->GetCID());
+			new(GameWorld()) CLaser(GameWorld(), m_Pos, Direction, GameServer()->Tuning()->m_LaserReach, m_pPlayer->GetCID());
 			GameServer()->CreateSound(m_Pos, SOUND_LASER_FIRE);
 		} break;
 
@@ -842,6 +844,14 @@ void CCharacter::Snap(int SnappingClient)
 	pCharacter->m_Health = 0;
 	pCharacter->m_Armor = 0;
 	pCharacter->m_TriggeredEvents = m_TriggeredEvents;
+	const int SinceTick = GameServer()->SnapEventTick(SnappingClient);
+	for(int i = 1; i <= EVENT_HISTORY; i++)
+	{
+		const int h = (m_EventHistoryIndex+EVENT_HISTORY-i)%EVENT_HISTORY;
+		if(m_aEventHistoryTick[h] <= SinceTick)
+			break;
+		pCharacter->m_TriggeredEvents |= m_aEventHistory[h];
+	}
 
 	pCharacter->m_Weapon = m_ActiveWeapon;
 	pCharacter->m_AttackTick = m_AttackTick;
@@ -868,5 +878,11 @@ void CCharacter::Snap(int SnappingClient)
 
 void CCharacter::PostSnap()
 {
+	if(m_TriggeredEvents)
+	{
+		m_aEventHistoryTick[m_EventHistoryIndex] = Server()->Tick();
+		m_aEventHistory[m_EventHistoryIndex] = m_TriggeredEvents;
+		m_EventHistoryIndex = (m_EventHistoryIndex+1)%EVENT_HISTORY;
+	}
 	m_TriggeredEvents = 0;
 }
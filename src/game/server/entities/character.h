@@ -11,7 +11,7 @@
 
 class CCharacter : public CEntity
 {
-	MACRO_ALLOC_POOL_ID()
+	MACRO_ALLOC_SLAB(CGameWorld, CGameWorld::ENTTYPE_CHARACTER)
 
 public:
 	//character's size
@@ -109,6 +109,15 @@ private:
 
 	int m_TriggeredEvents;
 
+	// the triggered events of the last rounds, for the clients that skipped them
+	enum
+	{
+		EVENT_HISTORY=32,
+	};
+	int m_aEventHistoryTick[EVENT_HISTORY];
+	int m_aEventHistory[EVENT_HISTORY];
+	int m_EventHistoryIndex;
+
 	// ninja
 	struct
 	{
@@ -7,6 +7,8 @@
 
 class CFlag : public CEntity
 {
+	MACRO_ALLOC_SLAB(CGameWorld, CGameWorld::ENTTYPE_FLAG)
+
 private:
 	/* Identity */
 	int m_Team;
@@ -22,6 +22,7 @@ CProjectile::CProjectile(CGameWorld *pGameWorld, int Type, int Owner, vec2 Pos,
 	m_Weapon = Weapon;
 	m_StartTick = Server()->Tick();
 	m_Explosive = Explosive;
+	m_SweepTick = -1;
 
 	GameWorld()->InsertEntity(this);
 }
@@ -66,15 +67,117 @@ vec2 CProjectile::GetPos(float Time)
 }
 
 
+void CProjectile::SweepAll(CGameWorld *pGameWorld)
+{
+	enum
+	{
+		BATCH_SIZE = 64,
+	};
+
+	const CTuningParams *pTuning = pGameWorld->GameServer()->Tuning();
+	const CCollision *pCollision = pGameWorld->GameServer()->Collision();
+	const int Tick = pGameWorld->Server()->Tick();
+	const float TickSpeed = (float)pGameWorld->Server()->TickSpeed();
+
+	// the tuning of GetPos per weapon, the last entry is for unknown types
+	float aCurvature[NUM_WEAPONS+1] = {0};
+	float aSpeed[NUM_WEAPONS+1] = {0};
+	aCurvature[WEAPON_GRENADE] = pTuning->m_GrenadeCurvature;
+	aSpeed[WEAPON_GRENADE] = pTuning->m_GrenadeSpeed;
+	aCurvature[WEAPON_SHOTGUN] = pTuning->m_ShotgunCurvature;
+	aSpeed[WEAPON_SHOTGUN] = pTuning->m_ShotgunSpeed;
+	aCurvature[WEAPON_GUN] = pTuning->m_GunCurvature;
+	aSpeed[WEAPON_GUN] = pTuning->m_GunSpeed;
+
+	// the character positions as seen by IntersectCharacter
+	const int NumCharacters = pGameWorld->UpdateSweepCharacters();
+	vec2 aCharacterPos[MAX_CLIENTS];
+	float aCharacterRadius[MAX_CLIENTS];
+	for(int c = 0; c < NumCharacters; c++)
+	{
+		aCharacterPos[c] = pGameWorld->SweepCharacter(c)->GetPos();
+		aCharacterRadius[c] = pGameWorld->SweepCharacter(c)->GetProximityRadius();
+	}
+
+	CProjectile *apBatch[BATCH_SIZE];
+	float aPosX[BATCH_SIZE], aPosY[BATCH_SIZE], aDirX[BATCH_SIZE], aDirY[BATCH_SIZE];
+	float aCurv[BATCH_SIZE], aPrevTime[BATCH_SIZE], aCurTime[BATCH_SIZE];
+	float aPrevX[BATCH_SIZE], aPrevY[BATCH_SIZE], aCurX[BATCH_SIZE], aCurY[BATCH_SIZE];
+
+	CProjectile *pNext = (CProjectile *)pGameWorld->FindFirst(CGameWorld::ENTTYPE_PROJECTILE);
+	while(pNext)
+	{
+		int Num = 0;
+		for(; pNext && Num < BATCH_SIZE; pNext = (CProjectile *)pNext->TypeNext(), Num++)
+		{
+			int Type = pNext->m_Type >= 0 && pNext->m_Type < NUM_WEAPONS ? pNext->m_Type : NUM_WEAPONS;
+			apBatch[Num] = pNext;
+			aPosX[Num] = pNext->m_Pos.x;
+			aPosY[Num] = pNext->m_Pos.y;
+			aDirX[Num] = pNext->m_Direction.x;
+			aDirY[Num] = pNext->m_Direction.y;
+			aCurv[Num] = aCurvature[Type];
+			aPrevTime[Num] = (Tick-pNext->m_StartTick-1)/TickSpeed*aSpeed[Type];
+			aCurTime[Num] = (Tick-pNext->m_StartTick)/TickSpeed*aSpeed[Type];
+		}
+
+		// CalcPos for the whole batch, the same operations in the same order
+		for(int i = 0; i < Num; i++)
+		{
+			aPrevX[i] = aPosX[i] + aDirX[i]*aPrevTime[i];
+			aPrevY[i] = aPosY[i] + aDirY[i]*aPrevTime[i] + aCurv[i]/10000*(aPrevTime[i]*aPrevTime[i]);
+			aCurX[i] = aPosX[i] + aDirX[i]*aCurTime[i];
+			aCurY[i] = aPosY[i] + aDirY[i]*aCurTime[i] + aCurv[i]/10000*(aCurTime[i]*aCurTime[i]);
+		}
+
+		for(int i = 0; i < Num; i++)
+		{
+			CProjectile *pProj = apBatch[i];
+			pProj->m_SweepTick = Tick;
+			pProj->m_SweepPos = vec2(aCurX[i], aCurY[i]);
+			pProj->m_SweepPrevPos = vec2(aPrevX[i], aPrevY[i]);
+			pProj->m_SweepCollide = pCollision->IntersectLine(pProj->m_SweepPrevPos, pProj->m_SweepPos, &pProj->m_SweepCurPos, 0);
+
+			// characters close to the bounding box of the path, the margin covers the
+			// rounding of closest_point_on_line
+			const float Margin = 6.0f+1.0f;
+			vec2 Min = vec2(min(pProj->m_SweepPrevPos.x, pProj->m_SweepCurPos.x), min(pProj->m_SweepPrevPos.y, pProj->m_SweepCurPos.y));
+			vec2 Max = vec2(max(pProj->m_SweepPrevPos.x, pProj->m_SweepCurPos.x), max(pProj->m_SweepPrevPos.y, pProj->m_SweepCurPos.y));
+			int64 Mask = 0;
+			for(int c = 0; c < NumCharacters; c++)
+			{
+				float Reach = aCharacterRadius[c]+Margin;
+				if(aCharacterPos[c].x > Min.x-Reach && aCharacterPos[c].x < Max.x+Reach &&
+					aCharacterPos[c].y > Min.y-Reach && aCharacterPos[c].y < Max.y+Reach)
+					Mask |= (int64)1<<c;
+			}
+			pProj->m_SweepCharacters = Mask;
+		}
+	}
+}
+
 void CProjectile::Tick()
 {
-	float Pt = (Server()->Tick()-m_StartTick-1)/(float)Server()->TickSpeed();
-	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
-	vec2 PrevPos = GetPos(Pt);
-	vec2 CurPos = GetPos(Ct);
-	int Collide = GameServer()->Collision()->IntersectLine(PrevPos, CurPos, &CurPos, 0);
+	vec2 PrevPos, CurPos;
+	int Collide;
 	CCharacter *OwnerChar = GameServer()->GetPlayerChar(m_Owner);
-	CCharacter *TargetChr = GameWorld()->IntersectCharacter(PrevPos, CurPos, 6.0f, CurPos, OwnerChar);
+	CCharacter *TargetChr;
+	if(m_SweepTick == Server()->Tick())
+	{
+		PrevPos = m_SweepPrevPos;
+		CurPos = m_SweepCurPos;
+		Collide = m_SweepCollide;
+		TargetChr = GameWorld()->IntersectSweptCharacter(PrevPos, CurPos, 6.0f, CurPos, OwnerChar, m_SweepCharacters);
+	}
+	else
+	{
+		float Pt = (Server()->Tick()-m_StartTick-1)/(float)Server()->TickSpeed();
+		float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+		PrevPos = GetPos(Pt);
+		CurPos = GetPos(Ct);
+		Collide = GameServer()->Collision()->IntersectLine(PrevPos, CurPos, &CurPos, 0);
+		TargetChr = GameWorld()->IntersectCharacter(PrevPos, CurPos, 6.0f, CurPos, OwnerChar);
+	}
 
 	m_LifeSpan--;
 
@@ -110,9 +213,11 @@ void CProjectile::FillInfo(CNetObj_Projectile *pProj)
 
 void CProjectile::Snap(int SnappingClient)
 {
-	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+	vec2 Pos = m_SweepPos;
+	if(m_SweepTick != Server()->Tick())
+		Pos = GetPos((Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed());
 
-	if(NetworkClipped(SnappingClient, GetPos(Ct)))
+	if(NetworkClipped(SnappingClient, Pos))
 		return;
 
 	CNetObj_Projectile *pProj = static_cast<CNetObj_Projectile *>(Server()->SnapNewItem(NETOBJTYPE_PROJECTILE, GetID(), sizeof(CNetObj_Projectile)));
@@ -13,6 +13,8 @@ enum
 
 class CProjectile : public CEntity
 {
+	MACRO_ALLOC_SLAB(CGameWorld, CGameWorld::ENTTYPE_PROJECTILE)
+
 public:
 	CProjectile(CGameWorld *pGameWorld, int Type, int Owner, vec2 Pos, vec2 Dir, int Span,
 		int Damage, bool Explosive, float Force, int SoundImpact, int Weapon);
@@ -28,7 +30,21 @@ public:
 	virtual void TickPaused();
 	virtual void Snap(int SnappingClient);
 
+	// evaluates the paths of all projectiles of the world for this tick and
+	// tests them against the map and the characters in one pass. Tick and Snap
+	// use the results, they are the same as the ones of GetPos and IntersectLine
+	static void SweepAll(CGameWorld *pGameWorld);
+
 private:
+	// results of the sweep at m_SweepTick
+	int m_SweepTick;
+	vec2 m_SweepPos;
+	vec2 m_SweepPrevPos;
+	vec2 m_SweepCurPos; // m_SweepPos up to the first solid tile
+	int m_SweepCollide;
+	int64 m_SweepCharacters; // characters of the world's sweep list close to the path
+
+
 	vec2 m_Direction;
 	int m_LifeSpan;
 	int m_Owner;
@@ -11,6 +11,7 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 
 	m_pPrevTypeEntity = 0;
 	m_pNextTypeEntity = 0;
+	m_InsertSerial = 0;
 
 	m_ID = Server()->SnapNewID();
 	m_ObjType = ObjType;
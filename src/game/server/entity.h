@@ -14,8 +14,6 @@
 */
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
-
 private:
 	/* Friend classes */
 	friend class CGameWorld; // for entity list handling
@@ -25,6 +23,7 @@ private:
 
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	int m_InsertSerial; // when it was inserted into the world, 0 if it is not in the world
 
 	int m_ID;
 	int m_ObjType;
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/system.h>
+#include <engine/shared/config.h>
 #include "eventhandler.h"
 #include "gamecontext.h"
 #include "player.h"
@@ -11,28 +12,82 @@
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = 0;
+	m_MaxEvents = MIN_EVENTS;
+	m_pEvents = (CEvent *)mem_alloc(m_MaxEvents*sizeof(CEvent), 1);
+	m_pSorted = (int *)mem_alloc(m_MaxEvents*sizeof(int), 1);
+	m_pVisible = (unsigned *)mem_alloc(m_MaxEvents/32*sizeof(unsigned), 1);
+	m_DataSize = MIN_DATASIZE;
+	m_pData = (char *)mem_alloc(m_DataSize, 1);
+	m_NumDropped = 0;
+	m_TotalDropped = 0;
 	Clear();
 }
 
+CEventHandler::~CEventHandler()
+{
+	mem_free(m_pEvents);
+	mem_free(m_pSorted);
+	mem_free(m_pVisible);
+	mem_free(m_pData);
+}
+
 void CEventHandler::SetGameServer(CGameContext *pGameServer)
 {
 	m_pGameServer = pGameServer;
 }
 
+bool CEventHandler::Grow(int Size)
+{
+	if(m_NumEvents == m_MaxEvents)
+	{
+		if(m_MaxEvents == MAX_EVENTS)
+			return false;
+
+		m_MaxEvents *= 2;
+		CEvent *pEvents = (CEvent *)mem_alloc(m_MaxEvents*sizeof(CEvent), 1);
+		mem_copy(pEvents, m_pEvents, m_NumEvents*sizeof(CEvent));
+		mem_free(m_pEvents);
+		m_pEvents = pEvents;
+
+		// the index is rebuilt anyway
+		mem_free(m_pSorted);
+		m_pSorted = (int *)mem_alloc(m_MaxEvents*sizeof(int), 1);
+		mem_free(m_pVisible);
+		m_pVisible = (unsigned *)mem_alloc(m_MaxEvents/32*sizeof(unsigned), 1);
+	}
+
+	if(m_CurrentOffset+Size > m_DataSize)
+	{
+		int DataSize = m_DataSize;
+		while(m_CurrentOffset+Size > DataSize)
+			DataSize *= 2;
+		char *pData = (char *)mem_alloc(DataSize, 1);
+		mem_copy(pData, m_pData, m_CurrentOffset);
+		mem_free(m_pData);
+		m_pData = pData;
+		m_DataSize = DataSize;
+	}
+	return true;
+}
+
 void *CEventHandler::Create(int Type, int Size, int64 Mask)
 {
-	if(m_NumEvents == MAX_EVENTS)
-		return 0;
-	if(m_CurrentOffset+Size >= MAX_DATASIZE)
+	if((m_NumEvents == m_MaxEvents || m_CurrentOffset+Size > m_DataSize) && !Grow(Size))
+	{
+		m_NumDropped++;
 		return 0;
+	}
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
+	void *p = &m_pData[m_CurrentOffset];
+	CEvent *pEvent = &m_pEvents[m_NumEvents];
+	pEvent->m_Offset = m_CurrentOffset;
+	pEvent->m_Type = Type;
+	pEvent->m_Tick = GameServer()->Server()->Tick();
+	pEvent->m_Size = Size;
+	pEvent->m_ClientMask = Mask;
 	m_CurrentOffset += Size;
 	m_NumEvents++;
+	m_Indexed = false;
 	return p;
 }
 
@@ -40,21 +95,125 @@ void CEventHandler::Clear()
 {
 	m_NumEvents = 0;
 	m_CurrentOffset = 0;
+	m_NumDropped = 0;
+	m_Indexed = false;
 }
 
-void CEventHandler::Snap(int SnappingClient)
+void CEventHandler::Expire(int Tick)
+{
+	if(m_NumDropped && m_pGameServer->Config()->m_Debug)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "dropped %d events this round, %lld since start", m_NumDropped, m_TotalDropped+m_NumDropped);
+		m_pGameServer->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "events", aBuf);
+	}
+	m_TotalDropped += m_NumDropped;
+	m_NumDropped = 0;
+
+	// the events are in creation order, move the ones to keep to the front
+	int First = 0;
+	while(First < m_NumEvents && m_pEvents[First].m_Tick <= Tick)
+		First++;
+	if(First == 0)
+		return;
+	if(First == m_NumEvents)
+	{
+		Clear();
+		return;
+	}
+
+	const int Offset = m_pEvents[First].m_Offset;
+	m_NumEvents -= First;
+	m_CurrentOffset -= Offset;
+	mem_move(m_pEvents, &m_pEvents[First], m_NumEvents*sizeof(CEvent));
+	mem_move(m_pData, &m_pData[Offset], m_CurrentOffset);
+	for(int i = 0; i < m_NumEvents; i++)
+		m_pEvents[i].m_Offset -= Offset;
+	m_Indexed = false;
+}
+
+int CEventHandler::Cell(float Pos)
 {
+	return (int)floorf(Pos) >> CELL_SHIFT;
+}
+
+void CEventHandler::BuildIndex()
+{
+	// counting sort by bucket, keeps the creation order inside of a bucket
+	mem_zero(m_aBucketStart, sizeof(m_aBucketStart));
 	for(int i = 0; i < m_NumEvents; i++)
 	{
-		if(SnappingClient == -1 || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		CEvent *pEvent = &m_pEvents[i];
+		const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+		pEvent->m_CellX = Cell(pCommon->m_X);
+		pEvent->m_CellY = Cell(pCommon->m_Y);
+		m_aBucketStart[Bucket(pEvent->m_CellX, pEvent->m_CellY)+1]++;
+	}
+	for(int b = 0; b < NUM_BUCKETS; b++)
+		m_aBucketStart[b+1] += m_aBucketStart[b];
+
+	int aFill[NUM_BUCKETS];
+	mem_copy(aFill, m_aBucketStart, sizeof(aFill));
+	for(int i = 0; i < m_NumEvents; i++)
+		m_pSorted[aFill[Bucket(m_pEvents[i].m_CellX, m_pEvents[i].m_CellY)]++] = i;
+
+	m_Indexed = true;
+}
+
+void CEventHandler::SnapEvent(int Index)
+{
+	const CEvent *pEvent = &m_pEvents[Index];
+	void *d = GameServer()->Server()->SnapNewItem(pEvent->m_Type, Index, pEvent->m_Size);
+	if(d)
+		mem_copy(d, &m_pData[pEvent->m_Offset], pEvent->m_Size);
+}
+
+void CEventHandler::Snap(int SnappingClient)
+{
+	const int SinceTick = GameServer()->SnapEventTick(SnappingClient);
+	if(SnappingClient == -1)
+	{
+		for(int i = 0; i < m_NumEvents; i++)
+			if(m_pEvents[i].m_Tick > SinceTick)
+				SnapEvent(i);
+		return;
+	}
+
+	if(!m_NumEvents)
+		return;
+	if(!m_Indexed)
+		BuildIndex();
+
+	const float Range = 1500.0f;
+	const vec2 ViewPos = GameServer()->m_apPlayers[SnappingClient]->m_ViewPos;
+	const int MinX = Cell(ViewPos.x-Range), MaxX = Cell(ViewPos.x+Range);
+	const int MinY = Cell(ViewPos.y-Range), MaxY = Cell(ViewPos.y+Range);
+
+	// mark the visible events first so they are snapped in creation order
+	const int NumWords = (m_NumEvents+31)/32;
+	mem_zero(m_pVisible, NumWords*sizeof(unsigned));
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < 1500.0f)
+			const int b = Bucket(x, y);
+			for(int s = m_aBucketStart[b]; s < m_aBucketStart[b+1]; s++)
 			{
-				void *d = GameServer()->Server()->SnapNewItem(m_aTypes[i], i, m_aSizes[i]);
-				if(d)
-					mem_copy(d, &m_aData[m_aOffsets[i]], m_aSizes[i]);
+				const int i = m_pSorted[s];
+				const CEvent *pEvent = &m_pEvents[i];
+				if(pEvent->m_CellX != x || pEvent->m_CellY != y || pEvent->m_Tick <= SinceTick || !CmaskIsSet(pEvent->m_ClientMask, SnappingClient))
+					continue;
+				const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+				if(distance(ViewPos, vec2(pCommon->m_X, pCommon->m_Y)) < Range)
+					m_pVisible[i>>5] |= 1u<<(i&31);
 			}
 		}
-	}
+
+	for(int w = 0; w < NumWords; w++)
+		for(unsigned Bits = m_pVisible[w]; Bits; Bits &= Bits-1)
+		{
+			int Bit = 0;
+			while(!(Bits&(1u<<Bit)))
+				Bit++;
+			SnapEvent(w*32+Bit);
+		}
 }
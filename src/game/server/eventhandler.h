@@ -3,30 +3,72 @@
 #ifndef GAME_SERVER_EVENTHANDLER_H
 #define GAME_SERVER_EVENTHANDLER_H
 
-//
+// events of the last snapshot rounds. the buffers grow with big fights, at the
+// first snap of a round the events get sorted into a grid so that a client only
+// looks at the events close to its view. a client gets the events created since
+// its last snapshot, so the ones of the rounds it skipped are kept until it is
+// snapped again
 class CEventHandler
 {
-	static const int MAX_EVENTS = 128;
-	static const int MAX_DATASIZE = 128*64;
+	enum
+	{
+		MIN_EVENTS = 128,
+		MAX_EVENTS = 4096, // beyond that events are dropped, the snapshot could not hold them anyway
+		MIN_DATASIZE = 128*64,
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	int64 m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+		CELL_SHIFT = 10, // 1024 units
+		NUM_BUCKETS = 256, // cells are hashed into the buckets
+	};
+
+	struct CEvent
+	{
+		int m_Type;
+		int m_Tick;
+		int m_Offset;
+		int m_Size;
+		int m_CellX;
+		int m_CellY;
+		int64 m_ClientMask;
+	};
+
+	CEvent *m_pEvents;
+	int m_MaxEvents;
+	char *m_pData;
+	int m_DataSize;
+
+	// events sorted by bucket, the ones of bucket b are m_pSorted[m_aBucketStart[b]] to m_pSorted[m_aBucketStart[b+1]]
+	int *m_pSorted;
+	int m_aBucketStart[NUM_BUCKETS+1];
+	bool m_Indexed;
+
+	// events a client sees, in the order they were created
+	unsigned *m_pVisible;
 
 	class CGameContext *m_pGameServer;
 
 	int m_CurrentOffset;
 	int m_NumEvents;
+	int m_NumDropped;
+	int64 m_TotalDropped;
+
+	static int Cell(float Pos);
+	static int Bucket(int CellX, int CellY) { return ((unsigned)CellX*73856093u ^ (unsigned)CellY*19349663u) & (NUM_BUCKETS-1); }
+	bool Grow(int Size);
+	void BuildIndex();
+	void SnapEvent(int Index);
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	void SetGameServer(CGameContext *pGameServer);
 
 	CEventHandler();
+	~CEventHandler();
 	void *Create(int Type, int Size, int64 Mask = -1);
 	void Clear();
+	void Expire(int Tick); // drops the events created up to the tick
 	void Snap(int SnappingClient);
+
+	// events that did not fit since the server started
+	int64 NumDropped() const { return m_TotalDropped; }
 };
 
 #endif
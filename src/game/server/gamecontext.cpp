@@ -43,6 +43,7 @@ void CGameContext::Construct(int Resetting)
 	m_pVoteOptionLast = 0;
 	m_NumVoteOptions = 0;
 	m_LockTeams = 0;
+	m_LastSnapTick = -1;
 
 	if(Resetting==NO_RESET)
 		m_pVoteOptionHeap = new CHeap();
@@ -87,6 +88,22 @@ void CGameContext::Clear()
 }
 
 
+void *CGameContext::AllocPlayer(int Size)
+{
+	if(m_PlayerPool.ObjectSize() == 0)
+		m_PlayerPool.Init(Size);
+	return m_PlayerPool.Alloc();
+}
+
+int CGameContext::SnapEventTick(int SnappingClient)
+{
+	// the demo is recorded every round
+	if(SnappingClient == -1)
+		return m_LastSnapTick;
+	// older events are expired already
+	return max(m_apPlayers[SnappingClient]->m_LastSnapTick, m_LastSnapTick-Server()->MaxSnapshotDelay());
+}
+
 class CCharacter *CGameContext::GetPlayerChar(int ClientID)
 {
 	if(ClientID < 0 || ClientID >= MAX_CLIENTS || !m_apPlayers[ClientID])
@@ -713,7 +730,7 @@ void CGameContext::OnClientConnected(int ClientID, bool Dummy, bool AsSpec)
 {
 	dbg_assert(!m_apPlayers[ClientID], "non-free player slot");
 
-	m_apPlayers[ClientID] = new(ClientID) CPlayer(this, ClientID, Dummy, AsSpec);
+	m_apPlayers[ClientID] = new(this) CPlayer(this, ClientID, Dummy, AsSpec);
 
 	if(Dummy)
 		return;
@@ -1564,7 +1581,8 @@ void CGameContext::OnInit()
 	for(int i = 0; i < OLD_NUM_NETOBJTYPES; i++)
 		Server()->SnapSetStaticsize(i, m_NetObjHandler.GetObjSize(i));
 
-	m_Layers.Init(Kernel());
+	// the server never renders, leave the design layers compressed
+	m_Layers.Init(Kernel(), 0, false);
 	m_Collision.Init(&m_Layers);
 
 	// select gametype
@@ -1658,12 +1676,17 @@ void CGameContext::OnSnap(int ClientID)
 		if(m_apPlayers[i])
 			m_apPlayers[i]->Snap(ClientID);
 	}
+
+	if(ClientID != -1)
+		m_apPlayers[ClientID]->m_LastSnapTick = Server()->Tick();
 }
 void CGameContext::OnPreSnap() {}
 void CGameContext::OnPostSnap()
 {
 	m_World.PostSnap();
-	m_Events.Clear();
+	// keep the events for the clients that skipped this round
+	m_Events.Expire(Server()->Tick()-Server()->MaxSnapshotDelay());
+	m_LastSnapTick = Server()->Tick();
 }
 
 bool CGameContext::IsClientBot(int ClientID) const
@@ -1686,10 +1709,32 @@ bool CGameContext::IsClientSpectator(int ClientID) const
 	return m_apPlayers[ClientID] && m_apPlayers[ClientID]->GetTeam() == TEAM_SPECTATORS;
 }
 
+bool CGameContext::IsClientAlive(int ClientID) const
+{
+	return m_apPlayers[ClientID] && m_apPlayers[ClientID]->GetCharacter();
+}
+
 const char *CGameContext::GameType() const { return m_pController && m_pController->GetGameType() ? m_pController->GetGameType() : ""; }
 const char *CGameContext::Version() const { return GAME_VERSION; }
 const char *CGameContext::NetVersion() const { return GAME_NETVERSION; }
 const char *CGameContext::NetVersionHashUsed() const { return GAME_NETVERSION_HASH_FORCED; }
 const char *CGameContext::NetVersionHashReal() const { return GAME_NETVERSION_HASH; }
+const char *CGameContext::GetItemName(int Type) const { return m_NetObjHandler.GetObjName(Type); }
+
+int CGameContext::GetTuning(void *pData, int MaxSize) const
+{
+	if(MaxSize < (int)sizeof(m_Tuning))
+		return 0;
+	mem_copy(pData, &m_Tuning, sizeof(m_Tuning));
+	return sizeof(m_Tuning);
+}
+
+void CGameContext::SetTuning(const void *pData, int Size)
+{
+	if(Size != (int)sizeof(m_Tuning))
+		return;
+	mem_copy(&m_Tuning, pData, sizeof(m_Tuning));
+	SendTuningParams(-1);
+}
 
 IGameServer *CreateGameServer() { return new CGameContext; }
@@ -43,6 +43,8 @@ class CGameContext : public IGameServer
 	CCollision m_Collision;
 	CNetObjHandler m_NetObjHandler;
 	CTuningParams m_Tuning;
+	CSlabPool m_PlayerPool;
+	int m_LastSnapTick; // tick of the last snapshot round
 
 	static void ConTuneParam(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneReset(IConsole::IResult *pResult, void *pUserData);
@@ -88,6 +90,12 @@ public:
 	CEventHandler m_Events;
 	class CPlayer *m_apPlayers[MAX_CLIENTS];
 
+	// events created after this tick are not in a snapshot of the client yet
+	int SnapEventTick(int SnappingClient);
+
+	// memory of the players, see CPlayer::operator new
+	void *AllocPlayer(int Size);
+
 	class IGameController *m_pController;
 	CGameWorld m_World;
 	CCommandManager m_CommandManager;
@@ -188,12 +196,16 @@ public:
 	virtual bool IsClientReady(int ClientID) const;
 	virtual bool IsClientPlayer(int ClientID) const;
 	virtual bool IsClientSpectator(int ClientID) const;
+	virtual bool IsClientAlive(int ClientID) const;
 
 	virtual const char *GameType() const;
 	virtual const char *Version() const;
 	virtual const char *NetVersion() const;
 	virtual const char *NetVersionHashUsed() const;
 	virtual const char *NetVersionHashReal() const;
+	virtual const char *GetItemName(int Type) const;
+	virtual int GetTuning(void *pData, int MaxSize) const;
+	virtual void SetTuning(const void *pData, int Size);
 };
 
 inline int64 CmaskAll() { return -1; }
@@ -302,7 +302,7 @@ bool IGameController::OnEntity(int Index, vec2 Pos)
 
 	if(Type != -1)
 	{
-		new CPickup(&GameServer()->m_World, Type, Pos);
+		new(&GameServer()->m_World) CPickup(&GameServer()->m_World, Type, Pos);
 		return true;
 	}
 
@@ -80,7 +80,7 @@ bool CGameControllerCTF::OnEntity(int Index, vec2 Pos)
 	if(Team == -1 || m_apFlags[Team])
 		return false;
 
-	CFlag *F = new CFlag(&GameServer()->m_World, Team, Pos);
+	CFlag *F = new(&GameServer()->m_World) CFlag(&GameServer()->m_World, Team, Pos);
 	m_apFlags[Team] = F;
 	return true;
 }
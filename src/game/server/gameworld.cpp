@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
 #include "entities/character.h"
+#include "entities/projectile.h"
 #include "entity.h"
 #include "gamecontext.h"
 #include "gamecontroller.h"
@@ -21,6 +22,11 @@ CGameWorld::CGameWorld()
 	m_ResetRequested = false;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 		m_apFirstEntityTypes[i] = 0;
+
+	m_InsertSerial = 0;
+	m_NumSweepCharacters = 0;
+	m_SweepCharacterVersion = -1;
+	m_CharacterVersion = 0;
 }
 
 CGameWorld::~CGameWorld()
@@ -38,6 +44,23 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pServer = m_pGameServer->Server();
 }
 
+void *CGameWorld::AllocObject(int Type, int Size)
+{
+	CSlabPool *pPool = &m_aEntityPools[Type];
+	if(pPool->ObjectSize() == 0)
+		pPool->Init(Size);
+	dbg_assert(pPool->ObjectSize() == Size, "entity classes of one type must have the same size");
+	return pPool->Alloc();
+}
+
+CEntity *CGameWorld::SlotEntity(int Type, int Slot, int Serial) const
+{
+	CEntity *pEnt = (CEntity *)m_aEntityPools[Type].Object(Slot);
+	if(!pEnt || pEnt->m_InsertSerial == 0 || pEnt->m_InsertSerial > Serial)
+		return 0;
+	return pEnt;
+}
+
 CEntity *CGameWorld::FindFirst(int Type)
 {
 	return Type < 0 || Type >= NUM_ENTTYPES ? 0 : m_apFirstEntityTypes[Type];
@@ -71,12 +94,16 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 		dbg_assert(pCur != pEnt, "err");
 #endif
 
+	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
+		m_CharacterVersion++;
+
 	// insert it
 	if(m_apFirstEntityTypes[pEnt->m_ObjType])
 		m_apFirstEntityTypes[pEnt->m_ObjType]->m_pPrevTypeEntity = pEnt;
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = 0x0;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+	pEnt->m_InsertSerial = ++m_InsertSerial;
 }
 
 void CGameWorld::DestroyEntity(CEntity *pEnt)
@@ -90,6 +117,9 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	if(!pEnt->m_pNextTypeEntity && !pEnt->m_pPrevTypeEntity && m_apFirstEntityTypes[pEnt->m_ObjType] != pEnt)
 		return;
 
+	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
+		m_CharacterVersion++;
+
 	// remove
 	if(pEnt->m_pPrevTypeEntity)
 		pEnt->m_pPrevTypeEntity->m_pNextTypeEntity = pEnt->m_pNextTypeEntity;
@@ -104,29 +134,26 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = 0;
 	pEnt->m_pPrevTypeEntity = 0;
+	pEnt->m_InsertSerial = 0;
 }
 
 //
 void CGameWorld::Snap(int SnappingClient)
 {
+	const int Serial = m_InsertSerial;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
-			pEnt = m_pNextTraverseEntity;
-		}
+		for(int Slot = 0; Slot < m_aEntityPools[i].NumSlots(); Slot++)
+			if(CEntity *pEnt = SlotEntity(i, Slot, Serial))
+				pEnt->Snap(SnappingClient);
 }
 
 void CGameWorld::PostSnap()
 {
+	const int Serial = m_InsertSerial;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->PostSnap();
-			pEnt = m_pNextTraverseEntity;
-		}
+		for(int Slot = 0; Slot < m_aEntityPools[i].NumSlots(); Slot++)
+			if(CEntity *pEnt = SlotEntity(i, Slot, Serial))
+				pEnt->PostSnap();
 }
 
 void CGameWorld::Reset()
@@ -171,38 +198,53 @@ void CGameWorld::Tick()
 	if(m_Paused || GameServer()->m_pController->IsGamePaused())
 	{
 		// update all objects
+		const int Serial = m_InsertSerial;
 		for(int i = 0; i < NUM_ENTTYPES; i++)
-			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-			{
-				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-				pEnt->TickPaused();
-				pEnt = m_pNextTraverseEntity;
-			}
+			for(int Slot = 0; Slot < m_aEntityPools[i].NumSlots(); Slot++)
+				if(CEntity *pEnt = SlotEntity(i, Slot, Serial))
+					pEnt->TickPaused();
 	}
 	else
 	{
+		// projectiles tick first, nothing moved yet
+		if(m_apFirstEntityTypes[ENTTYPE_PROJECTILE])
+			CProjectile::SweepAll(this);
+
 		// update all objects
+		int Serial = m_InsertSerial;
 		for(int i = 0; i < NUM_ENTTYPES; i++)
-			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-			{
-				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-				pEnt->Tick();
-				pEnt = m_pNextTraverseEntity;
-			}
+			for(int Slot = 0; Slot < m_aEntityPools[i].NumSlots(); Slot++)
+				if(CEntity *pEnt = SlotEntity(i, Slot, Serial))
+					pEnt->Tick();
 
+		Serial = m_InsertSerial;
 		for(int i = 0; i < NUM_ENTTYPES; i++)
-			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-			{
-				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-				pEnt->TickDefered();
-				pEnt = m_pNextTraverseEntity;
-			}
+			for(int Slot = 0; Slot < m_aEntityPools[i].NumSlots(); Slot++)
+				if(CEntity *pEnt = SlotEntity(i, Slot, Serial))
+					pEnt->TickDefered();
 	}
 
 	RemoveEntities();
 }
 
 
+// a character only replaces the closest one so far if it is strictly closer, the list order decides ties
+static inline void IntersectCharacterTest(CCharacter *p, vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, float &ClosestLen, CCharacter *&pClosest)
+{
+	vec2 IntersectPos = closest_point_on_line(Pos0, Pos1, p->GetPos());
+	float Len = distance(p->GetPos(), IntersectPos);
+	if(Len < p->GetProximityRadius()+Radius)
+	{
+		Len = distance(Pos0, IntersectPos);
+		if(Len < ClosestLen)
+		{
+			NewPos = IntersectPos;
+			ClosestLen = Len;
+			pClosest = p;
+		}
+	}
+}
+
 // TODO: should be more general
 CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis)
 {
@@ -216,23 +258,42 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 		if(p == pNotThis)
 			continue;
 
-		vec2 IntersectPos = closest_point_on_line(Pos0, Pos1, p->m_Pos);
-		float Len = distance(p->m_Pos, IntersectPos);
-		if(Len < p->m_ProximityRadius+Radius)
-		{
-			Len = distance(Pos0, IntersectPos);
-			if(Len < ClosestLen)
-			{
-				NewPos = IntersectPos;
-				ClosestLen = Len;
-				pClosest = p;
-			}
-		}
+		IntersectCharacterTest(p, Pos0, Pos1, Radius, NewPos, ClosestLen, pClosest);
+	}
+
+	return pClosest;
+}
+
+CCharacter *CGameWorld::IntersectSweptCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis, int64 Mask)
+{
+	// a character died since the sweep
+	if(m_SweepCharacterVersion != m_CharacterVersion)
+		return IntersectCharacter(Pos0, Pos1, Radius, NewPos, pNotThis);
+
+	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
+	CCharacter *pClosest = 0;
+
+	for(int i = 0; i < m_NumSweepCharacters; i++)
+	{
+		if(!(Mask&((int64)1<<i)) || m_apSweepCharacters[i] == pNotThis)
+			continue;
+
+		IntersectCharacterTest(m_apSweepCharacters[i], Pos0, Pos1, Radius, NewPos, ClosestLen, pClosest);
 	}
 
 	return pClosest;
 }
 
+int CGameWorld::UpdateSweepCharacters()
+{
+	m_NumSweepCharacters = 0;
+	CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER];
+	for(; pEnt && m_NumSweepCharacters < MAX_CLIENTS; pEnt = pEnt->m_pNextTypeEntity)
+		m_apSweepCharacters[m_NumSweepCharacters++] = (CCharacter *)pEnt;
+	m_SweepCharacterVersion = pEnt ? -1 : m_CharacterVersion;
+	return m_NumSweepCharacters;
+}
+
 
 CEntity *CGameWorld::ClosestEntity(vec2 Pos, float Radius, int Type, CEntity *pNotThis)
 {
@@ -5,6 +5,8 @@
 
 #include <game/gamecore.h>
 
+#include "alloc.h"
+
 class CEntity;
 class CCharacter;
 
@@ -33,6 +35,22 @@ private:
 	CEntity *m_pNextTraverseEntity;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// one pool per entity type. tick and snap walk the pools in slot order, so the
+	// entities are visited in memory order
+	CSlabPool m_aEntityPools[NUM_ENTTYPES];
+	int m_InsertSerial;
+
+	// the entity in a slot, if it was in the world before the walk started at Serial.
+	// like a walk of the list it skips the entities inserted meanwhile
+	CEntity *SlotEntity(int Type, int Slot, int Serial) const;
+
+	// the characters in list order at the last projectile sweep, only valid as
+	// long as no character was inserted or removed since
+	CCharacter *m_apSweepCharacters[MAX_CLIENTS];
+	int m_NumSweepCharacters;
+	int m_SweepCharacterVersion;
+	int m_CharacterVersion;
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -51,6 +69,9 @@ public:
 
 	void SetGameServer(CGameContext *pGameServer);
 
+	// memory of the entities, see MACRO_ALLOC_SLAB
+	void *AllocObject(int Type, int Size);
+
 	CEntity *FindFirst(int Type);
 
 	/*
@@ -101,6 +122,17 @@ public:
 	*/
 	class CCharacter *IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, class CEntity *pNotThis = 0);
 
+	/*
+		Function: IntersectSweptCharacter
+			Same as IntersectCharacter, but only tests the characters
+			of the sweep list that are set in the mask.
+	*/
+	class CCharacter *IntersectSweptCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, class CEntity *pNotThis, int64 Mask);
+
+	// takes the current characters as the sweep list
+	int UpdateSweepCharacters();
+	class CCharacter *SweepCharacter(int Index) const { return m_apSweepCharacters[Index]; }
+
 	/*
 		Function: insert_entity
 			Adds an entity to the world.
@@ -8,7 +8,20 @@
 #include "player.h"
 
 
-MACRO_ALLOC_POOL_ID_IMPL(CPlayer, MAX_CLIENTS)
+void *CPlayer::operator new(size_t Size, CGameContext *pGameServer)
+{
+	return pGameServer->AllocPlayer(Size);
+}
+
+void CPlayer::operator delete(void *pPtr, CGameContext *pGameServer)
+{
+	CSlabPool::Free(pPtr);
+}
+
+void CPlayer::operator delete(void *pPtr)
+{
+	CSlabPool::Free(pPtr);
+}
 
 IServer *CPlayer::Server() const { return m_pGameServer->Server(); }
 
@@ -18,6 +31,7 @@ CPlayer::CPlayer(CGameContext *pGameServer, int ClientID, bool Dummy, bool AsSpe
 	m_RespawnTick = Server()->Tick();
 	m_DieTick = Server()->Tick();
 	m_ScoreStartTick = Server()->Tick();
+	m_LastSnapTick = Server()->Tick();
 	m_pCharacter = 0;
 	m_ClientID = ClientID;
 	m_Team = AsSpec ? TEAM_SPECTATORS : GameServer()->m_pController->GetStartTeam();
@@ -466,7 +480,7 @@ void CPlayer::TryRespawn()
 		return;
 
 	m_Spawning = false;
-	m_pCharacter = new(m_ClientID) CCharacter(&GameServer()->m_World);
+	m_pCharacter = new(&GameServer()->m_World) CCharacter(&GameServer()->m_World);
 	m_pCharacter->Spawn(this, SpawnPos);
 	GameServer()->CreatePlayerSpawn(SpawnPos);
 }
@@ -16,9 +16,12 @@ enum
 // player object
 class CPlayer
 {
-	MACRO_ALLOC_POOL_ID()
-
 public:
+	// players live in a slab pool of their game context
+	void *operator new(size_t Size, CGameContext *pGameServer);
+	void operator delete(void *pPtr, CGameContext *pGameServer);
+	void operator delete(void *pPtr);
+
 	CPlayer(CGameContext *pGameServer, int ClientID, bool Dummy, bool AsSpec = false);
 	~CPlayer();
 
@@ -45,6 +48,7 @@ public:
 	//---------------------------------------------------------
 	// this is used for snapping so we know how we can clip the view for the player
 	vec2 m_ViewPos;
+	int m_LastSnapTick; // the events after it are still to be sent, see CGameContext::SnapEventTick
 
 	// states if the client is chatting, accessing a menu etc.
 	int m_PlayerFlags;
@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 
 #include <engine/config.h>
@@ -17,9 +18,14 @@
 enum {
 	MTU = 1400,
 	MAX_SERVERS_PER_PACKET=75,
-	MAX_PACKETS=16,
+	MAX_PACKETS=256,
 	MAX_SERVERS=MAX_SERVERS_PER_PACKET*MAX_PACKETS,
-	EXPIRE_TIME = 90
+	EXPIRE_TIME = 90,
+
+	// open addressing, kept at most ~60% full
+	HASH_SIZE = 1<<15,
+	// one slot per second, must span more than EXPIRE_TIME
+	EXPIRE_SLOTS = 128,
 };
 
 struct CCheckServer
@@ -35,19 +41,28 @@ struct CCheckServer
 static CCheckServer m_aCheckServers[MAX_SERVERS];
 static int m_NumCheckServers = 0;
 
+// servers are kept dense, server i is entry i%MAX_SERVERS_PER_PACKET of
+// list packet i/MAX_SERVERS_PER_PACKET so the packets never have to be rebuilt
 struct CServerEntry
 {
 	enum ServerType m_Type;
 	NETADDR m_Address;
 	int64 m_Expire;
+
+	// list of the servers expiring in the same second
+	int m_ExpireSlot;
+	int m_ExpirePrev;
+	int m_ExpireNext;
 };
 
 static CServerEntry m_aServers[MAX_SERVERS];
 static int m_NumServers = 0;
 
+static int m_aExpireSlots[EXPIRE_SLOTS]; // first server, -1 if empty
+static int64 m_ExpireSecond = 0; // first second not fully purged yet
+
 struct CPacketData
 {
-	int m_Size;
 	struct {
 		unsigned char m_aHeader[sizeof(SERVERBROWSE_LIST)];
 		CMastersrvAddr m_aServers[MAX_SERVERS_PER_PACKET];
@@ -55,7 +70,6 @@ struct CPacketData
 };
 
 CPacketData m_aPackets[MAX_PACKETS];
-static int m_NumPackets = 0;
 
 
 struct CCountPacketData
@@ -75,58 +89,212 @@ static CNetClient m_NetOp; // main
 
 IConsole *m_pConsole;
 
-void BuildPackets()
+// finds entries of a dense array by their address, the array removes
+// entries by moving its last one into the gap. several entries may have
+// the same address, Find returns one of them
+class CAddrIndex
 {
-	CServerEntry *pCurrent = &m_aServers[0];
-	int ServersLeft = m_NumServers;
-	m_NumPackets = 0;
-	int PacketIndex = 0;
-	while(ServersLeft-- && m_NumPackets < MAX_PACKETS)
+public:
+	typedef const NETADDR *(*FGetAddress)(int Index);
+
+	void Init(FGetAddress pfnGetAddress)
+	{
+		m_pfnGetAddress = pfnGetAddress;
+		for(int i = 0; i < HASH_SIZE; i++)
+			m_aSlots[i] = -1;
+	}
+
+	int Find(const NETADDR *pAddr) const
+	{
+		int Slot = FindSlot(pAddr);
+		return Slot == -1 ? -1 : m_aSlots[Slot];
+	}
+
+	void Insert(int Index)
+	{
+		unsigned Slot = Hash(m_pfnGetAddress(Index));
+		while(m_aSlots[Slot] != -1)
+			Slot = (Slot+1)&(HASH_SIZE-1);
+		m_aSlots[Slot] = Index;
+	}
+
+	void Remove(int Index)
 	{
-		if(pCurrent->m_Type == SERVERTYPE_NORMAL)
+		unsigned Slot = IndexSlot(Index, m_pfnGetAddress(Index));
+
+		// shift the following entries back so no probe sequence gets broken
+		unsigned Next = Slot;
+		while(1)
 		{
-			if(PacketIndex % MAX_SERVERS_PER_PACKET == 0)
+			Next = (Next+1)&(HASH_SIZE-1);
+			if(m_aSlots[Next] == -1)
+				break;
+			unsigned Home = Hash(m_pfnGetAddress(m_aSlots[Next]));
+			if(((Next-Home)&(HASH_SIZE-1)) >= ((Next-Slot)&(HASH_SIZE-1)))
 			{
-				PacketIndex = 0;
-				m_NumPackets++;
+				m_aSlots[Slot] = m_aSlots[Next];
+				Slot = Next;
 			}
+		}
+		m_aSlots[Slot] = -1;
+	}
 
-			// copy header
-			mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+	// entry From was copied to To
+	void Move(int From, int To)
+	{
+		m_aSlots[IndexSlot(From, m_pfnGetAddress(To))] = To;
+	}
 
-			// copy server addresses
-			if(pCurrent->m_Address.type == NETTYPE_IPV6)
-			{
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, pCurrent->m_Address.ip,
-					sizeof(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp));
-			}
-			else
-			{
-				static unsigned char s_aIPV4Mapping[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF};
+private:
+	FGetAddress m_pfnGetAddress;
+	int m_aSlots[HASH_SIZE]; // entry index, -1 if empty
 
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, s_aIPV4Mapping, sizeof(s_aIPV4Mapping));
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[12] = pCurrent->m_Address.ip[0];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[13] = pCurrent->m_Address.ip[1];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[14] = pCurrent->m_Address.ip[2];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[15] = pCurrent->m_Address.ip[3];
-			}
+	static unsigned Hash(const NETADDR *pAddr)
+	{
+		// fnv-1a over the parts net_addr_comp looks at
+		unsigned Hash = 2166136261u;
+		Hash = (Hash^pAddr->type)*16777619u;
+		const int IpSize = pAddr->type == NETTYPE_IPV4 ? NETADDR_SIZE_IPV4 : (int)sizeof(pAddr->ip);
+		for(int i = 0; i < IpSize; i++)
+			Hash = (Hash^pAddr->ip[i])*16777619u;
+		Hash = (Hash^(pAddr->port&0xff))*16777619u;
+		Hash = (Hash^(pAddr->port>>8))*16777619u;
+		return Hash&(HASH_SIZE-1);
+	}
+
+	int FindSlot(const NETADDR *pAddr) const
+	{
+		for(unsigned Slot = Hash(pAddr); m_aSlots[Slot] != -1; Slot = (Slot+1)&(HASH_SIZE-1))
+		{
+			if(net_addr_comp(m_pfnGetAddress(m_aSlots[Slot]), pAddr, true) == 0)
+				return Slot;
+		}
+		return -1;
+	}
 
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[0] = (pCurrent->m_Address.port>>8)&0xff;
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[1] = pCurrent->m_Address.port&0xff;
+	// the slot of the entry, found by the address it was inserted with
+	int IndexSlot(int Index, const NETADDR *pAddr) const
+	{
+		unsigned Slot = Hash(pAddr);
+		while(m_aSlots[Slot] != Index)
+			Slot = (Slot+1)&(HASH_SIZE-1);
+		return Slot;
+	}
+};
 
-			PacketIndex++;
+static CAddrIndex m_ServerIndex;
+static CAddrIndex m_CheckServerIndex;
+static CAddrIndex m_CheckServerAltIndex;
 
-			m_aPackets[m_NumPackets-1].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr)*PacketIndex;
+static const NETADDR *ServerAddress(int Index) { return &m_aServers[Index].m_Address; }
+static const NETADDR *CheckServerAddress(int Index) { return &m_aCheckServers[Index].m_Address; }
+static const NETADDR *CheckServerAltAddress(int Index) { return &m_aCheckServers[Index].m_AltAddress; }
 
-			pCurrent++;
-		}
+static void ExpireLink(int Index)
+{
+	CServerEntry *pEntry = &m_aServers[Index];
+	pEntry->m_ExpireSlot = (pEntry->m_Expire/time_freq())%EXPIRE_SLOTS;
+	pEntry->m_ExpirePrev = -1;
+	pEntry->m_ExpireNext = m_aExpireSlots[pEntry->m_ExpireSlot];
+	if(pEntry->m_ExpireNext != -1)
+		m_aServers[pEntry->m_ExpireNext].m_ExpirePrev = Index;
+	m_aExpireSlots[pEntry->m_ExpireSlot] = Index;
+}
+
+static void ExpireUnlink(int Index)
+{
+	CServerEntry *pEntry = &m_aServers[Index];
+	if(pEntry->m_ExpirePrev != -1)
+		m_aServers[pEntry->m_ExpirePrev].m_ExpireNext = pEntry->m_ExpireNext;
+	else
+		m_aExpireSlots[pEntry->m_ExpireSlot] = pEntry->m_ExpireNext;
+	if(pEntry->m_ExpireNext != -1)
+		m_aServers[pEntry->m_ExpireNext].m_ExpirePrev = pEntry->m_ExpirePrev;
+}
+
+static void WritePacketEntry(int Index)
+{
+	const NETADDR *pAddr = &m_aServers[Index].m_Address;
+	CMastersrvAddr *pOut = &m_aPackets[Index/MAX_SERVERS_PER_PACKET].m_Data.m_aServers[Index%MAX_SERVERS_PER_PACKET];
+
+	if(pAddr->type == NETTYPE_IPV6)
+	{
+		mem_copy(pOut->m_aIp, pAddr->ip, sizeof(pOut->m_aIp));
+	}
+	else
+	{
+		static unsigned char s_aIPV4Mapping[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF};
+
+		mem_copy(pOut->m_aIp, s_aIPV4Mapping, sizeof(s_aIPV4Mapping));
+		pOut->m_aIp[12] = pAddr->ip[0];
+		pOut->m_aIp[13] = pAddr->ip[1];
+		pOut->m_aIp[14] = pAddr->ip[2];
+		pOut->m_aIp[15] = pAddr->ip[3];
+	}
+
+	pOut->m_aPort[0] = (pAddr->port>>8)&0xff;
+	pOut->m_aPort[1] = pAddr->port&0xff;
+}
+
+static int NumPackets()
+{
+	return (m_NumServers+MAX_SERVERS_PER_PACKET-1)/MAX_SERVERS_PER_PACKET;
+}
+
+static int PacketSize(int Packet)
+{
+	int Num = min(m_NumServers-Packet*MAX_SERVERS_PER_PACKET, (int)MAX_SERVERS_PER_PACKET);
+	return sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr)*Num;
+}
+
+void InitServers()
+{
+	m_ServerIndex.Init(ServerAddress);
+	m_CheckServerIndex.Init(CheckServerAddress);
+	m_CheckServerAltIndex.Init(CheckServerAltAddress);
+	for(int i = 0; i < EXPIRE_SLOTS; i++)
+		m_aExpireSlots[i] = -1;
+	for(int i = 0; i < MAX_PACKETS; i++)
+		mem_copy(m_aPackets[i].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+	m_NumServers = 0;
+	m_ExpireSecond = time_get()/time_freq();
+}
+
+void RemoveServer(int Index)
+{
+	m_ServerIndex.Remove(Index);
+	ExpireUnlink(Index);
+
+	// fill the gap with the last server to keep the packets dense
+	int Last = m_NumServers-1;
+	if(Index != Last)
+	{
+		CServerEntry *pEntry = &m_aServers[Index];
+		*pEntry = m_aServers[Last];
+		m_ServerIndex.Move(Last, Index);
+		if(pEntry->m_ExpirePrev != -1)
+			m_aServers[pEntry->m_ExpirePrev].m_ExpireNext = Index;
 		else
-		{
-			*pCurrent = m_aServers[m_NumServers-1];
-			m_NumServers--;
-			dbg_msg("mastersrv", "error: server of invalid type, dropping it");
-		}
+			m_aExpireSlots[pEntry->m_ExpireSlot] = Index;
+		if(pEntry->m_ExpireNext != -1)
+			m_aServers[pEntry->m_ExpireNext].m_ExpirePrev = Index;
+		WritePacketEntry(Index);
+	}
+	m_NumServers--;
+}
+
+void RemoveCheckServer(int Index)
+{
+	m_CheckServerIndex.Remove(Index);
+	m_CheckServerAltIndex.Remove(Index);
+	int Last = m_NumCheckServers-1;
+	if(Index != Last)
+	{
+		m_aCheckServers[Index] = m_aCheckServers[Last];
+		m_CheckServerIndex.Move(Last, Index);
+		m_CheckServerAltIndex.Move(Last, Index);
 	}
+	m_NumCheckServers--;
 }
 
 void SendOk(NETADDR *pAddr, TOKEN Token)
@@ -167,6 +335,18 @@ void SendCheck(NETADDR *pAddr, TOKEN Token)
 
 void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type, TOKEN Token)
 {
+	// a heartbeat of a server that is still being checked only refreshes the check
+	int Index = m_CheckServerIndex.Find(pInfo);
+	if(Index != -1)
+	{
+		m_CheckServerAltIndex.Remove(Index);
+		m_aCheckServers[Index].m_AltAddress = *pAlt;
+		m_CheckServerAltIndex.Insert(Index);
+		m_aCheckServers[Index].m_Type = Type;
+		m_aCheckServers[Index].m_Token = Token;
+		return;
+	}
+
 	// add server
 	if(m_NumCheckServers == MAX_SERVERS)
 	{
@@ -179,28 +359,36 @@ void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type, TOKEN Token)
 	char aAltAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pAlt, aAltAddrStr, sizeof(aAltAddrStr), true);
 	dbg_msg("mastersrv", "checking: %s (%s)", aAddrStr, aAltAddrStr);
-	m_aCheckServers[m_NumCheckServers].m_Address = *pInfo;
-	m_aCheckServers[m_NumCheckServers].m_AltAddress = *pAlt;
-	m_aCheckServers[m_NumCheckServers].m_TryCount = 0;
-	m_aCheckServers[m_NumCheckServers].m_TryTime = 0;
-	m_aCheckServers[m_NumCheckServers].m_Type = Type;
-	m_aCheckServers[m_NumCheckServers].m_Token = Token;
-	m_NumCheckServers++;
+	Index = m_NumCheckServers++;
+	m_aCheckServers[Index].m_Address = *pInfo;
+	m_aCheckServers[Index].m_AltAddress = *pAlt;
+	m_aCheckServers[Index].m_TryCount = 0;
+	m_aCheckServers[Index].m_TryTime = 0;
+	m_aCheckServers[Index].m_Type = Type;
+	m_aCheckServers[Index].m_Token = Token;
+	m_CheckServerIndex.Insert(Index);
+	m_CheckServerAltIndex.Insert(Index);
 }
 
 void AddServer(NETADDR *pInfo, ServerType Type)
 {
+	if(Type != SERVERTYPE_NORMAL)
+	{
+		dbg_msg("mastersrv", "error: server of invalid type, dropping it");
+		return;
+	}
+
 	// see if server already exists in list
-	for(int i = 0; i < m_NumServers; i++)
+	int Index = m_ServerIndex.Find(pInfo);
+	if(Index != -1)
 	{
-		if(net_addr_comp(&m_aServers[i].m_Address, pInfo, true) == 0)
-		{
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "updated: %s", aAddrStr);
-			m_aServers[i].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-			return;
-		}
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "updated: %s", aAddrStr);
+		ExpireUnlink(Index);
+		m_aServers[Index].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+		ExpireLink(Index);
+		return;
 	}
 
 	// add server
@@ -213,10 +401,13 @@ void AddServer(NETADDR *pInfo, ServerType Type)
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	dbg_msg("mastersrv", "added: %s", aAddrStr);
-	m_aServers[m_NumServers].m_Address = *pInfo;
-	m_aServers[m_NumServers].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-	m_aServers[m_NumServers].m_Type = Type;
-	m_NumServers++;
+	Index = m_NumServers++;
+	m_aServers[Index].m_Address = *pInfo;
+	m_aServers[Index].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+	m_aServers[Index].m_Type = Type;
+	m_ServerIndex.Insert(Index);
+	ExpireLink(Index);
+	WritePacketEntry(Index);
 }
 
 void UpdateServers()
@@ -237,8 +428,7 @@ void UpdateServers()
 
 				// FAIL!!
 				SendError(&m_aCheckServers[i].m_Address, m_aCheckServers[i].m_Token);
-				m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers-1];
-				m_NumCheckServers--;
+				RemoveCheckServer(i);
 				i--;
 			}
 			else
@@ -257,38 +447,61 @@ void UpdateServers()
 void PurgeServers()
 {
 	int64 Now = time_get();
-	int i = 0;
-	while(i < m_NumServers)
+	int64 NowSecond = Now/time_freq();
+
+	// only the slots of the seconds that passed since the last purge can hold expired servers
+	for(int64 Second = max(m_ExpireSecond, NowSecond-EXPIRE_SLOTS+1); Second <= NowSecond; Second++)
 	{
-		if(m_aServers[i].m_Expire < Now)
+		int Index = m_aExpireSlots[Second%EXPIRE_SLOTS];
+		while(Index != -1)
 		{
-			// remove server
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(&m_aServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "expired: %s", aAddrStr);
-			m_aServers[i] = m_aServers[m_NumServers-1];
-			m_NumServers--;
+			int Next = m_aServers[Index].m_ExpireNext;
+			if(m_aServers[Index].m_Expire < Now)
+			{
+				// remove server
+				char aAddrStr[NETADDR_MAXSTRSIZE];
+				net_addr_str(&m_aServers[Index].m_Address, aAddrStr, sizeof(aAddrStr), true);
+				dbg_msg("mastersrv", "expired: %s", aAddrStr);
+				RemoveServer(Index);
+
+				// the last server moved into the freed index
+				if(Next == m_NumServers)
+					Next = Index;
+			}
+			Index = Next;
 		}
-		else
-			i++;
 	}
+
+	// the current second is checked again next time
+	m_ExpireSecond = NowSecond;
 }
 
 void ReloadBans()
 {
+	// a binary banlist replaces the old one in one go, replaying the bans of
+	// the config is only the fallback
+	IOHANDLE File = m_NetBan.Storage()->OpenFile("master_bans.bin", IOFLAG_READ, IStorage::TYPE_ALL);
+	if(File)
+	{
+		io_close(File);
+		if(m_NetBan.LoadBans("master_bans.bin") >= 0)
+			return;
+	}
+
 	m_NetBan.UnbanAll();
 	m_pConsole->ExecuteFile("master.cfg");
 }
 
 int main(int argc, const char **argv) // ignore_convention
 {
-	int64 LastBuild = 0, LastBanReload = 0;
+	int64 LastPurge = 0, LastBanReload = 0;
 	ServerType Type = SERVERTYPE_INVALID;
 	NETADDR BindAddr;
 
 	dbg_logger_stdout();
 	
 	mem_copy(m_CountData.m_Header, SERVERBROWSE_COUNT, sizeof(SERVERBROWSE_COUNT));
+	InitServers();
 
 	int FlagMask = CFGFLAG_MASTER;
 	IKernel *pKernel = IKernel::Create();
@@ -398,9 +611,9 @@ int main(int argc, const char **argv) // ignore_convention
 				p.m_Address = Packet.m_Address;
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 
-				for(int i = 0; i < m_NumPackets; i++)
+				for(int i = 0; i < NumPackets(); i++)
 				{
-					p.m_DataSize = m_aPackets[i].m_Size;
+					p.m_DataSize = PacketSize(i);
 					p.m_pData = &m_aPackets[i].m_Data;
 					m_NetOp.Send(&p, Token);
 				}
@@ -418,17 +631,14 @@ int main(int argc, const char **argv) // ignore_convention
 				mem_comp(Packet.m_pData, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE)) == 0)
 			{
 				Type = SERVERTYPE_INVALID;
-				// remove it from checking
-				for(int i = 0; i < m_NumCheckServers; i++)
+				// remove it from checking, it might answer from its alternative address
+				int Index = m_CheckServerIndex.Find(&Packet.m_Address);
+				if(Index == -1)
+					Index = m_CheckServerAltIndex.Find(&Packet.m_Address);
+				if(Index != -1)
 				{
-					if(net_addr_comp(&m_aCheckServers[i].m_Address, &Packet.m_Address, true) == 0 ||
-						net_addr_comp(&m_aCheckServers[i].m_AltAddress, &Packet.m_Address, true) == 0)
-					{
-						Type = m_aCheckServers[i].m_Type;
-						m_NumCheckServers--;
-						m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers];
-						break;
-					}
+					Type = m_aCheckServers[Index].m_Type;
+					RemoveCheckServer(Index);
 				}
 
 				// drops servers that were not in the CheckServers list
@@ -447,13 +657,12 @@ int main(int argc, const char **argv) // ignore_convention
 			ReloadBans();
 		}
 
-		if(time_get()-LastBuild > time_freq()*5)
+		if(time_get()-LastPurge > time_freq()*5)
 		{
-			LastBuild = time_get();
+			LastPurge = time_get();
 
 			PurgeServers();
 			UpdateServers();
-			BuildPackets();
 		}
 
 		// be nice to the CPU
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+static void ConCount(IConsole::IResult *pResult, void *pUserData)
+{
+	int *pCount = (int *)pUserData;
+	*pCount += pResult->NumArguments() ? pResult->GetInteger(0) : 1;
+}
+
+TEST(Console, CaseInsensitiveLookup)
+{
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	int Count = 0;
+	pConsole->Register("count_up", "?i[amount]", CFGFLAG_SERVER, ConCount, &Count, "");
+
+	pConsole->ExecuteLine("count_up");
+	pConsole->ExecuteLine("COUNT_UP 2");
+	pConsole->ExecuteLine("Count_Up 3; count_up");
+	EXPECT_EQ(Count, 7);
+	EXPECT_TRUE(pConsole->LineIsValid("COUNT_up 5"));
+	EXPECT_FALSE(pConsole->LineIsValid("count_down"));
+
+	pConsole->RegisterTemp("remote_cmd", "", CFGFLAG_SERVER, "");
+	EXPECT_TRUE(pConsole->GetCommandInfo("REMOTE_CMD", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(pConsole->GetCommandInfo("remote_cmd", CFGFLAG_SERVER, false));
+	pConsole->DeregisterTemp("remote_cmd");
+	EXPECT_FALSE(pConsole->GetCommandInfo("remote_cmd", CFGFLAG_SERVER, true));
+
+	pConsole->RegisterTemp("remote_cmd", "", CFGFLAG_SERVER, "");
+	pConsole->DeregisterTempAll();
+	EXPECT_FALSE(pConsole->GetCommandInfo("remote_cmd", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(pConsole->GetCommandInfo("count_up", CFGFLAG_SERVER, false));
+
+	delete pConsole;
+}
+
+TEST(Console, RepeatedLines)
+{
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	int Count = 0, Other = 0;
+	pConsole->Register("count_up", "?i[amount]", CFGFLAG_SERVER, ConCount, &Count, "");
+
+	for(int i = 0; i < 10; i++)
+		pConsole->ExecuteLine("count_up 4; count_up \"1\"");
+	EXPECT_EQ(Count, 50);
+
+	// a registration replaces the parsed lines, the command might take other arguments now
+	pConsole->Register("count_up", "", CFGFLAG_SERVER, ConCount, &Other, "");
+	pConsole->ExecuteLine("count_up 4; count_up \"1\"");
+	EXPECT_EQ(Count, 50);
+	EXPECT_EQ(Other, 2);
+
+	delete pConsole;
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+
+static int s_NumLines = 0;
+static int s_NumOutOfOrder = 0;
+
+static void CountLines(const char *pLine)
+{
+	const char *pMsg = str_find(pLine, "[test/logger]: ");
+	if(!pMsg)
+		return;
+	if(str_toint(pMsg+str_length("[test/logger]: ")) != s_NumLines)
+		s_NumOutOfOrder++;
+	s_NumLines++;
+}
+
+TEST(Logger, Async)
+{
+	dbg_logger(CountLines);
+
+	dbg_logger_async(10);
+	unsigned Dropped = dbg_logger_dropped();
+	// fits into the ring, so nothing is dropped no matter how slow the logger thread is
+	for(int i = 0; i < 1000; i++)
+		dbg_msg("test/logger", "%d", i);
+	dbg_logger_flush();
+	EXPECT_EQ(s_NumLines, 1000);
+	dbg_logger_sync();
+
+	EXPECT_EQ(dbg_logger_dropped(), Dropped);
+	EXPECT_EQ(s_NumOutOfOrder, 0);
+
+	// back to writing right away
+	dbg_msg("test/logger", "%d", 1000);
+	EXPECT_EQ(s_NumLines, 1001);
+}
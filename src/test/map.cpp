@@ -0,0 +1,143 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <engine/map.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+
+static const int WIDTH = 16;
+static const int HEIGHT = 8;
+
+// a map with a game layer and a design layer, both stored skip compressed
+static void WriteTestMap(IStorage *pStorage, const char *pFilename)
+{
+	CDataFileWriter Writer;
+	ASSERT_TRUE(Writer.Open(pStorage, pFilename));
+
+	CMapItemVersion Version;
+	Version.m_Version = CMapItemVersion::CURRENT_VERSION;
+	Writer.AddItem(MAPITEMTYPE_VERSION, 0, sizeof(Version), &Version);
+
+	CMapItemGroup Group;
+	mem_zero(&Group, sizeof(Group));
+	Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+	Group.m_ParallaxX = 100;
+	Group.m_ParallaxY = 100;
+	Group.m_StartLayer = 0;
+	Group.m_NumLayers = 2;
+	Writer.AddItem(MAPITEMTYPE_GROUP, 0, sizeof(Group), &Group);
+
+	for(int l = 0; l < 2; l++)
+	{
+		// one row per tile, index is the row for the game layer and 1 for the design layer
+		CTile aTiles[HEIGHT];
+		mem_zero(aTiles, sizeof(aTiles));
+		for(int y = 0; y < HEIGHT; y++)
+		{
+			aTiles[y].m_Index = l == 0 ? y : 1;
+			aTiles[y].m_Skip = WIDTH-1;
+		}
+
+		CMapItemLayerTilemap Layer;
+		mem_zero(&Layer, sizeof(Layer));
+		Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		Layer.m_Version = CMapItemLayerTilemap::CURRENT_VERSION;
+		Layer.m_Width = WIDTH;
+		Layer.m_Height = HEIGHT;
+		Layer.m_Flags = l == 0 ? TILESLAYERFLAG_GAME : 0;
+		Layer.m_Image = -1;
+		Layer.m_Data = Writer.AddData(sizeof(aTiles), aTiles);
+		Writer.AddItem(MAPITEMTYPE_LAYER, l, sizeof(Layer), &Layer);
+	}
+	EXPECT_TRUE(Writer.Finish());
+}
+
+TEST(Map, LazyTileExpansion)
+{
+	CTestInfo Info;
+	char aFilename[64];
+	Info.Filename(aFilename, sizeof(aFilename), ".map");
+	IStorage *pStorage = CreateTestStorage();
+	WriteTestMap(pStorage, aFilename);
+
+	IEngineMap *pMap = CreateEngineMap();
+	ASSERT_TRUE(pMap->Load(aFilename, pStorage));
+	EXPECT_EQ(pMap->MemoryUsage(), 0);
+
+	// only the game layer is read without the skip pass
+	CLayers Layers;
+	Layers.Init(0, pMap, false);
+	ASSERT_TRUE(Layers.GameLayer());
+	CTile *pGameTiles = (CTile *)pMap->GetData(Layers.GameLayer()->m_Data);
+	ASSERT_TRUE(pGameTiles);
+	EXPECT_EQ(pMap->MemoryUsage(), WIDTH*HEIGHT*(int)sizeof(CTile));
+	for(int i = 0; i < WIDTH*HEIGHT; i++)
+	{
+		EXPECT_EQ(pGameTiles[i].m_Index, i/WIDTH);
+		EXPECT_EQ(pGameTiles[i].m_Skip, 0);
+	}
+
+	// the design layer expands on access, also again after it was unloaded
+	CMapItemLayerTilemap *pDesign = (CMapItemLayerTilemap *)Layers.GetLayer(1);
+	for(int Pass = 0; Pass < 2; Pass++)
+	{
+		CTile *pTiles = (CTile *)pMap->GetData(pDesign->m_Data);
+		ASSERT_TRUE(pTiles);
+		for(int i = 0; i < WIDTH*HEIGHT; i++)
+			EXPECT_EQ(pTiles[i].m_Index, 1);
+		EXPECT_EQ(pMap->MemoryUsage(), 2*WIDTH*HEIGHT*(int)sizeof(CTile));
+		pMap->UnloadData(pDesign->m_Data);
+	}
+
+	pMap->Unload();
+	delete pMap;
+	EXPECT_TRUE(pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE));
+	delete pStorage;
+}
+
+TEST(Map, SharedCollision)
+{
+	CTestInfo Info;
+	char aFilename[64];
+	Info.Filename(aFilename, sizeof(aFilename), ".map");
+	IStorage *pStorage = CreateTestStorage();
+	WriteTestMap(pStorage, aFilename);
+
+	// two servers of one process load the same map, the second one shares
+	// the map data with the first
+	IEngineMap *apMaps[2];
+	CLayers aLayers[2];
+	CCollision aCollision[2];
+	for(int i = 0; i < 2; i++)
+	{
+		apMaps[i] = CreateEngineMap();
+		ASSERT_TRUE(apMaps[i]->Load(aFilename, pStorage));
+		aLayers[i].Init(0, apMaps[i], false);
+		aCollision[i].Init(&aLayers[i]);
+	}
+
+	// the rows of the game layer are air, solid, death and nohook
+	for(int i = 0; i < 2; i++)
+	{
+		EXPECT_EQ(aCollision[i].GetCollisionAt(16, 0*32+16), 0);
+		EXPECT_EQ(aCollision[i].GetCollisionAt(16, TILE_SOLID*32+16), CCollision::COLFLAG_SOLID);
+		EXPECT_EQ(aCollision[i].GetCollisionAt(16, TILE_DEATH*32+16), CCollision::COLFLAG_DEATH);
+		EXPECT_EQ(aCollision[i].GetCollisionAt(16, TILE_NOHOOK*32+16), CCollision::COLFLAG_SOLID|CCollision::COLFLAG_NOHOOK);
+	}
+
+	// the map data itself keeps the tile indices
+	CTile *pTiles = (CTile *)apMaps[0]->GetData(aLayers[0].GameLayer()->m_Data);
+	EXPECT_EQ(pTiles[TILE_NOHOOK*WIDTH].m_Index, TILE_NOHOOK);
+
+	for(int i = 0; i < 2; i++)
+	{
+		apMaps[i]->Unload();
+		delete apMaps[i];
+	}
+	EXPECT_TRUE(pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE));
+	delete pStorage;
+}
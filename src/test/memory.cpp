@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+
+TEST(Memory, Alignment)
+{
+	static const unsigned s_aAlignments[] = {1, 4, 16, 32, 64, 4096};
+	for(unsigned i = 0; i < sizeof(s_aAlignments)/sizeof(s_aAlignments[0]); i++)
+	{
+		for(int Level = MEMDEBUG_OFF; Level <= MEMDEBUG_GUARD; Level++)
+		{
+			mem_debug(Level);
+			unsigned char *pBlock = (unsigned char *)mem_alloc(100, s_aAlignments[i]);
+			ASSERT_TRUE(pBlock);
+			unsigned Align = s_aAlignments[i] > 16 ? s_aAlignments[i] : 16;
+			EXPECT_EQ((size_t)pBlock % Align, 0u);
+			mem_zero(pBlock, 100);
+			mem_free(pBlock);
+		}
+	}
+	mem_debug(MEMDEBUG_OFF);
+	mem_free(0);
+}
+
+TEST(Memory, Stats)
+{
+	// blocks from before the statistics were turned on are not subtracted
+	void *pUncounted = mem_alloc_tagged(500, 1, MEMTAG_MAP);
+	mem_debug(MEMDEBUG_STATS);
+
+	MEMSTATS Before;
+	mem_stats(MEMTAG_MAP, &Before);
+	void *pBlock = mem_alloc_tagged(1000, 1, MEMTAG_MAP);
+	MEMSTATS During;
+	mem_stats(MEMTAG_MAP, &During);
+	EXPECT_EQ(During.live_bytes, Before.live_bytes+1000);
+	EXPECT_EQ(During.live_blocks, Before.live_blocks+1);
+	EXPECT_EQ(During.num_allocs, Before.num_allocs+1);
+	EXPECT_GE(During.peak_bytes, During.live_bytes);
+
+	mem_free(pBlock);
+	mem_free(pUncounted);
+	MEMSTATS After;
+	mem_stats(MEMTAG_MAP, &After);
+	EXPECT_EQ(After.live_bytes, Before.live_bytes);
+	EXPECT_EQ(After.live_blocks, Before.live_blocks);
+	EXPECT_EQ(After.peak_bytes, During.peak_bytes);
+	mem_debug(MEMDEBUG_OFF);
+}
+
+TEST(Memory, Guard)
+{
+	mem_debug(MEMDEBUG_GUARD);
+	int NumBlocks = mem_print_blocks(0);
+	char *pBlock = (char *)mem_alloc(10, 1);
+	EXPECT_EQ(mem_print_blocks(0), NumBlocks+1);
+	EXPECT_TRUE(mem_check());
+
+	char Saved = pBlock[10];
+	pBlock[10] = ~Saved;
+	EXPECT_FALSE(mem_check());
+	pBlock[10] = Saved;
+	EXPECT_TRUE(mem_check());
+
+	mem_free(pBlock);
+	EXPECT_EQ(mem_print_blocks(0), NumBlocks);
+	mem_debug(MEMDEBUG_OFF);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/client/mixer.h>
+
+static void FillSamples(short *pData, int Num, unsigned Seed)
+{
+	for(int i = 0; i < Num; i++)
+	{
+		Seed = Seed*1103515245u + 12345u;
+		pData[i] = (short)(Seed >> 16);
+	}
+}
+
+TEST(Mixer, MixFramesMatchesScalar)
+{
+	short aIn[2*67];
+	FillSamples(aIn, 2*67, 1);
+
+	for(int Channels = 1; Channels <= 2; Channels++)
+	{
+		int aFast[2*67];
+		int aScalar[2*67];
+		for(int i = 0; i < 2*67; i++)
+			aFast[i] = aScalar[i] = i*1000-50000;
+
+		CMixer::MixFrames(aFast, aIn, Channels, 67, 255, 17);
+		CMixer::MixFramesScalar(aScalar, aIn, Channels, 67, 255, 17);
+		EXPECT_EQ(mem_comp(aFast, aScalar, sizeof(aFast)), 0);
+	}
+}
+
+TEST(Mixer, ClampFramesMatchesScalar)
+{
+	int aIn[2*37];
+	for(int i = 0; i < 2*37; i++)
+		aIn[i] = (i-37)*1000000 + i;
+
+	short aFast[2*37];
+	short aScalar[2*37];
+	CMixer::ClampFrames(aFast, aIn, 37, 100);
+	CMixer::ClampFramesScalar(aScalar, aIn, 37, 100);
+	EXPECT_EQ(mem_comp(aFast, aScalar, sizeof(aFast)), 0);
+	EXPECT_EQ(aScalar[0], -32767);
+	EXPECT_EQ(aScalar[2*37-1], 32767);
+}
+
+TEST(Mixer, VoicesThroughQueue)
+{
+	short aData[64];
+	for(int i = 0; i < 64; i++)
+		aData[i] = 1000;
+	CMixerSample Sample;
+	Sample.m_pData = aData;
+	Sample.m_NumFrames = 64;
+	Sample.m_Channels = 1;
+	Sample.m_PausedAt = 0;
+
+	CMixer Mixer;
+	Mixer.Init(16);
+
+	short aOut[2*32];
+	EXPECT_GE(Mixer.Play(0, &Sample, 0, 0, 0), 0);
+	EXPECT_TRUE(Mixer.IsPlaying(&Sample));
+	Mixer.Mix(aOut, 32);
+	EXPECT_NE(aOut[0], 0);
+	EXPECT_TRUE(Mixer.IsPlaying(&Sample));
+	Mixer.Mix(aOut, 32);
+	EXPECT_FALSE(Mixer.IsPlaying(&Sample));
+
+	// out of hearing range, the voice only advances
+	Mixer.SetMaxDistance(100.0f);
+	EXPECT_GE(Mixer.Play(0, &Sample, CMixer::FLAG_POS, 500, 0), 0);
+	Mixer.Mix(aOut, 32);
+	EXPECT_EQ(aOut[0], 0);
+	EXPECT_EQ(Mixer.NumCulledVoices(), 2);
+
+	Mixer.Stop(&Sample);
+	EXPECT_FALSE(Mixer.IsPlaying(&Sample));
+	Mixer.Mix(aOut, 32);
+	EXPECT_EQ(aOut[0], 0);
+	EXPECT_EQ(Mixer.NumCulledVoices(), 0);
+}
@@ -0,0 +1,173 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+static NETADDR MakeAddr(int a, int b, int c, int d)
+{
+	NETADDR Addr;
+	mem_zero(&Addr, sizeof(Addr));
+	Addr.type = NETTYPE_IPV4;
+	Addr.ip[0] = a;
+	Addr.ip[1] = b;
+	Addr.ip[2] = c;
+	Addr.ip[3] = d;
+	return Addr;
+}
+
+static bool IsBanned(CNetBan *pNetBan, NETADDR Addr)
+{
+	char aBuf[256];
+	return pNetBan->IsBanned(&Addr, aBuf, sizeof(aBuf), 0);
+}
+
+// sets the expiry time directly, the console only bans into the future
+class CTestNetBan : public CNetBan
+{
+public:
+	enum { EXPIRES_NEVER=CBanInfo::EXPIRES_NEVER };
+
+	void BanAddrUntil(NETADDR Addr, int Expires)
+	{
+		CBanInfo Info = {0};
+		Info.m_Expires = Expires;
+		str_copy(Info.m_aReason, "test", sizeof(Info.m_aReason));
+		CNetHash NetHash(&Addr);
+		CBanAddr *pBan = m_BanAddrPool.Find(&Addr, &NetHash);
+		if(pBan)
+			m_BanAddrPool.Update(pBan, &Info);
+		else
+			m_BanAddrPool.Add(&Addr, &Info, &NetHash);
+	}
+
+	int HeapIndex(NETADDR Addr)
+	{
+		CNetHash NetHash(&Addr);
+		return m_BanAddrPool.Find(&Addr, &NetHash)->m_HeapIndex;
+	}
+
+	int NumAddrBans() const { return m_BanAddrPool.Num(); }
+	int FirstExpires() const { return m_BanAddrPool.FirstExpiring() ? m_BanAddrPool.FirstExpiring()->m_Info.m_Expires : CBanInfo::EXPIRES_NEVER; }
+};
+
+TEST(NetBan, ExpiryHeap)
+{
+	IStorage *pStorage = CreateTestStorage();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CTestNetBan NetBan;
+	NetBan.Init(pConsole, pStorage);
+
+	// expired and pending bans in mixed order, every fifth one is for life
+	enum { NUM=100 };
+	int aExpires[NUM];
+	int Now = time_timestamp();
+	for(int i = 0; i < NUM; i++)
+	{
+		int Order = (i*37)%NUM;
+		if(Order%5 == 0)
+			aExpires[i] = CTestNetBan::EXPIRES_NEVER;
+		else
+			aExpires[i] = Order%2 ? Now-1000-Order : Now+1000+Order;
+		NetBan.BanAddrUntil(MakeAddr(10, 0, i, 1), aExpires[i]);
+	}
+	EXPECT_EQ(NetBan.NumAddrBans(), NUM);
+	EXPECT_LT(NetBan.FirstExpires(), Now);
+
+	// move bans across the current time in both directions
+	for(int i = 0; i < NUM; i += 7)
+	{
+		if(aExpires[i] == CTestNetBan::EXPIRES_NEVER)
+			continue;
+		aExpires[i] = aExpires[i] < Now ? Now+2000+i : Now-2000-i;
+		NetBan.BanAddrUntil(MakeAddr(10, 0, i, 1), aExpires[i]);
+	}
+
+	// remove a pending and an expired ban from the middle of the heap
+	int aRemoved[2] = {-1, -1};
+	for(int i = 0; i < NUM; i++)
+	{
+		if(aExpires[i] == CTestNetBan::EXPIRES_NEVER || NetBan.HeapIndex(MakeAddr(10, 0, i, 1)) < 4)
+			continue;
+		int Expired = aExpires[i] < Now;
+		if(aRemoved[Expired] < 0)
+			aRemoved[Expired] = i;
+	}
+	bool aUnbanned[NUM] = {false};
+	for(int r = 0; r < 2; r++)
+	{
+		ASSERT_GE(aRemoved[r], 0);
+		NETADDR Addr = MakeAddr(10, 0, aRemoved[r], 1);
+		EXPECT_EQ(NetBan.UnbanByAddr(&Addr), 0);
+		aUnbanned[aRemoved[r]] = true;
+	}
+
+	// exactly the expired bans are dropped
+	int NumLeft = 0;
+	for(int i = 0; i < NUM; i++)
+		if(!aUnbanned[i] && (aExpires[i] == CTestNetBan::EXPIRES_NEVER || aExpires[i] > Now))
+			NumLeft++;
+	EXPECT_LT(NumLeft, NUM-2);
+	NetBan.Update();
+	EXPECT_EQ(NetBan.NumAddrBans(), NumLeft);
+	for(int i = 0; i < NUM; i++)
+	{
+		bool Banned = !aUnbanned[i] && (aExpires[i] == CTestNetBan::EXPIRES_NEVER || aExpires[i] > Now);
+		EXPECT_EQ(IsBanned(&NetBan, MakeAddr(10, 0, i, 1)), Banned) << i;
+	}
+	EXPECT_GT(NetBan.FirstExpires(), Now);
+
+	delete pConsole;
+	delete pStorage;
+}
+
+TEST(NetBan, SaveLoadBinary)
+{
+	CTestInfo Info;
+	char aFilename[64];
+	Info.Filename(aFilename, sizeof(aFilename), ".bans");
+	IStorage *pStorage = CreateTestStorage();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan NetBan;
+	NetBan.Init(pConsole, pStorage);
+
+	for(int i = 0; i < 100; i++)
+	{
+		NETADDR Addr = MakeAddr(10, 0, i, 1);
+		NetBan.BanAddr(&Addr, i%2 ? 0 : 600+i, "test");
+	}
+	CNetRange Range;
+	Range.m_LB = MakeAddr(20, 0, 0, 0);
+	Range.m_UB = MakeAddr(20, 0, 255, 255);
+	NetBan.BanRange(&Range, 600, "test");
+	ASSERT_TRUE(NetBan.SaveBans(aFilename));
+
+	NetBan.UnbanAll();
+	EXPECT_FALSE(IsBanned(&NetBan, MakeAddr(10, 0, 5, 1)));
+
+	EXPECT_EQ(NetBan.LoadBans(aFilename), 101);
+	for(int i = 0; i < 100; i++)
+		EXPECT_TRUE(IsBanned(&NetBan, MakeAddr(10, 0, i, 1)));
+	EXPECT_TRUE(IsBanned(&NetBan, MakeAddr(20, 0, 17, 4)));
+	EXPECT_FALSE(IsBanned(&NetBan, MakeAddr(10, 0, 5, 2)));
+
+	// a broken file does not touch the current banlist
+	IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, "ban 1.2.3.4", 11);
+	io_close(File);
+	EXPECT_EQ(NetBan.LoadBans(aFilename), -1);
+	EXPECT_TRUE(IsBanned(&NetBan, MakeAddr(10, 0, 5, 1)));
+
+	// nothing expires yet, the lifetime bans are not in the expiry heap at all
+	NetBan.Update();
+	EXPECT_TRUE(IsBanned(&NetBan, MakeAddr(10, 0, 6, 1)));
+	EXPECT_TRUE(IsBanned(&NetBan, MakeAddr(10, 0, 7, 1)));
+
+	EXPECT_TRUE(pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE));
+	delete pConsole;
+	delete pStorage;
+}
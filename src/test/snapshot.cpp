@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot.h>
+
+static int BuildSnapshot(CSnapshotBuilder *pBuilder, void *pData, int NumChars, int Tick)
+{
+	pBuilder->Init();
+	for(int i = 0; i < NumChars; i++)
+	{
+		int *pItem = (int *)pBuilder->NewItem(9, i, 22*sizeof(int));
+		for(int d = 0; d < 22; d++)
+			pItem[d] = Tick*(d+1)+i*100;
+	}
+	int *pGameData = (int *)pBuilder->NewItem(6, 0, 3*sizeof(int));
+	pGameData[0] = Tick;
+	pGameData[1] = 0;
+	pGameData[2] = 0;
+	return pBuilder->Finish(pData);
+}
+
+TEST(Snapshot, AccountDeltaMatchesCompressedSize)
+{
+	CSnapshotBuilder *pBuilder = new CSnapshotBuilder;
+	CSnapshotDelta *pDelta = new CSnapshotDelta;
+	pDelta->SetStaticsize(9, 22*sizeof(int));
+
+	static char s_aFrom[CSnapshot::MAX_SIZE];
+	static char s_aTo[CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	static char s_aComp[CSnapshot::MAX_SIZE];
+	BuildSnapshot(pBuilder, s_aFrom, 8, 100);
+	BuildSnapshot(pBuilder, s_aTo, 6, 102);
+
+	int DeltaSize = pDelta->CreateDelta((CSnapshot *)s_aFrom, (CSnapshot *)s_aTo, s_aDelta);
+	ASSERT_GT(DeltaSize, 0);
+	int CompSize = (int)CVariableInt::Compress(s_aDelta, DeltaSize, s_aComp, sizeof(s_aComp));
+
+	int aTypeBytes[64] = {0};
+	int Overhead = pDelta->AccountDelta(s_aDelta, DeltaSize, aTypeBytes, 64);
+	int Total = Overhead;
+	for(int i = 0; i < 64; i++)
+		Total += aTypeBytes[i];
+
+	EXPECT_EQ(Total, CompSize);
+	EXPECT_GT(aTypeBytes[9], 0);
+	EXPECT_GT(aTypeBytes[6], 0);
+	EXPECT_EQ(aTypeBytes[1], 0);
+
+	delete pDelta;
+	delete pBuilder;
+}
+
+TEST(Snapshot, IDPoolTickReset)
+{
+	CSnapIDPool *pPool = new CSnapIDPool;
+
+	// free ids late on the old map
+	const int OldTick = 1000;
+	int aIDs[100];
+	for(int i = 0; i < 100; i++)
+		aIDs[i] = pPool->NewID(OldTick);
+	for(int i = 0; i < 100; i++)
+		pPool->FreeID(aIDs[i], OldTick);
+
+	// the new map starts at tick 0, the freed ids must not block the ones freed later
+	int NumAllocated = 0;
+	for(int Tick = 0; NumAllocated <= 2*CSnapIDPool::MAX_IDS; Tick++)
+	{
+		for(int i = 0; i < 50; i++, NumAllocated++)
+		{
+			aIDs[i] = pPool->NewID(Tick);
+			ASSERT_NE(aIDs[i], -1);
+		}
+		for(int i = 0; i < 50; i++)
+			pPool->FreeID(aIDs[i], Tick);
+	}
+
+	delete pPool;
+}
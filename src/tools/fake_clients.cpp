@@ -0,0 +1,505 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <math.h> // cosf, sinf
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/message.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+#include <game/version.h>
+#include <generated/protocol.h>
+
+/*
+	Simulates headless game clients for load tests against a local server.
+	Every client runs the full connect, map download and enter game handshake,
+	sends input at the server tick rate and acks the received snapshots.
+
+	Note that the server limits the amount of clients per address,
+	raise sv_max_clients_per_ip before connecting many clients over loopback.
+*/
+
+enum
+{
+	MAX_FAKE_CLIENTS=1024,
+	MAX_SERVERS=16,
+};
+
+static CConfig s_Config;
+static NETADDR s_aServers[MAX_SERVERS];
+static int s_NumServers = 0;
+static int s_NumClients = 8;
+static int s_Duration = 0;
+static int s_ReportInterval = 5;
+static bool s_DownloadMap = true;
+static const char *s_pPassword = "";
+
+class CFakeClient
+{
+public:
+	enum
+	{
+		STATE_OFFLINE=0,
+		STATE_CONNECTING,
+		STATE_LOADING,
+		STATE_ENTERING,
+		STATE_INGAME,
+		NUM_STATES,
+	};
+
+	CNetClient *m_pNet;
+	int m_ID;
+	int m_State;
+
+	// map download
+	int m_MapSize;
+	int m_MapReceived;
+	int m_MapChunkSize;
+	int m_MapChunksPerRequest;
+	int m_MapChunk;
+
+	// snapshots
+	int m_AckGameTick;
+	int m_RecvTick;
+	unsigned m_SnapParts;
+	int64 m_LastSnapTime;
+	int m_SnapStep;
+
+	// input
+	int64 m_NextInput;
+	int m_InputCounter;
+	CNetObj_PlayerInput m_Input;
+
+	// ping
+	int64 m_PingSent;
+	int64 m_NextPing;
+
+	// statistics since the last report
+	int m_NumSnaps;
+	int m_NumSnapsExpected;
+	int64 m_MaxSnapInterval;
+	int64 m_SumPing;
+	int64 m_MaxPing;
+	int m_NumPings;
+	int m_RecvBytes;
+
+	void ResetStats()
+	{
+		m_NumSnaps = 0;
+		m_NumSnapsExpected = 0;
+		m_MaxSnapInterval = 0;
+		m_SumPing = 0;
+		m_MaxPing = 0;
+		m_NumPings = 0;
+		m_RecvBytes = 0;
+	}
+
+	bool Init(int ID)
+	{
+		m_ID = ID;
+		m_State = STATE_OFFLINE;
+		m_AckGameTick = -1;
+		m_RecvTick = 0;
+		m_SnapParts = 0;
+		m_LastSnapTime = 0;
+		m_SnapStep = 0;
+		m_NextInput = 0;
+		m_InputCounter = 0;
+		m_PingSent = 0;
+		m_NextPing = 0;
+		mem_zero(&m_Input, sizeof(m_Input));
+		ResetStats();
+
+		NETADDR BindAddr;
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		BindAddr.type = NETTYPE_ALL;
+		m_pNet = new CNetClient;
+		if(!m_pNet->Open(BindAddr, &s_Config, 0, 0, 0))
+		{
+			dbg_msg("fake_clients", "couldn't open socket for client %d", ID);
+			return false;
+		}
+		return true;
+	}
+
+	void Connect()
+	{
+		NETADDR Addr = s_aServers[m_ID%s_NumServers];
+		m_pNet->Connect(&Addr);
+		m_State = STATE_CONNECTING;
+	}
+
+	void SendMsg(CMsgPacker *pMsg, int Flags)
+	{
+		CNetChunk Packet;
+		mem_zero(&Packet, sizeof(CNetChunk));
+		Packet.m_ClientID = 0;
+		Packet.m_pData = pMsg->Data();
+		Packet.m_DataSize = pMsg->Size();
+		if(Flags&MSGFLAG_VITAL)
+			Packet.m_Flags |= NETSENDFLAG_VITAL;
+		if(Flags&MSGFLAG_FLUSH)
+			Packet.m_Flags |= NETSENDFLAG_FLUSH;
+		m_pNet->Send(&Packet);
+	}
+
+	void SendInfo()
+	{
+		CMsgPacker Msg(NETMSG_INFO, true);
+		Msg.AddString(GAME_NETVERSION, 128);
+		Msg.AddString(s_pPassword, 128);
+		Msg.AddInt(CLIENT_VERSION);
+		SendMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+	}
+
+	void SendStartInfo()
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "fake%d", m_ID);
+		static const char *s_apSkinParts[NUM_SKINPARTS] = {"standard", "", "", "standard", "standard", "standard"};
+
+		CNetMsg_Cl_StartInfo Msg;
+		Msg.m_pName = aName;
+		Msg.m_pClan = "load";
+		Msg.m_Country = -1;
+		for(int p = 0; p < NUM_SKINPARTS; p++)
+		{
+			Msg.m_apSkinPartNames[p] = s_apSkinParts[p];
+			Msg.m_aUseCustomColors[p] = 0;
+			Msg.m_aSkinPartColors[p] = 0;
+		}
+
+		CMsgPacker Packer(Msg.MsgID(), false);
+		if(!Msg.Pack(&Packer))
+			SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+	}
+
+	int EstimatedServerTick(int64 Now) const
+	{
+		return m_RecvTick + (int)((Now-m_LastSnapTime)*SERVER_TICK_SPEED/time_freq());
+	}
+
+	// plausible input: wander around, jump, hook and shoot every now and then
+	void UpdateInput()
+	{
+		m_InputCounter++;
+		if(m_InputCounter%50 == 0)
+			m_Input.m_Direction = random_int()%3-1;
+		float Angle = (m_InputCounter+m_ID*17)*0.05f;
+		m_Input.m_TargetX = (int)(cosf(Angle)*200.0f);
+		m_Input.m_TargetY = (int)(sinf(Angle)*200.0f);
+		m_Input.m_Jump = (random_int()%40) == 0;
+		m_Input.m_Hook = (m_InputCounter/30)%3 == 0;
+		if(random_int()%10 == 0)
+			m_Input.m_Fire = (m_Input.m_Fire+1)&INPUT_STATE_MASK;
+		m_Input.m_PlayerFlags = PLAYERFLAG_BOT;
+		m_Input.m_WantedWeapon = 0;
+		m_Input.m_NextWeapon = 0;
+		m_Input.m_PrevWeapon = 0;
+	}
+
+	void SendInput(int64 Now)
+	{
+		UpdateInput();
+
+		CMsgPacker Msg(NETMSG_INPUT, true);
+		Msg.AddInt(m_AckGameTick);
+		Msg.AddInt(EstimatedServerTick(Now)+2);
+		Msg.AddInt(sizeof(m_Input));
+		const int *pData = (const int *)&m_Input;
+		for(unsigned i = 0; i < sizeof(m_Input)/sizeof(int); i++)
+			Msg.AddInt(pData[i]);
+		Msg.AddInt(0); // ping correction
+		SendMsg(&Msg, MSGFLAG_FLUSH);
+	}
+
+	void OnSnapshot(int Msg, CUnpacker *pUnpacker, int64 Now)
+	{
+		int NumParts = 1;
+		int Part = 0;
+		int GameTick = pUnpacker->GetInt();
+		pUnpacker->GetInt(); // delta tick
+		if(Msg == NETMSG_SNAP)
+		{
+			NumParts = pUnpacker->GetInt();
+			Part = pUnpacker->GetInt();
+		}
+		if(pUnpacker->Error() || NumParts < 1 || NumParts > CSnapshot::MAX_PARTS || Part < 0 || Part >= NumParts || GameTick < m_RecvTick)
+			return;
+
+		if(GameTick != m_RecvTick)
+			m_SnapParts = 0;
+		m_SnapParts |= 1<<Part;
+		if(m_SnapParts != (unsigned)((1<<NumParts)-1))
+		{
+			m_RecvTick = GameTick;
+			return;
+		}
+		m_SnapParts = 0;
+
+		// the snapshot is complete. the content is not unpacked, acking it is
+		// enough to make the server delta against it like for a real client
+		if(m_AckGameTick > 0)
+		{
+			int Step = GameTick-m_AckGameTick;
+			if(Step > 0 && (!m_SnapStep || Step < m_SnapStep))
+				m_SnapStep = Step;
+			if(m_SnapStep)
+				m_NumSnapsExpected += Step/m_SnapStep;
+			m_MaxSnapInterval = max(m_MaxSnapInterval, Now-m_LastSnapTime);
+		}
+		else
+			m_NumSnapsExpected++;
+		m_NumSnaps++;
+
+		m_RecvTick = GameTick;
+		m_LastSnapTime = Now;
+		m_AckGameTick = GameTick;
+		if(m_State == STATE_ENTERING)
+			m_State = STATE_INGAME;
+	}
+
+	void ProcessPacket(CNetChunk *pPacket, int64 Now)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+		int Msg = Unpacker.GetInt();
+		int Sys = Msg&1;
+		Msg >>= 1;
+		if(Unpacker.Error())
+			return;
+
+		m_RecvBytes += pPacket->m_DataSize;
+
+		if(!Sys)
+		{
+			if(Msg == NETMSGTYPE_SV_READYTOENTER)
+			{
+				CMsgPacker Packer(NETMSG_ENTERGAME, true);
+				SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+				m_State = STATE_ENTERING;
+			}
+			return;
+		}
+
+		if(Msg == NETMSG_MAP_CHANGE)
+		{
+			Unpacker.GetString();
+			Unpacker.GetInt(); // crc
+			m_MapSize = Unpacker.GetInt();
+			m_MapChunksPerRequest = Unpacker.GetInt();
+			m_MapChunkSize = Unpacker.GetInt();
+			m_MapReceived = 0;
+			m_MapChunk = 0;
+			m_AckGameTick = -1;
+			m_RecvTick = 0;
+			m_State = STATE_LOADING;
+			if(Unpacker.Error() || m_MapSize <= 0 || m_MapChunkSize <= 0 || m_MapChunksPerRequest <= 0 || !s_DownloadMap)
+			{
+				CMsgPacker Packer(NETMSG_READY, true);
+				SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+			}
+			else
+			{
+				CMsgPacker Packer(NETMSG_REQUEST_MAP_DATA, true);
+				SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+			}
+		}
+		else if(Msg == NETMSG_MAP_DATA)
+		{
+			int Size = min(m_MapChunkSize, m_MapSize-m_MapReceived);
+			Unpacker.GetRaw(Size);
+			if(Unpacker.Error())
+				return;
+			m_MapReceived += Size;
+			m_MapChunk++;
+			if(m_MapReceived >= m_MapSize)
+			{
+				CMsgPacker Packer(NETMSG_READY, true);
+				SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+			}
+			else if(m_MapChunk%m_MapChunksPerRequest == 0)
+			{
+				CMsgPacker Packer(NETMSG_REQUEST_MAP_DATA, true);
+				SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+			}
+		}
+		else if(Msg == NETMSG_CON_READY)
+			SendStartInfo();
+		else if(Msg == NETMSG_PING)
+		{
+			CMsgPacker Packer(NETMSG_PING_REPLY, true);
+			SendMsg(&Packer, 0);
+		}
+		else if(Msg == NETMSG_PING_REPLY)
+		{
+			if(m_PingSent)
+			{
+				int64 Ping = Now-m_PingSent;
+				m_SumPing += Ping;
+				m_MaxPing = max(m_MaxPing, Ping);
+				m_NumPings++;
+				m_PingSent = 0;
+			}
+		}
+		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+			OnSnapshot(Msg, &Unpacker, Now);
+	}
+
+	void Update(int64 Now)
+	{
+		m_pNet->Update();
+
+		if(m_State != STATE_OFFLINE && m_pNet->State() == NETSTATE_OFFLINE)
+		{
+			dbg_msg("fake_clients", "client %d dropped: %s", m_ID, m_pNet->ErrorString());
+			m_State = STATE_OFFLINE;
+			return;
+		}
+
+		if(m_State == STATE_CONNECTING && m_pNet->State() == NETSTATE_ONLINE)
+		{
+			m_State = STATE_LOADING;
+			SendInfo();
+		}
+
+		CNetChunk Packet;
+		while(m_pNet->Recv(&Packet))
+		{
+			if(!(Packet.m_Flags&NETSENDFLAG_CONNLESS))
+				ProcessPacket(&Packet, Now);
+		}
+
+		if(m_State == STATE_INGAME && Now >= m_NextInput)
+		{
+			// keep a fixed rate even if an update was late
+			m_NextInput = max(m_NextInput+time_freq()/SERVER_TICK_SPEED, Now-time_freq());
+			SendInput(Now);
+		}
+
+		if(m_State >= STATE_ENTERING && !m_PingSent && Now >= m_NextPing)
+		{
+			m_PingSent = Now;
+			m_NextPing = Now+time_freq();
+			CMsgPacker Msg(NETMSG_PING, true);
+			SendMsg(&Msg, MSGFLAG_FLUSH);
+		}
+	}
+
+	void Shutdown()
+	{
+		m_pNet->Close();
+		delete m_pNet;
+	}
+};
+
+static CFakeClient s_aClients[MAX_FAKE_CLIENTS];
+
+static void Report(int64 Elapsed)
+{
+	int aStates[CFakeClient::NUM_STATES] = {0};
+	int NumSnaps = 0, NumSnapsExpected = 0, NumPings = 0;
+	int64 SumPing = 0, MaxPing = 0, MaxSnapInterval = 0, RecvBytes = 0;
+	for(int i = 0; i < s_NumClients; i++)
+	{
+		CFakeClient *pClient = &s_aClients[i];
+		aStates[pClient->m_State]++;
+		NumSnaps += pClient->m_NumSnaps;
+		NumSnapsExpected += pClient->m_NumSnapsExpected;
+		NumPings += pClient->m_NumPings;
+		SumPing += pClient->m_SumPing;
+		MaxPing = max(MaxPing, pClient->m_MaxPing);
+		MaxSnapInterval = max(MaxSnapInterval, pClient->m_MaxSnapInterval);
+		RecvBytes += pClient->m_RecvBytes;
+		pClient->ResetStats();
+	}
+
+	int64 Freq = time_freq();
+	Elapsed = max(Elapsed, (int64)1);
+	dbg_msg("fake_clients", "ingame=%d connecting=%d loading=%d offline=%d snaps/s=%d loss=%.2f%% ping_avg=%dms ping_max=%dms snap_gap_max=%dms recv=%dKiB/s",
+		aStates[CFakeClient::STATE_INGAME], aStates[CFakeClient::STATE_CONNECTING], aStates[CFakeClient::STATE_LOADING]+aStates[CFakeClient::STATE_ENTERING],
+		aStates[CFakeClient::STATE_OFFLINE], (int)(NumSnaps*Freq/Elapsed),
+		NumSnapsExpected ? (NumSnapsExpected-NumSnaps)*100.0f/NumSnapsExpected : 0.0f,
+		NumPings ? (int)(SumPing*1000/NumPings/Freq) : 0, (int)(MaxPing*1000/Freq), (int)(MaxSnapInterval*1000/Freq),
+		(int)(RecvBytes*Freq/Elapsed/1024));
+}
+
+static int Run()
+{
+	for(int i = 0; i < s_NumClients; i++)
+	{
+		if(!s_aClients[i].Init(i))
+			return -1;
+		s_aClients[i].Connect();
+	}
+
+	int64 StartTime = time_get();
+	int64 LastReport = StartTime;
+	while(!s_Duration || time_get() < StartTime+s_Duration*time_freq())
+	{
+		int64 Now = time_get();
+		for(int i = 0; i < s_NumClients; i++)
+			s_aClients[i].Update(Now);
+
+		if(Now > LastReport+s_ReportInterval*time_freq())
+		{
+			Report(Now-LastReport);
+			LastReport = Now;
+		}
+
+		thread_sleep(1);
+	}
+
+	for(int i = 0; i < s_NumClients; i++)
+		s_aClients[i].Shutdown();
+	return 0;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+	mem_zero(&s_Config, sizeof(s_Config));
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(str_comp(argv[i], "-c") == 0 && i+1 < argc) // ignore_convention
+			s_NumClients = clamp(str_toint(argv[++i]), 1, (int)MAX_FAKE_CLIENTS); // ignore_convention
+		else if(str_comp(argv[i], "-t") == 0 && i+1 < argc) // ignore_convention
+			s_Duration = str_toint(argv[++i]); // ignore_convention
+		else if(str_comp(argv[i], "-r") == 0 && i+1 < argc) // ignore_convention
+			s_ReportInterval = max(1, str_toint(argv[++i])); // ignore_convention
+		else if(str_comp(argv[i], "-p") == 0 && i+1 < argc) // ignore_convention
+			s_pPassword = argv[++i]; // ignore_convention
+		else if(str_comp(argv[i], "-n") == 0) // ignore_convention
+			s_DownloadMap = false;
+		else if(s_NumServers < MAX_SERVERS)
+		{
+			if(net_addr_from_str(&s_aServers[s_NumServers], argv[i]) != 0 && net_host_lookup(argv[i], &s_aServers[s_NumServers], NETTYPE_ALL) != 0) // ignore_convention
+			{
+				dbg_msg("fake_clients", "could not resolve '%s'", argv[i]); // ignore_convention
+				return -1;
+			}
+			if(s_aServers[s_NumServers].port == 0)
+				s_aServers[s_NumServers].port = 8303;
+			s_NumServers++;
+		}
+	}
+
+	if(!s_NumServers)
+	{
+		dbg_msg("fake_clients", "usage: fake_clients [-c clients] [-t seconds] [-r report_interval] [-p password] [-n] <server address>...");
+		dbg_msg("fake_clients", "clients are spread over the given servers, -n skips the map download");
+		return -1;
+	}
+
+	if(secure_random_init() != 0)
+	{
+		dbg_msg("fake_clients", "could not initialize secure RNG");
+		return -1;
+	}
+
+	dbg_msg("fake_clients", "connecting %d clients to %d server(s)", s_NumClients, s_NumServers);
+	return Run();
+}
@@ -27,6 +27,9 @@ int MaxPlayers = 0;
 char aInfoMsg[1024];
 int aInfoMsgSize;
 
+int NumLoadServers = 0;
+int LoadBasePort = 18400;
+
 static void SendHeartBeats()
 {
 	static unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
@@ -148,14 +151,184 @@ static int Run()
 	}
 }
 
+/*
+	Load test for the master server. Every simulated server has its own
+	socket, talks the token protocol directly on it and otherwise behaves
+	like the register code of a real server: heartbeats every 15 to 30
+	seconds and answers to the firewall checks.
+
+	Each server needs a file descriptor, raise the limit (ulimit -n)
+	before simulating thousands of them.
+*/
+class CLoadServer
+{
+public:
+	NETSOCKET m_Socket;
+	NETADDR m_Master;
+	TOKEN m_Token;
+	TOKEN m_MasterToken;
+	int64 m_MasterTokenExpire;
+	int64 m_NextHeartBeat;
+	bool m_Registered;
+
+	void SendConnless(const NETADDR *pAddr, TOKEN Token, const void *pData, int DataSize)
+	{
+		unsigned char aBuffer[NET_MAX_PACKETSIZE];
+		aBuffer[0] = ((NET_PACKETFLAG_CONNLESS<<2)&0xfc) | (NET_PACKETVERSION&0x03);
+		aBuffer[1] = (Token>>24)&0xff;
+		aBuffer[2] = (Token>>16)&0xff;
+		aBuffer[3] = (Token>>8)&0xff;
+		aBuffer[4] = Token&0xff;
+		aBuffer[5] = (m_Token>>24)&0xff;
+		aBuffer[6] = (m_Token>>16)&0xff;
+		aBuffer[7] = (m_Token>>8)&0xff;
+		aBuffer[8] = m_Token&0xff;
+		mem_copy(&aBuffer[NET_PACKETHEADERSIZE_CONNLESS], pData, DataSize);
+		net_udp_send(m_Socket, pAddr, aBuffer, NET_PACKETHEADERSIZE_CONNLESS+DataSize);
+	}
+
+	void RequestToken()
+	{
+		// control packets are never compressed, the request is padded like the real one
+		unsigned char aBuffer[NET_PACKETHEADERSIZE+1+NET_TOKENREQUEST_DATASIZE] = {0};
+		aBuffer[0] = (NET_PACKETFLAG_CONTROL<<2)&0xfc;
+		aBuffer[3] = aBuffer[4] = aBuffer[5] = aBuffer[6] = 0xff; // NET_TOKEN_NONE
+		aBuffer[7] = NET_CTRLMSG_TOKEN;
+		aBuffer[8] = (m_Token>>24)&0xff;
+		aBuffer[9] = (m_Token>>16)&0xff;
+		aBuffer[10] = (m_Token>>8)&0xff;
+		aBuffer[11] = m_Token&0xff;
+		net_udp_send(m_Socket, &m_Master, aBuffer, sizeof(aBuffer));
+	}
+
+	void SendHeartBeat(int Port)
+	{
+		unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
+		mem_copy(aData, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT));
+		aData[sizeof(SERVERBROWSE_HEARTBEAT)] = Port>>8;
+		aData[sizeof(SERVERBROWSE_HEARTBEAT)+1] = Port&0xff;
+		SendConnless(&m_Master, m_MasterToken, aData, sizeof(aData));
+	}
+};
+
+static int RunLoadTest()
+{
+	CLoadServer *pServers = new CLoadServer[NumLoadServers];
+	int NumOpen = 0;
+	int64 Now = time_get();
+	for(int i = 0; i < NumLoadServers; i++)
+	{
+		NETADDR BindAddr = {NETTYPE_IPV4, {0}, (unsigned short)(LoadBasePort+i)};
+		CLoadServer *pServer = &pServers[NumOpen];
+		pServer->m_Socket = net_udp_create(BindAddr, 0);
+		if(!pServer->m_Socket.type)
+		{
+			dbg_msg("fake_server", "couldn't open port %d, stopping at %d servers", LoadBasePort+i, NumOpen);
+			break;
+		}
+		pServer->m_Master = aMasterServers[i%NumMasters];
+		secure_random_fill(&pServer->m_Token, sizeof(pServer->m_Token));
+		pServer->m_MasterToken = NET_TOKEN_NONE;
+		pServer->m_MasterTokenExpire = 0;
+		// spread the first heartbeats so the master sees a steady stream
+		pServer->m_NextHeartBeat = Now+time_freq()*(random_int()%15000)/1000;
+		pServer->m_Registered = false;
+		NumOpen++;
+	}
+
+	int NumHeartBeats = 0, NumChecks = 0, NumOks = 0, NumErrors = 0, MasterCount = -1;
+	int64 LastReport = Now;
+	while(1)
+	{
+		Now = time_get();
+		for(int i = 0; i < NumOpen; i++)
+		{
+			CLoadServer *pServer = &pServers[i];
+			NETADDR From;
+			unsigned char aBuffer[NET_MAX_PACKETSIZE];
+			int Size;
+			while((Size = net_udp_recv(pServer->m_Socket, &From, aBuffer, sizeof(aBuffer))) > 0)
+			{
+				int Flags = (aBuffer[0]&0xfc)>>2;
+				if(Flags&NET_PACKETFLAG_CONNLESS)
+				{
+					if(Size < NET_PACKETHEADERSIZE_CONNLESS)
+						continue;
+					TOKEN ResponseToken = (aBuffer[5]<<24) | (aBuffer[6]<<16) | (aBuffer[7]<<8) | aBuffer[8];
+					const unsigned char *pData = &aBuffer[NET_PACKETHEADERSIZE_CONNLESS];
+					int DataSize = Size-NET_PACKETHEADERSIZE_CONNLESS;
+
+					if(DataSize == sizeof(SERVERBROWSE_FWCHECK) && mem_comp(pData, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)) == 0)
+					{
+						pServer->SendConnless(&From, ResponseToken, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE));
+						NumChecks++;
+					}
+					else if(DataSize == sizeof(SERVERBROWSE_FWOK) && mem_comp(pData, SERVERBROWSE_FWOK, sizeof(SERVERBROWSE_FWOK)) == 0)
+					{
+						// the master sends it twice, on both of its sockets
+						if(From.port == pServer->m_Master.port)
+						{
+							pServer->m_Registered = true;
+							NumOks++;
+						}
+					}
+					else if(DataSize == sizeof(SERVERBROWSE_FWERROR) && mem_comp(pData, SERVERBROWSE_FWERROR, sizeof(SERVERBROWSE_FWERROR)) == 0)
+						NumErrors++;
+					else if(DataSize == sizeof(SERVERBROWSE_COUNT)+2 && mem_comp(pData, SERVERBROWSE_COUNT, sizeof(SERVERBROWSE_COUNT)) == 0)
+						MasterCount = (pData[sizeof(SERVERBROWSE_COUNT)]<<8) | pData[sizeof(SERVERBROWSE_COUNT)+1];
+				}
+				else if(Flags&NET_PACKETFLAG_CONTROL && Size >= NET_PACKETHEADERSIZE+5 && aBuffer[NET_PACKETHEADERSIZE] == NET_CTRLMSG_TOKEN)
+				{
+					const unsigned char *pData = &aBuffer[NET_PACKETHEADERSIZE+1];
+					pServer->m_MasterToken = (pData[0]<<24) | (pData[1]<<16) | (pData[2]<<8) | pData[3];
+					pServer->m_MasterTokenExpire = Now+time_freq()*NET_TOKENCACHE_ADDRESSEXPIRY;
+					pServer->m_NextHeartBeat = Now;
+				}
+			}
+
+			if(pServer->m_NextHeartBeat < Now)
+			{
+				// the master changes its tokens, fetch a new one like the token cache does
+				if(pServer->m_MasterToken == NET_TOKEN_NONE || pServer->m_MasterTokenExpire < Now)
+				{
+					pServer->RequestToken();
+					pServer->m_NextHeartBeat = Now+time_freq();
+				}
+				else
+				{
+					pServer->SendHeartBeat(LoadBasePort+i);
+					pServer->m_NextHeartBeat = Now+time_freq()*(15+(random_int()%15));
+					NumHeartBeats++;
+				}
+			}
+		}
+
+		if(Now > LastReport+time_freq()*5)
+		{
+			int NumRegistered = 0;
+			for(int i = 0; i < NumOpen; i++)
+				NumRegistered += pServers[i].m_Registered;
+			dbg_msg("fake_server", "servers=%d registered=%d master_count=%d | heartbeats=%d checks=%d ok=%d error=%d",
+				NumOpen, NumRegistered, MasterCount, NumHeartBeats, NumChecks, NumOks, NumErrors);
+			NumHeartBeats = NumChecks = NumOks = NumErrors = 0;
+			LastReport = Now;
+
+			// ask for the count the master reports to clients
+			if(NumOpen && pServers[0].m_MasterToken != NET_TOKEN_NONE && pServers[0].m_MasterTokenExpire > Now)
+				pServers[0].SendConnless(&pServers[0].m_Master, pServers[0].m_MasterToken, SERVERBROWSE_GETCOUNT, sizeof(SERVERBROWSE_GETCOUNT));
+		}
+
+		thread_sleep(5);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	pNet = new CNetServer;
 
 	while(argc)
 	{
-		// ?
-		/*if(str_comp(*argv, "-m") == 0)
+		if(str_comp(*argv, "-m") == 0 && NumMasters < 16)
 		{
 			argc--; argv++;
 			net_host_lookup(*argv, &aMasterServers[NumMasters], NETTYPE_IPV4);
@@ -163,7 +336,17 @@ int main(int argc, char **argv)
 			aMasterServers[NumMasters].port = str_toint(*argv);
 			NumMasters++;
 		}
-		else */if(str_comp(*argv, "-p") == 0)
+		else if(str_comp(*argv, "-l") == 0)
+		{
+			argc--; argv++;
+			NumLoadServers = str_toint(*argv);
+		}
+		else if(str_comp(*argv, "-b") == 0)
+		{
+			argc--; argv++;
+			LoadBasePort = str_toint(*argv);
+		}
+		else if(str_comp(*argv, "-p") == 0)
 		{
 			argc--; argv++;
 			PlayerNames[NumPlayers++] = *argv;
@@ -210,6 +393,17 @@ int main(int argc, char **argv)
 		return -1;
 	}
 
+	if(NumLoadServers > 0)
+	{
+		if(!NumMasters)
+		{
+			dbg_msg("fake_server", "the load test needs a master server, add one with -m <host> <port>");
+			return -1;
+		}
+		dbg_logger_stdout();
+		return RunLoadTest();
+	}
+
 	BuildInfoMsg();
 	int RunReturn = Run();
 